@@ -7,6 +7,7 @@
 #include "AudioFormat.h"
 #include "AudioIn.h"
 #include "AudioOut.h"
+#include "AudioResampler.h"
 #include "LineOut.h"
 #include "OggVorbisDecoder.h"
 
@@ -1,42 +1,401 @@
+#include <string.h>
+
 #include <algorithm>
 
 #include "AudioConverter.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define DIGI_AUDIO_SSE2
+#endif
+
 
 namespace digi {
 
+namespace
+{
+	template <typename Type>
+	Type clamp(float value, float limit)
+	{
+		return Type(std::max(std::min(value, limit), -limit));
+	}
+
+	void int8ToInt16(const int8_t* src, int16_t* dst, size_t numValues)
+	{
+		for (size_t i = 0; i < numValues; ++i)
+			dst[i] = int16_t(src[i] * 256);
+	}
+
+	void int16ToInt8(const int16_t* src, int8_t* dst, size_t numValues)
+	{
+		for (size_t i = 0; i < numValues; ++i)
+			dst[i] = int8_t(src[i] >> 8);
+	}
+
+	void int8ToFloat(const int8_t* src, float* dst, size_t numValues)
+	{
+		for (size_t i = 0; i < numValues; ++i)
+			dst[i] = float(src[i]) * (1.0f / 127.0f);
+	}
+
+	void floatToInt8(const float* src, int8_t* dst, size_t numValues)
+	{
+		for (size_t i = 0; i < numValues; ++i)
+			dst[i] = clamp<int8_t>(src[i] * 127.0f, 127.0f);
+	}
+
+	void int16ToFloat(const int16_t* src, float* dst, size_t numValues)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		__m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+		for (; i + 8 <= numValues; i += 8)
+		{
+			// sign extend 8 values to 32 bit and convert to float
+			__m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+			_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+		}
+	#endif
+		for (; i < numValues; ++i)
+			dst[i] = float(src[i]) * (1.0f / 32767.0f);
+	}
+
+	void floatToInt16(const float* src, int16_t* dst, size_t numValues)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		__m128 scale = _mm_set1_ps(32767.0f);
+		__m128 maxValue = _mm_set1_ps(32767.0f);
+		__m128 minValue = _mm_set1_ps(-32767.0f);
+		for (; i + 8 <= numValues; i += 8)
+		{
+			// scale and clamp before the conversion to 32 bit so that large values do not wrap around
+			__m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+			__m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+			a = _mm_max_ps(_mm_min_ps(a, maxValue), minValue);
+			b = _mm_max_ps(_mm_min_ps(b, maxValue), minValue);
+			__m128i x = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+			_mm_storeu_si128((__m128i*)(dst + i), x);
+		}
+	#endif
+		for (; i < numValues; ++i)
+		{
+			float value = std::max(std::min(src[i] * 32767.0f, 32767.0f), -32767.0f);
+
+			// round to nearest like _mm_cvtps_epi32
+			dst[i] = int16_t(value >= 0.0f ? value + 0.5f : value - 0.5f);
+		}
+	}
+
+	template <typename Type>
+	void interleaveGeneric(const void* const* planes, int numPlanes, void* dst, int numChannels, size_t numSamples)
+	{
+		for (int planeIndex = 0; planeIndex < numPlanes; ++planeIndex)
+		{
+			const Type* s = (const Type*)planes[planeIndex];
+			Type* d = (Type*)dst + planeIndex;
+			for (size_t i = 0; i < numSamples; ++i)
+				d[i * numChannels] = s[i];
+		}
+	}
+
+	template <typename Type>
+	void deinterleaveGeneric(const void* src, int numChannels, void* const* planes, int numPlanes, size_t numSamples)
+	{
+		for (int planeIndex = 0; planeIndex < numPlanes; ++planeIndex)
+		{
+			const Type* s = (const Type*)src + planeIndex;
+			Type* d = (Type*)planes[planeIndex];
+			for (size_t i = 0; i < numSamples; ++i)
+				d[i] = s[i * numChannels];
+		}
+	}
+
+	void interleaveStereo16(const int16_t* l, const int16_t* r, int16_t* dst, size_t numSamples)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(l + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(r + i));
+			_mm_storeu_si128((__m128i*)(dst + i * 2), _mm_unpacklo_epi16(a, b));
+			_mm_storeu_si128((__m128i*)(dst + i * 2 + 8), _mm_unpackhi_epi16(a, b));
+		}
+	#endif
+		for (; i < numSamples; ++i)
+		{
+			dst[i * 2] = l[i];
+			dst[i * 2 + 1] = r[i];
+		}
+	}
+
+	void interleaveStereo32(const float* l, const float* r, float* dst, size_t numSamples)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(l + i);
+			__m128 b = _mm_loadu_ps(r + i);
+			_mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(a, b));
+			_mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(a, b));
+		}
+	#endif
+		for (; i < numSamples; ++i)
+		{
+			dst[i * 2] = l[i];
+			dst[i * 2 + 1] = r[i];
+		}
+	}
+
+	void deinterleaveStereo16(const int16_t* src, int16_t* l, int16_t* r, size_t numSamples)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			// left channel is in the low half, right channel in the high half of each 32 bit value
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + i * 2));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + i * 2 + 8));
+			__m128i la = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+			__m128i lb = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+			_mm_storeu_si128((__m128i*)(l + i), _mm_packs_epi32(la, lb));
+			_mm_storeu_si128((__m128i*)(r + i), _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+		}
+	#endif
+		for (; i < numSamples; ++i)
+		{
+			l[i] = src[i * 2];
+			r[i] = src[i * 2 + 1];
+		}
+	}
+
+	void deinterleaveStereo32(const float* src, float* l, float* r, size_t numSamples)
+	{
+		size_t i = 0;
+	#ifdef DIGI_AUDIO_SSE2
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(src + i * 2);
+			__m128 b = _mm_loadu_ps(src + i * 2 + 4);
+			_mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	#endif
+		for (; i < numSamples; ++i)
+		{
+			l[i] = src[i * 2];
+			r[i] = src[i * 2 + 1];
+		}
+	}
+
+	// returns true if the samples of a format are interleaved in one buffer
+	bool isInterleaved(const AudioFormat& format)
+	{
+		return format.layout == AudioFormat::INTERLEAVED && format.numChannels > 1;
+	}
+} // anonymous namespace
+
+
+void convertValues(AudioFormat::Type srcType, const void* src, AudioFormat::Type dstType, void* dst,
+	size_t numValues)
+{
+	switch (srcType)
+	{
+	case AudioFormat::INT8:
+		switch (dstType)
+		{
+		case AudioFormat::INT8:
+			memcpy(dst, src, numValues);
+			break;
+		case AudioFormat::INT16:
+			int8ToInt16((const int8_t*)src, (int16_t*)dst, numValues);
+			break;
+		case AudioFormat::FLOAT32:
+			int8ToFloat((const int8_t*)src, (float*)dst, numValues);
+			break;
+		default:
+			break;
+		}
+		break;
+	case AudioFormat::INT16:
+		switch (dstType)
+		{
+		case AudioFormat::INT8:
+			int16ToInt8((const int16_t*)src, (int8_t*)dst, numValues);
+			break;
+		case AudioFormat::INT16:
+			memcpy(dst, src, numValues * 2);
+			break;
+		case AudioFormat::FLOAT32:
+			int16ToFloat((const int16_t*)src, (float*)dst, numValues);
+			break;
+		default:
+			break;
+		}
+		break;
+	case AudioFormat::FLOAT32:
+		switch (dstType)
+		{
+		case AudioFormat::INT8:
+			floatToInt8((const float*)src, (int8_t*)dst, numValues);
+			break;
+		case AudioFormat::INT16:
+			floatToInt16((const float*)src, (int16_t*)dst, numValues);
+			break;
+		case AudioFormat::FLOAT32:
+			memcpy(dst, src, numValues * 4);
+			break;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void interleave(int elementSize, const void* const* planes, int numPlanes, void* dst, int numChannels,
+	size_t numSamples)
+{
+	if (numPlanes == 2 && numChannels == 2 && elementSize == 2)
+		interleaveStereo16((const int16_t*)planes[0], (const int16_t*)planes[1], (int16_t*)dst, numSamples);
+	else if (numPlanes == 2 && numChannels == 2 && elementSize == 4)
+		interleaveStereo32((const float*)planes[0], (const float*)planes[1], (float*)dst, numSamples);
+	else if (elementSize == 1)
+		interleaveGeneric<uint8_t>(planes, numPlanes, dst, numChannels, numSamples);
+	else if (elementSize == 2)
+		interleaveGeneric<uint16_t>(planes, numPlanes, dst, numChannels, numSamples);
+	else
+		interleaveGeneric<uint32_t>(planes, numPlanes, dst, numChannels, numSamples);
+}
+
+void deinterleave(int elementSize, const void* src, int numChannels, void* const* planes, int numPlanes,
+	size_t numSamples)
+{
+	if (numPlanes == 2 && numChannels == 2 && elementSize == 2)
+		deinterleaveStereo16((const int16_t*)src, (int16_t*)planes[0], (int16_t*)planes[1], numSamples);
+	else if (numPlanes == 2 && numChannels == 2 && elementSize == 4)
+		deinterleaveStereo32((const float*)src, (float*)planes[0], (float*)planes[1], numSamples);
+	else if (elementSize == 1)
+		deinterleaveGeneric<uint8_t>(src, numChannels, planes, numPlanes, numSamples);
+	else if (elementSize == 2)
+		deinterleaveGeneric<uint16_t>(src, numChannels, planes, numPlanes, numSamples);
+	else
+		deinterleaveGeneric<uint32_t>(src, numChannels, planes, numPlanes, numSamples);
+}
+
+void convertSamples(const void* const* src, AudioFormat srcFormat, void* const* dst, AudioFormat dstFormat,
+	int numChannels, size_t numSamples, void* temp)
+{
+	bool srcInterleaved = isInterleaved(srcFormat);
+	bool dstInterleaved = isInterleaved(dstFormat);
+	int srcSize = srcFormat.getElementSize();
+	int dstSize = dstFormat.getElementSize();
+
+	// interleaved with same number of channels: convert all values at once
+	if (srcInterleaved && dstInterleaved && srcFormat.numChannels == numChannels
+		&& dstFormat.numChannels == numChannels)
+	{
+		convertValues(srcFormat.type, src[0], dstFormat.type, dst[0], numSamples * numChannels);
+		return;
+	}
+
+	// deinterleave source into temp buffer
+	const void* srcPlanes[16];
+	if (srcInterleaved)
+	{
+		void* planes[16];
+		for (int i = 0; i < numChannels; ++i)
+		{
+			planes[i] = (uint8_t*)temp + i * numSamples * srcSize;
+			srcPlanes[i] = planes[i];
+		}
+		deinterleave(srcSize, src[0], srcFormat.numChannels, planes, numChannels, numSamples);
+	}
+	else
+	{
+		for (int i = 0; i < numChannels; ++i)
+			srcPlanes[i] = src[i];
+	}
+
+	if (!dstInterleaved)
+	{
+		// convert each channel into destination
+		for (int i = 0; i < numChannels; ++i)
+			convertValues(srcFormat.type, srcPlanes[i], dstFormat.type, dst[i], numSamples);
+	}
+	else
+	{
+		// convert each channel into temp buffer (in-place if source was deinterleaved) and interleave
+		const void* dstPlanes[16];
+		if (srcFormat.type == dstFormat.type)
+		{
+			for (int i = 0; i < numChannels; ++i)
+				dstPlanes[i] = srcPlanes[i];
+		}
+		else
+		{
+			// the destination elements must not be larger than the source elements for in-place conversion
+			bool inPlace = srcInterleaved && dstSize <= srcSize;
+			uint8_t* t = (uint8_t*)temp + (srcInterleaved && !inPlace ? numChannels * numSamples * srcSize : 0);
+			for (int i = 0; i < numChannels; ++i)
+			{
+				void* plane = inPlace ? (void*)srcPlanes[i] : (void*)(t + i * numSamples * dstSize);
+				convertValues(srcFormat.type, srcPlanes[i], dstFormat.type, plane, numSamples);
+				dstPlanes[i] = plane;
+			}
+		}
+		interleave(dstSize, dstPlanes, numChannels, dst[0], dstFormat.numChannels, numSamples);
+	}
+}
+
+
+// AudioInConverter
+
 AudioInConverter::AudioInConverter(Pointer<AudioIn> input, AudioFormat format, int numBufferSamples)
-	: input(input), format(format), numBufferSamples(numBufferSamples)
+	: input(input), inFormat(input->getFormat()), format(format), numBufferSamples(numBufferSamples), resampler(),
+	endOfInput(false)
 {
-	AudioFormat inFormat = input->getFormat();
+	AudioFormat& inFormat = this->inFormat;
 		
 	// allocate buffer(s)
 	bool srcInterleaved = inFormat.layout == AudioFormat::INTERLEAVED;
 	int srcSize = inFormat.getElementSize();	
-	int bufferSize = numBufferSamples * inFormat.numChannels * srcSize;
-	uint8_t* buffer = this->buffer = new uint8_t[bufferSize];
+	this->buffer.resize(numBufferSamples * inFormat.numChannels * srcSize);
+	uint8_t* buffer = this->buffer.data();
 	for (int i = 0; i < inFormat.numChannels; ++i)
 	{
 		this->buffers[i] = buffer;
-		buffer += srcInterleaved ? srcSize : bufferSize * srcSize;
+		buffer += srcInterleaved ? srcSize : numBufferSamples * srcSize;
 	}
 	
 	// number of channels to convert
-	this->numChannels = std::min(inFormat.numChannels, format.numChannels);
-	
-	// source info
-	this->srcType = inFormat.type;
-	this->srcStride = inFormat.getSampleSize(); 
-
-	// destination info
-	this->dstInterleaved = format.layout == AudioFormat::INTERLEAVED;
-	this->dstSize = format.getElementSize();
-	this->dstStride = format.getSampleSize();
+	int numChannels = this->numChannels = std::min(inFormat.numChannels, format.numChannels);
+
+	// temp buffer, large enough for deinterleaved source and converted channels
+	this->temp.resize(numBufferSamples * numChannels * 8);
+
+	// create resampler if the sample rates differ
+	if (inFormat.sampleRate != format.sampleRate && inFormat.sampleRate > 0 && format.sampleRate > 0)
+	{
+		this->resampler = new AudioResampler(numChannels, inFormat.sampleRate, format.sampleRate);
+
+		// float buffers for input and output of resampler
+		this->floatBuffer.resize(numBufferSamples * numChannels * 2);
+		this->floatBuffers.resize(numChannels * 2);
+		for (int i = 0; i < numChannels * 2; ++i)
+			this->floatBuffers[i] = this->floatBuffer.data() + i * numBufferSamples;
+	}
 }
 
 AudioInConverter::~AudioInConverter()
 {
-	delete [] this->buffer;
+	delete this->resampler;
 }
 
 AudioFormat AudioInConverter::getFormat()
@@ -49,96 +408,78 @@ void AudioInConverter::close()
 	return this->input->close();
 }
 
-template <typename Type>
-void copy(uint8_t* src, int srcStride, uint8_t* dst, int dstStride, size_t numValues)
-{
-	for (size_t i = 0; i < numValues; ++i)
-	{	
-		*(Type*)dst = *(Type*)src;
-		src += srcStride;
-		dst += dstStride;
-	}
-}
-
-template <typename SrcType, typename DstType>
-void copyToFloat(uint8_t* src, int srcStride, DstType scale, uint8_t* dst, int dstStride, size_t numValues)
-{
-	for (size_t i = 0; i < numValues; ++i)
-	{	
-		*(DstType*)dst = DstType(*(SrcType*)src) * scale;
-		src += srcStride;
-		dst += dstStride;
-	}
-}
-
 size_t AudioInConverter::read(Buffer* buffers, size_t numSamples)
 {	
+	void* dst[16];
 	size_t numRead = 0;
-	while (numRead < numSamples)
+	if (this->resampler == NULL)
 	{
-		// read
-		size_t nr = this->input->read(this->buffers, std::min(numSamples, this->numBufferSamples));
-		if (nr == 0)
-			break;
-		
-		// convert
-		for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+		while (numRead < numSamples)
 		{
-			uint8_t* src = (uint8_t*)this->buffers[channelIndex];
-			uint8_t* dst = (uint8_t*)buffers[this->dstInterleaved ? 0 : channelIndex]
-				+ numRead * this->dstStride + (this->dstInterleaved ? channelIndex * this->dstSize : 0);
-			
-			switch (this->srcType)
-			{
-			case AudioFormat::INT8:
-				switch (this->format.type)
-				{
-				case AudioFormat::INT8:
-					copy<int8_t>(src, this->srcStride, dst, this->dstStride, nr);
-					break;				
-				case AudioFormat::INT16:
-
-					break;				
-				case AudioFormat::FLOAT32:
-					copyToFloat<int8_t, float>(src, this->srcStride, 1.0f / 127.0f, dst, this->dstStride, nr);
-					break;				
-				}
-				break;
-			
-			case AudioFormat::INT16:
-				switch (this->format.type)
-				{
-				case AudioFormat::INT8:
-
-					break;				
-				case AudioFormat::INT16:
-					copy<int16_t>(src, this->srcStride, dst, this->dstStride, nr);
-					break;				
-				case AudioFormat::FLOAT32:
-					copyToFloat<int16_t, float>(src, this->srcStride, 1.0f / 32767.0f, dst, this->dstStride, nr);
-					break;				
-				}
+			// read
+			size_t nr = this->input->read(this->buffers, std::min(numSamples - numRead, this->numBufferSamples));
+			if (nr == 0)
 				break;
 			
-			case AudioFormat::FLOAT32:
-				switch (this->format.type)
+			// convert
+			this->getBuffers(buffers, numRead, dst);
+			convertSamples(this->buffers, this->inFormat, dst, this->format, this->numChannels, nr,
+				this->temp.data());
+			numRead += nr;
+		}
+	}
+	else
+	{
+		int numChannels = this->numChannels;
+		AudioFormat floatFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, numChannels, 0);
+		float** resamplerInput = this->floatBuffers.data();
+		float** resamplerOutput = resamplerInput + numChannels;
+		while (numRead < numSamples)
+		{
+			// get resampled samples
+			size_t nr = this->resampler->read(resamplerOutput, std::min(numSamples - numRead, this->numBufferSamples));
+			if (nr > 0)
+			{
+				// convert
+				this->getBuffers(buffers, numRead, dst);
+				convertSamples((void**)resamplerOutput, floatFormat, dst, this->format, numChannels, nr,
+					this->temp.data());
+				numRead += nr;
+			}
+			else
+			{
+				// resampler needs more input
+				if (this->endOfInput)
+					break;
+				size_t numInput = this->input->read(this->buffers, this->numBufferSamples);
+				if (numInput == 0)
 				{
-				case AudioFormat::INT8:
-
-					break;				
-				case AudioFormat::INT16:
-
-					break;				
-				case AudioFormat::FLOAT32:
-					copy<float>(src, this->srcStride, dst, this->dstStride, nr);
-					break;				
+					// get the remaining output samples at the end of the input
+					this->resampler->flush();
+					this->endOfInput = true;
+					continue;
 				}
-				break;				
+				convertSamples(this->buffers, this->inFormat, (void**)resamplerInput, floatFormat, numChannels,
+					numInput, this->temp.data());
+				this->resampler->write(resamplerInput, numInput);
 			}
 		}
-		numRead += nr;
 	}
 	return numRead;
 }
 
+void AudioInConverter::getBuffers(Buffer* buffers, size_t offset, void** dst)
+{
+	int dstSize = this->format.getElementSize();
+	if (isInterleaved(this->format))
+	{
+		dst[0] = (uint8_t*)buffers[0] + offset * this->format.numChannels * dstSize;
+	}
+	else
+	{
+		for (int i = 0; i < this->numChannels; ++i)
+			dst[i] = (uint8_t*)buffers[i] + offset * dstSize;
+	}
+}
+
 } // namespace digi
@@ -1,8 +1,11 @@
 #ifndef digi_Audio_AudioConverter_h
 #define digi_Audio_AudioConverter_h
 
+#include <vector>
+
 #include <digi/Base/Platform.h>
 #include "AudioIn.h"
+#include "AudioResampler.h"
 
 
 namespace digi {
@@ -10,7 +13,28 @@ namespace digi {
 /// @addtogroup Audio
 /// @{
 
-/// base class for audio input stream
+/// convert contiguous values between INT8, INT16 and FLOAT32. floats are clamped to [-1, 1] when converted to
+/// integers. uses SSE2 if available
+void convertValues(AudioFormat::Type srcType, const void* src, AudioFormat::Type dstType, void* dst,
+	size_t numValues);
+
+/// interleave numPlanes separate channels with given element size (1, 2 or 4) into the first numPlanes channels
+/// of dst which has numChannels channels
+void interleave(int elementSize, const void* const* planes, int numPlanes, void* dst, int numChannels,
+	size_t numSamples);
+
+/// deinterleave the first numPlanes channels of src which has numChannels channels into separate channels
+void deinterleave(int elementSize, const void* src, int numChannels, void* const* planes, int numPlanes,
+	size_t numSamples);
+
+/// convert type and layout of the first numChannels channels of samples. src and dst contain one buffer for
+/// interleaved and numChannels buffers for separate layout. the sample rates are ignored.
+/// temp must have space for numSamples * numChannels * 8 bytes
+void convertSamples(const void* const* src, AudioFormat srcFormat, void* const* dst, AudioFormat dstFormat,
+	int numChannels, size_t numSamples, void* temp);
+
+
+/// audio input that converts type, layout and sample rate of another audio input
 class AudioInConverter : public AudioIn
 {
 public:
@@ -31,26 +55,35 @@ public:
 	virtual size_t read(Buffer* buffers, size_t numSamples);
 
 protected:
+
+	// get pointers to the buffers of the destination at given sample offset
+	void getBuffers(Buffer* buffers, size_t offset, void** dst);
 	
 	// input
 	Pointer<AudioIn> input;
+	AudioFormat inFormat;
 	
 	// output format
 	AudioFormat format;
 	
-	// buffer
+	// buffer for input samples
 	size_t numBufferSamples;
-	uint8_t* buffer;
+	std::vector<uint8_t> buffer;
 	void* buffers[16];
 
-	int numChannels;
+	// temp buffer for conversion
+	std::vector<uint8_t> temp;
 
-	AudioFormat::Type srcType;
-	int srcStride;
+	// number of channels to convert
+	int numChannels;
 
-	bool dstInterleaved;
-	int dstSize;
-	int dstStride;
+	// resampler if the sample rates differ (otherwise NULL) and its float input and output buffers
+	AudioResampler* resampler;
+	std::vector<float> floatBuffer;
+	std::vector<float*> floatBuffers;
+	
+	// true if the end of the input was reached and the resampler was flushed
+	bool endOfInput;
 };
 
 /// @}
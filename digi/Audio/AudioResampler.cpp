@@ -0,0 +1,155 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "AudioResampler.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define DIGI_AUDIO_SSE
+#endif
+
+
+namespace digi {
+
+namespace
+{
+	const double pi = 3.1415926535897932384626433832795;
+
+	uint32_t gcd(uint32_t a, uint32_t b)
+	{
+		while (b != 0)
+		{
+			uint32_t t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	// dot product of samples and filter coefficients. numTaps is a multiple of 4
+	inline float filter(const float* samples, const float* coefficients, int numTaps)
+	{
+	#ifdef DIGI_AUDIO_SSE
+		__m128 sum = _mm_setzero_ps();
+		for (int i = 0; i < numTaps; i += 4)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(coefficients + i)));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+	#else
+		float sum = 0.0f;
+		for (int i = 0; i < numTaps; ++i)
+			sum += samples[i] * coefficients[i];
+		return sum;
+	#endif
+	}
+} // anonymous namespace
+
+
+// AudioResampler
+
+AudioResampler::AudioResampler(int numChannels, int srcRate, int dstRate, int numTaps)
+	: numChannels(numChannels), numTaps((numTaps + 3) & ~3), inputs(numChannels)
+{
+	uint32_t d = gcd(uint32_t(srcRate), uint32_t(dstRate));
+	this->up = uint32_t(dstRate) / d;
+	this->down = uint32_t(srcRate) / d;
+	this->numPhases = int(std::min(this->up, uint32_t(MAX_NUM_PHASES)));
+
+	// cutoff relative to input nyquist frequency
+	double cutoff = std::min(1.0, double(this->up) / double(this->down));
+
+	// calc filter for each phase. tap i of phase p is at distance i - (halfTaps - 1) - p / numPhases
+	// from the output sample
+	int halfTaps = this->numTaps / 2;
+	this->coefficients.resize(this->numPhases * this->numTaps);
+	for (int p = 0; p < this->numPhases; ++p)
+	{
+		float* c = &this->coefficients[p * this->numTaps];
+		double sum = 0.0;
+		for (int i = 0; i < this->numTaps; ++i)
+		{
+			double d = double(i - (halfTaps - 1)) - double(p) / double(this->numPhases);
+			double x = pi * cutoff * d;
+			double sinc = x == 0.0 ? 1.0 : sin(x) / x;
+			double w = pi * d / double(halfTaps);
+			double window = 0.42 + 0.5 * cos(w) + 0.08 * cos(2.0 * w);
+			double h = sinc * window;
+			c[i] = float(h);
+			sum += h;
+		}
+
+		// normalize to unit gain
+		for (int i = 0; i < this->numTaps; ++i)
+			c[i] = float(c[i] / sum);
+	}
+
+	this->reset();
+}
+
+AudioResampler::~AudioResampler()
+{
+}
+
+void AudioResampler::write(const float* const* samples, size_t numSamples)
+{
+	for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+	{
+		std::vector<float>& input = this->inputs[channelIndex];
+		input.insert(input.end(), samples[channelIndex], samples[channelIndex] + numSamples);
+	}
+}
+
+size_t AudioResampler::read(float* const* samples, size_t numSamples)
+{
+	int numTaps = this->numTaps;
+	size_t numInput = this->inputs[0].size();
+	size_t numRead = 0;
+	while (numRead < numSamples && this->position + numTaps <= numInput)
+	{
+		const float* c = &this->coefficients[size_t(uint64_t(this->phase) * this->numPhases / this->up) * numTaps];
+		for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+			samples[channelIndex][numRead] = filter(&this->inputs[channelIndex][this->position], c, numTaps);
+
+		// advance input position by down / up
+		this->phase += this->down;
+		this->position += this->phase / this->up;
+		this->phase %= this->up;
+		++numRead;
+	}
+
+	// remove input samples that are not needed any more
+	size_t numUsed = std::min(this->position, numInput);
+	if (numUsed > 0)
+	{
+		for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+		{
+			std::vector<float>& input = this->inputs[channelIndex];
+			input.erase(input.begin(), input.begin() + numUsed);
+		}
+		this->position -= numUsed;
+	}
+	return numRead;
+}
+
+void AudioResampler::flush()
+{
+	// the filter of the last output sample needs numTaps / 2 samples after the last input sample
+	for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+	{
+		std::vector<float>& input = this->inputs[channelIndex];
+		input.insert(input.end(), this->numTaps / 2, 0.0f);
+	}
+}
+
+void AudioResampler::reset()
+{
+	// start with zeros so that the first output sample is centered on the first input sample
+	for (int channelIndex = 0; channelIndex < this->numChannels; ++channelIndex)
+		this->inputs[channelIndex].assign(this->numTaps / 2 - 1, 0.0f);
+	this->position = 0;
+	this->phase = 0;
+}
+
+} // namespace digi
@@ -0,0 +1,75 @@
+#ifndef digi_Audio_AudioResampler_h
+#define digi_Audio_AudioResampler_h
+
+#include <vector>
+
+#include <digi/Base/Platform.h>
+
+
+namespace digi {
+
+/// @addtogroup Audio
+/// @{
+
+/**
+	polyphase resampler for float samples with separate channels. the filter of each phase is a blackman windowed
+	sinc with numTaps taps and a cutoff at the lower of the two nyquist frequencies. input samples are added with
+	write() and output samples are fetched with read(). the output is aligned to the input, i.e. there is no delay
+*/
+class AudioResampler
+{
+public:
+
+	/// maximum number of phases. if the ratio of the sample rates needs more phases the nearest phase is used
+	enum
+	{
+		MAX_NUM_PHASES = 512
+	};
+
+	/// constructor. numTaps gets rounded up to a multiple of 4
+	AudioResampler(int numChannels, int srcRate, int dstRate, int numTaps = 32);
+
+	~AudioResampler();
+
+	int getNumChannels() {return this->numChannels;}
+
+	/// add input samples (one buffer per channel)
+	void write(const float* const* samples, size_t numSamples);
+
+	/// get output samples (one buffer per channel). returns the number of samples which is less than numSamples if
+	/// more input is needed
+	size_t read(float* const* samples, size_t numSamples);
+
+	/// add zeros after the last input sample so that read() returns the output samples up to the end of the input.
+	/// call once at end of input
+	void flush();
+
+	/// discard all input samples
+	void reset();
+
+protected:
+
+	int numChannels;
+	int numTaps;
+
+	// ratio of the sample rates is up / down
+	uint32_t up;
+	uint32_t down;
+
+	// filter coefficients for each phase (numPhases * numTaps)
+	int numPhases;
+	std::vector<float> coefficients;
+
+	// input samples for each channel including the history that is needed by the filter
+	std::vector<std::vector<float> > inputs;
+
+	// current input position, integer part is an index into the inputs, fractional part is phase / up
+	size_t position;
+	uint32_t phase;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
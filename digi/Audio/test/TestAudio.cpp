@@ -7,6 +7,7 @@
 #include <digi/Math/All.h>
 #include <digi/System/File.h>
 #include <digi/System/Timer.h>
+#include <digi/Audio/AudioConverter.h>
 #include <digi/Audio/LineOut.h>
 #ifdef HAVE_OGG
 #include <digi/Audio/OggVorbisDecoder.h>
@@ -159,6 +160,267 @@ TEST(Audio, LineOut)
 	#endif
 }
 
+// test audio input that generates a sine with a different frequency for each channel
+class TestSineIn : public AudioIn
+{
+public:
+
+	TestSineIn(AudioFormat format, double frequency)
+		: format(format), frequency(frequency), index(0) {}
+
+	virtual AudioFormat getFormat()
+	{
+		return this->format;
+	}
+
+	virtual void close()
+	{
+	}
+
+	virtual size_t read(Buffer* buffers, size_t numSamples)
+	{
+		int numChannels = this->format.numChannels;
+		bool interleaved = this->format.layout == AudioFormat::INTERLEAVED;
+		for (size_t i = 0; i < numSamples; ++i)
+		{
+			for (int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+			{
+				float value = getValue(this->index + i, channelIndex);
+				size_t offset = interleaved ? i * numChannels + channelIndex : i;
+				void* buffer = buffers[interleaved ? 0 : channelIndex];
+				if (this->format.type == AudioFormat::INT16)
+					((int16_t*)buffer)[offset] = int16_t(floor(value * 32767.0f + 0.5f));
+				else
+					((float*)buffer)[offset] = value;
+			}
+		}
+		this->index += numSamples;
+		return numSamples;
+	}
+
+	float getValue(size_t index, int channelIndex)
+	{
+		return float(sin(double(index) * this->frequency * (channelIndex + 1) * 2.0 * pi / this->format.sampleRate)
+			* 0.5);
+	}
+
+	AudioFormat format;
+	double frequency;
+	size_t index;
+};
+
+// test audio input that repeats the first samples of another audio input
+class TestLoopIn : public AudioIn
+{
+public:
+
+	TestLoopIn(Pointer<AudioIn> input, size_t numSamples)
+		: format(input->getFormat()), numSamples(numSamples)
+	{
+		int numBuffers = this->format.getNumBuffers();
+		size_t bufferSize = numSamples * this->format.getSampleSize();
+		this->data.resize(numBuffers * bufferSize);
+		Buffer buffers[16];
+		for (int i = 0; i < numBuffers; ++i)
+			buffers[i] = this->data.data() + i * bufferSize;
+		input->read(buffers, numSamples);
+	}
+
+	virtual AudioFormat getFormat()
+	{
+		return this->format;
+	}
+
+	virtual void close()
+	{
+	}
+
+	virtual size_t read(Buffer* buffers, size_t numSamples)
+	{
+		numSamples = std::min(numSamples, this->numSamples);
+		int numBuffers = this->format.getNumBuffers();
+		size_t bufferSize = this->numSamples * this->format.getSampleSize();
+		for (int i = 0; i < numBuffers; ++i)
+			memcpy(buffers[i], this->data.data() + i * bufferSize, numSamples * this->format.getSampleSize());
+		return numSamples;
+	}
+
+	AudioFormat format;
+	size_t numSamples;
+	std::vector<uint8_t> data;
+};
+
+// test audio input that ends after the first samples of another audio input
+class TestLimitIn : public AudioIn
+{
+public:
+
+	TestLimitIn(Pointer<AudioIn> input, size_t numSamples)
+		: input(input), numSamples(numSamples) {}
+
+	virtual AudioFormat getFormat()
+	{
+		return this->input->getFormat();
+	}
+
+	virtual void close()
+	{
+	}
+
+	virtual size_t read(Buffer* buffers, size_t numSamples)
+	{
+		numSamples = this->input->read(buffers, std::min(numSamples, this->numSamples));
+		this->numSamples -= numSamples;
+		return numSamples;
+	}
+
+	Pointer<AudioIn> input;
+	size_t numSamples;
+};
+
+TEST(Audio, Converter)
+{
+	const int numSamples = 1000;
+
+	// int16 interleaved to float separate
+	{
+		AudioFormat format(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, 44100);
+		Pointer<TestSineIn> input = new TestSineIn(format, 1000.0);
+		Pointer<AudioIn> converter = new AudioInConverter(new TestSineIn(format, 1000.0),
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, 44100), 256);
+		std::vector<int16_t> expected(numSamples * 2);
+		input->readInterleaved(expected.data(), numSamples);
+		std::vector<float> left(numSamples);
+		std::vector<float> right(numSamples);
+		AudioIn::Buffer buffers[] = {left.data(), right.data()};
+		EXPECT_EQ(numSamples, int(converter->read(buffers, numSamples)));
+		for (int i = 0; i < numSamples; ++i)
+		{
+			EXPECT_FLOAT_EQ(float(expected[i * 2]) / 32767.0f, left[i]);
+			EXPECT_FLOAT_EQ(float(expected[i * 2 + 1]) / 32767.0f, right[i]);
+		}
+	}
+
+	// float separate to int16 interleaved with three output channels, the third channel stays untouched
+	{
+		AudioFormat format(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, 44100);
+		Pointer<AudioIn> converter = new AudioInConverter(new TestSineIn(format, 1000.0),
+			AudioFormat(AudioFormat::INT16, AudioFormat::INTERLEAVED, 3, 44100), 256);
+		std::vector<int16_t> samples(numSamples * 3, 12345);
+		EXPECT_EQ(numSamples, int(converter->readInterleaved(samples.data(), numSamples)));
+		TestSineIn input(format, 1000.0);
+		for (int i = 0; i < numSamples; ++i)
+		{
+			EXPECT_EQ(int(floor(input.getValue(i, 0) * 32767.0f + 0.5f)), samples[i * 3]);
+			EXPECT_EQ(int(floor(input.getValue(i, 1) * 32767.0f + 0.5f)), samples[i * 3 + 1]);
+			EXPECT_EQ(12345, samples[i * 3 + 2]);
+		}
+	}
+
+	// float values are clamped when converted to int16
+	{
+		float values[] = {-2.0f, -1.0f, 0.0f, 0.5f, 1.0f, 2.0f, 1e10f, -1e10f, 0.25f};
+		int16_t result[9];
+		convertValues(AudioFormat::FLOAT32, values, AudioFormat::INT16, result, 9);
+		int16_t expected[] = {-32767, -32767, 0, 16384, 32767, 32767, 32767, -32767, 8192};
+		for (int i = 0; i < 9; ++i)
+			EXPECT_EQ(expected[i], result[i]);
+	}
+
+	// resample sine to higher and lower sample rate
+	int rates[][2] = {{44100, 48000}, {48000, 44100}, {22050, 44100}};
+	for (int r = 0; r < 3; ++r)
+	{
+		int srcRate = rates[r][0];
+		int dstRate = rates[r][1];
+		AudioFormat format(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, srcRate);
+		Pointer<AudioIn> converter = new AudioInConverter(new TestSineIn(format, 1000.0),
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, dstRate), 256);
+		std::vector<float> left(numSamples);
+		std::vector<float> right(numSamples);
+		AudioIn::Buffer buffers[] = {left.data(), right.data()};
+		EXPECT_EQ(numSamples, int(converter->read(buffers, numSamples)));
+
+		// compare with ideal sine, skip start where the filter sees the zeros before the first sample
+		TestSineIn ideal(AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, dstRate), 1000.0);
+		float maxError = 0.0f;
+		for (int i = 32; i < numSamples; ++i)
+		{
+			maxError = std::max(maxError, std::abs(left[i] - ideal.getValue(i, 0)));
+			maxError = std::max(maxError, std::abs(right[i] - ideal.getValue(i, 1)));
+		}
+		EXPECT_LT(maxError, 2e-3f);
+	}
+
+	// resample finite input with more than 8 channels, the output continues up to the last input sample
+	for (int r = 0; r < 3; ++r)
+	{
+		int srcRate = rates[r][0];
+		int dstRate = rates[r][1];
+		const int numChannels = 10;
+		AudioFormat format(AudioFormat::FLOAT32, AudioFormat::SEPARATE, numChannels, srcRate);
+		Pointer<AudioIn> converter = new AudioInConverter(new TestLimitIn(new TestSineIn(format, 100.0), numSamples),
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::INTERLEAVED, numChannels, dstRate), 256);
+		std::vector<float> samples(numSamples * 3 * numChannels);
+		size_t expected = (size_t(numSamples) * dstRate + srcRate - 1) / srcRate;
+		EXPECT_EQ(expected, converter->readInterleaved(samples.data(), numSamples * 3));
+
+		// compare with ideal sine before the end where the filter sees the zeros after the last sample
+		TestSineIn ideal(AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, numChannels, dstRate), 100.0);
+		float maxError = 0.0f;
+		for (size_t i = 32; i < expected - 32; ++i)
+		{
+			for (int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+			{
+				float value = samples[i * numChannels + channelIndex];
+				maxError = std::max(maxError, std::abs(value - ideal.getValue(i, channelIndex)));
+			}
+		}
+		EXPECT_LT(maxError, 2e-3f);
+	}
+}
+
+TEST(Audio, ConverterBenchmark)
+{
+	const int numSamples = 44100 * 600;
+	const int bufferSize = 1024;
+	struct Conversion
+	{
+		const char* name;
+		AudioFormat srcFormat;
+		AudioFormat dstFormat;
+	};
+	Conversion conversions[] =
+	{
+		{"float separate -> int16 interleaved", AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, 44100),
+			AudioFormat(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, 44100)},
+		{"int16 interleaved -> float separate", AudioFormat(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, 44100),
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, 44100)},
+		{"int16 interleaved -> float interleaved", AudioFormat(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, 44100),
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::INTERLEAVED, 2, 44100)},
+		{"float separate 44100 -> int16 interleaved 48000",
+			AudioFormat(AudioFormat::FLOAT32, AudioFormat::SEPARATE, 2, 44100),
+			AudioFormat(AudioFormat::INT16, AudioFormat::INTERLEAVED, 2, 48000)},
+	};
+	for (int c = 0; c < 4; ++c)
+	{
+		Conversion& conversion = conversions[c];
+
+		// generate input once so that mainly the conversion is measured
+		Pointer<AudioIn> input = new TestLoopIn(new TestSineIn(conversion.srcFormat, 1000.0), bufferSize);
+		Pointer<AudioIn> converter = new AudioInConverter(input, conversion.dstFormat, bufferSize);
+		std::vector<float> output(bufferSize * 2);
+		AudioIn::Buffer buffers[] = {output.data(), output.data() + bufferSize};
+
+		int start = Timer::getMilliSeconds();
+		size_t numRead = 0;
+		while (numRead < numSamples)
+			numRead += converter->read(buffers, bufferSize);
+		int duration = std::max(Timer::getMilliSeconds() - start, 1);
+		std::cout << conversion.name << ": " << double(numRead) / (duration * 1000.0) << " Msamples/s" << std::endl;
+	}
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,19 @@
 #include "CRC32.h"
 
+// pclmulqdq folding is available on x86 and x64, selected at runtime
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define DIGI_CRC32_PCLMUL
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define DIGI_TARGET_PCLMUL
+	#else
+		#include <cpuid.h>
+		#define DIGI_TARGET_PCLMUL __attribute__((target("sse2,pclmul")))
+	#endif
+	#include <emmintrin.h>
+	#include <wmmintrin.h>
+#endif
+
 
 namespace digi {
 
@@ -51,8 +65,200 @@ static const uint32_t crcTable[256] =
 };
 
 
+namespace
+{
+	// tables for slicing-by-16. table k contains the crc of a byte followed by k zero bytes
+	struct CRCTables
+	{
+		uint32_t tables[16][256];
+		bool hasPCLMUL;
+		
+		CRCTables()
+		{
+			for (int n = 0; n < 256; ++n)
+			{
+				uint32_t crc = crcTable[n];
+				this->tables[0][n] = crc;
+				for (int k = 1; k < 16; ++k)
+				{
+					crc = (crc >> 8) ^ crcTable[crc & 0xff];
+					this->tables[k][n] = crc;
+				}
+			}
+
+			this->hasPCLMUL = false;
+		#ifdef DIGI_CRC32_PCLMUL
+			// check cpuid for sse2 (edx bit 26) and pclmulqdq (ecx bit 1)
+			#ifdef _MSC_VER
+				int info[4];
+				__cpuid(info, 1);
+				uint32_t ecx = info[2];
+				uint32_t edx = info[3];
+			#else
+				unsigned int eax, ebx, ecx = 0, edx = 0;
+				__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+			#endif
+			this->hasPCLMUL = (ecx & (1 << 1)) != 0 && (edx & (1 << 26)) != 0;
+		#endif
+		}
+	};
+	
+	CRCTables crcTables;
+
+	inline uint32_t load32(const uint8_t* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+	}
+	
+	// process buffer with slicing-by-16, crc is not inverted
+	uint32_t crcSlicing(uint32_t crc, const uint8_t* buffer, size_t count)
+	{
+		const uint32_t (*t)[256] = crcTables.tables;
+		const uint8_t* end = buffer + count;
+		
+		// process 16 bytes per iteration
+		while (end - buffer >= 16)
+		{
+			uint32_t a = load32(buffer) ^ crc;
+			uint32_t b = load32(buffer + 4);
+			uint32_t c = load32(buffer + 8);
+			uint32_t d = load32(buffer + 12);
+			crc = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24]
+				^ t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff] ^ t[8][b >> 24]
+				^ t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^ t[4][c >> 24]
+				^ t[3][d & 0xff] ^ t[2][(d >> 8) & 0xff] ^ t[1][(d >> 16) & 0xff] ^ t[0][d >> 24];
+			buffer += 16;
+		}
+		
+		// process remaining bytes
+		while (buffer != end)
+		{
+			crc = (crc >> 8) ^ crcTable[(*buffer ^ crc) & 0xff];
+			++buffer;
+		}
+		return crc;
+	}
+
+#ifdef DIGI_CRC32_PCLMUL
+	// fold constants for the reflected crc32 polynomial (see "Fast CRC Computation for Generic Polynomials Using
+	// PCLMULQDQ Instruction", Intel 2009)
+	const uint64_t k1k2[2] = {0x0154442bd4ULL, 0x01c6e41596ULL};
+	const uint64_t k3k4[2] = {0x01751997d0ULL, 0x00ccaa009eULL};
+	const uint64_t k5k0[2] = {0x0163cd6124ULL, 0x0000000000ULL};
+	const uint64_t poly[2] = {0x01db710641ULL, 0x01f7011641ULL};
+
+	// fold 128 bit value x into next 128 bits of data
+	DIGI_TARGET_PCLMUL inline __m128i fold(__m128i x, __m128i k, __m128i data)
+	{
+		__m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+		__m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+		return _mm_xor_si128(_mm_xor_si128(hi, lo), data);
+	}
+	
+	// process buffer with pclmulqdq folding. count must be at least 64 and a multiple of 16, crc is not inverted
+	DIGI_TARGET_PCLMUL uint32_t crcPCLMUL(uint32_t crc, const uint8_t* buffer, size_t count)
+	{
+		const __m128i* p = (const __m128i*)buffer;
+		
+		// fold by 4 (512 bits per iteration)
+		__m128i x1 = _mm_loadu_si128(p + 0);
+		__m128i x2 = _mm_loadu_si128(p + 1);
+		__m128i x3 = _mm_loadu_si128(p + 2);
+		__m128i x4 = _mm_loadu_si128(p + 3);
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(int(crc)));
+		p += 4;
+		count -= 64;
+		__m128i k = _mm_loadu_si128((const __m128i*)k1k2);
+		while (count >= 64)
+		{
+			x1 = fold(x1, k, _mm_loadu_si128(p + 0));
+			x2 = fold(x2, k, _mm_loadu_si128(p + 1));
+			x3 = fold(x3, k, _mm_loadu_si128(p + 2));
+			x4 = fold(x4, k, _mm_loadu_si128(p + 3));
+			p += 4;
+			count -= 64;
+		}
+		
+		// fold into 128 bits
+		k = _mm_loadu_si128((const __m128i*)k3k4);
+		x1 = fold(x1, k, x2);
+		x1 = fold(x1, k, x3);
+		x1 = fold(x1, k, x4);
+		
+		// fold remaining 16 byte blocks
+		while (count >= 16)
+		{
+			x1 = fold(x1, k, _mm_loadu_si128(p));
+			++p;
+			count -= 16;
+		}
+		
+		// fold 128 to 64 bits
+		__m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+		x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+		x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+		k = _mm_loadl_epi64((const __m128i*)k5k0);
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, mask);
+		x1 = _mm_clmulepi64_si128(x1, k, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+		
+		// barrett reduction to 32 bits
+		k = _mm_loadu_si128((const __m128i*)poly);
+		x2 = _mm_and_si128(x1, mask);
+		x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+		x2 = _mm_and_si128(x2, mask);
+		x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+		return uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+	}
+#endif
+
+	// multiply 32x32 bit matrix over gf(2) with vector
+	uint32_t gf2MatrixTimes(const uint32_t* matrix, uint32_t vector)
+	{
+		uint32_t sum = 0;
+		while (vector != 0)
+		{
+			if (vector & 1)
+				sum ^= *matrix;
+			vector >>= 1;
+			++matrix;
+		}
+		return sum;
+	}
+
+	void gf2MatrixSquare(uint32_t* square, const uint32_t* matrix)
+	{
+		for (int n = 0; n < 32; ++n)
+			square[n] = gf2MatrixTimes(matrix, matrix[n]);
+	}
+
+} // anonymous namespace
+
+
 /// function returns the hash of a buffer
 uint32_t calcCRC32(const uint8_t* buffer, size_t count, uint32_t seed)
+{
+	uint32_t crc = ~seed;
+
+#ifdef DIGI_CRC32_PCLMUL
+	// use pclmulqdq for the part that is a multiple of 16 bytes
+	if (count >= 64 && crcTables.hasPCLMUL)
+	{
+		size_t n = count & ~size_t(15);
+		crc = crcPCLMUL(crc, buffer, n);
+		buffer += n;
+		count -= n;
+	}
+#endif
+
+	crc = crcSlicing(crc, buffer, count);
+
+	return ~crc;
+}
+
+uint32_t calcCRC32Bytewise(const uint8_t* buffer, size_t count, uint32_t seed)
 {
 	uint32_t crc = ~seed;
 
@@ -64,4 +270,51 @@ uint32_t calcCRC32(const uint8_t* buffer, size_t count, uint32_t seed)
 	return ~crc;
 }
 
+uint32_t calcCRC32Slicing(const uint8_t* buffer, size_t count, uint32_t seed)
+{
+	return ~crcSlicing(~seed, buffer, count);
+}
+
+uint32_t combineCRC32(uint32_t crc1, uint32_t crc2, size_t length2)
+{
+	// same algorithm as crc32_combine() of zlib: apply length2 zero bytes to crc1 using repeated squaring of the
+	// operator matrix for one zero bit, then xor crc2
+	if (length2 == 0)
+		return crc1;
+	
+	uint32_t even[32];
+	uint32_t odd[32];
+
+	// operator for one zero bit
+	odd[0] = 0xedb88320;
+	uint32_t row = 1;
+	for (int n = 1; n < 32; ++n)
+	{
+		odd[n] = row;
+		row <<= 1;
+	}
+
+	// operator for two and four zero bits
+	gf2MatrixSquare(even, odd);
+	gf2MatrixSquare(odd, even);
+
+	// apply length2 zero bytes to crc1 (first square puts the operator for one zero byte into even)
+	do
+	{
+		gf2MatrixSquare(even, odd);
+		if (length2 & 1)
+			crc1 = gf2MatrixTimes(even, crc1);
+		length2 >>= 1;
+		if (length2 == 0)
+			break;
+
+		gf2MatrixSquare(odd, even);
+		if (length2 & 1)
+			crc1 = gf2MatrixTimes(odd, crc1);
+		length2 >>= 1;
+	} while (length2 != 0);
+
+	return crc1 ^ crc2;
+}
+
 } // namespace digi
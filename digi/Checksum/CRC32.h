@@ -11,7 +11,7 @@
 namespace digi {
 
 
-/// returns the CRC32 of a buffer
+/// returns the CRC32 of a buffer. uses pclmulqdq if available, otherwise slicing-by-16
 uint32_t calcCRC32(const uint8_t* buffer, size_t count, uint32_t seed = 0);
 inline uint32_t calcCRC32(const char* buffer, size_t count, uint32_t seed = 0)
 {
@@ -24,6 +24,16 @@ inline uint32_t calcCRC32(const std::string& s, uint32_t seed = 0)
 	return calcCRC32((const uint8_t*)s.c_str(), s.size(), seed);
 }
 
+/// returns the CRC32 of a buffer, one table lookup per byte (reference implementation)
+uint32_t calcCRC32Bytewise(const uint8_t* buffer, size_t count, uint32_t seed = 0);
+
+/// returns the CRC32 of a buffer using slicing-by-16 on any cpu
+uint32_t calcCRC32Slicing(const uint8_t* buffer, size_t count, uint32_t seed = 0);
+
+/// combine CRC32 of two consecutive buffers, crc2 must be calculated with seed 0.
+/// allows to calculate the CRC32 of a large buffer in parallel chunks
+uint32_t combineCRC32(uint32_t crc1, uint32_t crc2, size_t length2);
+
 } // namespace digi
 
 #endif
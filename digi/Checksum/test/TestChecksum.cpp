@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <vector>
+#include <ctime>
+#include <iostream>
+#include <algorithm>
+
 #include <digi/Checksum/CRC32.h>
 
 #include "InitLibraries.h"
@@ -19,6 +24,73 @@ TEST(Checksum, CRC32)
 		EXPECT_EQ(crc, 0x8C736521);
 }		
 
+TEST(Checksum, CRC32Implementations)
+{
+	std::vector<uint8_t> buffer(1000);
+	for (size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = uint8_t(i * 7 + (i >> 3));
+
+	// compare all implementations for all lengths and misalignments
+	for (size_t offset = 0; offset < 16; ++offset)
+	{
+		for (size_t count = 0; count <= 300; ++count)
+		{
+			uint32_t crc = calcCRC32Bytewise(buffer.data() + offset, count, 0x12345678);
+			EXPECT_EQ(calcCRC32Slicing(buffer.data() + offset, count, 0x12345678), crc);
+			EXPECT_EQ(calcCRC32(buffer.data() + offset, count, 0x12345678), crc);
+		}
+	}
+	EXPECT_EQ(calcCRC32("123456789", 9), 0xCBF43926);
+}
+
+TEST(Checksum, CombineCRC32)
+{
+	std::vector<uint8_t> buffer(10000);
+	for (size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = uint8_t(i * 13 + (i >> 5));
+	uint32_t crc = calcCRC32(buffer.data(), buffer.size());
+	
+	// split at various positions
+	for (size_t split = 0; split <= buffer.size(); split += 777)
+	{
+		uint32_t crc1 = calcCRC32(buffer.data(), split);
+		uint32_t crc2 = calcCRC32(buffer.data() + split, buffer.size() - split);
+		EXPECT_EQ(combineCRC32(crc1, crc2, buffer.size() - split), crc);
+	}
+	
+	// combine chunks
+	size_t chunkSize = 1024;
+	uint32_t combined = 0;
+	for (size_t i = 0; i < buffer.size(); i += chunkSize)
+	{
+		size_t count = std::min(chunkSize, buffer.size() - i);
+		combined = combineCRC32(combined, calcCRC32(buffer.data() + i, count), count);
+	}
+	EXPECT_EQ(combined, crc);
+}
+
+TEST(Checksum, CRC32Benchmark)
+{
+	std::vector<uint8_t> buffer(16 * 1024 * 1024);
+	for (size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = uint8_t(i * 7 + (i >> 11));
+	
+	const char* names[] = {"bytewise", "slicing-by-16", "calcCRC32"};
+	uint32_t (*functions[])(const uint8_t*, size_t, uint32_t) = {&calcCRC32Bytewise, &calcCRC32Slicing, &calcCRC32};
+	uint32_t crcs[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		// checksum depends only on utility, therefore measure with clock()
+		std::clock_t t1 = std::clock();
+		crcs[i] = functions[i](buffer.data(), buffer.size(), 0);
+		std::clock_t t2 = std::clock();
+		double seconds = std::max(double(t2 - t1) / CLOCKS_PER_SEC, 1e-6);
+		std::cout << names[i] << ": " << buffer.size() / seconds / (1024.0 * 1024.0) << " MB/s" << std::endl;
+	}
+	EXPECT_EQ(crcs[1], crcs[0]);
+	EXPECT_EQ(crcs[2], crcs[0]);
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
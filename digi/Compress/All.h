@@ -2,5 +2,6 @@
 #define digi_Data_All_h
 
 #include "DLZSS.h"
+#include "DlzssFrame.h"
 
 #endif
@@ -0,0 +1,49 @@
+#include <digi/Data/ReadFunctions.h>
+#include <digi/Data/DataException.h>
+
+#include "DlzssFrame.h"
+
+
+namespace digi {
+
+// DlzssFrameReader
+
+DlzssFrameReader::DlzssFrameReader(uint8_t* compressed, size_t size)
+{
+	// check header
+	if (size < DLZSS_FRAME_HEADER_SIZE || readLE<uint32_t>(compressed) != DLZSS_FRAME_MAGIC)
+		throw DataException(null, DataException::FORMAT_ERROR);
+	if (readLE<uint32_t>(compressed + 4) != DLZSS_FRAME_VERSION)
+		throw DataException(null, DataException::UNKNOWN_VERSION);
+	this->valueSize = readLE<uint32_t>(compressed + 8);
+	this->blockSize = readLE<uint32_t>(compressed + 12);
+	uint64_t numValues = readLE<uint64_t>(compressed + 16);
+	if ((this->valueSize != 1 && this->valueSize != 2 && this->valueSize != 4) || this->blockSize == 0
+		|| numValues > uint64_t(size_t(-1)))
+	{
+		throw DataException(null, DataException::DATA_CORRUPT);
+	}
+	this->numValues = size_t(numValues);
+
+	// read block index
+	size_t numBlocks = (this->numValues + this->blockSize - 1) / this->blockSize;
+	size_t dataOffset = DLZSS_FRAME_HEADER_SIZE + numBlocks * 8;
+	if (numBlocks > (size - DLZSS_FRAME_HEADER_SIZE) / 8)
+		throw DataException(null, DataException::UNEXPECTED_END_OF_DATA);
+	this->offsets.resize(numBlocks + 1);
+	this->offsets[0] = 0;
+	uint8_t* index = compressed + DLZSS_FRAME_HEADER_SIZE;
+	for (size_t i = 0; i < numBlocks; ++i)
+	{
+		uint64_t offset = readLE<uint64_t>(index + i * 8);
+		if (offset < this->offsets[i])
+			throw DataException(null, DataException::DATA_CORRUPT);
+		this->offsets[i + 1] = offset;
+	}
+	if (this->offsets[numBlocks] > size - dataOffset)
+		throw DataException(null, DataException::UNEXPECTED_END_OF_DATA);
+
+	this->blockData = compressed + dataOffset;
+}
+
+} // namespace digi
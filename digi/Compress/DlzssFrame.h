@@ -0,0 +1,234 @@
+/*
+	framed DLZSS: the input is split into blocks of values that are compressed independently. therefore the blocks
+	can be compressed and decompressed in parallel and a block index allows to decompress single blocks.
+
+	layout (little endian):
+		uint32 magic "DLZF"
+		uint32 version
+		uint32 size of values in bytes (1, 2 or 4)
+		uint32 number of values per block
+		uint64 number of values
+		uint64 end offset of each block relative to the start of the block data
+		compressed blocks
+*/
+
+#ifndef digi_Compress_DlzssFrame_h
+#define digi_Compress_DlzssFrame_h
+
+#include <vector>
+
+#include <digi/System/MemoryDevices.h>
+#include <digi/System/ThreadPool.h>
+#include <digi/Data/BufferedWriter.h>
+#include <digi/Data/WriteFunctions.h>
+
+#include "DLZSS.h"
+
+
+namespace digi {
+
+/// @addtogroup Compress
+/// @{
+
+enum
+{
+	DLZSS_FRAME_MAGIC = 0x465a4c44, // "DLZF"
+	DLZSS_FRAME_VERSION = 1,
+	DLZSS_FRAME_HEADER_SIZE = 24
+};
+
+
+// compresses one block into a separate buffer
+template <typename Value>
+class DlzssCompressTask : public ThreadTask
+{
+public:
+
+	DlzssCompressTask(const Value* data, size_t size, size_t blockSize, std::vector<std::vector<uint8_t> >& blocks)
+		: data(data), size(size), blockSize(blockSize), blocks(blocks) {}
+
+	virtual ~DlzssCompressTask() {}
+
+	virtual void run(int index)
+	{
+		size_t begin = size_t(index) * this->blockSize;
+		size_t end = std::min(begin + this->blockSize, this->size);
+
+		// the compressor modifies its input, therefore compress a copy
+		std::vector<Value> values(this->data + begin, this->data + end);
+		Pointer<MemoryDevice> dev = new MemoryDevice();
+		BufferedWriter w(dev, 16384);
+		DlzssCompressor c(w);
+		c.compress(values);
+		c.flush();
+		std::swap(this->blocks[index], dev->container);
+	}
+
+protected:
+
+	const Value* data;
+	size_t size;
+	size_t blockSize;
+	std::vector<std::vector<uint8_t> >& blocks;
+};
+
+/// compress array of 8 bit, 16 bit or 32 bit unsigned integer values into framed format. the blocks are compressed
+/// in parallel if a thread pool is given. smaller blocks allow more parallelism but lead to a lower compression ratio
+template <typename Value>
+void compressFramed(BufferedWriter& w, const Value* data, size_t size, size_t blockSize = 65536,
+	Pointer<ThreadPool> threadPool = null)
+{
+	size_t numBlocks = (size + blockSize - 1) / blockSize;
+	std::vector<std::vector<uint8_t> > blocks(numBlocks);
+
+	// compress blocks
+	DlzssCompressTask<Value> task(data, size, blockSize, blocks);
+	if (threadPool != null)
+	{
+		threadPool->run(task, int(numBlocks));
+	}
+	else
+	{
+		for (size_t i = 0; i < numBlocks; ++i)
+			task.run(int(i));
+	}
+
+	// write header
+	uint8_t header[DLZSS_FRAME_HEADER_SIZE];
+	writeLE<uint32_t>(DLZSS_FRAME_MAGIC, header + 0);
+	writeLE<uint32_t>(DLZSS_FRAME_VERSION, header + 4);
+	writeLE<uint32_t>(uint32_t(sizeof(Value)), header + 8);
+	writeLE<uint32_t>(uint32_t(blockSize), header + 12);
+	writeLE<uint64_t>(uint64_t(size), header + 16);
+	w.writeData(header, DLZSS_FRAME_HEADER_SIZE);
+
+	// write block index
+	uint64_t offset = 0;
+	for (size_t i = 0; i < numBlocks; ++i)
+	{
+		uint8_t buffer[8];
+		offset += blocks[i].size();
+		writeLE<uint64_t>(offset, buffer);
+		w.writeData(buffer, 8);
+	}
+
+	// write blocks
+	for (size_t i = 0; i < numBlocks; ++i)
+		w.writeData(blocks[i].data(), blocks[i].size());
+}
+
+template <typename Container>
+void compressFramed(BufferedWriter& w, const Container& container, size_t blockSize = 65536,
+	Pointer<ThreadPool> threadPool = null)
+{
+	compressFramed(w, container.data(), container.size(), blockSize, threadPool);
+}
+
+
+/// reader for framed DLZSS format
+class DlzssFrameReader
+{
+public:
+
+	/// constructor. the compressed data must stay valid while the reader is used.
+	/// throws DataException if the header or the block index is invalid
+	DlzssFrameReader(uint8_t* compressed, size_t size);
+
+	/// get size of values in bytes
+	int getValueSize() {return this->valueSize;}
+
+	/// get total number of values
+	size_t getNumValues() {return this->numValues;}
+
+	/// get number of values per block (last block may be shorter)
+	size_t getBlockSize() {return this->blockSize;}
+
+	/// get number of blocks
+	size_t getNumBlocks() {return this->offsets.size() - 1;}
+
+	/// get index of first value of given block
+	size_t getBlockBegin(size_t blockIndex) {return blockIndex * this->blockSize;}
+
+	/// get number of values of given block
+	size_t getBlockLength(size_t blockIndex)
+	{
+		return std::min(this->blockSize, this->numValues - blockIndex * this->blockSize);
+	}
+
+	/// decompress one block into array of getBlockLength(blockIndex) values. the type of the values must have the
+	/// same size as the compressed values
+	template <typename Value>
+	void decompressBlock(size_t blockIndex, Value* data)
+	{
+		uint64_t begin = this->offsets[blockIndex];
+		uint64_t end = this->offsets[blockIndex + 1];
+		DlzssDecompressor d(this->blockData + size_t(begin), size_t(end - begin));
+		d.decompress(data, this->getBlockLength(blockIndex));
+	}
+
+	/// decompress all blocks into array of getNumValues() values. the blocks are decompressed in parallel if a thread
+	/// pool is given
+	template <typename Value>
+	void decompress(Value* data, Pointer<ThreadPool> threadPool = null);
+
+	template <typename Container>
+	void decompress(Container& container, Pointer<ThreadPool> threadPool = null)
+	{
+		this->decompress(container.data(), threadPool);
+	}
+
+protected:
+
+	int valueSize;
+	size_t numValues;
+	size_t blockSize;
+
+	// offsets of blocks relative to blockData including end offset of last block
+	std::vector<uint64_t> offsets;
+	uint8_t* blockData;
+};
+
+
+// decompresses one block
+template <typename Value>
+class DlzssDecompressTask : public ThreadTask
+{
+public:
+
+	DlzssDecompressTask(DlzssFrameReader& reader, Value* data)
+		: reader(reader), data(data) {}
+
+	virtual ~DlzssDecompressTask() {}
+
+	virtual void run(int index)
+	{
+		this->reader.decompressBlock(index, this->data + this->reader.getBlockBegin(index));
+	}
+
+protected:
+
+	DlzssFrameReader& reader;
+	Value* data;
+};
+
+template <typename Value>
+void DlzssFrameReader::decompress(Value* data, Pointer<ThreadPool> threadPool)
+{
+	DlzssDecompressTask<Value> task(*this, data);
+	size_t numBlocks = this->getNumBlocks();
+	if (threadPool != null)
+	{
+		threadPool->run(task, int(numBlocks));
+	}
+	else
+	{
+		for (size_t i = 0; i < numBlocks; ++i)
+			task.run(int(i));
+	}
+}
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -6,9 +6,12 @@
 #include <CharLS.h>
 
 #include <digi/Utility/ArrayUtility.h>
+#include <digi/Utility/foreach.h>
 #include <digi/System/MemoryDevices.h>
 #include <digi/Data/DataWriter.h>
 #include <digi/Data/DataReader.h>
+#include <digi/Data/ReadFunctions.h>
+#include <digi/Data/WriteFunctions.h>
 
 #include "JLSCodec2.h"
 
@@ -504,6 +507,9 @@ public:
 	{
 		static std::vector<signed char> rgtableC;
 		
+		// create only once as _tableC points into the vector (tiled mode calls this before starting the threads)
+		if (!rgtableC.empty())
+			return;
 		rgtableC.reserve(256 + 2);
 
 		rgtableC.push_back(-128);	
@@ -522,6 +528,8 @@ private:
 	static signed char* _tableC;
 };
 
+signed char* JlsContext::_tableC = NULL;
+
 struct CContextRunMode 
 {
 	CContextRunMode(int a, int nRItype, int nReset) :
@@ -926,6 +934,7 @@ bool JLSCodec2::compress(UByteArray& compressedData, const uint16_t* image, int
 		w.write<uint8_t>(0xFF);
 		w.write<uint8_t>(JPEG_EOI);
 	}
+	w.flush();
 
 	return true;
 }
@@ -1203,6 +1212,211 @@ std::string JLSCodec2::getExtension()
 }
 
 
+// tiled mode
+
+static const uint32_t TILED_MAGIC = 0x54534c4a; // "JLST"
+static const uint32_t TILED_VERSION = 1;
+static const int TILED_HEADER_SIZE = 24;
+
+// compresses one stripe into a separate buffer
+class JLSCompressTask : public ThreadTask
+{
+	public:
+	
+		JLSCompressTask(JLSCodec2& codec, std::vector<UByteArray>& stripes, const uint16_t* image, int width,
+			int numLines, int stripeHeight)
+			: codec(codec), stripes(stripes), image(image), width(width), numLines(numLines),
+			stripeHeight(stripeHeight), result(true) {}
+		
+		virtual ~JLSCompressTask() {}
+		
+		virtual void run(int index)
+		{
+			int firstLine = index * this->stripeHeight;
+			int numLines = min(this->stripeHeight, this->numLines - firstLine);
+			if (!this->codec.compress(this->stripes[index], this->image + size_t(firstLine) * this->width,
+				this->width, numLines, 1))
+			{
+				this->result = false;
+			}
+		}
+		
+		JLSCodec2& codec;
+		std::vector<UByteArray>& stripes;
+		const uint16_t* image;
+		int width;
+		int numLines;
+		int stripeHeight;
+		volatile bool result;
+};
+
+// decompresses the part of one stripe that lies in the requested range of lines
+class JLSDecompressTask : public ThreadTask
+{
+	public:
+	
+		JLSDecompressTask(JLSCodec2& codec, const uint8_t* stripeData, const uint64_t* offsets, uint16_t* image,
+			int width, int numLines, int stripeHeight, int firstLine, int numRequestedLines, int firstStripe)
+			: codec(codec), stripeData(stripeData), offsets(offsets), image(image), width(width), numLines(numLines),
+			stripeHeight(stripeHeight), firstLine(firstLine), numRequestedLines(numRequestedLines),
+			firstStripe(firstStripe), result(true) {}
+		
+		virtual ~JLSDecompressTask() {}
+		
+		virtual void run(int index)
+		{
+			int stripeIndex = this->firstStripe + index;
+			int stripeBegin = stripeIndex * this->stripeHeight;
+			int stripeLines = min(this->stripeHeight, this->numLines - stripeBegin);
+			
+			// the decoder reads from a container
+			UByteArray stripe(this->stripeData + size_t(this->offsets[stripeIndex]),
+				this->stripeData + size_t(this->offsets[stripeIndex + 1]));
+			
+			// range of lines of this stripe that are requested
+			int begin = max(stripeBegin, this->firstLine);
+			int end = min(stripeBegin + stripeLines, this->firstLine + this->numRequestedLines);
+			uint16_t* dst = this->image + size_t(begin - this->firstLine) * this->width;
+			bool result;
+			if (begin == stripeBegin && end == stripeBegin + stripeLines)
+			{
+				// whole stripe: decode directly into the image
+				result = this->codec.decompress(stripe, dst, this->width, stripeLines, 1);
+			}
+			else
+			{
+				// partial stripe: decode into temp buffer and copy the requested lines
+				std::vector<uint16_t> lines(size_t(stripeLines) * this->width);
+				result = this->codec.decompress(stripe, lines.data(), this->width, stripeLines, 1);
+				std::copy(lines.begin() + size_t(begin - stripeBegin) * this->width,
+					lines.begin() + size_t(end - stripeBegin) * this->width, dst);
+			}
+			if (!result)
+				this->result = false;
+		}
+		
+		JLSCodec2& codec;
+		const uint8_t* stripeData;
+		const uint64_t* offsets;
+		uint16_t* image;
+		int width;
+		int numLines;
+		int stripeHeight;
+		int firstLine;
+		int numRequestedLines;
+		int firstStripe;
+		volatile bool result;
+};
+
+bool JLSCodec2::compressTiled(UByteArray& compressedData, const uint16_t* image, int width, int height, int depth,
+	int stripeHeight, Pointer<ThreadPool> threadPool)
+{
+	int numLines = height * depth;
+	if (stripeHeight <= 0)
+		stripeHeight = height;
+	int numStripes = (numLines + stripeHeight - 1) / stripeHeight;
+	
+	// the table is shared by all threads
+	JlsContext::CreateTableC();
+	
+	// compress stripes
+	std::vector<UByteArray> stripes(numStripes);
+	JLSCompressTask task(*this, stripes, image, width, numLines, stripeHeight);
+	if (threadPool != null)
+	{
+		threadPool->run(task, numStripes);
+	}
+	else
+	{
+		for (int i = 0; i < numStripes; ++i)
+			task.run(i);
+	}
+	if (!task.result)
+		return false;
+	
+	// header
+	size_t indexSize = (numStripes + 1) * 8;
+	compressedData.resize(TILED_HEADER_SIZE + indexSize);
+	uint8_t* header = compressedData.data();
+	writeLE<uint32_t>(TILED_MAGIC, header + 0);
+	writeLE<uint32_t>(TILED_VERSION, header + 4);
+	writeLE<uint32_t>(width, header + 8);
+	writeLE<uint32_t>(numLines, header + 12);
+	writeLE<uint32_t>(stripeHeight, header + 16);
+	writeLE<uint32_t>(numStripes, header + 20);
+
+	// offset table (relative to end of table) and stripes
+	uint64_t offset = 0;
+	for (int i = 0; i < numStripes; ++i)
+	{
+		writeLE<uint64_t>(offset, compressedData.data() + TILED_HEADER_SIZE + i * 8);
+		offset += stripes[i].size();
+	}
+	writeLE<uint64_t>(offset, compressedData.data() + TILED_HEADER_SIZE + numStripes * 8);
+	foreach (const UByteArray& stripe, stripes)
+		compressedData.insert(compressedData.end(), stripe.begin(), stripe.end());
+
+	return true;
+}
+
+bool JLSCodec2::decompressTiled(const UByteArray& compressedData, uint16_t* image, int width, int height, int depth,
+	Pointer<ThreadPool> threadPool)
+{
+	return this->decompressTiledLines(compressedData, image, width, height, depth, 0, height * depth, threadPool);
+}
+
+bool JLSCodec2::decompressTiledLines(const UByteArray& compressedData, uint16_t* image, int width, int height,
+	int depth, int firstLine, int numLines, Pointer<ThreadPool> threadPool)
+{
+	// check header
+	if (compressedData.size() < size_t(TILED_HEADER_SIZE))
+		return false;
+	uint8_t* header = (uint8_t*)compressedData.data();
+	int totalLines = height * depth;
+	int stripeHeight = readLE<uint32_t>(header + 16);
+	int numStripes = readLE<uint32_t>(header + 20);
+	if (readLE<uint32_t>(header + 0) != TILED_MAGIC || readLE<uint32_t>(header + 4) != TILED_VERSION
+		|| int(readLE<uint32_t>(header + 8)) != width || int(readLE<uint32_t>(header + 12)) != totalLines
+		|| stripeHeight <= 0 || numStripes != (totalLines + stripeHeight - 1) / stripeHeight)
+	{
+		return false;
+	}
+	if (firstLine < 0 || numLines <= 0 || firstLine + numLines > totalLines)
+		return false;
+
+	// read offset table
+	size_t dataOffset = TILED_HEADER_SIZE + size_t(numStripes + 1) * 8;
+	if (compressedData.size() < dataOffset)
+		return false;
+	std::vector<uint64_t> offsets(numStripes + 1);
+	for (int i = 0; i <= numStripes; ++i)
+	{
+		offsets[i] = readLE<uint64_t>(header + TILED_HEADER_SIZE + i * 8);
+		if ((i > 0 && offsets[i] < offsets[i - 1]) || offsets[i] > compressedData.size() - dataOffset)
+			return false;
+	}
+	
+	// the table is shared by all threads
+	JlsContext::CreateTableC();
+
+	// decompress stripes that intersect the requested lines
+	int firstStripe = firstLine / stripeHeight;
+	int endStripe = (firstLine + numLines - 1) / stripeHeight + 1;
+	JLSDecompressTask task(*this, compressedData.data() + dataOffset, offsets.data(), image, width, totalLines,
+		stripeHeight, firstLine, numLines, firstStripe);
+	if (threadPool != null)
+	{
+		threadPool->run(task, endStripe - firstStripe);
+	}
+	else
+	{
+		for (int i = 0; i < endStripe - firstStripe; ++i)
+			task.run(i);
+	}
+	return task.result;
+}
+
+
 // test code
 
 float3 hsvToRGB(float h, float s, float v)
@@ -1,6 +1,8 @@
 #ifndef JLSCodec2_h
 #define JLSCodec2_h
 
+#include <digi/System/ThreadPool.h>
+
 #include "Codec.h"
 
 // same as JLSCodec but with all necessary code extracted from CharLS
@@ -21,6 +23,19 @@ class JLSCodec2 : public Codec
 		virtual std::string getName();
 		virtual std::string getExtension();
 		
+		// tiled mode: the height * depth lines are split into stripes of stripeHeight lines (0: one stripe per slice)
+		// that are encoded independently with own context state into a container with an offset table.
+		// the stripes are encoded and decoded in parallel if a thread pool is given
+		bool compressTiled(UByteArray& compressedData, const ushort* image, int width, int height, int depth,
+			int stripeHeight = 0, Pointer<ThreadPool> threadPool = null);
+		bool decompressTiled(const UByteArray& compressedData, ushort* image, int width, int height, int depth,
+			Pointer<ThreadPool> threadPool = null);
+		
+		// decode numLines lines starting at firstLine from tiled data, only the stripes that contain these lines get
+		// decoded. use firstLine = slice * height and numLines = numSlices * height to decode a sub-volume
+		bool decompressTiledLines(const UByteArray& compressedData, ushort* image, int width, int height, int depth,
+			int firstLine, int numLines, Pointer<ThreadPool> threadPool = null);
+		
 		
 		void getQImage(uint8_t* statImage, const ushort* image, int width, int height, int depth);
 		void getkImage(uint8_t* statImage, const ushort* image, int width, int height, int depth);
@@ -6,8 +6,12 @@
 #include <digi/System/File.h>
 #include <digi/System/IOException.h>
 #include <digi/System/MemoryDevices.h>
+#include <digi/System/ThreadPool.h>
+#include <digi/System/Timer.h>
 #include <digi/Data/BufferedWriter.h>
+#include <digi/Data/DataException.h>
 #include <digi/Compress/DLZSS.h>
+#include <digi/Compress/DlzssFrame.h>
 
 #include "InitLibraries.h"
 
@@ -124,6 +128,91 @@ TEST(Compress, DlzssCompress)
 	compressRandom<uint32_t>();
 }
 
+TEST(Compress, DlzssFrame)
+{
+	// smooth values with noise, similar to vertex data
+	std::vector<uint16_t> data(100000);
+	uint32_t seed = 0;
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = uint16_t(i * 3 + (random(seed) >> 29));
+
+	Pointer<ThreadPool> threadPool = ThreadPool::create(4);
+	for (int threaded = 0; threaded < 2; ++threaded)
+	{
+		Pointer<MemoryDevice> dev = new MemoryDevice();
+		BufferedWriter w(dev);
+		compressFramed(w, data, 4096, threaded ? threadPool : null);
+		w.flush();
+
+		DlzssFrameReader reader(dev->container.data(), dev->container.size());
+		EXPECT_EQ(reader.getValueSize(), 2);
+		EXPECT_EQ(reader.getNumValues(), data.size());
+		EXPECT_EQ(reader.getNumBlocks(), (data.size() + 4095) / 4096);
+		
+		// decompress all
+		std::vector<uint16_t> data2(reader.getNumValues());
+		reader.decompress(data2, threaded ? threadPool : null);
+		EXPECT_TRUE(data2 == data);
+		
+		// random access to last block
+		size_t blockIndex = reader.getNumBlocks() - 1;
+		std::vector<uint16_t> block(reader.getBlockLength(blockIndex));
+		reader.decompressBlock(blockIndex, block.data());
+		EXPECT_TRUE(std::equal(block.begin(), block.end(), data.begin() + reader.getBlockBegin(blockIndex)));
+	}
+	
+	// invalid data
+	uint8_t invalid[32] = {};
+	EXPECT_THROW(DlzssFrameReader(invalid, 32), DataException);
+}
+
+TEST(Compress, DlzssFrameBenchmark)
+{
+	std::vector<uint16_t> data(8000000);
+	uint32_t seed = 0;
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = uint16_t((i & 0xffff) * 3 + (random(seed) >> 28));
+	double megaBytes = data.size() * sizeof(uint16_t) / (1024.0 * 1024.0);
+
+	// single stream
+	{
+		std::vector<uint16_t> copy = data;
+		Pointer<MemoryDevice> dev = new MemoryDevice();
+		BufferedWriter w(dev);
+		int t1 = Timer::getMilliSeconds();
+		DlzssCompressor c(w);
+		c.compress(copy);
+		c.flush();
+		int t2 = Timer::getMilliSeconds();
+		std::cout << "single stream: " << megaBytes / (std::max(t2 - t1, 1) * 0.001) << " MB/s, ratio "
+			<< double(data.size() * sizeof(uint16_t)) / dev->container.size() << std::endl;
+	}
+
+	// framed
+	int numThreads = ThreadPool::getNumProcessors();
+	Pointer<ThreadPool> threadPool = ThreadPool::create(numThreads);
+	for (size_t blockSize = 16384; blockSize <= 262144; blockSize *= 4)
+	{
+		Pointer<MemoryDevice> dev = new MemoryDevice();
+		BufferedWriter w(dev);
+		int t1 = Timer::getMilliSeconds();
+		compressFramed(w, data, blockSize, threadPool);
+		w.flush();
+		int t2 = Timer::getMilliSeconds();
+		
+		DlzssFrameReader reader(dev->container.data(), dev->container.size());
+		std::vector<uint16_t> data2(reader.getNumValues());
+		reader.decompress(data2, threadPool);
+		int t3 = Timer::getMilliSeconds();
+		EXPECT_TRUE(data2 == data);
+		
+		std::cout << "framed, block size " << blockSize << ", " << numThreads << " threads: compress "
+			<< megaBytes / (std::max(t2 - t1, 1) * 0.001) << " MB/s, decompress "
+			<< megaBytes / (std::max(t3 - t2, 1) * 0.001) << " MB/s, ratio "
+			<< double(data.size() * sizeof(uint16_t)) / dev->container.size() << std::endl;
+	}
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
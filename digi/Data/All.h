@@ -10,6 +10,7 @@
 #include "EbmlWriter.h"
 #include "IffReader.h"
 #include "JsonReader.h"
+#include "JsonTokenizer.h"
 #include "JsonWriter.h"
 #include "LittleEndianReader.h"
 #include "LittleEndianWriter.h"
@@ -8,19 +8,53 @@ namespace digi {
 
 BufferedReader::BufferedReader(Pointer<IODevice> dev, int bufferSize)
 	: dev(dev), bufferBegin(new uint8_t[bufferSize]), bufferEnd(bufferBegin + bufferSize),
-	begin(bufferBegin), end(bufferBegin)
+	readSize(bufferSize), initialReadSize(bufferSize), numCompleteReads(0), begin(bufferBegin), end(bufferBegin)
 {
 }	
 
 BufferedReader::BufferedReader(const fs::path& path, int bufferSize)
-	: dev(File::open(path, File::READ)), bufferBegin(new uint8_t[bufferSize]), bufferEnd(bufferBegin + bufferSize),
-	begin(bufferBegin), end(bufferBegin)
+	: dev(File::open(path, File::READ)), bufferBegin(NULL), bufferEnd(NULL),
+	readSize(bufferSize), initialReadSize(bufferSize), numCompleteReads(0), begin(NULL), end(NULL)
 {
+	// map the file into memory. this fails if the address space is too small. pipes and special files such as in
+	// /proc give an empty mapping, therefore they are read from the device as well as empty files
+	try
+	{
+		this->file = MappedFile::open(path);
+		if (this->file->size() == 0)
+			this->file = null;
+	}
+	catch (IOException&)
+	{
+	}
+	
+	if (this->file != null)
+	{
+		this->bufferBegin = this->begin = this->file->begin();
+		this->bufferEnd = this->end = this->file->end();
+	}
+	else
+	{
+		this->bufferBegin = this->begin = this->end = new uint8_t[bufferSize];
+		this->bufferEnd = this->bufferBegin + bufferSize;
+	}
 }
 
 BufferedReader::~BufferedReader()
 {
-	delete [] this->bufferBegin;
+	if (this->file == null)
+		delete [] this->bufferBegin;
+}
+
+void BufferedReader::close()
+{
+	if (this->file != null)
+	{
+		// unmap file
+		this->file = null;
+		this->bufferBegin = this->bufferEnd = this->begin = this->end = NULL;
+	}
+	this->dev->close();
 }
 
 void BufferedReader::readData(void* data, size_t numBytes)
@@ -38,23 +72,28 @@ void BufferedReader::readData(void* data, size_t numBytes)
 	if (numBytes == 0)
 		return;
 	
-	size_t bufferSize = this->bufferEnd - this->bufferBegin;
-	if (numBytes > bufferSize)
-	{
-		// read directly if still more than one buffer size to read
-		numBytes -= this->dev->read(d, numBytes);
-	}
-	else
+	// a mapped file has no more data
+	if (this->file == null)
 	{
-		// read buffer from device
-		size_t numRead = this->dev->read(this->bufferBegin, bufferSize);
-			
-		// copy data from buffer
-		size_t toCopy2 = std::min(numRead, numBytes);
-		std::copy(this->bufferBegin, this->bufferBegin + toCopy2, d);
-		this->begin = this->bufferBegin + toCopy2;
-		this->end = this->bufferBegin + numRead;
-		numBytes -= toCopy2;
+		this->growBuffer();
+		size_t bufferSize = this->bufferEnd - this->bufferBegin;
+		if (numBytes > bufferSize)
+		{
+			// read directly if still more than one buffer size to read
+			numBytes -= this->dev->read(d, numBytes);
+		}
+		else
+		{
+			// read buffer from device
+			size_t numRead = this->readDevice(this->bufferBegin, this->readSize);
+				
+			// copy data from buffer
+			size_t toCopy2 = std::min(numRead, numBytes);
+			std::copy(this->bufferBegin, this->bufferBegin + toCopy2, d);
+			this->begin = this->bufferBegin + toCopy2;
+			this->end = this->bufferBegin + numRead;
+			numBytes -= toCopy2;
+		}
 	}
 	
 	// throw exception if not enough bytes could be read
@@ -76,7 +115,12 @@ void BufferedReader::skip(size_t numBytes)
 			return;
 
 		// read buffer from device
-		size_t numRead = this->dev->read(this->bufferBegin, this->bufferEnd - this->bufferBegin);
+		size_t numRead = 0;
+		if (this->file == null)
+		{
+			this->growBuffer();
+			numRead = this->readDevice(this->bufferBegin, this->readSize);
+		}
 		if (numRead == 0)
 			throw DataException(this->dev, DataException::UNEXPECTED_END_OF_DATA);
 		this->begin = this->bufferBegin;
@@ -86,6 +130,22 @@ void BufferedReader::skip(size_t numBytes)
 
 int64_t BufferedReader::seek(int64_t position, IODevice::PositionMode mode)
 {
+	if (this->file != null)
+	{
+		// set position in mapped file
+		int64_t size = this->bufferEnd - this->bufferBegin;
+		if (mode == IODevice::CURRENT)
+			position += this->begin - this->bufferBegin;
+		else if (mode == IODevice::END)
+			position += size;
+		if (position < 0)
+			throw IOException(this->dev, IOException::SEEK_ERROR);
+		
+		// position behind the end is allowed, but reading fails there
+		this->begin = this->bufferBegin + std::min(position, size);
+		return position;
+	}
+	
 	// correct position if seek is relative to current position
 	if (mode == IODevice::CURRENT)
 		position -= this->end - this->begin;
@@ -93,11 +153,17 @@ int64_t BufferedReader::seek(int64_t position, IODevice::PositionMode mode)
 	// clear buffer
 	this->begin = this->end = this->bufferBegin;
 
+	// start with small reads again as the access may be random
+	this->readSize = std::min(this->initialReadSize, size_t(this->bufferEnd - this->bufferBegin));
+	this->numCompleteReads = 0;
+
 	return this->dev->seek(position, mode);
 }
 
 int64_t BufferedReader::getPosition()
 {
+	if (this->file != null)
+		return this->begin - this->bufferBegin;
 	return this->dev->getPosition() - int64_t(this->end - this->begin);
 }
 
@@ -113,26 +179,42 @@ void BufferedReader::readBuffer(size_t size)
 {
 	// move tail of buffer to front
 	size_t toCopy = this->end - this->begin;
-	uint8_t* begin = this->bufferBegin;
-	for (size_t i = 0; i < toCopy; ++i)
+	if (this->file == null)
 	{
-		*(begin + i) = *(this->begin + i);
+		this->growBuffer();
+		uint8_t* begin = this->bufferBegin;
+		for (size_t i = 0; i < toCopy; ++i)
+		{
+			*(begin + i) = *(this->begin + i);
+		}
+		
+		size_t numRead = this->readDevice(this->bufferBegin + toCopy,
+			std::min(this->readSize, size_t(this->bufferEnd - this->bufferBegin) - toCopy));
+		this->begin = begin;
+		this->end = begin + toCopy + numRead;
+		toCopy += numRead;
 	}
 	
-	size_t numRead = this->dev->read(this->bufferBegin + toCopy, this->bufferEnd - this->bufferBegin - toCopy);
-	this->begin = begin;
-	this->end = begin + toCopy + numRead;
-	
 	// check if enough data was read
-	if (toCopy + numRead < size)
+	if (toCopy < size)
 		throw DataException(this->dev, DataException::UNEXPECTED_END_OF_DATA);
 }
 
 size_t BufferedReader::readNextBuffer(bool noThrow)
 {
-	size_t numRead = this->dev->read(this->bufferBegin, this->bufferEnd - this->bufferBegin);	
-	this->begin = this->bufferBegin;
-	this->end = this->bufferBegin + numRead;
+	size_t numRead = 0;
+	if (this->file == null)
+	{
+		this->growBuffer();
+		numRead = this->readDevice(this->bufferBegin, this->readSize);
+		this->begin = this->bufferBegin;
+		this->end = this->bufferBegin + numRead;
+	}
+	else
+	{
+		// all data of a mapped file is in the buffer
+		this->begin = this->end;
+	}
 
 	if (!noThrow && numRead == 0)
 		throw DataException(this->dev, DataException::UNEXPECTED_END_OF_DATA);
@@ -140,4 +222,37 @@ size_t BufferedReader::readNextBuffer(bool noThrow)
 	return numRead;
 }
 
+size_t BufferedReader::readDevice(uint8_t* data, size_t size)
+{
+	size_t numRead = this->dev->read(data, size);
+	
+	// count complete reads to detect sequential reading
+	if (numRead == size && size > 0)
+		++this->numCompleteReads;
+	else
+		this->numCompleteReads = 0;
+	return numRead;
+}
+
+void BufferedReader::growBuffer()
+{
+	// grow if the device delivered complete buffers several times, i.e. it is read sequentially
+	if (this->numCompleteReads < 2 || this->readSize >= MAX_BUFFER_SIZE)
+		return;
+	this->numCompleteReads = 0;
+	size_t bufferSize = this->bufferEnd - this->bufferBegin;
+	this->readSize = std::min(this->readSize * 2, size_t(MAX_BUFFER_SIZE));
+	if (this->readSize > bufferSize)
+	{
+		// allocate larger buffer and copy valid data
+		uint8_t* buffer = new uint8_t[this->readSize];
+		std::copy(this->begin, this->end, buffer);
+		this->end = buffer + (this->end - this->begin);
+		this->begin = buffer;
+		delete [] this->bufferBegin;
+		this->bufferBegin = buffer;
+		this->bufferEnd = buffer + this->readSize;
+	}
+}
+
 } // namespace digi
@@ -3,6 +3,7 @@
 
 #include <digi/System/IODevice.h>
 #include <digi/System/FileSystem.h>
+#include <digi/System/MappedFile.h>
 
 
 namespace digi {
@@ -10,11 +11,19 @@ namespace digi {
 /// @addtogroup Data
 /// @{
 
-/// provides a buffer for accelerating read of many small data blocks
+/// provides a buffer for accelerating read of many small data blocks.
+/// a file that is opened by path is mapped into memory if possible, then the buffer is the whole file and never
+/// needs to be refilled. a device is read into a buffer that grows up to MAX_BUFFER_SIZE while it is read sequentially
 class BufferedReader
 {
 public:
 
+	enum
+	{
+		// maximum size of the buffer for devices
+		MAX_BUFFER_SIZE = 256 * 1024
+	};
+
 	BufferedReader(Pointer<IODevice> dev, int bufferSize = 1024);
 
 	BufferedReader(const fs::path& path, int bufferSize = 1024);
@@ -32,7 +41,10 @@ public:
 	//bool isEndOfInput() {return this->dev->isEndOfInput();}
 
 	/// close underlying device
-	void close() {this->dev->close();}
+	void close();
+
+	/// returns true if the file is mapped into memory
+	bool isMapped() {return this->file != null;}
 
 
 	/// read geven number of bytes
@@ -93,6 +105,12 @@ protected:
 
 	size_t readNextBuffer(bool noThrow);
 
+	// read from device and count consecutive complete reads
+	size_t readDevice(uint8_t* data, size_t size);
+
+	// grow the buffer before the next read if the device is read sequentially
+	void growBuffer();
+
 public:
 
 	/// parse a token using given parser. throws DataException::UNEXPECTED_END_OF_DATA if noThrow is false
@@ -126,10 +144,19 @@ protected:
 
 	// input device
 	Pointer<IODevice> dev;
+
+	// mapped file, null if the device is read into the buffer
+	Pointer<MappedFile> file;
 	
-	// preallocated buffer
+	// preallocated buffer or mapped file
 	uint8_t* bufferBegin;
 	uint8_t* bufferEnd;
+
+	// number of bytes to read from the device at once. grows while the device is read sequentially and gets
+	// reset by seek()
+	size_t readSize;
+	size_t initialReadSize;
+	int numCompleteReads;
 	
 	// range with valid data
 	uint8_t* begin;
@@ -0,0 +1,590 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include <digi/Utility/lexicalCast.h>
+#include <digi/Utility/UtfTranscode.h>
+
+#include "JsonTokenizer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+	#define DIGI_JSON_SSE2
+#endif
+
+
+namespace digi {
+
+namespace
+{
+	// powers of ten that are exact in double precision
+	const double powersOf10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline bool isDigit(char ch)
+	{
+		return uint8_t(ch - '0') < 10;
+	}
+
+	// parse 4 hex digits, returns -1 on error
+	int32_t parseHex4(const char*& it, const char* end)
+	{
+		if (end - it < 4)
+			return -1;
+		int32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			char ch = *it++;
+			value <<= 4;
+			if (ch >= '0' && ch <= '9')
+				value |= ch - '0';
+			else if (ch >= 'a' && ch <= 'f')
+				value |= ch - 'a' + 10;
+			else if (ch >= 'A' && ch <= 'F')
+				value |= ch - 'A' + 10;
+			else
+				return -1;
+		}
+		return value;
+	}
+
+#ifdef DIGI_JSON_SSE2
+	inline int getFirstBit(int mask)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return int(index);
+	#else
+		return __builtin_ctz(mask);
+	#endif
+	}
+#endif
+
+	// find next '"' or '\\'. returns end if not found
+	inline const char* findQuoteOrBackslash(const char* it, const char* end)
+	{
+	#ifdef DIGI_JSON_SSE2
+		// compare 16 characters at once
+		__m128i quote = _mm_set1_epi8('"');
+		__m128i backslash = _mm_set1_epi8('\\');
+		while (end - it >= 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)it);
+			int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+			if (mask != 0)
+				return it + getFirstBit(mask);
+			it += 16;
+		}
+	#endif
+		while (it < end && *it != '"' && *it != '\\')
+			++it;
+		return it;
+	}
+
+	// find next '"', '{', '}', '[' or ']'. returns end if not found
+	inline const char* findStructural(const char* it, const char* end)
+	{
+	#ifdef DIGI_JSON_SSE2
+		__m128i quote = _mm_set1_epi8('"');
+		__m128i beginStruct = _mm_set1_epi8('{');
+		__m128i endStruct = _mm_set1_epi8('}');
+		__m128i beginArray = _mm_set1_epi8('[');
+		__m128i endArray = _mm_set1_epi8(']');
+		while (end - it >= 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)it);
+			__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, beginStruct), _mm_cmpeq_epi8(v, endStruct)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, beginArray), _mm_cmpeq_epi8(v, endArray)));
+			int mask = _mm_movemask_epi8(_mm_or_si128(m, _mm_cmpeq_epi8(v, quote)));
+			if (mask != 0)
+				return it + getFirstBit(mask);
+			it += 16;
+		}
+	#endif
+		while (it < end && *it != '"' && *it != '{' && *it != '}' && *it != '[' && *it != ']')
+			++it;
+		return it;
+	}
+
+} // anonymous namespace
+
+
+// JsonTokenizer
+
+JsonTokenizer::JsonTokenizer(const char* data, size_t size)
+{
+	this->begin = data;
+	this->end = data + size;
+	this->init();
+}
+
+JsonTokenizer::JsonTokenizer(Pointer<MappedFile> file)
+	: file(file)
+{
+	this->begin = (const char*)file->data();
+	this->end = this->begin + file->size();
+	this->init();
+}
+
+void JsonTokenizer::init()
+{
+	this->it = this->begin;
+	this->state = STATE_INITIAL;
+	this->integer = false;
+	this->doubleValue = 0.0;
+	this->int64Value = 0;
+}
+
+JsonTokenizer::Token JsonTokenizer::read()
+{
+	switch (this->state)
+	{
+	case STATE_ARRAY_END:
+		// ',' or ']' is next
+		this->skipWhiteSpace();
+		if (this->it == this->end)
+			this->error(DataException::UNEXPECTED_END_OF_DATA);
+		if (*this->it == ']')
+		{
+			++this->it;
+			return this->endContainer(END_ARRAY);
+		}
+		if (*this->it != ',')
+			this->error(DataException::DATA_CORRUPT);
+		++this->it;
+		this->state = STATE_ELEMENT;
+
+		// parse next value
+		// fall through
+	case STATE_ELEMENT:
+		// value or ']' is next
+		this->skipWhiteSpace();
+		if (this->it < this->end && *this->it == ']')
+		{
+			++this->it;
+			return this->endContainer(END_ARRAY);
+		}
+		this->state = STATE_ARRAY_VALUE;
+		return ELEMENT;
+
+	case STATE_INITIAL:
+		// skip utf-8 bom
+		if (this->end - this->it >= 3 && memcmp(this->it, "\xEF\xBB\xBF", 3) == 0)
+			this->it += 3;
+		this->state = STATE_STRUCT_VALUE;
+		// fall through
+	case STATE_ARRAY_VALUE:
+	case STATE_STRUCT_VALUE:
+		// value (number, string, array or struct) is next
+		this->skipWhiteSpace();
+		if (this->it == this->end)
+			this->error(DataException::UNEXPECTED_END_OF_DATA);
+
+		// STATE_STRUCT_VALUE -> STATE_STRUCT_END
+		// STATE_ARRAY_VALUE -> STATE_ARRAY_END
+		this->state = State(this->state + 1);
+
+		switch (*this->it)
+		{
+		case '{':
+			++this->it;
+			this->states.push_back(this->state);
+			this->state = STATE_ATTRIBUTE;
+			return BEGIN_STRUCT;
+		case '[':
+			++this->it;
+			this->states.push_back(this->state);
+			this->state = STATE_ELEMENT;
+			return BEGIN_ARRAY;
+		case '"':
+			++this->it;
+			this->parseString();
+			return STRING;
+		case 'f':
+			if (this->parseKeyword("false", 5))
+				return BOOLEAN;
+			break;
+		case 't':
+			if (this->parseKeyword("true", 4))
+				return BOOLEAN;
+			break;
+		case 'n':
+			if (this->parseKeyword("null", 4))
+				return NULL_VALUE;
+			break;
+		default:
+			if (*this->it == '-' || isDigit(*this->it))
+			{
+				this->parseNumber();
+				return NUMBER;
+			}
+		}
+
+		// parse error
+		this->error(DataException::DATA_CORRUPT);
+		break;
+
+	case STATE_STRUCT_END:
+		// ',' or '}' is next
+		this->skipWhiteSpace();
+		if (this->it == this->end)
+			this->error(DataException::UNEXPECTED_END_OF_DATA);
+		if (*this->it == '}')
+		{
+			++this->it;
+			return this->endContainer(END_STRUCT);
+		}
+		if (*this->it != ',')
+			this->error(DataException::DATA_CORRUPT);
+		++this->it;
+		this->state = STATE_ATTRIBUTE;
+
+		// parse next attribute
+		// fall through
+	case STATE_ATTRIBUTE:
+		// '}' or quoted attribute name is next
+		this->skipWhiteSpace();
+		if (this->it < this->end && *this->it == '}')
+		{
+			++this->it;
+			return this->endContainer(END_STRUCT);
+		}
+		if (this->it == this->end || *this->it != '"')
+			this->error(DataException::DATA_CORRUPT);
+		++this->it;
+		this->parseString();
+
+		// parse ':'
+		this->skipWhiteSpace();
+		if (this->it == this->end || *this->it != ':')
+			this->error(DataException::DATA_CORRUPT);
+		++this->it;
+
+		this->state = STATE_STRUCT_VALUE;
+		return ATTRIBUTE;
+	}
+
+	// should never be reached
+	return NULL_VALUE;
+}
+
+double JsonTokenizer::readDouble()
+{
+	if (this->read() != NUMBER)
+		this->error(DataException::BAD_VALUE);
+	return this->doubleValue;
+}
+
+int64_t JsonTokenizer::readInt64()
+{
+	if (this->read() != NUMBER || !this->integer)
+		this->error(DataException::BAD_VALUE);
+	return this->int64Value;
+}
+
+StringRef JsonTokenizer::readString()
+{
+	if (this->read() != STRING)
+		this->error(DataException::BAD_VALUE);
+	return this->value;
+}
+
+bool JsonTokenizer::readBool()
+{
+	if (this->read() != BOOLEAN)
+		this->error(DataException::BAD_VALUE);
+	return this->value.length() == 4;
+}
+
+void JsonTokenizer::skipValue(Token token)
+{
+	if (token != BEGIN_STRUCT && token != BEGIN_ARRAY)
+		return;
+
+	// skip to the matching closing bracket without tokenizing the content
+	const char* it = this->it;
+	int depth = 1;
+	while (true)
+	{
+		it = findStructural(it, this->end);
+		if (it == this->end)
+			break;
+		char ch = *it++;
+		if (ch == '"')
+		{
+			// skip string
+			while (true)
+			{
+				it = findQuoteOrBackslash(it, this->end);
+				if (it == this->end)
+					break;
+				if (*it == '"')
+				{
+					++it;
+					break;
+				}
+
+				// skip escaped character
+				it = std::min(it + 2, this->end);
+			}
+		}
+		else if (ch == '{' || ch == '[')
+		{
+			++depth;
+		}
+		else if (--depth == 0)
+		{
+			this->it = it;
+			this->endContainer(token == BEGIN_STRUCT ? END_STRUCT : END_ARRAY);
+			return;
+		}
+	}
+	this->it = it;
+	this->error(DataException::UNEXPECTED_END_OF_DATA);
+}
+
+int JsonTokenizer::getLineIndex()
+{
+	return int(std::count(this->begin, this->it, '\n')) + 1;
+}
+
+void JsonTokenizer::parseString()
+{
+	// fast path: string without escape sequences is returned without copying
+	const char* start = this->it;
+	const char* it = findQuoteOrBackslash(start, this->end);
+	if (it == this->end)
+		this->error(DataException::UNEXPECTED_END_OF_DATA);
+	if (*it == '"')
+	{
+		this->value = StringRef(start, it - start);
+		this->it = it + 1;
+		return;
+	}
+
+	// replace escape sequences in buffer
+	this->buffer.assign(start, it);
+	while (*it == '\\')
+	{
+		// skip backslash
+		++it;
+		if (it == this->end)
+			break;
+		char ch = *it++;
+		switch (ch)
+		{
+		case 'b':
+			this->buffer += '\b';
+			break;
+		case 'f':
+			this->buffer += '\f';
+			break;
+		case 'n':
+			this->buffer += '\n';
+			break;
+		case 'r':
+			this->buffer += '\r';
+			break;
+		case 't':
+			this->buffer += '\t';
+			break;
+		case 'u':
+			{
+				int32_t c = parseHex4(it, this->end);
+				if (c < 0)
+				{
+					this->it = it;
+					this->error(DataException::DATA_CORRUPT);
+				}
+
+				// combine surrogate pair
+				if (c >= 0xD800 && c < 0xDC00 && this->end - it >= 6 && it[0] == '\\' && it[1] == 'u')
+				{
+					const char* low = it + 2;
+					int32_t c2 = parseHex4(low, this->end);
+					if (c2 >= 0xDC00 && c2 < 0xE000)
+					{
+						c = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+						it = low;
+					}
+				}
+
+				// encode as utf-8
+				char utf8[8];
+				char* u = utf8;
+				UtfEncoder<1> encode;
+				encode(u, c);
+				this->buffer.append(utf8, u);
+			}
+			break;
+		default:
+			// '"', '\\', '/'
+			this->buffer += ch;
+		}
+
+		// copy up to next quote or backslash
+		const char* next = findQuoteOrBackslash(it, this->end);
+		this->buffer.append(it, next);
+		it = next;
+		if (it == this->end)
+			break;
+	}
+	this->it = it;
+	if (it == this->end)
+		this->error(DataException::UNEXPECTED_END_OF_DATA);
+
+	// skip closing quote
+	++this->it;
+	this->value = StringRef(this->buffer);
+}
+
+void JsonTokenizer::parseNumber()
+{
+	const char* start = this->it;
+	const char* it = start;
+	const char* end = this->end;
+
+	bool negative = *it == '-';
+	if (negative)
+		++it;
+
+	// integer part. all digits are accumulated into the mantissa which is exact for up to 19 digits
+	uint64_t mantissa = 0;
+	const char* digitsBegin = it;
+	while (it < end && isDigit(*it))
+	{
+		mantissa = mantissa * 10 + (*it - '0');
+		++it;
+	}
+	int numDigits = int(it - digitsBegin);
+	if (numDigits == 0)
+	{
+		this->it = it;
+		this->error(DataException::DATA_CORRUPT);
+	}
+	int exponent = 0;
+	bool integer = true;
+
+	// fraction
+	if (it < end && *it == '.')
+	{
+		integer = false;
+		++it;
+		const char* fractionBegin = it;
+		while (it < end && isDigit(*it))
+		{
+			mantissa = mantissa * 10 + (*it - '0');
+			++it;
+		}
+		int numFractionDigits = int(it - fractionBegin);
+		if (numFractionDigits == 0)
+		{
+			this->it = it;
+			this->error(DataException::DATA_CORRUPT);
+		}
+		numDigits += numFractionDigits;
+		exponent -= numFractionDigits;
+	}
+
+	// exponent
+	if (it < end && (*it == 'e' || *it == 'E'))
+	{
+		integer = false;
+		++it;
+		bool negativeExponent = false;
+		if (it < end && (*it == '+' || *it == '-'))
+		{
+			negativeExponent = *it == '-';
+			++it;
+		}
+		const char* exponentBegin = it;
+		int e = 0;
+		while (it < end && isDigit(*it))
+		{
+			if (e < 100000)
+				e = e * 10 + (*it - '0');
+			++it;
+		}
+		if (it == exponentBegin)
+		{
+			this->it = it;
+			this->error(DataException::DATA_CORRUPT);
+		}
+		exponent += negativeExponent ? -e : e;
+	}
+
+	this->it = it;
+	this->value = StringRef(start, it - start);
+	this->integer = false;
+	this->int64Value = 0;
+
+	if (numDigits <= 19)
+	{
+		if (integer)
+		{
+			// integer if it fits into int64_t
+			const uint64_t limit = uint64_t(1) << 63;
+			if (negative ? mantissa <= limit : mantissa < limit)
+			{
+				this->integer = true;
+				this->int64Value = negative ? int64_t(0 - mantissa) : int64_t(mantissa);
+			}
+			double d = double(mantissa);
+			this->doubleValue = negative ? -d : d;
+			return;
+		}
+
+		// fast path: mantissa and power of ten are exact in double precision, therefore one multiplication or
+		// division gives a correctly rounded result
+		if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+		{
+			double d = double(mantissa);
+			d = exponent < 0 ? d / powersOf10[-exponent] : d * powersOf10[exponent];
+			this->doubleValue = negative ? -d : d;
+			return;
+		}
+	}
+
+	// slow path for numbers with many digits or large exponent
+	try
+	{
+		this->doubleValue = lexicalCast<double>(std::string(start, it));
+	}
+	catch (boost::bad_lexical_cast&)
+	{
+		this->error(DataException::BAD_VALUE);
+	}
+}
+
+bool JsonTokenizer::parseKeyword(const char* keyword, size_t length)
+{
+	if (size_t(this->end - this->it) < length || memcmp(this->it, keyword, length) != 0)
+		return false;
+	this->value = StringRef(this->it, length);
+	this->it += length;
+	return true;
+}
+
+JsonTokenizer::Token JsonTokenizer::endContainer(Token token)
+{
+	if (this->states.empty())
+		this->error(DataException::DATA_INCONSISTENT);
+	this->state = this->states.back();
+	this->states.pop_back();
+	return token;
+}
+
+void JsonTokenizer::error(DataException::Reason reason)
+{
+	throw TextDataException(null, reason, this->getLineIndex());
+}
+
+} // namespace digi
@@ -0,0 +1,171 @@
+#ifndef digi_Data_JsonTokenizer_h
+#define digi_Data_JsonTokenizer_h
+
+#include <string>
+#include <vector>
+
+#include <digi/Utility/StringRef.h>
+#include <digi/System/MappedFile.h>
+
+#include "DataException.h"
+
+
+namespace digi {
+
+/// @addtogroup Data
+/// @{
+
+/**
+	SAX style JSON tokenizer for large files. works on data in memory (e.g. a MappedFile) and returns the tokens in
+	the same order as JsonReader. strings are returned as StringRef into the data without copying, only strings
+	that contain escape sequences are copied. numbers are parsed directly into double and int64_t.
+	errors are reported with TextDataException
+*/
+class JsonTokenizer
+{
+public:
+	enum Token
+	{
+		BEGIN_STRUCT,
+		END_STRUCT,
+		BEGIN_ARRAY,
+		END_ARRAY,
+
+		// attribute was read, use getValue() to get the attribute name
+		ATTRIBUTE,
+
+		// array element was read
+		ELEMENT,
+
+		// a number was read, use getDouble(), getInt64() or getValue()
+		NUMBER,
+
+		// a string was read, use getValue()
+		STRING,
+
+		// a boolean was read, use getBool()
+		BOOLEAN,
+
+		// a null value was read
+		NULL_VALUE
+	};
+
+	/// constructor. the data must stay valid while the tokenizer is used
+	JsonTokenizer(const char* data, size_t size);
+
+	/// constructor. keeps the mapped file alive
+	JsonTokenizer(Pointer<MappedFile> file);
+
+
+	/// read next element and return its type. then use getValue()
+	Token read();
+
+	/// read the next element and check if it is a number. if not DataException::BAD_VALUE is thrown
+	double readDouble();
+
+	/// read the next element and check if it is an integer number. if not DataException::BAD_VALUE is thrown
+	int64_t readInt64();
+
+	/// read the next element and check if it is a string. if not DataException::BAD_VALUE is thrown
+	StringRef readString();
+
+	/// read the next element and check if it is a bool. if not DataException::BAD_VALUE is thrown
+	bool readBool();
+
+
+	/// get value of element that was last read. only valid until the next call of read()
+	StringRef getValue() {return this->value;}
+
+	/// get bool value if the last read value was BOOLEAN
+	bool getBool() {return this->value.length() == 4;}
+
+	/// returns true if the last read number has no fraction and exponent and fits into int64_t
+	bool isInteger() {return this->integer;}
+
+	/// get value of last read number as double
+	double getDouble() {return this->doubleValue;}
+
+	/// get value of last read number as int64_t. only valid if isInteger() is true
+	int64_t getInt64() {return this->int64Value;}
+
+
+	/// skips the next value past its end
+	void skipValue() {this->skipValue(this->read());}
+
+	/// skips the current value past its end. structs and arrays are skipped by only scanning for brackets and quotes
+	void skipValue(Token token);
+
+
+	/// get current line index. counts the lines up to the current position, therefore intended for error messages
+	int getLineIndex();
+
+	/// get current position in the data
+	size_t getPosition() {return this->it - this->begin;}
+
+	/// set position in data and reset parser state
+	void setPosition(size_t position)
+	{
+		this->it = this->begin + position;
+		this->state = STATE_STRUCT_VALUE;
+		this->states.clear();
+	}
+
+protected:
+
+	void init();
+
+	void skipWhiteSpace()
+	{
+		while (this->it < this->end && uint8_t(*this->it) <= 32)
+			++this->it;
+	}
+
+	// parse string after opening quote
+	void parseString();
+
+	// parse number
+	void parseNumber();
+
+	// parse a keyword (false, true, null)
+	bool parseKeyword(const char* keyword, size_t length);
+
+	// restore the state of the enclosing struct or array
+	Token endContainer(Token token);
+
+	void error(DataException::Reason reason);
+
+	enum State
+	{
+		STATE_INITIAL,
+
+		STATE_ATTRIBUTE,
+		STATE_STRUCT_VALUE,
+		STATE_STRUCT_END = STATE_STRUCT_VALUE + 1,
+
+		STATE_ELEMENT,
+		STATE_ARRAY_VALUE,
+		STATE_ARRAY_END = STATE_ARRAY_VALUE + 1,
+	};
+
+	Pointer<MappedFile> file;
+	const char* begin;
+	const char* it;
+	const char* end;
+
+	State state;
+	std::vector<State> states;
+
+	StringRef value;
+	bool integer;
+	double doubleValue;
+	int64_t int64Value;
+
+	// buffer for strings that contain escape sequences
+	std::string buffer;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
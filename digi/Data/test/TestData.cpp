@@ -1,15 +1,21 @@
+#include <iostream>
+#include <limits>
+
 #include <gtest/gtest.h>
 
 #include <digi/Base/VersionInfo.h>
 #include <digi/Utility/lexicalCast.h>
 #include <digi/System/File.h>
 #include <digi/System/IOException.h>
+#include <digi/System/MappedFile.h>
+#include <digi/System/Timer.h>
 #include <digi/Data/DataException.h>
 #include <digi/Data/DataWriter.h>
 #include <digi/Data/DataReader.h>
 #include <digi/Data/EbmlReader.h>
 #include <digi/Data/EbmlWriter.h>
 #include <digi/Data/JsonReader.h>
+#include <digi/Data/JsonTokenizer.h>
 #include <digi/Data/JsonWriter.h>
 #include <digi/Data/ReadHelper.h>
 #include <digi/Data/TextReader.h>
@@ -174,6 +180,125 @@ TEST(Data, DataReaderWriter)
 	}
 }
 
+void helperTestBufferedReader(DataReader& r, int numValues)
+{
+	// read sequentially
+	bool ok = true;
+	for (int i = 0; i < numValues / 2; ++i)
+		ok &= r.read<uint32_t>() == uint32_t(i);
+	EXPECT_TRUE(ok);
+	EXPECT_EQ(r.getPosition(), numValues / 2 * 4);
+
+	// skip and seek
+	r.skip(400);
+	EXPECT_EQ(r.read<uint32_t>(), uint32_t(numValues / 2 + 100));
+	EXPECT_EQ(r.seek(-8, IODevice::CURRENT), numValues / 2 * 4 + 396);
+	EXPECT_EQ(r.read<uint32_t>(), uint32_t(numValues / 2 + 99));
+	EXPECT_EQ(r.seek(-4, IODevice::END), numValues * 4 - 4);
+	EXPECT_EQ(r.read<uint32_t>(), uint32_t(numValues - 1));
+	r.setPosition(40);
+	uint32_t values[3];
+	r.readData(values, 12);
+	EXPECT_EQ(values[2], 12);
+
+	// read past end
+	r.setPosition(numValues * 4 - 2);
+	try
+	{
+		r.read<uint32_t>();
+		EXPECT_TRUE(false) << "no exception was thrown";
+	}
+	catch (DataException& e)
+	{
+		EXPECT_EQ(e.getReason(), DataException::UNEXPECTED_END_OF_DATA);
+	}
+	r.close();
+}
+
+TEST(Data, BufferedReader)
+{
+	// write 1M 32 bit values
+	const int numValues = 1000000;
+	{
+		DataWriter w("buffered.bin");
+		for (int i = 0; i < numValues; ++i)
+			w.write<uint32_t>(i);
+		w.close();
+	}
+
+	// a file that is opened by path is mapped
+	{
+		DataReader r("buffered.bin");
+		EXPECT_TRUE(r.isMapped());
+		helperTestBufferedReader(r, numValues);
+	}
+	
+	// a device is read into a growing buffer
+	{
+		DataReader r(File::open("buffered.bin", File::READ));
+		EXPECT_FALSE(r.isMapped());
+		helperTestBufferedReader(r, numValues);
+	}
+
+#ifdef __linux__
+	// a special file has no size, therefore it is read from the device
+	{
+		DataReader r("/proc/self/status");
+		EXPECT_FALSE(r.isMapped());
+		char name[5];
+		r.readData(name, 5);
+		EXPECT_EQ(std::string(name, 5), "Name:");
+		r.close();
+	}
+#endif
+}
+
+uint32_t helperSumValues(DataReader& r, int numValues)
+{
+	uint32_t sum = 0;
+	for (int i = 0; i < numValues; ++i)
+		sum += r.read<uint32_t>();
+	r.close();
+	return sum;
+}
+
+TEST(Data, BufferedReaderBenchmark)
+{
+	// write 64MB
+	const int numValues = 16 * 1024 * 1024;
+	{
+		DataWriter w("benchmark.bin");
+		for (int i = 0; i < numValues; ++i)
+			w.write<uint32_t>(i);
+		w.close();
+	}
+	double size = double(numValues) * 4.0 / 1000000.0;
+	uint32_t sum = uint32_t(uint64_t(numValues) * (numValues - 1) / 2);
+
+	int t1 = Timer::getMilliSeconds();
+	{
+		DataReader r("benchmark.bin");
+		EXPECT_EQ(helperSumValues(r, numValues), sum);
+	}
+	int t2 = Timer::getMilliSeconds();
+	{
+		DataReader r(File::open("benchmark.bin", File::READ));
+		EXPECT_EQ(helperSumValues(r, numValues), sum);
+	}
+	int t3 = Timer::getMilliSeconds();
+	{
+		// device with maximum buffer size from the start
+		DataReader r(File::open("benchmark.bin", File::READ), false, BufferedReader::MAX_BUFFER_SIZE);
+		EXPECT_EQ(helperSumValues(r, numValues), sum);
+	}
+	int t4 = Timer::getMilliSeconds();
+
+	std::cout << "mapped file: " << size * 1000.0 / std::max(t2 - t1, 1) << " MB/s" << std::endl;
+	std::cout << "device: " << size * 1000.0 / std::max(t3 - t2, 1) << " MB/s" << std::endl;
+	std::cout << "device with " << BufferedReader::MAX_BUFFER_SIZE << " byte buffer: "
+		<< size * 1000.0 / std::max(t4 - t3, 1) << " MB/s" << std::endl;
+}
+
 TEST(Data, EBMLReaderWriter)
 {
 	EXPECT_EQ(EbmlWriter::calcSizeVarInt(0), 1);
@@ -353,6 +478,217 @@ TEST(Data, JSONReaderWriter)
 	}
 }
 
+TEST(Data, JsonTokenizer)
+{
+	const char json[] = "\xEF\xBB\xBF{\"a\": 55, \"b\": \"abc\\tdef\\nxyz\\\"\\\\\", \"c\": {},\n"
+		"\"d\": [\"xyz\", -1.5e3, 0.125], \"e\": [{}], \"f\": {\"x\": false, \"y\": true, \"z\": null},\n"
+		"\"u\": \"\\u00e4\\ud83d\\ude00\",\n"
+		"\"n\": [-9223372036854775808, 12345678901234567890, 1.7976931348623157e308, 3.141592653589793]}";
+	size_t length = sizeof(json) - 1;
+	JsonTokenizer t(json, length);
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_STRUCT);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "a");
+	EXPECT_EQ(t.read(), JsonTokenizer::NUMBER);
+	EXPECT_EQ(t.getValue(), "55");
+	EXPECT_TRUE(t.isInteger());
+	EXPECT_EQ(t.getInt64(), 55);
+	EXPECT_EQ(t.getDouble(), 55.0);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "b");
+	EXPECT_EQ(t.read(), JsonTokenizer::STRING);
+	EXPECT_EQ(t.getValue(), "abc\tdef\nxyz\"\\");
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "c");
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_STRUCT);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_STRUCT);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "d");
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_ARRAY);
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.read(), JsonTokenizer::STRING);
+	EXPECT_EQ(t.getValue(), "xyz");
+	
+	// string without escape sequences points into the data
+	EXPECT_TRUE(t.getValue().data() > json && t.getValue().data() < json + length);
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readDouble(), -1500.0);
+	EXPECT_FALSE(t.isInteger());
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readDouble(), 0.125);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_ARRAY);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "e");
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_ARRAY);
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_STRUCT);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_STRUCT);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_ARRAY);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "f");
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_STRUCT);
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "x");
+	EXPECT_EQ(t.readBool(), false);
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "y");
+	EXPECT_EQ(t.readBool(), true);
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "z");
+	EXPECT_EQ(t.read(), JsonTokenizer::NULL_VALUE);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_STRUCT);
+
+	// unicode escape sequences including a surrogate pair are converted to utf-8
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "u");
+	EXPECT_EQ(t.readString(), "\xC3\xA4\xF0\x9F\x98\x80");
+
+	EXPECT_EQ(t.read(), JsonTokenizer::ATTRIBUTE);
+	EXPECT_EQ(t.getValue(), "n");
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_ARRAY);
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readInt64(), std::numeric_limits<int64_t>::min());
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readDouble(), 12345678901234567890.0);
+	EXPECT_FALSE(t.isInteger());
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readDouble(), std::numeric_limits<double>::max());
+	EXPECT_EQ(t.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(t.readDouble(), 3.141592653589793);
+	EXPECT_EQ(t.read(), JsonTokenizer::END_ARRAY);
+
+	EXPECT_EQ(t.read(), JsonTokenizer::END_STRUCT);
+	EXPECT_EQ(t.getPosition(), length);
+
+	// skip attribute values
+	t.setPosition(3);
+	EXPECT_EQ(t.read(), JsonTokenizer::BEGIN_STRUCT);
+	int numAttributes = 0;
+	while (t.read() == JsonTokenizer::ATTRIBUTE)
+	{
+		t.skipValue();
+		++numAttributes;
+	}
+	EXPECT_EQ(numAttributes, 8);
+	
+	// skip everything
+	t.setPosition(3);
+	t.skipValue();
+	EXPECT_EQ(t.getPosition(), length);
+
+	// parse error with line index
+	const char error[] = "{\"a\":\n tru}";
+	JsonTokenizer e(error, sizeof(error) - 1);
+	EXPECT_EQ(e.read(), JsonTokenizer::BEGIN_STRUCT);
+	EXPECT_EQ(e.read(), JsonTokenizer::ATTRIBUTE);
+	try
+	{
+		e.read();
+		EXPECT_TRUE(false) << "no exception was thrown";
+	}
+	catch (TextDataException& e)
+	{
+		EXPECT_EQ(e.getReason(), DataException::DATA_CORRUPT);
+		EXPECT_EQ(e.getLineIndex(), 2);
+	}
+
+	// unexpected end
+	const char end[] = "[1, \"abc";
+	JsonTokenizer u(end, sizeof(end) - 1);
+	EXPECT_EQ(u.read(), JsonTokenizer::BEGIN_ARRAY);
+	EXPECT_EQ(u.read(), JsonTokenizer::ELEMENT);
+	EXPECT_EQ(u.readInt64(), 1);
+	EXPECT_EQ(u.read(), JsonTokenizer::ELEMENT);
+	try
+	{
+		u.read();
+		EXPECT_TRUE(false) << "no exception was thrown";
+	}
+	catch (DataException& e)
+	{
+		EXPECT_EQ(e.getReason(), DataException::UNEXPECTED_END_OF_DATA);
+	}
+}
+
+TEST(Data, JsonTokenizerBenchmark)
+{
+	// write json with scene nodes
+	const int numNodes = 200000;
+	{
+		JsonWriter w("benchmark.json");
+		w.beginArray();
+		for (int i = 0; i < numNodes; ++i)
+		{
+			w.beginStruct();
+			w.writeAttribute("name");
+			w.writeString("node" + lexicalCast<std::string>(i));
+			w.writeAttribute("id");
+			w.writeNumber(lexicalCast<std::string>(i));
+			w.writeAttribute("position");
+			w.beginArray();
+			w.writeNumber(lexicalCast<std::string>(i * 0.5));
+			w.writeNumber("2.25");
+			w.writeNumber("3.125e2");
+			w.endArray();
+			w.writeAttribute("visible");
+			w.writeBool(true);
+			w.endStruct();
+		}
+		w.endArray();
+		w.close();
+	}
+	
+	// read with JsonReader
+	double sum1 = 0;
+	int t1 = Timer::getMilliSeconds();
+	{
+		JsonReader r("benchmark.json");
+		JsonReader::Token token;
+		while (true)
+		{
+			try
+			{
+				token = r.read();
+			}
+			catch (DataException&)
+			{
+				// JsonReader has no end token
+				break;
+			}
+			if (token == JsonReader::NUMBER)
+				sum1 += lexicalCast<double>(r.getValue());
+		}
+		r.close();
+	}
+
+	// read with JsonTokenizer
+	Pointer<MappedFile> file = MappedFile::open("benchmark.json");
+	double sum2 = 0;
+	int t2 = Timer::getMilliSeconds();
+	{
+		JsonTokenizer t(file);
+		JsonTokenizer::Token token;
+		do
+		{
+			token = t.read();
+			if (token == JsonTokenizer::NUMBER)
+				sum2 += t.getDouble();
+		} while (t.getPosition() < file->size());
+	}
+	int t3 = Timer::getMilliSeconds();
+	EXPECT_EQ(sum1, sum2);
+
+	double size = double(file->size()) / 1000000.0;
+	std::cout << "JsonReader: " << size * 1000.0 / std::max(t2 - t1, 1) << " MB/s" << std::endl;
+	std::cout << "JsonTokenizer: " << size * 1000.0 / std::max(t3 - t2, 1) << " MB/s" << std::endl;
+}
+
 enum Enum {FOO, BAR};
 
 TEST(Data, ReadHelper)
@@ -2,9 +2,9 @@
 #define digi_Display_InputDevice_h
 
 #include <digi/Utility/ArrayRef.h>
+#include <digi/Utility/LockFreeQueue.h>
 #include <digi/Utility/Object.h>
 
-#include "SimpleQueue.h"
 
 namespace digi {
 
@@ -14,7 +14,7 @@ namespace digi {
 class EventQueue
 {
 public:
-	EventQueue(const std::vector<int>& handles, SimpleQueue<int, 32>& events)
+	EventQueue(const std::vector<int>& handles, LockFreeQueue<int>& events)
 		: handles(handles), events(events) {}
 
 	void add(int index)
@@ -26,13 +26,13 @@ public:
 		if (handle != -1)
 		{
 			// post handle as event
-			this->events.add(handle);
+			this->events.push(handle);
 		}
 	}
 
 protected:
 	const std::vector<int>& handles;
-	SimpleQueue<int, 32>& events;
+	LockFreeQueue<int>& events;
 };
 
 class InputDevice : public Object
@@ -42,7 +42,7 @@ class LinuxDisplay : public Display
 public:
 	
 	LinuxDisplay(EGLDisplay display, EGLSurface surface, EGLContext context)
-		: display(display), surface(surface), context(context)
+		: display(display), surface(surface), context(context), events(32)
 	{
 	}
 	virtual ~LinuxDisplay()
@@ -86,7 +86,7 @@ public:
 
 	virtual int getEvent()
 	{
-		if (this->events.isEmpty())
+		if (this->events.empty())
 		{
 			// handle events from input devices
 			foreach (InputsPair& input, this->inputs)
@@ -96,7 +96,9 @@ public:
 		}
 		
 		// get an event (use NO_EVENT if queue is empty)
-		return this->events.get(NO_EVENT);
+		int event = NO_EVENT;
+		this->events.pop(event);
+		return event;
 	}
 
 	
@@ -110,7 +112,7 @@ public:
 	EGLContext context;
 
 	// event queue
-	SimpleQueue<int, 32> events;
+	LockFreeQueue<int> events;
 };
 
 Pointer<Display> Display::open(StringRef title, int width, int height, int state)
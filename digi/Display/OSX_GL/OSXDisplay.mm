@@ -12,7 +12,6 @@
 #import "../Version.h"
 #import "../Display.h"
 #import "../InputDevice.h"
-#import "../SimpleQueue.h"
 
 
 // application
@@ -188,7 +187,7 @@ class OSXDisplay : public Display
 public:
 	
 	OSXDisplay(DigiWindow* window, DigiOpenGLView* view, bool fullscreen)
-		: window(window), view(view), fullscreen(fullscreen)
+		: window(window), view(view), fullscreen(fullscreen), textInput(128), events(32)
 	{
 		[window setReleasedWhenClosed: false];
 		[window setAcceptsMouseMovedEvents: true];
@@ -277,20 +276,12 @@ public:
 	
 	virtual int readTextInput(char* data, int length)
 	{
-		int numRead = 0;
-		while (length > 0 && !this->textInput.isEmpty())
-		{
-			*data = this->textInput.get(0);
-			++data;
-			--length;
-			++numRead;
-		}
-		return numRead;		
+		return int(this->textInput.read(data, length));
 	}
 
 	virtual int getEvent()
 	{		
-		if (this->events.isEmpty())
+		if (this->events.empty())
 		{
 			// handle window system events
 			NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
@@ -314,7 +305,9 @@ public:
 		}
 		
 		// get an event (use NO_EVENT if queue is empty)
-		return this->events.get(NO_EVENT);		
+		int event = NO_EVENT;
+		this->events.pop(event);
+		return event;
 	}
 	
 	void showError(StringRef message)
@@ -386,10 +379,10 @@ public:
 	NSCursor* noCursor;
 
 	// text input queue
-	SimpleQueue<char, 128> textInput;
+	LockFreeQueue<char> textInput;
 
 	// event queue
-	SimpleQueue<int, 32> events;
+	LockFreeQueue<int> events;
 	
 	// this flag is set to stop event processing in getEvent so that key or button presses are not missed
 	bool stopEvents;
@@ -511,7 +504,7 @@ using namespace digi;
 	// the application has to close the window when it receives EVENT_CLOSE
 	//[super close];
 	
-	self->display->events.add(Display::EVENT_CLOSE);
+	self->display->events.push(Display::EVENT_CLOSE);
 }
 @end
 
@@ -546,7 +539,7 @@ using namespace digi;
 	// text input
 	NSString* str = [event characters];
 	const char* utf8 = [str UTF8String];
-	self->display->textInput.add(utf8, strlen(utf8));
+	self->display->textInput.push(utf8, strlen(utf8));
 }
 
 - (void) keyUp:(NSEvent*)event
@@ -572,7 +565,7 @@ using namespace digi;
 	// text input
 	NSString* str = (NSString*)aString;//[event characters];
 	const char* utf8 = [str UTF8String];
-	self->display->textInput.add(utf8, strlen(utf8));
+	self->display->textInput.push(utf8, strlen(utf8));
 std::cout << "insertText " << strlen(utf8) << std::endl;
 }
 */
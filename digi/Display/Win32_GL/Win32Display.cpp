@@ -11,7 +11,6 @@
 
 #include "../Version.h"
 #include "../InputDevice.h"
-#include "../SimpleQueue.h"
 #include "../Display.h"
 
 #ifdef GL_ES
@@ -301,10 +300,12 @@ public:
 
 #ifdef GL_ES
 	Win32Display(HWND hWnd, HDC hDC, EGLDisplay display, EGLSurface surface, EGLContext context, int state)
-		: hWnd(hWnd), hDC(hDC), display(display), surface(surface), context(context), state(state & FULLSCREEN), cursor(true)
+		: hWnd(hWnd), hDC(hDC), display(display), surface(surface), context(context), state(state & FULLSCREEN), cursor(true),
+		textInput(128), events(32)
 #else
 	Win32Display(HWND hWnd, HDC hDC, HGLRC context, int state)
-		: hWnd(hWnd), hDC(hDC), context(context), state(state & FULLSCREEN), cursor(true)
+		: hWnd(hWnd), hDC(hDC), context(context), state(state & FULLSCREEN), cursor(true),
+		textInput(128), events(32)
 #endif
 	{
 		// store this pointer into window
@@ -419,20 +420,12 @@ public:
 
 	virtual int readTextInput(char* data, int length)
 	{
-		int numRead = 0;
-		while (length > 0 && !this->textInput.isEmpty())
-		{
-			*data = this->textInput.get(0);
-			++data;
-			--length;
-			++numRead;
-		}
-		return numRead;		
+		return int(this->textInput.read(data, length));
 	}
 
 	virtual int getEvent()
 	{		
-		if (this->events.isEmpty())
+		if (this->events.empty())
 		{
 			// handle window system events
 			this->stopEvents = false;
@@ -454,7 +447,9 @@ public:
 		}
 		
 		// get an event (use NO_EVENT if queue is empty)
-		return this->events.get(NO_EVENT);		
+		int event = NO_EVENT;
+		this->events.pop(event);
+		return event;
 	}
 
 	void showError(StringRef message)
@@ -504,10 +499,10 @@ public:
 	bool cursor;
 
 	// text input queue
-	SimpleQueue<char, 128> textInput;
+	LockFreeQueue<char> textInput;
 
 	// event queue
-	SimpleQueue<int, 32> events;
+	LockFreeQueue<int> events;
 
 	// this flag is set to stop event processing in getEvent so that key or button presses are not missed
 	bool stopEvents;
@@ -1001,7 +996,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 				char* it = buffer;
 				encode(it, wParam);
 				
-				display->textInput.add(buffer, it - buffer);
+				display->textInput.push(buffer, it - buffer);
 			}
 			return 0;
 	#ifndef _WIN32_WCE
@@ -1015,7 +1010,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 				char* it = buffer;
 				encode(it, wParam);
 				
-				display->textInput.add(buffer, it - buffer);
+				display->textInput.push(buffer, it - buffer);
 			}
 			return 1; // 1 to indicate support of WM_UNICHAR
 	#endif
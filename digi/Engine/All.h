@@ -5,6 +5,7 @@
 #include "Engine.h"
 #include "EngineInfo.h"
 #include "IK.h"
+#include "PickBVH.h"
 #include "Projection.h"
 #include "RenderLib.h"
 #include "Track.h"
@@ -65,29 +65,6 @@ namespace
 		}
 	};
 
-	// less functors
-
-	template <typename Type>
-	struct NameLess
-	{
-		bool operator ()(const Type& info, StringRef name)
-		{
-			return info.name < name;
-		}
-
-		bool operator ()(StringRef name, const Type& info)
-		{
-			return name < info.name;
-		}
-	};
-
-	typedef NameLess<TextureInfo> TextureLess;
-	typedef NameLess<SceneInfo> SceneLess;
-	typedef NameLess<AttributeInfo> AttributeLess;
-	typedef NameLess<AttributeSetInfo> AttributeSetLess;
-	typedef NameLess<ClipInfo> ClipLess;
-	typedef NameLess<ObjectInfo> ObjectLess;
-
 } // anonymous namespace
 
 
@@ -111,6 +88,9 @@ int Engine::addFile(Pointer<EngineFile> file)
 	if (file == null)
 		return -1;
 
+	// build name indices for fast lookup of scenes, attributes etc. by name
+	file->buildNameIndices();
+
 	// get a free file handle
 	int handle = getFreeHandle(this->files);
 	
@@ -182,6 +162,7 @@ void Engine::clear()
 	this->scenes.clear();
 	this->attributes.clear();
 	this->numAttributes = 0;
+	this->freeAttributeHandles.clear();
 	this->attributeSets.clear();
 	//this->clips.clear();
 	this->nextObjectId = 1;
@@ -259,6 +240,45 @@ void Engine::updateGroup(int groupHandle)
 	}	
 }
 
+// updates one scene of a group per work item
+class Engine::UpdateTask : public ThreadTask
+{
+public:
+
+	UpdateTask(Engine* engine, Group* group)
+		: engine(engine), group(group) {}
+
+	virtual void run(int index)
+	{
+		this->engine->updateScene((*this->group)[index]);
+	}
+
+	Engine* engine;
+	Group* group;
+};
+
+void Engine::updateGroupParallel(int groupHandle, int numThreads)
+{
+	// check group handle
+	if (uint(groupHandle) < uint(this->groups.size()))
+	{
+		Group* group = this->groups[groupHandle];
+		if (group != NULL)
+		{
+			if (numThreads <= 0)
+				numThreads = ThreadPool::getNumProcessors();
+
+			// create thread pool if number of threads has changed
+			if (this->threadPool == null || this->threadPool->getNumThreads() != numThreads)
+				this->threadPool = ThreadPool::create(numThreads);
+
+			// update all scenes in group
+			UpdateTask task(this, group);
+			this->threadPool->run(task, int(group->size()));
+		}
+	}
+}
+
 void Engine::renderGroup(int groupHandle, const float4x4& viewMatrix, const float4x4& projectionMatrix, int layerIndex)
 {
 	// check group handle
@@ -310,7 +330,7 @@ void Engine::renderGroup(int groupHandle, const float4x4& viewMatrix, const floa
 				glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 			
 				// render sorted and reset last shader
-				renderSorted(renderQueues.alphaSort);
+				renderSorted(renderQueues.alphaSort, this->sortKeys);
 			
 				// reset blend mode
 				glBlendFunc(GL_ONE, GL_ZERO);
@@ -483,17 +503,12 @@ int Engine::createScene(int fileHandle, StringRef sceneName, int groupHandle)
 	{
 		if (Pointer<EngineFile> file = this->files[fileHandle])
 		{
-			ArrayRef<const SceneInfo> sceneInfos = file->getSceneInfos();
-
 			// find scene by name
-			ArrayRef<const SceneInfo>::iterator begin = sceneInfos.begin();
-			ArrayRef<const SceneInfo>::iterator end = sceneInfos.end();
-			ArrayRef<const SceneInfo>::iterator it = binaryFind(begin, end,
-				sceneName, SceneLess());
+			int sceneIndex = file->sceneNameIndex.find(sceneName);
 
 			// check if scene was found
-			if (it != end)
-				return this->createScene(file, int(it - begin), groupHandle);
+			if (sceneIndex != -1)
+				return this->createScene(file, sceneIndex, groupHandle);
 		}
 	}
 	return -1;
@@ -687,21 +702,12 @@ int Engine::getAttributeHandle(int sceneHandle, StringRef attributeName)
 		Scene* scene = this->scenes[sceneHandle];
 		if (scene != NULL)
 		{
-			ArrayData<AttributeInfo> attributeInfos = scene->sceneInfo.attributeInfos;
-
 			// find attribute by name
-			ArrayData<AttributeInfo>::const_iterator begin = attributeInfos.begin();
-			ArrayData<AttributeInfo>::const_iterator end = attributeInfos.end();
-			ArrayData<AttributeInfo>::const_iterator attributeInfo = binaryFind(
-				begin,
-				end,
-				attributeName, AttributeLess());
+			int attributeIndex = scene->nameIndex.attributes.find(attributeName);
 
 			// check if attribute was found
-			if (attributeInfo != end)
+			if (attributeIndex != -1)
 			{
-				int attributeIndex = int(attributeInfo - begin);
-
 				// check if attribute already has a handle
 				int attributeHandle = scene->attributeHandles[attributeIndex];
 				if (attributeHandle != -1)
@@ -714,6 +720,36 @@ int Engine::getAttributeHandle(int sceneHandle, StringRef attributeName)
 	return -1;
 }
 
+void Engine::getAttributeHandles(int sceneHandle, ArrayRef<const StringRef> attributeNames, int* attributeHandles)
+{
+	size_t numNames = attributeNames.size();
+	std::fill(attributeHandles, attributeHandles + numNames, -1);
+
+	// check scene handle
+	if (uint(sceneHandle) < uint(this->scenes.size()))
+	{	
+		// get scene instance
+		Scene* scene = this->scenes[sceneHandle];
+		if (scene != NULL)
+		{
+			const NameIndex& nameIndex = scene->nameIndex.attributes;
+			for (size_t i = 0; i < numNames; ++i)
+			{
+				// find attribute by name
+				int attributeIndex = nameIndex.find(attributeNames[i]);
+				if (attributeIndex != -1)
+				{
+					// use existing handle or create new one
+					int attributeHandle = scene->attributeHandles[attributeIndex];
+					if (attributeHandle == -1)
+						attributeHandle = this->getAttributeHandleInternal(sceneHandle, attributeIndex);
+					attributeHandles[i] = attributeHandle;
+				}
+			}
+		}
+	}
+}
+
 
 int Engine::getNumAttributeSets(int sceneHandle)
 {
@@ -782,21 +818,12 @@ int Engine::getAttributeSetHandle(int sceneHandle, StringRef attributeSetName)
 		Scene* scene = this->scenes[sceneHandle];
 		if (scene != NULL)
 		{
-			ArrayData<AttributeSetInfo> attributeSetInfos = scene->sceneInfo.attributeSetInfos;
+			// find attribute set by name
+			int attributeSetIndex = scene->nameIndex.attributeSets.find(attributeSetName);
 
-			// find attribute by name
-			ArrayData<AttributeSetInfo>::const_iterator begin = attributeSetInfos.begin();
-			ArrayData<AttributeSetInfo>::const_iterator end = attributeSetInfos.end();
-			ArrayData<AttributeSetInfo>::const_iterator attributeSetInfo = binaryFind(
-				begin,
-				end,
-				attributeSetName, AttributeSetLess());
-
-			// check if attribute was found
-			if (attributeSetInfo != end)
+			// check if attribute set was found
+			if (attributeSetIndex != -1)
 			{
-				int attributeSetIndex = int(attributeSetInfo - begin);
-
 				// check if attribute set already has a handle
 				int attributeSetHandle = scene->attributeSetHandles[attributeSetIndex];
 				if (attributeSetHandle != -1)
@@ -867,21 +894,10 @@ int Engine::getClipIndex(int attributeSetHandle, StringRef clipName)
 		const AttributeSetInfo* attributeSetInfo = attributeSet.attributeSetInfo;
 		if (attributeSetInfo != NULL)
 		{		
-			// find clip by name
-			ArrayData<ClipInfo>::const_iterator begin = attributeSet.scene->sceneInfo.clipInfos.begin() + attributeSetInfo->clipIndex;
-			ArrayData<ClipInfo>::const_iterator end = begin + attributeSetInfo->numClips;
-			ArrayData<ClipInfo>::const_iterator clipInfo = binaryFind(
-				begin,
-				end,
-				clipName, ClipLess());
-				
-			// check if clip was found
-			if (clipInfo != end)
-			{
-				// check if clip already has a handle
-				int clipIndex = int(clipInfo - begin);
-				return clipIndex;
-			}
+			// find clip by name in the index of the attribute set
+			Scene* scene = attributeSet.scene;
+			int attributeSetIndex = int(attributeSetInfo - scene->sceneInfo.attributeSetInfos.begin());
+			return scene->nameIndex.clips[attributeSetIndex].find(clipName);
 		}
 	}
 	return -1;
@@ -1069,27 +1085,8 @@ int Engine::getObjectId(int sceneHandle, int objectIndex)
 		Scene* scene = this->scenes[sceneHandle];
 		if (scene != NULL)
 		{
-			ArrayData<ObjectInfo> objectInfos = scene->sceneInfo.objectInfos;
-
-			if (uint(objectIndex) < uint(objectInfos.length))
-			{ 
-				// get offset of object id in scene instance
-				size_t offset = objectInfos[objectIndex].offset;
-			
-				int* idPointer = (int*)(scene->instance + offset);
-				if (*idPointer == 0)
-				{		
-					// get object id
-					//! recycle id's when a scene instance is deleted
-					int id = this->nextObjectId++;
-					
-					// set object id 
-					*idPointer = id;
-				}
-				
-				// return id as handle
-				return *idPointer;
-			}
+			if (uint(objectIndex) < uint(scene->sceneInfo.objectInfos.length))
+				return this->getObjectIdInternal(scene, objectIndex);
 		}
 	}
 	return -1;
@@ -1104,38 +1101,39 @@ int Engine::getObjectId(int sceneHandle, StringRef objectName)
 		Scene* scene = this->scenes[sceneHandle];
 		if (scene != NULL)
 		{
-			ArrayData<ObjectInfo> objectInfos = scene->sceneInfo.objectInfos;
-
 			// find object info by name
-			ArrayData<ObjectInfo>::const_iterator objectInfosEnd = objectInfos.end();
-			ArrayData<ObjectInfo>::const_iterator objectInfo = binaryFind(
-				objectInfos.begin(),
-				objectInfosEnd,
-				objectName, ObjectLess());
+			int objectIndex = scene->nameIndex.objects.find(objectName);
 
 			// check if object info was found
-			if (objectInfo != objectInfosEnd)
+			if (objectIndex != -1)
+				return this->getObjectIdInternal(scene, objectIndex);
+		}
+	}
+	return -1;
+}
+
+void Engine::getObjectIds(int sceneHandle, ArrayRef<const StringRef> objectNames, int* objectIds)
+{
+	size_t numNames = objectNames.size();
+	std::fill(objectIds, objectIds + numNames, -1);
+
+	// check scene handle
+	if (uint(sceneHandle) < uint(this->scenes.size()))
+	{
+		// get scene instance
+		Scene* scene = this->scenes[sceneHandle];
+		if (scene != NULL)
+		{
+			const NameIndex& nameIndex = scene->nameIndex.objects;
+			for (size_t i = 0; i < numNames; ++i)
 			{
-				// get offset of object id in scene instance
-				size_t offset = objectInfo->offset;
-			
-				int* idPointer = (int*)(scene->instance + offset);
-				if (*idPointer == 0)
-				{		
-					// get object id
-					//! recycle id's when a scene instance is deleted
-					int id = this->nextObjectId++;
-					
-					// set object id 
-					*idPointer = id;
-				}
-				
-				// return id as handle
-				return *idPointer;
+				// find object info by name
+				int objectIndex = nameIndex.find(objectNames[i]);
+				if (objectIndex != -1)
+					objectIds[i] = this->getObjectIdInternal(scene, objectIndex);
 			}
 		}
 	}
-	return -1;
 }
 
 /*
@@ -1218,7 +1216,7 @@ int Engine::createScene(Pointer<EngineFile> file, int sceneIndex, int groupHandl
 			StateSetter setter;
 
 			// create scene instance
-			Scene* scene = new Scene(sceneInfos[sceneIndex], global);
+			Scene* scene = new Scene(sceneInfos[sceneIndex], file->sceneNameIndices[sceneIndex], global);
 			scene->sceneIndex = sceneHandle;
 			scene->groupIndex = groupHandle;
 			this->scenes[sceneHandle] = scene;
@@ -1273,6 +1271,7 @@ void Engine::deleteScene(Scene* scene)
 			
 			attribute.attributeInfo = &this->dummyAttributeInfo;
 			attribute.pointer = NULL;
+			this->freeAttributeHandles += attributeHandle;
 		}
 	}
 	
@@ -1305,19 +1304,39 @@ void Engine::deleteScene(Scene* scene)
 	delete scene;	
 }
 
+int Engine::getObjectIdInternal(Scene* scene, int objectIndex)
+{
+	// get offset of object id in scene instance
+	size_t offset = scene->sceneInfo.objectInfos[objectIndex].offset;
+
+	int* idPointer = (int*)(scene->instance + offset);
+	if (*idPointer == 0)
+	{		
+		// get object id
+		//! recycle id's when a scene instance is deleted
+		int id = this->nextObjectId++;
+		
+		// set object id 
+		*idPointer = id;
+	}
+	
+	// return id as handle
+	return *idPointer;
+}
+
 int Engine::getAttributeHandleInternal(int sceneHandle, int attributeIndex)
 {
-	// search for free attribute handle
-	std::vector<Attribute>::iterator it = this->attributes.begin();
-	std::vector<Attribute>::iterator end = this->attributes.end();
-	for (; it != end; ++it)
+	// get a free attribute handle
+	int attributeHandle;
+	if (!this->freeAttributeHandles.empty())
 	{
-		if (it->attributeInfo == &this->dummyAttributeInfo)
-			break;
+		attributeHandle = this->freeAttributeHandles.back();
+		this->freeAttributeHandles.pop_back();
 	}
-	int attributeHandle = int(it - this->attributes.begin());
-	if (it == end)
+	else
 	{
+		attributeHandle = int(this->attributes.size());
+		
 		// add attribute instance
 		add(this->attributes);
 
@@ -1494,4 +1513,32 @@ EngineFile::~EngineFile()
 {
 }
 
+void EngineFile::buildNameIndices()
+{
+	ArrayRef<const SceneInfo> sceneInfos = this->getSceneInfos();
+	this->sceneNameIndex.build(sceneInfos.begin(), sceneInfos.end());
+	
+	size_t numScenes = sceneInfos.size();
+	this->sceneNameIndices.resize(numScenes);
+	for (size_t i = 0; i < numScenes; ++i)
+	{
+		const SceneInfo& sceneInfo = sceneInfos[i];
+		SceneNameIndex& sceneNameIndex = this->sceneNameIndices[i];
+		
+		sceneNameIndex.attributes.build(sceneInfo.attributeInfos.begin(), sceneInfo.attributeInfos.end());
+		sceneNameIndex.attributeSets.build(sceneInfo.attributeSetInfos.begin(), sceneInfo.attributeSetInfos.end());
+		sceneNameIndex.objects.build(sceneInfo.objectInfos.begin(), sceneInfo.objectInfos.end());
+
+		// clips of each attribute set
+		size_t numAttributeSets = sceneInfo.attributeSetInfos.size();
+		sceneNameIndex.clips.resize(numAttributeSets);
+		for (size_t j = 0; j < numAttributeSets; ++j)
+		{
+			const AttributeSetInfo& attributeSetInfo = sceneInfo.attributeSetInfos[j];
+			ArrayData<ClipInfo>::const_iterator begin = sceneInfo.clipInfos.begin() + attributeSetInfo.clipIndex;
+			sceneNameIndex.clips[j].build(begin, begin + attributeSetInfo.numClips);
+		}
+	}
+}
+
 } // namespace digi
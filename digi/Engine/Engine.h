@@ -8,9 +8,11 @@
 #include <digi/Utility/VectorUtility.h>
 #include <digi/Utility/UTFTranscode.h>
 #include <digi/System/FileSystem.h>
+#include <digi/System/ThreadPool.h>
 
 #include "DataMemory.h"
 #include "EngineInfo.h"
+#include "NameIndex.h"
 
 
 namespace digi {
@@ -58,13 +60,19 @@ public:
 	/// calculate all dependent values such as world matrices for all scenes in group. needs current OpenGL context
 	void updateGroup(int groupHandle);
 
+	/// same as updateGroup but the scenes are distributed over the given number of threads (0 means one thread per
+	/// processor). the scene instances are independent of each other, therefore scenes in the group must not be
+	/// accessed while this function is running. needs current OpenGL context
+	void updateGroupParallel(int groupHandle, int numThreads = 0);
+
 	/// render a group using the given view and projection matrix. default render state is assumed and left behind.
 	/// needs current OpenGL context
 	void renderGroup(int groupHandle, const float4x4& viewMatrix, const float4x4& projectionMatrix, int layerIndex = 0);
 
 	/// pick an object in given group at device coordinates x, y which range from -1 to 1. If an object was hit,
 	/// return its handle. Handles to objects can be obtained with getObjectHandle().
-	/// only works if a pick render layer is present. needs current OpenGL context
+	/// only works if a pick render layer is present. needs current OpenGL context. this stalls the OpenGL pipeline,
+	/// see PickBVH for picking on the cpu
 	int pickGroup(int groupHandle, const float4x4& viewMatrix, const float4x4& projectionMatrix, float x, float y);
 	int pickGroup(int groupHandle, const float4x4& viewMatrix, const float4x4& projectionMatrix, float2 position)
 	{
@@ -119,6 +127,9 @@ public:
 	/// get handle for a scene attribute by name. returns -1 on error
 	int getAttributeHandle(int sceneHandle, StringRef attributeName);
 
+	/// get handles for many scene attributes by name at once. the handle is set to -1 for names that were not found
+	void getAttributeHandles(int sceneHandle, ArrayRef<const StringRef> attributeNames, int* attributeHandles);
+
 	/// get attribute name
 	StringRef getAttributeName(int attributeHandle)
 	{
@@ -560,6 +571,9 @@ public:
 	/// append the instance index in square brackets, e.g. "pCubeShape1[0]".
 	int getObjectId(int sceneHandle, StringRef objectName);
 
+	/// get ids of many objects in a scene by name at once. the id is set to -1 for names that were not found
+	void getObjectIds(int sceneHandle, ArrayRef<const StringRef> objectNames, int* objectIds);
+
 
 	//struct AttributeSetHandles
 	//{
@@ -570,8 +584,8 @@ public:
 	class Scene
 	{
 	public:
-		Scene(const SceneInfo& sceneInfo, void* global)
-			: sceneInfo(sceneInfo), instance(sceneInfo.instanceSize),
+		Scene(const SceneInfo& sceneInfo, const SceneNameIndex& nameIndex, void* global)
+			: sceneInfo(sceneInfo), nameIndex(nameIndex), instance(sceneInfo.instanceSize),
 			attributeHandles(sceneInfo.attributeInfos.size(), -1),
 			attributeSetHandles(sceneInfo.attributeSetInfos.size(), -1),
 			clipHandles(sceneInfo.clipInfos.size(), -1),
@@ -586,6 +600,7 @@ public:
 		}
 
 		const SceneInfo& sceneInfo;
+		const SceneNameIndex& nameIndex;
 		DataMemory instance;
 		
 		std::vector<int> attributeHandles;
@@ -667,18 +682,29 @@ protected:
 	int createScene(Pointer<EngineFile> file, int sceneIndex, int groupHandle);
 	void deleteScene(Scene* scene);
 
+	int getObjectIdInternal(Scene* scene, int objectIndex);
+
 	virtual int getAttributeHandleInternal(int sceneHandle, int attributeIndex);
 	virtual int getAttributeSetHandleInternal(int sceneHandle, int attributeSetIndex);
 	//virtual int getClipHandleInternal(int attributeSetHandle, int clipIndex);
 	
 	void updateScene(Scene* scene);
 
+	// task for updateGroupParallel
+	class UpdateTask;
+
 
 	// memory for render jobs
 	DataMemory renderJobs;
 
+	// buffer for sorting transparent render jobs
+	std::vector<RenderSortKey> sortKeys;
+
 	// 1x1 frame buffer object target for picking
 	GLuint pickFBO;
+
+	// worker threads for updateGroupParallel, created lazily
+	Pointer<ThreadPool> threadPool;
 	
 	// file loaders
 	std::map<std::string, Pointer<EngineLoader> > loaders;
@@ -697,6 +723,7 @@ protected:
 	// attribute instances
 	std::vector<Attribute> attributes;
 	uint numAttributes;
+	std::vector<int> freeAttributeHandles;
 	AttributeInfo dummyAttributeInfo;
 	std::map<int, std::string> strings;
 
@@ -739,8 +766,15 @@ public:
 
 private:
 
+	// build name indices, called when the file is added to the engine
+	void buildNameIndices();
+
 	// all scenes that are instances of this file
 	std::vector<Engine::Scene*> scenes;
+	
+	// name index for scenes and name indices for each scene
+	NameIndex sceneNameIndex;
+	std::vector<SceneNameIndex> sceneNameIndices;
 };
 
 /// @}
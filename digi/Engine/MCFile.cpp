@@ -2,6 +2,9 @@
 #include <digi/Utility/Find.h>
 #include <digi/Utility/MapUtility.h>
 #include <digi/Utility/foreach.h>
+#include <digi/System/MappedFile.h>
+#include <digi/Data/BufferedWriter.h>
+#include <digi/Data/DataException.h>
 #include <digi/System/File.h>
 #include <digi/Data/WriteFunctions.h>
 #include <digi/Math/All.h>
@@ -51,6 +54,83 @@ namespace
 
 	typedef NameLess<Function> FunctionLess;
 	
+	// relocation for external symbol (e.g. function that is called by the machine code)
+	bool relocateExternal(CodeMemory& code, size_t offset, StringRef functionName, Function* functionsBegin,
+		Function* functionsEnd)
+	{
+		ReadLE<size_t> read;
+		WriteLE<size_t> write;
+
+		// get external symbol
+		size_t s;
+	#ifdef _WIN32
+		// win32 uses _alloca/__chkstk to grow the stack if more than 4k (size of guard page) are allocated
+	#ifdef _M_X64
+		// 64 bit
+		if (functionName == "__chkstk")
+		{
+			s = (size_t)(void*)__chkstk;
+		}
+	#else
+		// 32 bit
+		if (functionName == "_alloca")
+		{
+			s = (size_t)(void*)_alloca_probe_16;
+		}
+	#endif
+		else
+	#endif
+		{
+			Function* function = binaryFind(
+				functionsBegin,
+				functionsEnd,
+				functionName, FunctionLess());
+
+			// check if function was found
+			if (function == functionsEnd)
+			{
+				// error
+				dError("reference to unknown function '" << functionName << "'");
+				return false;
+			}
+			s = (size_t)function->function;
+		}
+
+		// do relocation
+		size_t a = read(&code[offset]);
+		size_t p = 0;
+		if (sizeof(size_t) == 4)
+		{
+			// 32 bit: pc-relative addressing
+			p = (size_t)&code[offset];
+		}
+
+		write(s + a - p, &code[offset]);
+		return true;
+	}
+	
+	// internal relocation (e.g. access to data)
+	void relocateInternal(CodeMemory& code, size_t offset)
+	{
+		ReadLE<size_t> read;
+		WriteLE<size_t> write;
+
+		/*if (type == 0)
+		{
+			// 32 bit S + A
+			int32_t s = (int32_t)&code[0];
+			int32_t a = read(&code[offset]);
+			write(&code[offset], s + a);
+		}
+		else*/
+		{
+			// S + A
+			size_t s = (size_t)&code[0];
+			size_t a = read(&code[offset]);
+			write(s + a, &code[offset]);
+		}
+	}
+
 	bool relocate(ObjectReader& r, CodeMemory& code, Function* functionsBegin, Function* functionsEnd)
 	{
 		// read names of external symbols
@@ -62,9 +142,6 @@ namespace
 			r & externalNames[i];
 		}
 
-		ReadLE<size_t> read;
-		WriteLE<size_t> write;
-
 		// read relocations for extrnal symbols
 		uint numExternalRelocs;
 		r & numExternalRelocs;
@@ -76,53 +153,8 @@ namespace
 			r & nameIndex;
 			r & offset;
 
-			StringRef functionName = externalNames[nameIndex];
-
-			// get external symbol
-			size_t s;
-		#ifdef _WIN32
-			// win32 uses _alloca/__chkstk to grow the stack if more than 4k (size of guard page) are allocated
-		#ifdef _M_X64
-			// 64 bit
-			if (functionName == "__chkstk")
-			{
-				s = (size_t)(void*)__chkstk;
-			}
-		#else
-			// 32 bit
-			if (functionName == "_alloca")
-			{
-				s = (size_t)(void*)_alloca_probe_16;
-			}
-		#endif
-			else
-		#endif
-			{
-				Function* function = binaryFind(
-					functionsBegin,
-					functionsEnd,
-					functionName, FunctionLess());
-
-				// check if function was found
-				if (function == functionsEnd)
-				{
-					// error
-					dError("reference to unknown function '" << functionName << "'");
-					return false;
-				}
-				s = (size_t)function->function;
-			}
-
-			// do relocation
-			size_t a = read(&code[offset]);
-			size_t p = 0;
-			if (sizeof(size_t) == 4)
-			{
-				// 32 bit: pc-relative addressing
-				p = (size_t)&code[offset];
-			}
-
-			write(s + a - p, &code[offset]);
+			if (!relocateExternal(code, offset, externalNames[nameIndex], functionsBegin, functionsEnd))
+				return false;
 		}
 		
 		// read internal relocations
@@ -137,23 +169,539 @@ namespace
 			r & offset;
 			//r & type;
 			
-			/*if (type == 0)
+			relocateInternal(code, offset);
+		}
+		return true;
+	}
+
+	// set public symbol of texture
+	void setPublic(TextureInfo& info, StringRef name, uint8_t* address)
+	{
+		if (name == "initGlobal")
+			info.initGlobal = (TextureInfo::InitGlobal)address;
+		else if (name == "doneGlobal")
+			info.doneGlobal = (TextureInfo::DoneGlobal)address;
+		else if (name == "copy")
+			info.copy = (TextureInfo::Copy)address;
+	}
+	
+	bool hasPublics(const TextureInfo& info)
+	{
+		return info.initGlobal != NULL && info.doneGlobal != NULL && info.copy != NULL;
+	}
+	
+	// set public symbol of scene
+	void setPublic(SceneInfo& info, StringRef name, uint8_t* address)
+	{
+		if (name == "initGlobal")
+			info.initGlobal = (SceneInfo::InitGlobal)address;
+		else if (name == "doneGlobal")
+			info.doneGlobal = (SceneInfo::DoneGlobal)address;
+		else if (name == "initInstance")
+			info.initInstance = (SceneInfo::InitInstance)address;
+		else if (name == "doneInstance")
+			info.doneInstance = (SceneInfo::DoneInstance)address;
+		else if (name == "addClip")
+			info.addClip = (SceneInfo::AddClip)address;
+		else if (name == "update")
+			info.update = (SceneInfo::Update)address;
+		else if (name == "getBoundingBox")
+			info.getBoundingBox = (SceneInfo::GetBoundingBox)address;
+		else if (name == "render")
+			info.render = (SceneInfo::Render)address;
+		//else if (name == "rayTest")
+		//	info.rayTest = (SceneInfo::RayTest)address;
+	}
+
+	bool hasPublics(const SceneInfo& info)
+	{
+		return info.initGlobal != NULL && info.doneGlobal != NULL && info.initInstance != NULL
+			&& info.doneInstance != NULL && info.addClip != NULL && info.update != NULL
+			&& info.getBoundingBox != NULL && info.render != NULL; // && info.rayTest != NULL
+	}
+
+	// layout of memory mapped machine code file. offsets are relative to the beginning of the file and names
+	// are offsets into the string table. the info arrays are stored in the native layout of the host machine
+	// with names also stored as offsets into the string table.
+	const uint32_t MAPPED_MAGIC = 0x4d434d44; // "DMCM"
+	const uint32_t MAPPED_VERSION = 1;
+	const uint INVALID_INDEX = 0xffffffff;
+	
+	struct MappedArray
+	{
+		uint64_t offset;
+		uint64_t length;
+	};
+
+	struct MappedHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		
+		// size of pointers of the host machine
+		uint32_t pointerSize;
+		uint32_t reserved;
+		
+		uint32_t numTextures;
+		uint32_t numScenes;
+
+		// MappedModule, textures followed by scenes
+		uint64_t modulesOffset;
+
+		// zero terminated strings
+		MappedArray strings;
+	};
+	
+	struct MappedSymbol
+	{
+		// name or index of name
+		uint64_t name;
+		
+		// offset in code
+		uint64_t offset;
+	};
+	
+	struct MappedModule
+	{
+		uint64_t name;
+		uint64_t type;
+		
+		MappedArray data;
+		MappedArray code;
+		uint64_t globalSize;
+		uint64_t instanceSize;
+		
+		// public symbols (MappedSymbol)
+		MappedArray publics;
+		
+		// names of external symbols (uint64_t)
+		MappedArray externalNames;
+		
+		// external relocations (MappedSymbol with index into externalNames)
+		MappedArray externalRelocations;
+		
+		// internal relocations (uint64_t offset)
+		MappedArray internalRelocations;
+		
+		// info arrays of scenes
+		MappedArray nodeInfos;
+		MappedArray attributeInfos;
+		MappedArray textureBindings;
+		MappedArray attributeSetInfos;
+		MappedArray clipInfos;
+		MappedArray objectInfos;
+	};
+	
+	// converts a machine code file into the memory mapped layout
+	class MappedWriter
+	{
+	public:
+	
+		MappedWriter(Pointer<IODevice> dev)
+			: r(dev), buffer(sizeof(MappedHeader)) {}
+		
+		void write(Pointer<IODevice> dev)
+		{
+			MappedHeader header = {};
+			header.magic = MAPPED_MAGIC;
+			header.version = MAPPED_VERSION;
+			header.pointerSize = uint32_t(sizeof(void*));
+			
+			// textures. failed textures are removed, therefore texture indices have to be remapped
+			uint numTextures;
+			r & numTextures;
+			this->textureRemap.resize(numTextures, INVALID_INDEX);
+			for (uint i = 0; i < numTextures; ++i)
+			{
+				MappedModule module = {};
+				if (this->readModule(module, false))
+				{
+					this->textureRemap[i] = header.numTextures;
+					++header.numTextures;
+					this->modules.push_back(module);
+				}
+			}
+			
+			// scenes
+			uint numScenes;
+			r & numScenes;
+			for (uint i = 0; i < numScenes; ++i)
+			{
+				MappedModule module = {};
+				if (this->readModule(module, true))
+				{
+					++header.numScenes;
+					this->modules.push_back(module);
+				}
+			}
+			
+			header.modulesOffset = this->add(this->modules).offset;
+			header.strings = this->add(this->strings);
+			*(MappedHeader*)this->buffer.data() = header;
+			
+			BufferedWriter w(dev);
+			w.writeData(this->buffer.data(), this->buffer.size());
+			w.close();
+		}
+
+	protected:
+	
+		bool readModule(MappedModule& module, bool isScene)
+		{
+			// a zero-length name indicates that something went wrong while writing the file
+			module.name = this->readString();
+			if (this->strings[size_t(module.name)] == 0)
+				return false;
+
+			if (!isScene)
+			{
+				uint type;
+				r & type;
+				module.type = type;
+			}
+			
+			module.data = this->readData();
+			module.code = this->readData();
+			
+			// public symbols
+			uint numPublics;
+			r & numPublics;
+			std::vector<MappedSymbol> publics(numPublics);
+			foreach (MappedSymbol& symbol, publics)
+			{
+				size_t offset;
+				symbol.name = this->readString();
+				r & offset;
+				symbol.offset = offset;
+			}
+			module.publics = this->add(publics);
+			
+			// names of external symbols
+			uint numExternalNames;
+			r & numExternalNames;
+			std::vector<uint64_t> externalNames(numExternalNames);
+			foreach (uint64_t& name, externalNames)
+				name = this->readString();
+			module.externalNames = this->add(externalNames);
+			
+			// external relocations
+			uint numExternalRelocs;
+			r & numExternalRelocs;
+			std::vector<MappedSymbol> externalRelocations(numExternalRelocs);
+			foreach (MappedSymbol& relocation, externalRelocations)
 			{
-				// 32 bit S + A
-				int32_t s = (int32_t)&code[0];
-				int32_t a = read(&code[offset]);
-				write(&code[offset], s + a);
+				uint nameIndex;
+				size_t offset;
+				r & nameIndex;
+				r & offset;
+				relocation.name = nameIndex;
+				relocation.offset = offset;
 			}
-			else*/
+			module.externalRelocations = this->add(externalRelocations);
+
+			// internal relocations
+			uint numInternalRelocs;
+			r & numInternalRelocs;
+			std::vector<uint64_t> internalRelocations(numInternalRelocs);
+			foreach (uint64_t& offset, internalRelocations)
 			{
-				// S + A
-				size_t s = (size_t)&code[0];
-				size_t a = read(&code[offset]);
-				write(s + a, &code[offset]);
+				size_t o;
+				r & o;
+				offset = o;
+			}
+			module.internalRelocations = this->add(internalRelocations);
+			
+			// global size
+			uint globalSize;
+			r & globalSize;
+			module.globalSize = globalSize;
+			if (!isScene)
+				return true;
+			
+			// instance size
+			uint instanceSize;
+			r & instanceSize;
+			module.instanceSize = instanceSize;
+			
+			// nodes
+			{
+				std::vector<NodeInfo> nodeInfos(this->readCount());
+				foreach (NodeInfo& nodeInfo, nodeInfos)
+				{
+					nodeInfo.name = this->readStringOffset();
+					r & nodeInfo.type;
+				}
+				module.nodeInfos = this->add(nodeInfos);
+			}
+			
+			// attributes
+			{
+				std::vector<AttributeInfo> attributeInfos(this->readCount());
+				foreach (AttributeInfo& attributeInfo, attributeInfos)
+				{
+					attributeInfo.name = this->readStringOffset();
+					r & attributeInfo.type;
+					r & attributeInfo.offset;
+					attributeInfo.semantic = this->readStringOffset();
+				}
+				module.attributeInfos = this->add(attributeInfos);
+			}
+			
+			// texture bindings
+			{
+				uint numTextureBindings = this->readCount();
+				std::vector<TextureBinding> textureBindings;
+				for (uint i = 0; i < numTextureBindings; ++i)
+				{
+					TextureBinding textureBinding;
+					uint textureIndex;
+					r & textureIndex;
+					r & textureBinding.type;
+					r & textureBinding.offset;
+					
+					// drop bindings to textures that failed to load
+					if (textureIndex < this->textureRemap.size() && this->textureRemap[textureIndex] != INVALID_INDEX)
+					{
+						textureBinding.textureIndex = this->textureRemap[textureIndex];
+						textureBindings.push_back(textureBinding);
+					}
+				}
+				module.textureBindings = this->add(textureBindings);
+			}
+			
+			// attribute sets
+			{
+				std::vector<AttributeSetInfo> attributeSetInfos(this->readCount());
+				foreach (AttributeSetInfo& attributeSetInfo, attributeSetInfos)
+				{
+					attributeSetInfo.name = this->readStringOffset();
+					r & attributeSetInfo.offset;
+					r & attributeSetInfo.numTracks;
+					r & attributeSetInfo.clipIndex;
+					r & attributeSetInfo.numClips;
+				}
+				module.attributeSetInfos = this->add(attributeSetInfos);
+			}
+			
+			// clips
+			{
+				std::vector<ClipInfo> clipInfos(this->readCount());
+				foreach (ClipInfo& clipInfo, clipInfos)
+				{
+					clipInfo.name = this->readStringOffset();
+					r & clipInfo.index;
+					r & clipInfo.length;
+				}
+				module.clipInfos = this->add(clipInfos);
+			}
+			
+			// objects
+			{
+				std::vector<ObjectInfo> objectInfos(this->readCount());
+				foreach (ObjectInfo& objectInfo, objectInfos)
+				{
+					objectInfo.name = this->readStringOffset();
+					r & objectInfo.offset;
+				}
+				module.objectInfos = this->add(objectInfos);
 			}
+			return true;
+		}
+		
+		uint readCount()
+		{
+			uint count;
+			r & count;
+			return count;
+		}
+		
+		// read string and add to string table, returns offset in string table
+		uint64_t readString()
+		{
+			std::string str;
+			r & str;
+			
+			// reuse equal strings
+			std::map<std::string, uint64_t>::iterator it = this->stringOffsets.find(str);
+			if (it != this->stringOffsets.end())
+				return it->second;
+			
+			uint64_t offset = this->strings.size();
+			this->strings.insert(this->strings.end(), str.begin(), str.end());
+			this->strings.push_back(0);
+			this->stringOffsets[str] = offset;
+			return offset;
+		}
+		
+		// read string, the offset is stored in place of the pointer
+		const char* readStringOffset()
+		{
+			return (const char*)size_t(this->readString());
+		}
+		
+		// read data block with size into buffer
+		MappedArray readData()
+		{
+			size_t size;
+			r & size;
+			MappedArray array = this->allocate(size);
+			r.readData(this->buffer.data() + array.offset, size);
+			return array;
+		}
+		
+		// add array to buffer
+		template <typename Type>
+		MappedArray add(const std::vector<Type>& data)
+		{
+			MappedArray array = this->allocate(data.size() * sizeof(Type));
+			if (!data.empty())
+				memcpy(this->buffer.data() + array.offset, data.data(), data.size() * sizeof(Type));
+			array.length = data.size();
+			return array;
+		}
+		
+		MappedArray allocate(size_t size)
+		{
+			// align to 16 bytes for data that is used in place
+			size_t offset = (this->buffer.size() + 15) & ~15;
+			this->buffer.resize(offset + size);
+			MappedArray array = {offset, size};
+			return array;
+		}
+		
+		ObjectReader r;
+		std::vector<uint8_t> buffer;
+		std::vector<uint> textureRemap;
+		std::vector<MappedModule> modules;
+		std::vector<char> strings;
+		std::map<std::string, uint64_t> stringOffsets;
+	};
+
+	// accesses the memory mapped layout and checks that everything lies inside the file
+	class MappedReader
+	{
+	public:
+	
+		MappedReader(Pointer<MappedFile> file)
+			: file(file), data(file->data()), size(file->size()), strings(NULL), stringsSize(0)
+		{
+			const MappedHeader* header = this->getHeader();
+			if (header == NULL || header->magic != MAPPED_MAGIC)
+				this->error(DataException::FORMAT_ERROR);
+			if (header->version != MAPPED_VERSION)
+				this->error(DataException::UNKNOWN_VERSION);
+			if (header->pointerSize != sizeof(void*))
+				this->error(DataException::FORMAT_NOT_SUPPORTED);
+			
+			// the string table must be zero terminated
+			this->strings = this->get<const char>(header->strings);
+			this->stringsSize = size_t(header->strings.length);
+			if (this->stringsSize > 0 && this->strings[this->stringsSize - 1] != 0)
+				this->error(DataException::DATA_CORRUPT);
+		}
+		
+		const MappedHeader* getHeader()
+		{
+			if (this->size < sizeof(MappedHeader))
+				return NULL;
+			return (const MappedHeader*)this->data;
+		}
+		
+		const MappedModule* getModules()
+		{
+			const MappedHeader* header = this->getHeader();
+			MappedArray array = {header->modulesOffset, uint64_t(header->numTextures) + header->numScenes};
+			return this->get<const MappedModule>(array);
+		}
+		
+		template <typename Type>
+		Type* get(const MappedArray& array)
+		{
+			if (array.offset > this->size || array.length > (this->size - array.offset) / sizeof(Type))
+				this->error(DataException::DATA_CORRUPT);
+			return (Type*)(this->data + size_t(array.offset));
+		}
+		
+		const char* getString(uint64_t offset)
+		{
+			if (offset >= this->stringsSize)
+				this->error(DataException::DATA_CORRUPT);
+			return this->strings + size_t(offset);
+		}
+		
+		// replace string offsets stored in the name member of info structs by pointers
+		template <typename Type>
+		void setNames(Type* infos, uint length)
+		{
+			for (uint i = 0; i < length; ++i)
+				infos[i].name = this->getString(size_t(infos[i].name));
+		}
+
+		void error(DataException::Reason reason)
+		{
+			throw DataException(File::getDummyFile(this->file->getPath()), reason);
+		}
+		
+		Pointer<MappedFile> file;
+		uint8_t* data;
+		size_t size;
+		const char* strings;
+		size_t stringsSize;
+	};
+	
+	// copy code into executable memory and relocate
+	bool loadCode(MappedReader& r, const MappedModule& module, CodeMemory& code, Function* functionsBegin,
+		Function* functionsEnd)
+	{
+		size_t codeSize = size_t(module.code.length);
+		const uint8_t* codeData = r.get<const uint8_t>(module.code);
+		CodeMemory c(codeSize);
+		memcpy(c, codeData, codeSize);
+		swap(code, c);
+		
+		// relocations for external symbols
+		const uint64_t* externalNames = r.get<const uint64_t>(module.externalNames);
+		size_t numExternalNames = size_t(module.externalNames.length);
+		const MappedSymbol* externalRelocations = r.get<const MappedSymbol>(module.externalRelocations);
+		size_t numExternalRelocations = size_t(module.externalRelocations.length);
+		for (size_t i = 0; i < numExternalRelocations; ++i)
+		{
+			const MappedSymbol& relocation = externalRelocations[i];
+			if (relocation.name >= numExternalNames || codeSize < sizeof(size_t)
+				|| relocation.offset > codeSize - sizeof(size_t))
+				r.error(DataException::DATA_CORRUPT);
+			
+			StringRef functionName = r.getString(externalNames[size_t(relocation.name)]);
+			if (!relocateExternal(code, size_t(relocation.offset), functionName, functionsBegin, functionsEnd))
+				return false;
+		}
+		
+		// internal relocations
+		const uint64_t* internalRelocations = r.get<const uint64_t>(module.internalRelocations);
+		size_t numInternalRelocations = size_t(module.internalRelocations.length);
+		for (size_t i = 0; i < numInternalRelocations; ++i)
+		{
+			uint64_t offset = internalRelocations[i];
+			if (codeSize < sizeof(size_t) || offset > codeSize - sizeof(size_t))
+				r.error(DataException::DATA_CORRUPT);
+			relocateInternal(code, size_t(offset));
 		}
 		return true;
 	}
+	
+	// set public symbols of texture or scene
+	template <typename Info>
+	void setPublics(MappedReader& r, const MappedModule& module, CodeMemory& code, Info& info)
+	{
+		const MappedSymbol* publics = r.get<const MappedSymbol>(module.publics);
+		size_t numPublics = size_t(module.publics.length);
+		for (size_t i = 0; i < numPublics; ++i)
+		{
+			const MappedSymbol& symbol = publics[i];
+			if (symbol.offset < code.size())
+				setPublic(info, r.getString(symbol.name), &code[size_t(symbol.offset)]);
+		}
+	}
 
 } // anonymous namespace
 
@@ -167,6 +715,15 @@ MCLoader::~MCLoader()
 Pointer<EngineFile> MCLoader::load(const fs::path& path)
 {
 	Pointer<File> file = File::open(path, File::READ);
+
+	// check for memory mapped layout
+	uint32_t magic = 0;
+	if (file->read(&magic, 4) == 4 && magic == MAPPED_MAGIC)
+	{
+		file->close();
+		return new MappedMCFile(MappedFile::open(path));
+	}
+	file->setPosition(0);
 	return new MCFile(file);
 }
 
@@ -193,7 +750,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 	this->textureInfos.resize(numTextures);
 	this->textures.resize(numTextures);
 	uint textureIndex = 0;
-	std::vector<uint> textureRemap(numTextures, textureIndex);
+	std::vector<uint> textureRemap(numTextures, INVALID_INDEX);
 	for (uint k = 0; k < numTextures; ++k)
 	{
 		TextureInfo& info = this->textureInfos[textureIndex];
@@ -230,15 +787,9 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				r & name;
 				r & offset;
 
-				if (name == "initGlobal")
-					info.initGlobal = (TextureInfo::InitGlobal)&code[offset];
-				else if (name == "doneGlobal")
-					info.doneGlobal = (TextureInfo::DoneGlobal)&code[offset];
-				else if (name == "copy")
-					info.copy = (TextureInfo::Copy)&code[offset];
+				setPublic(info, name, &code[offset]);
 			}
-			if (info.initGlobal != NULL && info.doneGlobal != NULL && info.copy != NULL
-				&& relocate(r, code, functions, functionsEnd))
+			if (hasPublics(info) && relocate(r, code, functions, functionsEnd))
 			{
 				// everything is ok
 				
@@ -305,29 +856,9 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				r & name;
 				r & offset;
 
-				if (name == "initGlobal")
-					info.initGlobal = (SceneInfo::InitGlobal)&code[offset];
-				else if (name == "doneGlobal")
-					info.doneGlobal = (SceneInfo::DoneGlobal)&code[offset];
-				else if (name == "initInstance")
-					info.initInstance = (SceneInfo::InitInstance)&code[offset];
-				else if (name == "doneInstance")
-					info.doneInstance = (SceneInfo::DoneInstance)&code[offset];
-				else if (name == "addClip")
-					info.addClip = (SceneInfo::AddClip)&code[offset];
-				else if (name == "update")
-					info.update = (SceneInfo::Update)&code[offset];
-				else if (name == "getBoundingBox")
-					info.getBoundingBox = (SceneInfo::GetBoundingBox)&code[offset];
-				else if (name == "render")
-					info.render = (SceneInfo::Render)&code[offset];
-				//else if (name == "rayTest")
-				//	info.rayTest = (SceneInfo::RayTest)&code[offset];
+				setPublic(info, name, &code[offset]);
 			}
-			if (info.initGlobal != NULL && info.doneGlobal != NULL && info.initInstance != NULL
-				&& info.doneInstance != NULL && info.addClip != NULL && info.update != NULL
-				&& info.getBoundingBox != NULL && info.render != NULL// && info.rayTest != NULL
-				&& relocate(r, code, functions, functionsEnd))
+			if (hasPublics(info) && relocate(r, code, functions, functionsEnd))
 			{
 				// everything is ok
 
@@ -339,7 +870,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numNodes;
 					r & numNodes;
-					NodeInfo* nodeInfos = this->nodeInfoPool.alloc(numNodes);
+					NodeInfo* nodeInfos = this->arena.alloc<NodeInfo>(numNodes);
 					info.nodeInfos.data = nodeInfos;
 					info.nodeInfos.length = numNodes;
 					for (uint i = 0; i < numNodes; ++i)
@@ -358,7 +889,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numAttributes;
 					r & numAttributes;
-					AttributeInfo* attributeInfos = this->parameterInfoPool.alloc(numAttributes);
+					AttributeInfo* attributeInfos = this->arena.alloc<AttributeInfo>(numAttributes);
 					info.attributeInfos.data = attributeInfos;
 					info.attributeInfos.length = numAttributes;
 					for (uint i = 0; i < numAttributes; ++i)
@@ -383,7 +914,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numTextureBindings;
 					r & numTextureBindings;
-					TextureBinding* textureBindings = this->textureBindingPool.alloc(numTextureBindings);
+					TextureBinding* textureBindings = this->arena.alloc<TextureBinding>(numTextureBindings);
 					info.textureBindings.data = textureBindings;
 					uint textureBindingIndex = 0;
 					for (uint i = 0; i < numTextureBindings; ++i)
@@ -406,7 +937,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numParameterSets;
 					r & numParameterSets;
-					AttributeSetInfo* attributeSetInfos = this->parameterSetInfoPool.alloc(numParameterSets);
+					AttributeSetInfo* attributeSetInfos = this->arena.alloc<AttributeSetInfo>(numParameterSets);
 					info.attributeSetInfos.data = attributeSetInfos;
 					info.attributeSetInfos.length = numParameterSets;
 					for (uint i = 0; i < numParameterSets; ++i)
@@ -426,7 +957,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numClips;
 					r & numClips;
-					ClipInfo* clipInfos = this->clipInfoPool.alloc(numClips);
+					ClipInfo* clipInfos = this->arena.alloc<ClipInfo>(numClips);
 					info.clipInfos.data = clipInfos;
 					info.clipInfos.length = numClips;
 					for (uint i = 0; i < numClips; ++i)
@@ -444,7 +975,7 @@ MCFile::MCFile(Pointer<IODevice> dev)
 				{
 					uint numObjects;
 					r & numObjects;
-					ObjectInfo* objectInfos = this->objectInfoPool.alloc(numObjects);
+					ObjectInfo* objectInfos = this->arena.alloc<ObjectInfo>(numObjects);
 					info.objectInfos.data = objectInfos;
 					info.objectInfos.length = numObjects;
 					for (uint i = 0; i < numObjects; ++i)
@@ -523,10 +1054,199 @@ void MCFile::done()
 const char* MCFile::readString(ObjectReader& r)
 {
 	size_t length = readVarSize<size_t>(r);
-	char* str = this->stringPool.alloc(length + 1);
+	char* str = this->arena.alloc<char>(length + 1);
 	r.readData(str, length);
 	str[length] = 0;
 	return str;
 }
 
+
+// MappedMCFile
+
+MappedMCFile::MappedMCFile(Pointer<MappedFile> file)
+	: file(file)
+{
+	// initialize list of functions that the machine code can call (see MCFile)
+	#include "MCNumFunctions.inc.h"
+	Function functions[NUM_FUNCTIONS];
+	Function* f = functions;
+	#include "MCSetFunctions.inc.h"
+	Function* functionsEnd = f;
+
+	MappedReader r(file);
+	const MappedHeader* header = r.getHeader();
+	const MappedModule* modules = r.getModules();
+	uint numTextures = header->numTextures;
+	uint numScenes = header->numScenes;
+
+	// textures
+	this->textureInfos.resize(numTextures);
+	this->textures.resize(numTextures);
+	uint textureIndex = 0;
+	std::vector<uint> textureRemap(numTextures, INVALID_INDEX);
+	for (uint k = 0; k < numTextures; ++k)
+	{
+		const MappedModule& module = modules[k];
+		TextureInfo& info = this->textureInfos[textureIndex];
+		info = TextureInfo();
+		info.name = r.getString(module.name);
+		info.type = uint(module.type);
+		info.globalSize = uint(module.globalSize);
+		
+		Global& texture = this->textures[textureIndex];
+		if (loadCode(r, module, texture.code, functions, functionsEnd))
+		{
+			setPublics(r, module, texture.code, info);
+			if (hasPublics(info))
+			{
+				DataMemory global(info.globalSize);
+				swap(texture.global, global);
+
+				// initialize, the data is used in place
+				info.initGlobal(texture.global, r.get<uint8_t>(module.data));
+
+				textureRemap[k] = textureIndex;
+				++textureIndex;
+				continue;
+			}
+		}
+		dError("texture '" << info.name << "' failed to load");
+	}
+	this->textureInfos.resize(textureIndex);
+	this->textures.resize(textureIndex);
+	
+	// scenes
+	this->sceneInfos.resize(numScenes);
+	this->scenes.resize(numScenes);
+	uint sceneIndex = 0;
+	for (uint k = 0; k < numScenes; ++k)
+	{
+		const MappedModule& module = modules[numTextures + k];
+		SceneInfo& info = this->sceneInfos[sceneIndex];
+		info = SceneInfo();
+		info.name = r.getString(module.name);
+		info.globalSize = uint(module.globalSize);
+		info.instanceSize = uint(module.instanceSize);
+
+		Global& scene = this->scenes[sceneIndex];
+		if (loadCode(r, module, scene.code, functions, functionsEnd))
+		{
+			setPublics(r, module, scene.code, info);
+			if (hasPublics(info))
+			{
+				// the info arrays are used in place. names are stored as offsets into the string table and get
+				// replaced by pointers (the mapping is copy-on-write, therefore the file is not modified)
+				NodeInfo* nodeInfos = r.get<NodeInfo>(module.nodeInfos);
+				info.nodeInfos.data = nodeInfos;
+				info.nodeInfos.length = uint(module.nodeInfos.length);
+				r.setNames(nodeInfos, info.nodeInfos.length);
+
+				AttributeInfo* attributeInfos = r.get<AttributeInfo>(module.attributeInfos);
+				info.attributeInfos.data = attributeInfos;
+				info.attributeInfos.length = uint(module.attributeInfos.length);
+				r.setNames(attributeInfos, info.attributeInfos.length);
+				for (uint i = 0; i < info.attributeInfos.length; ++i)
+					attributeInfos[i].semantic = r.getString(size_t(attributeInfos[i].semantic));
+
+				// remove bindings to textures that failed to load
+				TextureBinding* textureBindings = r.get<TextureBinding>(module.textureBindings);
+				uint numTextureBindings = uint(module.textureBindings.length);
+				uint textureBindingIndex = 0;
+				for (uint i = 0; i < numTextureBindings; ++i)
+				{
+					uint index = textureBindings[i].textureIndex;
+					if (index < numTextures && textureRemap[index] != INVALID_INDEX)
+					{
+						TextureBinding& textureBinding = textureBindings[textureBindingIndex++];
+						textureBinding = textureBindings[i];
+						textureBinding.textureIndex = textureRemap[index];
+					}
+				}
+				info.textureBindings.data = textureBindings;
+				info.textureBindings.length = textureBindingIndex;
+
+				AttributeSetInfo* attributeSetInfos = r.get<AttributeSetInfo>(module.attributeSetInfos);
+				info.attributeSetInfos.data = attributeSetInfos;
+				info.attributeSetInfos.length = uint(module.attributeSetInfos.length);
+				r.setNames(attributeSetInfos, info.attributeSetInfos.length);
+
+				ClipInfo* clipInfos = r.get<ClipInfo>(module.clipInfos);
+				info.clipInfos.data = clipInfos;
+				info.clipInfos.length = uint(module.clipInfos.length);
+				r.setNames(clipInfos, info.clipInfos.length);
+
+				ObjectInfo* objectInfos = r.get<ObjectInfo>(module.objectInfos);
+				info.objectInfos.data = objectInfos;
+				info.objectInfos.length = uint(module.objectInfos.length);
+				r.setNames(objectInfos, info.objectInfos.length);
+				
+				DataMemory global(info.globalSize);
+				swap(scene.global, global);
+
+				// initialize, the data is used in place
+				info.initGlobal(scene.global, r.get<uint8_t>(module.data));
+			
+				++sceneIndex;
+				continue;
+			}
+		}
+		dError("scene '" << info.name << "' failed to load");
+	}
+	this->sceneInfos.resize(sceneIndex);
+	this->scenes.resize(sceneIndex);
+}
+
+MappedMCFile::~MappedMCFile()
+{
+}
+
+ArrayRef<const TextureInfo> MappedMCFile::getTextureInfos()
+{
+	return ArrayRef<const TextureInfo>(this->textureInfos);
+}
+
+void* MappedMCFile::getTextureGlobal(int index)
+{
+	return this->textures[index].global;
+}
+
+ArrayRef<const SceneInfo> MappedMCFile::getSceneInfos()
+{
+	return ArrayRef<const SceneInfo>(this->sceneInfos);
+}
+
+void* MappedMCFile::getSceneGlobal(int index)
+{
+	return this->scenes[index].global;
+}
+
+void MappedMCFile::done()
+{
+	size_t numTextures = this->textureInfos.size();
+	size_t numScenes = this->sceneInfos.size();
+	
+	// done textures
+	for (size_t i = 0; i < numTextures; ++i)
+	{
+		const TextureInfo& textureInfo = this->textureInfos[i];
+		textureInfo.doneGlobal(this->textures[i].global);
+	}
+	
+	// done scenes
+	for (size_t i = 0; i < numScenes; ++i)
+	{
+		const SceneInfo& sceneInfo = this->sceneInfos[i];
+		sceneInfo.doneGlobal(this->scenes[i].global);
+	}
+}
+
+
+// functions
+
+void writeMappedMC(Pointer<IODevice> src, Pointer<IODevice> dst)
+{
+	MappedWriter w(src);
+	w.write(dst);
+}
+
 } // namespace digi
@@ -1,8 +1,9 @@
 #ifndef digi_Engine_MCFile_h
 #define digi_Engine_MCFile_h
 
-#include <digi/Utility/MemoryPool.h>
+#include <digi/Utility/Arena.h>
 #include <digi/Scene/ObjectReader.h>
+#include <digi/System/MappedFile.h>
 #include <digi/Engine/Engine.h>
 
 #include "CodeMemory.h"
@@ -60,15 +61,48 @@ protected:
 	std::vector<Global> textures;
 	std::vector<Global> scenes;
 
-	MemoryPool<char, 1024> stringPool;
-	MemoryPool<NodeInfo, 128> nodeInfoPool;
-	MemoryPool<AttributeInfo, 128> parameterInfoPool;
-	MemoryPool<TextureBinding, 64> textureBindingPool;
-	MemoryPool<AttributeSetInfo, 64> parameterSetInfoPool;
-	MemoryPool<ClipInfo, 64> clipInfoPool;
-	MemoryPool<ObjectInfo, 64> objectInfoPool;
+	// memory for strings and info arrays
+	Arena arena;
 };
 
+// machine code engine file in memory mapped layout (see writeMappedMC). only the code is copied into
+// executable memory, the data and scene infos are used in place
+class MappedMCFile : public EngineFile
+{
+public:
+	
+	MappedMCFile(Pointer<MappedFile> file);
+	virtual ~MappedMCFile();
+
+	virtual ArrayRef<const TextureInfo> getTextureInfos();
+	virtual void* getTextureGlobal(int index);
+
+	virtual ArrayRef<const SceneInfo> getSceneInfos();
+	virtual void* getSceneGlobal(int index);
+
+	virtual void done();
+
+protected:
+
+	Pointer<MappedFile> file;
+
+	std::vector<TextureInfo> textureInfos;
+	std::vector<SceneInfo> sceneInfos;		
+
+	struct Global
+	{
+		CodeMemory code;
+		DataMemory global;
+	};
+
+	std::vector<Global> textures;
+	std::vector<Global> scenes;
+};
+
+// convert machine code engine file into memory mapped layout that can be loaded by MappedMCFile.
+// the layout depends on the host machine (pointer size and byte order)
+void writeMappedMC(Pointer<IODevice> src, Pointer<IODevice> dst);
+
 /// @}
 
 } // namespace digi
@@ -0,0 +1,173 @@
+#include <algorithm>
+
+#include "NameIndex.h"
+
+
+namespace digi {
+
+namespace
+{
+	uint32_t getPowerOfTwo(size_t size)
+	{
+		uint32_t n = 1;
+		while (n < size)
+			n <<= 1;
+		return n;
+	}
+	
+	// compare functor for sorting buckets by size in descending order
+	struct BucketLess
+	{
+		BucketLess(const std::vector<uint32_t>& starts)
+			: starts(starts) {}
+
+		bool operator ()(uint32_t a, uint32_t b) const
+		{
+			return this->starts[a + 1] - this->starts[a] > this->starts[b + 1] - this->starts[b];
+		}
+		
+		const std::vector<uint32_t>& starts;
+	};
+
+	// maximum number of displacements to try for a bucket
+	const uint32_t MAX_DISPLACEMENT = 1 << 16;
+
+} // anonymous namespace
+
+
+// NameIndex
+
+void NameIndex::build(const std::vector<StringRef>& names)
+{
+	this->displacements.clear();
+	this->slots.clear();
+	this->overflow.clear();
+	this->bucketMask = 0;
+	this->slotMask = 0;
+
+	size_t numNames = names.size();
+	if (numNames == 0)
+		return;
+	
+	// about 4 names per bucket and a load factor between 0.5 and 1
+	uint32_t numBuckets = getPowerOfTwo((numNames + 3) / 4);
+	uint32_t numSlots = getPowerOfTwo(numNames);
+	this->bucketMask = numBuckets - 1;
+	this->slotMask = numSlots - 1;
+	this->displacements.resize(numBuckets);
+	this->slots.resize(numSlots);
+	
+	// precompute hashes
+	std::vector<uint32_t> hashes(numNames);
+	for (size_t i = 0; i < numNames; ++i)
+		hashes[i] = hash(names[i]);
+	
+	// sort names into buckets (counting sort)
+	std::vector<uint32_t> starts(numBuckets + 1);
+	for (size_t i = 0; i < numNames; ++i)
+		++starts[(hashes[i] & this->bucketMask) + 1];
+	for (uint32_t i = 0; i < numBuckets; ++i)
+		starts[i + 1] += starts[i];
+	std::vector<uint32_t> bucketNames(numNames);
+	{
+		std::vector<uint32_t> offsets(starts.begin(), starts.end() - 1);
+		for (size_t i = 0; i < numNames; ++i)
+			bucketNames[offsets[hashes[i] & this->bucketMask]++] = uint32_t(i);
+	}
+	
+	// place large buckets first while there are many free slots
+	std::vector<uint32_t> buckets(numBuckets);
+	for (uint32_t i = 0; i < numBuckets; ++i)
+		buckets[i] = i;
+	std::sort(buckets.begin(), buckets.end(), BucketLess(starts));
+	
+	std::vector<uint32_t> bucketSlots;
+	for (uint32_t i = 0; i < numBuckets; ++i)
+	{
+		uint32_t bucket = buckets[i];
+		uint32_t begin = starts[bucket];
+		uint32_t end = starts[bucket + 1];
+		if (begin == end)
+			break;
+		
+		// search a displacement so that all names of the bucket hit distinct free slots
+		bool found = false;
+		for (uint32_t displacement = 0; displacement < MAX_DISPLACEMENT && !found; ++displacement)
+		{
+			bucketSlots.clear();
+			found = true;
+			for (uint32_t j = begin; j < end; ++j)
+			{
+				uint32_t slot = getSlot(hashes[bucketNames[j]], displacement) & this->slotMask;
+				if (this->slots[slot].index != -1
+					|| std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+				{
+					found = false;
+					break;
+				}
+				bucketSlots.push_back(slot);
+			}
+			
+			if (found)
+			{
+				this->displacements[bucket] = displacement;
+				for (uint32_t j = begin; j < end; ++j)
+				{
+					uint32_t index = bucketNames[j];
+					Entry& entry = this->slots[bucketSlots[j - begin]];
+					entry.hash = hashes[index];
+					entry.index = int(index);
+					entry.name = names[index];
+				}
+			}
+		}
+		
+		if (!found)
+		{
+			// give up on this bucket
+			for (uint32_t j = begin; j < end; ++j)
+			{
+				uint32_t index = bucketNames[j];
+				Entry entry;
+				entry.hash = hashes[index];
+				entry.index = int(index);
+				entry.name = names[index];
+				this->overflow.push_back(entry);
+			}
+		}
+	}
+}
+
+int NameIndex::find(StringRef name) const
+{
+	if (this->slots.empty())
+		return -1;
+
+	uint32_t h = hash(name);
+	const Entry& entry = this->slots[getSlot(h, this->displacements[h & this->bucketMask]) & this->slotMask];
+	if (entry.hash == h && entry.name == name)
+		return entry.index;
+	
+	std::vector<Entry>::const_iterator end = this->overflow.end();
+	for (std::vector<Entry>::const_iterator it = this->overflow.begin(); it != end; ++it)
+	{
+		if (it->hash == h && it->name == name)
+			return it->index;
+	}
+	return -1;
+}
+
+uint32_t NameIndex::hash(StringRef name)
+{
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	const char* end = name.end();
+	for (const char* it = name.begin(); it != end; ++it)
+	{
+		h ^= uint8_t(*it);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+} // namespace digi
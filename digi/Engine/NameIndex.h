@@ -0,0 +1,89 @@
+#ifndef digi_Engine_NameIndex_h
+#define digi_Engine_NameIndex_h
+
+#include <vector>
+
+#include <digi/Base/Platform.h>
+#include <digi/Utility/StringRef.h>
+
+
+namespace digi {
+
+/// @addtogroup Engine
+/// @{
+
+/// perfect hash index for looking up names in info tables. the hashes of the names are computed when the index
+/// is built, therefore a lookup needs one hash of the searched name and usually one string compare
+class NameIndex
+{
+public:
+
+	NameIndex()
+		: bucketMask(0), slotMask(0) {}
+
+	/// build index for a table of infos that have a name member (e.g. AttributeInfo)
+	template <typename Iterator>
+	void build(Iterator begin, Iterator end)
+	{
+		std::vector<StringRef> names;
+		for (Iterator it = begin; it != end; ++it)
+			names.push_back(it->name);
+		this->build(names);
+	}
+
+	/// build index for given names. the names are not copied and must stay valid
+	void build(const std::vector<StringRef>& names);
+
+	/// find a name, returns its index in the table or -1 if not found
+	int find(StringRef name) const;
+	
+	/// hash function for names
+	static uint32_t hash(StringRef name);
+
+protected:
+
+	struct Entry
+	{
+		uint32_t hash;
+		int index;
+		StringRef name;
+		
+		Entry()
+			: hash(), index(-1) {}
+	};
+	
+	static uint32_t getSlot(uint32_t hash, uint32_t displacement)
+	{
+		uint32_t h = (hash ^ (displacement * 0x9e3779b9)) * 0x85ebca6b;
+		return h ^ (h >> 16);
+	}
+
+	// displacement for each bucket of hashes so that the names of a bucket hit free slots
+	std::vector<uint32_t> displacements;
+	uint32_t bucketMask;
+	
+	// hash table without collisions
+	std::vector<Entry> slots;
+	uint32_t slotMask;
+
+	// names for which no free slots were found (in practice only names with the same hash)
+	std::vector<Entry> overflow;
+};
+
+/// name indices of a scene
+struct SceneNameIndex
+{
+	NameIndex attributes;
+	NameIndex attributeSets;
+	
+	// clips are indexed per attribute set
+	std::vector<NameIndex> clips;
+	
+	NameIndex objects;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
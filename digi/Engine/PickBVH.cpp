@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <limits>
+
+#include "PickBVH.h"
+
+
+namespace digi {
+
+namespace {
+
+// maximum number of primitives in a leaf node
+const int LEAF_SIZE = 4;
+
+// size of traversal stack
+const int STACK_SIZE = 64;
+
+// ray parameter for a miss, larger than any distance
+const float NO_HIT = std::numeric_limits<float>::infinity();
+
+inline float getComponent(float3 v, int axis)
+{
+	return (&v.x)[axis];
+}
+
+// compares the centers of two boxes along an axis
+struct CenterLess
+{
+	const PickBVH::Box* boxes;
+	int axis;
+
+	bool operator ()(int a, int b) const
+	{
+		return getComponent(this->boxes[a].minimum + this->boxes[a].maximum, this->axis)
+			< getComponent(this->boxes[b].minimum + this->boxes[b].maximum, this->axis);
+	}
+};
+
+void buildNode(const std::vector<PickBVH::Box>& boxes, std::vector<PickBVH::Node>& nodes,
+	std::vector<int>& primitiveIndices, int nodeIndex, int begin, int end, int depth)
+{
+	// bounding box of primitives and of their centers
+	float3 minimum = splat3(1e30f);
+	float3 maximum = splat3(-1e30f);
+	float3 minCenter = splat3(1e30f);
+	float3 maxCenter = splat3(-1e30f);
+	for (int i = begin; i < end; ++i)
+	{
+		const PickBVH::Box& box = boxes[primitiveIndices[i]];
+		minimum = min(minimum, box.minimum);
+		maximum = max(maximum, box.maximum);
+		float3 center = box.minimum + box.maximum;
+		minCenter = min(minCenter, center);
+		maxCenter = max(maxCenter, center);
+	}
+	nodes[nodeIndex].minimum = minimum;
+	nodes[nodeIndex].maximum = maximum;
+
+	// split at the median of the axis with the largest extent of the centers
+	float3 extent = maxCenter - minCenter;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	if (end - begin <= LEAF_SIZE || getComponent(extent, axis) <= 0.0f || depth >= STACK_SIZE - 2)
+	{
+		nodes[nodeIndex].index = begin;
+		nodes[nodeIndex].count = end - begin;
+		return;
+	}
+	int middle = (begin + end) / 2;
+	CenterLess less = {boxes.data(), axis};
+	std::nth_element(primitiveIndices.begin() + begin, primitiveIndices.begin() + middle,
+		primitiveIndices.begin() + end, less);
+
+	// children are stored next to each other
+	int childIndex = int(nodes.size());
+	nodes.resize(childIndex + 2);
+	nodes[nodeIndex].index = childIndex;
+	nodes[nodeIndex].count = 0;
+	buildNode(boxes, nodes, primitiveIndices, childIndex, begin, middle, depth + 1);
+	buildNode(boxes, nodes, primitiveIndices, childIndex + 1, middle, end, depth + 1);
+}
+
+// intersect ray with box of a node. returns the ray parameter where the ray enters the box or NO_HIT if the box is
+// missed or only hit beyond distance
+inline float intersectNode(const PickBVH::Node& node, float3 origin, float3 invDirection, float distance)
+{
+	float3 t1 = (node.minimum - origin) * invDirection;
+	float3 t2 = (node.maximum - origin) * invDirection;
+	float3 tMin = min(t1, t2);
+	float3 tMax = max(t1, t2);
+	float tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0f));
+	float tFar = min(min(tMax.x, tMax.y), min(tMax.z, distance));
+	return tNear <= tFar ? tNear : NO_HIT;
+}
+
+// inverse direction that avoids 0 * infinity in intersectNode
+inline float3 calcInvDirection(float3 direction)
+{
+	float3 d;
+	d.x = abs(direction.x) > 1e-30f ? direction.x : 1e-30f;
+	d.y = abs(direction.y) > 1e-30f ? direction.y : 1e-30f;
+	d.z = abs(direction.z) > 1e-30f ? direction.z : 1e-30f;
+	return splat3(1.0f) / d;
+}
+
+// traverse a hierarchy front to back and call visitor.leaf(index, count, distance) for each leaf that is hit by the
+// ray before distance. the visitor reduces distance when it finds a hit
+template <typename Visitor>
+void traverse(const std::vector<PickBVH::Node>& nodes, float3 origin, float3 direction, float& distance,
+	Visitor& visitor)
+{
+	if (nodes.empty())
+		return;
+	float3 invDirection = calcInvDirection(direction);
+
+	int stack[STACK_SIZE];
+	float stackNear[STACK_SIZE];
+	int stackSize = 0;
+	if (intersectNode(nodes[0], origin, invDirection, distance) == NO_HIT)
+		return;
+	stack[stackSize] = 0;
+	stackNear[stackSize] = 0.0f;
+	++stackSize;
+	while (stackSize > 0)
+	{
+		--stackSize;
+
+		// skip node if a closer hit was found after it was pushed
+		if (stackNear[stackSize] >= distance)
+			continue;
+		const PickBVH::Node& node = nodes[stack[stackSize]];
+		if (node.count > 0)
+		{
+			visitor.leaf(node.index, node.count, distance);
+		}
+		else
+		{
+			// push the farther child first so that the nearer child is visited first
+			float near0 = intersectNode(nodes[node.index], origin, invDirection, distance);
+			float near1 = intersectNode(nodes[node.index + 1], origin, invDirection, distance);
+			int first = node.index;
+			int second = node.index + 1;
+			if (near1 < near0)
+			{
+				std::swap(first, second);
+				std::swap(near0, near1);
+			}
+			if (near1 < distance)
+			{
+				stack[stackSize] = second;
+				stackNear[stackSize] = near1;
+				++stackSize;
+			}
+			if (near0 < distance)
+			{
+				stack[stackSize] = first;
+				stackNear[stackSize] = near0;
+				++stackSize;
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+
+// PickBVH
+
+// visitor for the triangles of a mesh
+struct PickBVH::TriangleVisitor
+{
+	const float3* positions;
+	float3 origin;
+	float3 direction;
+	bool hit;
+	int numTests;
+
+	void leaf(int index, int count, float& distance)
+	{
+		const float3* p = this->positions + index * 3;
+		this->numTests += count;
+		for (int i = 0; i < count; ++i, p += 3)
+		{
+			// only accept hits in front of the current hit
+			float3 tuv;
+			if (intersectRayTriangle(this->origin, this->direction, p[0], p[1], p[2], tuv)
+				&& tuv.x >= 0.0f && tuv.x < distance)
+			{
+				distance = tuv.x;
+				this->hit = true;
+			}
+		}
+	}
+};
+
+// visitor for the instances
+struct PickBVH::InstanceVisitor
+{
+	PickBVH* bvh;
+	float3 origin;
+	float3 direction;
+	int objectId;
+	int numTriangleTests;
+
+	void leaf(int index, int count, float& distance)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			const Instance& instance = this->bvh->instances[this->bvh->instanceIndices[index + i]];
+			if (!instance.visible)
+				continue;
+
+			// transform ray into object space. the ray parameter stays the same
+			const Mesh& mesh = this->bvh->meshes[instance.meshIndex];
+			TriangleVisitor visitor;
+			visitor.positions = mesh.positions.data();
+			visitor.origin = transformPosition(instance.inverseMatrix, this->origin);
+			visitor.direction = transformDirection(instance.inverseMatrix, this->direction);
+			visitor.hit = false;
+			visitor.numTests = 0;
+			traverse(mesh.nodes, visitor.origin, visitor.direction, distance, visitor);
+			if (visitor.hit)
+				this->objectId = instance.objectId;
+			this->numTriangleTests += visitor.numTests;
+		}
+	}
+};
+
+PickBVH::PickBVH()
+	: numTriangleTests(0)
+{
+}
+
+PickBVH::~PickBVH()
+{
+}
+
+void PickBVH::clear()
+{
+	this->meshes.clear();
+	this->instances.clear();
+	this->nodes.clear();
+	this->instanceIndices.clear();
+}
+
+int PickBVH::addMesh(const float3* positions, const int* triangleVertexIndices, int numTriangles)
+{
+	int meshIndex = int(this->meshes.size());
+	this->meshes.push_back(Mesh());
+	Mesh& mesh = this->meshes.back();
+	if (numTriangles <= 0)
+		return meshIndex;
+
+	// bounding boxes of triangles
+	std::vector<Box> boxes(numTriangles);
+	for (int i = 0; i < numTriangles; ++i)
+	{
+		float3 p0 = positions[triangleVertexIndices[i * 3 + 0]];
+		float3 p1 = positions[triangleVertexIndices[i * 3 + 1]];
+		float3 p2 = positions[triangleVertexIndices[i * 3 + 2]];
+		boxes[i].minimum = min(p0, min(p1, p2));
+		boxes[i].maximum = max(p0, max(p1, p2));
+	}
+
+	// build hierarchy and copy triangles in leaf order
+	std::vector<int> triangleIndices;
+	build(boxes, mesh.nodes, triangleIndices);
+	mesh.positions.resize(numTriangles * 3);
+	for (int i = 0; i < numTriangles; ++i)
+	{
+		const int* t = triangleVertexIndices + triangleIndices[i] * 3;
+		mesh.positions[i * 3 + 0] = positions[t[0]];
+		mesh.positions[i * 3 + 1] = positions[t[1]];
+		mesh.positions[i * 3 + 2] = positions[t[2]];
+	}
+	return meshIndex;
+}
+
+int PickBVH::addInstance(int meshIndex, const float4x4& matrix, int objectId)
+{
+	int instanceIndex = int(this->instances.size());
+	this->instances.push_back(Instance());
+	Instance& instance = this->instances.back();
+	instance.meshIndex = meshIndex;
+	instance.objectId = objectId;
+	instance.visible = true;
+	this->calcBox(instance, matrix);
+	return instanceIndex;
+}
+
+void PickBVH::setMatrix(int instanceIndex, const float4x4& matrix)
+{
+	this->calcBox(this->instances[instanceIndex], matrix);
+}
+
+void PickBVH::build()
+{
+	int numInstances = int(this->instances.size());
+	std::vector<Box> boxes(numInstances);
+	for (int i = 0; i < numInstances; ++i)
+		boxes[i] = this->instances[i].box;
+	build(boxes, this->nodes, this->instanceIndices);
+}
+
+void PickBVH::refit()
+{
+	// children are always stored after their parent, therefore update in reverse order
+	for (int nodeIndex = int(this->nodes.size()) - 1; nodeIndex >= 0; --nodeIndex)
+	{
+		Node& node = this->nodes[nodeIndex];
+		float3 minimum = splat3(1e30f);
+		float3 maximum = splat3(-1e30f);
+		if (node.count > 0)
+		{
+			for (int i = 0; i < node.count; ++i)
+			{
+				const Box& box = this->instances[this->instanceIndices[node.index + i]].box;
+				minimum = min(minimum, box.minimum);
+				maximum = max(maximum, box.maximum);
+			}
+		}
+		else
+		{
+			minimum = min(this->nodes[node.index].minimum, this->nodes[node.index + 1].minimum);
+			maximum = max(this->nodes[node.index].maximum, this->nodes[node.index + 1].maximum);
+		}
+		node.minimum = minimum;
+		node.maximum = maximum;
+	}
+}
+
+int PickBVH::pick(float3 origin, float3 direction, float& distance)
+{
+	return this->pick(origin, direction, NO_HIT, distance);
+}
+
+int PickBVH::pick(float3 origin, float3 direction, float maxDistance, float& distance)
+{
+	InstanceVisitor visitor;
+	visitor.bvh = this;
+	visitor.origin = origin;
+	visitor.direction = direction;
+	visitor.objectId = 0;
+	visitor.numTriangleTests = 0;
+	distance = maxDistance;
+	traverse(this->nodes, origin, direction, distance, visitor);
+	this->numTriangleTests = visitor.numTriangleTests;
+	return visitor.objectId;
+}
+
+int PickBVH::pick(const float4x4& viewMatrix, const float4x4& projectionMatrix, float x, float y)
+{
+	// unproject points on near and far plane
+	float4x4 inverseViewProjection = inv(projectionMatrix * viewMatrix);
+	float4 n = inverseViewProjection * vector4(x, y, -1.0f, 1.0f);
+	float4 f = inverseViewProjection * vector4(x, y, 1.0f, 1.0f);
+	float3 origin = getXYZ(n) / n.w;
+	float3 direction = getXYZ(f) / f.w - origin;
+
+	// only pick up to the far plane
+	float distance;
+	return this->pick(origin, direction, 1.0f, distance);
+}
+
+void PickBVH::build(const std::vector<Box>& boxes, std::vector<Node>& nodes, std::vector<int>& primitiveIndices)
+{
+	int numPrimitives = int(boxes.size());
+	nodes.clear();
+	primitiveIndices.resize(numPrimitives);
+	for (int i = 0; i < numPrimitives; ++i)
+		primitiveIndices[i] = i;
+	if (numPrimitives == 0)
+		return;
+	nodes.reserve(numPrimitives * 2 / LEAF_SIZE + 1);
+	nodes.resize(1);
+	buildNode(boxes, nodes, primitiveIndices, 0, 0, numPrimitives, 0);
+}
+
+void PickBVH::calcBox(Instance& instance, const float4x4& matrix)
+{
+	instance.inverseMatrix = inv(matrix);
+
+	const Mesh& mesh = this->meshes[instance.meshIndex];
+	if (mesh.nodes.empty())
+	{
+		// empty mesh can't be hit
+		instance.box.minimum = splat3(1e30f);
+		instance.box.maximum = splat3(-1e30f);
+		return;
+	}
+
+	// transform center and extent of bounding box of mesh
+	const Node& root = mesh.nodes[0];
+	float3 center = transformPosition(matrix, (root.minimum + root.maximum) * 0.5f);
+	float3 extent = (root.maximum - root.minimum) * 0.5f;
+	extent = abs(getXYZ(matrix.x)) * extent.x + abs(getXYZ(matrix.y)) * extent.y + abs(getXYZ(matrix.z)) * extent.z;
+	instance.box.minimum = center - extent;
+	instance.box.maximum = center + extent;
+}
+
+} // namespace digi
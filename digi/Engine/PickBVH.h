@@ -0,0 +1,135 @@
+#ifndef digi_Engine_PickBVH_h
+#define digi_Engine_PickBVH_h
+
+#include <vector>
+
+#include <digi/Math/All.h>
+
+
+namespace digi {
+
+/// @addtogroup Engine
+/// @{
+
+/**
+	bounding volume hierarchy for picking on the cpu as an alternative to Engine::pickGroup() which renders into a
+	frame buffer and reads back a pixel. each mesh gets a hierarchy over its triangles in object space, the instances
+	of the meshes get a hierarchy over their world space bounding boxes. after the matrix of an instance has changed
+	the instance hierarchy can be refitted without rebuilding it.
+*/
+class PickBVH
+{
+public:
+
+	// node of a hierarchy. inner nodes have count 0 and index is the first of the two consecutive children,
+	// leaf nodes reference count primitives starting at index
+	struct Node
+	{
+		float3 minimum;
+		float3 maximum;
+		int index;
+		int count;
+	};
+
+	// box of a primitive for building a hierarchy
+	struct Box
+	{
+		float3 minimum;
+		float3 maximum;
+	};
+
+
+	PickBVH();
+	~PickBVH();
+
+	/// remove all meshes and instances
+	void clear();
+
+	/// add a triangle mesh. the triangles are copied and a hierarchy is built over them. returns the mesh index
+	int addMesh(const float3* positions, const int* triangleVertexIndices, int numTriangles);
+	int addMesh(const std::vector<float3>& positions, const std::vector<int>& triangleVertexIndices)
+	{
+		return this->addMesh(positions.data(), triangleVertexIndices.data(), int(triangleVertexIndices.size() / 3));
+	}
+
+	/// add an instance of a mesh with world matrix and object id (see Engine::getObjectId()). returns the instance
+	/// index. build() must be called before the next pick
+	int addInstance(int meshIndex, const float4x4& matrix, int objectId);
+
+	/// get number of instances
+	int getNumInstances() {return int(this->instances.size());}
+
+	/// set world matrix of an instance. refit() must be called before the next pick
+	void setMatrix(int instanceIndex, const float4x4& matrix);
+
+	/// show or hide an instance. hidden instances can't be picked
+	void setVisible(int instanceIndex, bool visible) {this->instances[instanceIndex].visible = visible;}
+
+	/// build the instance hierarchy
+	void build();
+
+	/// update the bounding boxes of the instance hierarchy after matrices have changed. picking gets slower if the
+	/// instances moved far from their position at build time, then build() should be called again
+	void refit();
+
+	/// pick the object that is hit first by the given ray. returns the object id or 0 if no object was hit,
+	/// distance is the ray parameter of the hit
+	int pick(float3 origin, float3 direction, float& distance);
+
+	/// pick the object that is hit first by the given ray with a ray parameter below maxDistance
+	int pick(float3 origin, float3 direction, float maxDistance, float& distance);
+
+	/// pick an object at device coordinates x, y which range from -1 to 1, same as Engine::pickGroup()
+	int pick(const float4x4& viewMatrix, const float4x4& projectionMatrix, float x, float y);
+	int pick(const float4x4& viewMatrix, const float4x4& projectionMatrix, float2 position)
+	{
+		return this->pick(viewMatrix, projectionMatrix, position.x, position.y);
+	}
+
+	/// get number of ray/triangle tests of the last pick for statistics
+	int getNumTriangleTests() {return this->numTriangleTests;}
+
+protected:
+
+	struct Mesh
+	{
+		std::vector<Node> nodes;
+
+		// three positions per triangle in the order of the leaf nodes
+		std::vector<float3> positions;
+	};
+
+	struct Instance
+	{
+		int meshIndex;
+		int objectId;
+		bool visible;
+		float4x4 inverseMatrix;
+		Box box;
+	};
+
+	// build hierarchy over boxes, primitiveIndices gets the order of the primitives in the leaf nodes
+	static void build(const std::vector<Box>& boxes, std::vector<Node>& nodes, std::vector<int>& primitiveIndices);
+
+	// calc world space bounding box of an instance
+	void calcBox(Instance& instance, const float4x4& matrix);
+
+	struct TriangleVisitor;
+	struct InstanceVisitor;
+	friend struct InstanceVisitor;
+
+	std::vector<Mesh> meshes;
+	std::vector<Instance> instances;
+
+	// instance hierarchy
+	std::vector<Node> nodes;
+	std::vector<int> instanceIndices;
+
+	int numTriangleTests;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
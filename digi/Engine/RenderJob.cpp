@@ -3,98 +3,106 @@
 
 namespace digi {
 
-void renderSorted(RenderJob* renderJobs)
+namespace
 {
-	//ResetShader resetShader = &resetShaderDummy;
-
-	// list merge sort by Simon Tatham
-	typedef RenderJob Element;
-	Element* list = renderJobs;
-	
-	int insize = 1;
-
-	while (true)
+	// convert float to unsigned int so that larger distances result in smaller keys
+	inline uint32_t getSortKey(float distance)
 	{
-		Element* p = list;
-		list = NULL;
-		Element* tail = NULL;
-
-		int nmerges = 0;  /* count number of merges we do in this pass */
-
-		while (p != NULL)
+		union
 		{
-			nmerges++;  /* there exists a merge to be done */
-			
-			/* step `insize' places along from p */
-			Element* q = p;
-			int psize = 0;
-			for (int i = 0; i < insize; i++)
-			{
-				psize++;
-				q = q->next;
-				if (q == NULL)
-					break;
-			}
-
-			/* if q hasn't fallen off end, we have two lists to merge */
-			int qsize = insize;
-
-			/* now we have two lists; merge them */
-			Element* e;
-			while (psize > 0 || (qsize > 0 && q != NULL))
-			{
-				/* decide whether next element of merge comes from p or q */
-				if (psize == 0)
-				{
-					/* p is empty; e must come from q. */
-					e = q; q = q->next; qsize--;
-				}
-				else if (qsize == 0 || q == NULL)
-				{
-					/* q is empty; e must come from p. */
-					e = p; p = p->next; psize--;
-				}
-				else if (p->distance > q->distance)
-				{
-					/* First element of p is lower (or same); e must come from p. */
-					e = p; p = p->next; psize--;
-				}
-				else
-				{
-					/* First element of q is lower; e must come from q. */
-					e = q; q = q->next; qsize--;
-				}
+			float f;
+			uint32_t u;
+		} v;
+		v.f = distance;
+		
+		// flip sign bit of positive values and all bits of negative values to get an ascending order, then invert
+		uint32_t mask = uint32_t(-int32_t(v.u >> 31)) | 0x80000000;
+		return ~(v.u ^ mask);
+	}
+	
+	// number of bits per radix sort pass (3 passes for 32 bit keys)
+	const int RADIX_BITS = 11;
+	const int RADIX_SIZE = 1 << RADIX_BITS;
+	const int RADIX_MASK = RADIX_SIZE - 1;
+	const int NUM_PASSES = (32 + RADIX_BITS - 1) / RADIX_BITS;
+	
+} // anonymous namespace
 
-				/* add the next element to the merged list */
-				if (tail != NULL)
-					tail->next = e;
-				else
-					list = e;
 
-				tail = e;
-			}
+void renderSorted(RenderJob* renderJobs, std::vector<RenderSortKey>& sortKeys)
+{
+	//ResetShader resetShader = &resetShaderDummy;
 
-			/* now p has stepped `insize' places along, and q has too */
-			p = q;
+	// count render jobs
+	size_t numJobs = 0;
+	for (RenderJob* it = renderJobs; it != NULL; it = it->next)
+		++numJobs;
+	if (numJobs == 0)
+		return;
+
+	// the buffer holds the keys and a temp array of the same size
+	if (sortKeys.size() < numJobs * 2)
+		sortKeys.resize(numJobs * 2);
+	RenderSortKey* keys = sortKeys.data();
+	RenderSortKey* temp = keys + numJobs;
+	
+	// gather keys into packed array and build histograms for all passes in one go
+	uint32_t histograms[NUM_PASSES][RADIX_SIZE] = {};
+	{
+		RenderSortKey* key = keys;
+		for (RenderJob* it = renderJobs; it != NULL; it = it->next, ++key)
+		{
+			uint32_t k = getSortKey(it->distance);
+			key->key = k;
+			key->renderJob = it;
+			for (int pass = 0; pass < NUM_PASSES; ++pass)
+				++histograms[pass][(k >> pass * RADIX_BITS) & RADIX_MASK];
 		}
-		tail->next = NULL;
-
-		/* If we have done only one merge, we're finished. */
-		if (nmerges <= 1)   /* allow for nmerges==0, the empty list case */
-			break;
-
-		/* Otherwise repeat, merging lists twice the size */
-		insize *= 2;
 	}
-
-
-	while (list != NULL)
+	
+	// least significant digit radix sort, stable so that jobs of equal distance stay in queue order
+	for (int pass = 0; pass < NUM_PASSES; ++pass)
+	{
+		uint32_t* histogram = histograms[pass];
+		int shift = pass * RADIX_BITS;
+		
+		// skip pass if all keys have the same digit
+		if (histogram[(keys[0].key >> shift) & RADIX_MASK] == numJobs)
+			continue;
+		
+		// convert histogram to start offsets
+		uint32_t offset = 0;
+		for (int i = 0; i < RADIX_SIZE; ++i)
+		{
+			uint32_t count = histogram[i];
+			histogram[i] = offset;
+			offset += count;
+		}
+		
+		// scatter
+		RenderSortKey* end = keys + numJobs;
+		for (RenderSortKey* it = keys; it != end; ++it)
+		{
+			temp[histogram[(it->key >> shift) & RADIX_MASK]++] = *it;
+		}
+		std::swap(keys, temp);
+	}
+	
+	// render in sorted order
+	RenderSortKey* end = keys + numJobs;
+	for (RenderSortKey* it = keys; it != end; ++it)
 	{
 		//resetShader = list->render(list, resetShader);
-		list->render(list);
-		list = list->next;
+		RenderJob* renderJob = it->renderJob;
+		renderJob->render(renderJob);
 	}
 }
+
+void renderSorted(RenderJob* renderJobs)
+{
+	std::vector<RenderSortKey> sortKeys;
+	renderSorted(renderJobs, sortKeys);
+}
 /*
 void resetShaderDummy()
 {
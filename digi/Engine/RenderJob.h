@@ -1,6 +1,8 @@
 #ifndef digi_Engine_RenderJob_h
 #define digi_Engine_RenderJob_h
 
+#include <vector>
+
 #include <digi/Utility/Standard.h>
 #include <digi/Math/All.h>
 #include <digi/OpenGL/GLWrapper.h>
@@ -49,6 +51,19 @@ struct RenderQueues
 	RenderJob* alphaSort;
 };
 
+// sort key of a render job. the jobs are sorted as a packed array of keys instead of chasing the next pointers
+struct RenderSortKey
+{
+	// distance converted to an unsigned integer that sorts back to front
+	uint32_t key;
+
+	RenderJob* renderJob;
+};
+
+/// sort render jobs back to front by distance and render them. sortKeys is a buffer that gets reused between calls
+void renderSorted(RenderJob* renderJobs, std::vector<RenderSortKey>& sortKeys);
+
+/// sort render jobs back to front by distance and render them
 void renderSorted(RenderJob* renderJobs);
 
 //void resetShaderDummy();
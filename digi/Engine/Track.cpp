@@ -1,5 +1,10 @@
 #include "Track.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define DIGI_TRACK_SSE
+#endif
+
 
 namespace digi {
 
@@ -407,4 +412,168 @@ float evalCatmullRomTrack(const uint16_t* yValues, float x)
 		a);
 }
 
+// batch evaluation
+
+namespace
+{
+	// find index of key starting at the cached index of the last evaluation. during coherent playback
+	// the key is either the cached key or its successor, otherwise fall back to binary search
+	template <typename Type, typename XType>
+	inline int findCachedIndex(const Type* xValues, int numKeys, XType x, int index)
+	{
+		if (index < numKeys && xValues[index] <= x)
+		{
+			if (index + 1 >= numKeys || xValues[index + 1] > x)
+				return index;
+			if (index + 2 >= numKeys || xValues[index + 2] > x)
+				return index + 1;
+		}
+		return findIndex(xValues, numKeys, x);
+	}
+
+	// polynomial coefficients of u^3, u^2, u, 1 in terms of the 4 control values
+	const float hermiteBasis[4][4] = {
+		{ 2,  1,  1, -2},
+		{-3, -2, -1,  3},
+		{ 0,  1,  0,  0},
+		{ 1,  0,  0,  0}};
+
+	const float bezierBasis[4][4] = {
+		{-1,  3, -3,  1},
+		{ 3, -6,  3,  0},
+		{-3,  3,  0,  0},
+		{ 1,  0,  0,  0}};
+
+	// spline segments of 4 tracks in structure of arrays layout
+	struct Segments
+	{
+		float x0[4];
+		float x1[4];
+		float y[4][4];
+	};
+
+	// evaluate spline segments of 4 tracks at x
+	inline void evalSegments(const float (*basis)[4], const Segments& s, float x, float* results)
+	{
+	#ifdef DIGI_TRACK_SSE
+		__m128 x0 = _mm_loadu_ps(s.x0);
+		__m128 u = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(x), x0), _mm_sub_ps(_mm_loadu_ps(s.x1), x0));
+		__m128 y0 = _mm_loadu_ps(s.y[0]);
+		__m128 y1 = _mm_loadu_ps(s.y[1]);
+		__m128 y2 = _mm_loadu_ps(s.y[2]);
+		__m128 y3 = _mm_loadu_ps(s.y[3]);
+		
+		// horner scheme
+		__m128 r = _mm_setzero_ps();
+		for (int i = 0; i < 4; ++i)
+		{
+			const float* b = basis[i];
+			__m128 c = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(b[0]), y0), _mm_mul_ps(_mm_set1_ps(b[1]), y1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(b[2]), y2), _mm_mul_ps(_mm_set1_ps(b[3]), y3)));
+			r = _mm_add_ps(_mm_mul_ps(r, u), c);
+		}
+		_mm_storeu_ps(results, r);
+	#else
+		for (int j = 0; j < 4; ++j)
+		{
+			float u = (x - s.x0[j]) / (s.x1[j] - s.x0[j]);
+
+			// horner scheme
+			float r = 0.0f;
+			for (int i = 0; i < 4; ++i)
+			{
+				const float* b = basis[i];
+				r = r * u + b[0] * s.y[0][j] + b[1] * s.y[1][j] + b[2] * s.y[2][j] + b[3] * s.y[3][j];
+			}
+			results[j] = r;
+		}
+	#endif
+	}
+
+	template <typename Type, typename XType>
+	void evalSplineTracks(const float (*basis)[4], BatchTrack<Type>* tracks, int numTracks, float x, float* results)
+	{
+		XType tx = XType(x);
+		Segments s;
+		for (int i = 0; i < numTracks; i += 4)
+		{
+			int count = min(numTracks - i, 4);
+			
+			// gather spline segments of up to 4 tracks. the last key cannot be found
+			for (int j = 0; j < count; ++j)
+			{
+				BatchTrack<Type>& track = tracks[i + j];
+				int index = findCachedIndex(track.xValues, track.numKeys - 1, tx, track.keyIndex);
+				track.keyIndex = index;
+				
+				s.x0[j] = float(track.xValues[index]);
+				s.x1[j] = float(track.xValues[index + 1]);
+				const Type* y = track.yValues + index * 3;
+				s.y[0][j] = float(y[0]);
+				s.y[1][j] = float(y[1]);
+				s.y[2][j] = float(y[2]);
+				s.y[3][j] = float(y[3]);
+			}
+			
+			if (count == 4)
+			{
+				evalSegments(basis, s, x, results + i);
+			}
+			else
+			{
+				// fill unused lanes with a valid segment
+				for (int j = count; j < 4; ++j)
+				{
+					s.x0[j] = 0.0f;
+					s.x1[j] = 1.0f;
+					s.y[0][j] = s.y[1][j] = s.y[2][j] = s.y[3][j] = 0.0f;
+				}
+				float r[4];
+				evalSegments(basis, s, x, r);
+				for (int j = 0; j < count; ++j)
+					results[i + j] = r[j];
+			}
+		}
+	}
+
+	template <typename Type, typename XType>
+	void evalStepTracks(BatchTrack<Type>* tracks, int numTracks, float x, float* results)
+	{
+		XType tx = XType(x);
+		for (int i = 0; i < numTracks; ++i)
+		{
+			BatchTrack<Type>& track = tracks[i];
+			int index = findCachedIndex(track.xValues, track.numKeys, tx, track.keyIndex);
+			track.keyIndex = index;
+			results[i] = float(track.yValues[index]);
+		}
+	}
+} // anonymous namespace
+
+void evalStepTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results)
+{
+	evalStepTracks<float, float>(tracks, numTracks, x, results);
+}
+
+void evalHermiteTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results)
+{
+	evalSplineTracks<float, float>(hermiteBasis, tracks, numTracks, x, results);
+}
+
+void evalBezierTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results)
+{
+	evalSplineTracks<float, float>(bezierBasis, tracks, numTracks, x, results);
+}
+
+void evalStepTracks(BatchTrack<uint16_t>* tracks, int numTracks, float x, float* results)
+{
+	evalStepTracks<uint16_t, int>(tracks, numTracks, x, results);
+}
+
+void evalBezierTracks(BatchTrack<uint16_t>* tracks, int numTracks, float x, float* results)
+{
+	evalSplineTracks<uint16_t, int>(bezierBasis, tracks, numTracks, x, results);
+}
+
 }
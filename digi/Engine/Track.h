@@ -50,6 +50,35 @@ float evalWeightedBezierTrack(const uint16_t* xValues, const uint16_t* yValues,
 float evalCatmullRomTrack(const uint16_t* yValues, float x);
 
 
+// batch evaluation
+
+// track for batch evaluation of many tracks of a clip at the same time. keyIndex caches the
+// key index of the last evaluation for coherent playback and should be initialized to 0
+template <typename Type>
+struct BatchTrack
+{
+	const Type* xValues;
+	const Type* yValues;
+	int numKeys;
+	int keyIndex;
+};
+
+// step tracks
+void evalStepTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results);
+
+// hermite spline tracks, evaluates 4 tracks at once using SIMD
+void evalHermiteTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results);
+
+// bezier spline tracks, evaluates 4 tracks at once using SIMD
+void evalBezierTracks(BatchTrack<float>* tracks, int numTracks, float x, float* results);
+
+// step tracks
+void evalStepTracks(BatchTrack<uint16_t>* tracks, int numTracks, float x, float* results);
+
+// bezier spline tracks, evaluates 4 tracks at once using SIMD
+void evalBezierTracks(BatchTrack<uint16_t>* tracks, int numTracks, float x, float* results);
+
+
 /// @}
 
 } // namespace digi
@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
 
 #include <digi/Base/VersionInfo.h>
+#include <digi/Utility/Convert.h>
 #include <digi/Math/GTestHelpers.h>
+#include <digi/System/File.h>
+#include <digi/System/ThreadPool.h>
+#include <digi/System/Timer.h>
+#include <digi/Data/DataException.h>
+#include <digi/Scene/ObjectWriter.h>
+#include <digi/Engine/Engine.h>
 #include <digi/Engine/Track.h>
+#include <digi/Engine/MCFile.h>
+#include <digi/Engine/PickBVH.h>
 
 #include "InitLibraries.h"
 
@@ -78,6 +87,620 @@ TEST(Engine, WeightedTrack)
 	}
 }
 
+
+TEST(Engine, BatchTrack)
+{
+	const int numTracks = 301;
+	const int numKeys = 50;
+
+	// random bezier and hermite tracks with float and quantized keys
+	std::vector<float> xValues(numTracks * numKeys);
+	std::vector<float> yValues(numTracks * (numKeys * 3 - 2));
+	std::vector<uint16_t> xValues16(numTracks * numKeys);
+	std::vector<uint16_t> yValues16(numTracks * (numKeys * 3 - 2));
+	uint32_t seed = 0;
+	for (size_t i = 0; i < yValues.size(); ++i)
+	{
+		seed = 1103515245 * seed + 12345;
+		yValues[i] = float(seed >> 8) / float(1 << 24);
+		yValues16[i] = uint16_t(seed >> 16);
+	}
+	std::vector<BatchTrack<float> > tracks(numTracks);
+	std::vector<BatchTrack<uint16_t> > tracks16(numTracks);
+	for (int i = 0; i < numTracks; ++i)
+	{
+		float* x = &xValues[i * numKeys];
+		uint16_t* x16 = &xValues16[i * numKeys];
+		for (int j = 0; j < numKeys; ++j)
+		{
+			// different key times per track
+			x[j] = float(j * 10 + i % 7);
+			x16[j] = uint16_t(j * 10 + i % 7);
+		}
+		BatchTrack<float> track = {x, &yValues[i * (numKeys * 3 - 2)], numKeys, 0};
+		tracks[i] = track;
+		BatchTrack<uint16_t> track16 = {x16, &yValues16[i * (numKeys * 3 - 2)], numKeys, 0};
+		tracks16[i] = track16;
+	}
+
+	// compare against scalar evaluation, playback forward and with jumps
+	std::vector<float> results(numTracks);
+	for (int k = 0; k < 1000; ++k)
+	{
+		float time = k < 900 ? float(k) * 0.55f : float((k * 37) % 500);
+		
+		evalStepTracks(&tracks[0], numTracks, time, &results[0]);
+		for (int i = 0; i < numTracks; ++i)
+			EXPECT_EQ(results[i], evalStepTrack(tracks[i].xValues, tracks[i].yValues, numKeys, time));
+		
+		evalHermiteTracks(&tracks[0], numTracks, time, &results[0]);
+		for (int i = 0; i < numTracks; ++i)
+			EXPECT_NEAR(results[i], evalHermiteTrack(tracks[i].xValues, tracks[i].yValues, numKeys, time), 1e-3f);
+
+		evalBezierTracks(&tracks[0], numTracks, time, &results[0]);
+		for (int i = 0; i < numTracks; ++i)
+			EXPECT_NEAR(results[i], evalBezierTrack(tracks[i].xValues, tracks[i].yValues, numKeys, time), 1e-3f);
+
+		evalStepTracks(&tracks16[0], numTracks, time, &results[0]);
+		for (int i = 0; i < numTracks; ++i)
+			EXPECT_EQ(results[i], evalStepTrack(tracks16[i].xValues, tracks16[i].yValues, numKeys, time));
+
+		evalBezierTracks(&tracks16[0], numTracks, time, &results[0]);
+		for (int i = 0; i < numTracks; ++i)
+			EXPECT_NEAR(results[i], evalBezierTrack(tracks16[i].xValues, tracks16[i].yValues, numKeys, time), 0.1f);
+	}
+
+	// benchmark against scalar evaluation
+	const int numFrames = 2000;
+	float sum = 0.0f;
+	int startTime = Timer::getMilliSeconds();
+	for (int k = 0; k < numFrames; ++k)
+	{
+		float time = float(k) * 0.2f;
+		for (int i = 0; i < numTracks; ++i)
+			results[i] = evalBezierTrack(tracks[i].xValues, tracks[i].yValues, numKeys, time);
+		sum += results[k % numTracks];
+	}
+	int scalarTime = Timer::getMilliSeconds() - startTime;
+
+	startTime = Timer::getMilliSeconds();
+	for (int k = 0; k < numFrames; ++k)
+	{
+		float time = float(k) * 0.2f;
+		evalBezierTracks(&tracks[0], numTracks, time, &results[0]);
+		sum -= results[k % numTracks];
+	}
+	int batchTime = Timer::getMilliSeconds() - startTime;
+	std::cout << "bezier tracks scalar: " << scalarTime << "ms, batch: " << batchTime << "ms" << std::endl;
+	EXPECT_NEAR(sum, 0.0f, 1e-2f);
+}
+
+
+// benchmark scene: a chain of transforms that gets evaluated on update
+struct BenchmarkInstance
+{
+	float time;
+	float4x4 matrices[1024];
+};
+
+void benchmarkInitGlobal(void* global, uint8_t* data) {}
+void benchmarkDoneGlobal(void* global) {}
+void benchmarkInitInstance(const void* global, void* instance) {}
+void benchmarkDoneInstance(void* instance) {}
+void benchmarkAddClip(void* instance, int index, float* tracks, float time, float weight) {}
+
+void benchmarkUpdate(void* pInstance)
+{
+	BenchmarkInstance& instance = *(BenchmarkInstance*)pInstance;
+	instance.time += 0.01f;
+	float4x4 m = matrix4x4Translate(vector3(instance.time, 0.0f, 0.0f));
+	for (int i = 0; i < 1024; ++i)
+	{
+		m = m * matrix4x4Translate(vector3(0.0f, sin(instance.time + float(i)), 0.0f));
+		instance.matrices[i] = m;
+	}
+}
+
+void benchmarkGetBoundingBox(void* pInstance, float4x2& boundingBox)
+{
+	// report time in bounding box to be able to check the number of updates
+	BenchmarkInstance& instance = *(BenchmarkInstance*)pInstance;
+	boundingBox.x.x = instance.time;
+}
+
+void benchmarkRender(void* instance, const float4x4& viewMatrix, const float4x4& projectionMatrix, int layerIndex,
+	RenderQueues& renderQueues) {}
+
+class BenchmarkFile : public EngineFile
+{
+public:
+	BenchmarkFile()
+	{
+		SceneInfo sceneInfo =
+		{
+			"benchmark",
+			{NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0},
+			0, sizeof(BenchmarkInstance),
+			benchmarkInitGlobal,
+			benchmarkDoneGlobal,
+			benchmarkInitInstance,
+			benchmarkDoneInstance,
+			benchmarkAddClip,
+			benchmarkUpdate,
+			benchmarkGetBoundingBox,
+			benchmarkRender
+		};
+		this->sceneInfo = sceneInfo;
+	}
+
+	virtual ArrayRef<const TextureInfo> getTextureInfos() {return ArrayRef<const TextureInfo>();}
+	virtual void* getTextureGlobal(int index) {return NULL;}
+	virtual ArrayRef<const SceneInfo> getSceneInfos() {return ArrayRef<const SceneInfo>(&this->sceneInfo, 1);}
+	virtual void* getSceneGlobal(int index) {return NULL;}
+	virtual void done() {}
+
+	SceneInfo sceneInfo;
+};
+
+TEST(Engine, UpdateGroupParallel)
+{
+	Pointer<Engine> engine = new Engine();
+	int fileHandle = engine->addFile(new BenchmarkFile());
+	int groupHandle = engine->createGroup();
+	for (int i = 0; i < 500; ++i)
+		engine->createScene(fileHandle, 0, groupHandle);
+
+	const int numUpdates = 20;
+
+	// serial update
+	int startTime = Timer::getMilliSeconds();
+	for (int i = 0; i < numUpdates; ++i)
+		engine->updateGroup(groupHandle);
+	int serialTime = Timer::getMilliSeconds() - startTime;
+	std::cout << "serial: " << serialTime << "ms" << std::endl;
+
+	// parallel update with increasing number of threads
+	int numProcessors = ThreadPool::getNumProcessors();
+	for (int numThreads = 1; numThreads <= numProcessors; numThreads *= 2)
+	{
+		startTime = Timer::getMilliSeconds();
+		for (int i = 0; i < numUpdates; ++i)
+			engine->updateGroupParallel(groupHandle, numThreads);
+		int parallelTime = Timer::getMilliSeconds() - startTime;
+		std::cout << numThreads << " threads: " << parallelTime << "ms" << std::endl;
+	}
+
+	// all scenes must have been updated the same number of times
+	float time = engine->getBoundingBox(0).center.x;
+	for (int sceneHandle = 1; sceneHandle < 500; ++sceneHandle)
+		EXPECT_EQ(engine->getBoundingBox(sceneHandle).center.x, time);
+}
+
+struct AttributeNameLess
+{
+	bool operator ()(const AttributeInfo& info, StringRef name) {return info.name < name;}
+	bool operator ()(StringRef name, const AttributeInfo& info) {return name < info.name;}
+};
+
+TEST(Engine, AttributeNameLookup)
+{
+	const int numAttributes = 10000;
+	const int numRounds = 20;
+
+	// sorted attribute names
+	std::vector<std::string> names(numAttributes);
+	std::vector<StringRef> nameRefs(numAttributes);
+	std::vector<AttributeInfo> attributeInfos(numAttributes);
+	for (int i = 0; i < numAttributes; ++i)
+	{
+		char name[32];
+		sprintf(name, "node%05d.attribute", i);
+		names[i] = name;
+		nameRefs[i] = names[i];
+		AttributeInfo attributeInfo = {names[i].c_str(), P_FLOAT, uint(i * 4), ""};
+		attributeInfos[i] = attributeInfo;
+	}
+	
+	Pointer<Engine> engine = new Engine();
+	BenchmarkFile* file = new BenchmarkFile();
+	ArrayData<AttributeInfo> attributeInfoData = {&attributeInfos[0], uint(numAttributes)};
+	file->sceneInfo.attributeInfos = attributeInfoData;
+	int fileHandle = engine->addFile(file);
+	int groupHandle = engine->createGroup();
+	
+	// lookup using binary search
+	int startTime = Timer::getMilliSeconds();
+	int count = 0;
+	for (int j = 0; j < numRounds; ++j)
+	{
+		for (int i = 0; i < numAttributes; ++i)
+		{
+			const AttributeInfo* it = std::lower_bound(attributeInfoData.begin(), attributeInfoData.end(), nameRefs[i],
+				AttributeNameLess());
+			count += it != attributeInfoData.end() && it->name == nameRefs[i];
+		}
+	}
+	int binaryTime = Timer::getMilliSeconds() - startTime;
+	EXPECT_EQ(count, numAttributes * numRounds);
+	
+	// resolve handles one by one
+	startTime = Timer::getMilliSeconds();
+	for (int j = 0; j < numRounds; ++j)
+	{
+		int sceneHandle = engine->createScene(fileHandle, 0, groupHandle);
+		for (int i = 0; i < numAttributes; ++i)
+			EXPECT_EQ(engine->getAttributeName(engine->getAttributeHandle(sceneHandle, nameRefs[i])), nameRefs[i]);
+		engine->deleteScene(sceneHandle);
+	}
+	int singleTime = Timer::getMilliSeconds() - startTime;
+
+	// resolve handles at once
+	std::vector<int> attributeHandles(numAttributes);
+	startTime = Timer::getMilliSeconds();
+	for (int j = 0; j < numRounds; ++j)
+	{
+		int sceneHandle = engine->createScene(fileHandle, 0, groupHandle);
+		engine->getAttributeHandles(sceneHandle, nameRefs, &attributeHandles[0]);
+		for (int i = 0; i < numAttributes; ++i)
+			EXPECT_EQ(engine->getAttributeName(attributeHandles[i]), nameRefs[i]);
+		engine->deleteScene(sceneHandle);
+	}
+	int batchTime = Timer::getMilliSeconds() - startTime;
+	std::cout << "resolve " << numAttributes << " attributes: binary search " << float(binaryTime) / float(numRounds)
+		<< "ms, single " << float(singleTime) / float(numRounds)
+		<< "ms, batch " << float(batchTime) / float(numRounds) << "ms" << std::endl;
+		
+	// unknown names
+	int sceneHandle = engine->createScene(fileHandle, "benchmark", groupHandle);
+	EXPECT_EQ(engine->getAttributeHandle(sceneHandle, "node10000.attribute"), -1);
+	EXPECT_EQ(engine->getAttributeHandle(sceneHandle, ""), -1);
+	EXPECT_EQ(engine->createScene(fileHandle, "foo", groupHandle), -1);
+}
+
+std::vector<float> renderedDistances;
+
+void renderDistance(RenderJob* renderJob)
+{
+	renderedDistances.push_back(renderJob->distance);
+}
+
+TEST(Engine, RenderSorted)
+{
+	const int numJobs = 100000;
+	std::vector<RenderJob> renderJobs(numJobs);
+	std::vector<RenderSortKey> sortKeys;
+
+	// build alpha sort queue with random distances in normalized device space
+	uint32_t seed = 0;
+	RenderJob* alphaSort = NULL;
+	for (int i = 0; i < numJobs; ++i)
+	{
+		seed = 1103515245 * seed + 12345;
+		RenderJob& renderJob = renderJobs[i];
+		renderJob.distance = float(seed >> 8) / float(1 << 23) - 1.0f;
+		renderJob.render = &renderDistance;
+		renderJob.next = alphaSort;
+		alphaSort = &renderJob;
+	}
+
+	const int numSorts = 20;
+	int startTime = Timer::getMilliSeconds();
+	for (int i = 0; i < numSorts; ++i)
+	{
+		renderedDistances.clear();
+		renderSorted(alphaSort, sortKeys);
+	}
+	int time = Timer::getMilliSeconds() - startTime;
+	std::cout << "sort " << numJobs << " render jobs: " << float(time) / float(numSorts) << "ms" << std::endl;
+
+	// check if rendered back to front
+	ASSERT_EQ(renderedDistances.size(), size_t(numJobs));
+	for (int i = 1; i < numJobs; ++i)
+		EXPECT_GE(renderedDistances[i - 1], renderedDistances[i]);
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+namespace
+{
+	// write module with a single return instruction for all public functions
+	void writeCode(ObjectWriter& w, const char** publics, int numPublics)
+	{
+		// data
+		size_t dataSize = 16;
+		uint8_t data[16] = {};
+		w & dataSize;
+		w.writeData(data, dataSize);
+		
+		// code (x86 ret)
+		size_t codeSize = 1;
+		uint8_t code[1] = {0xc3};
+		w & codeSize;
+		w.writeData(code, codeSize);
+		
+		// public symbols
+		w & uint(numPublics);
+		for (int i = 0; i < numPublics; ++i)
+		{
+			w & std::string(publics[i]);
+			w & size_t(0);
+		}
+		
+		// no external names, external relocations and internal relocations
+		w & uint(0);
+		w & uint(0);
+		w & uint(0);
+	}
+	
+	// write machine code engine file with a failed texture, a texture and a scene
+	void writeMC(Pointer<IODevice> dev, int numAttributes)
+	{
+		const char* texturePublics[] = {"initGlobal", "doneGlobal", "copy"};
+		const char* scenePublics[] = {"initGlobal", "doneGlobal", "initInstance", "doneInstance", "addClip",
+			"update", "getBoundingBox", "render"};
+		ObjectWriter w(dev);
+		
+		// textures
+		w & uint(2);
+		w & std::string();
+		w & std::string("texture");
+		w & uint(0); // type
+		writeCode(w, texturePublics, 3);
+		w & uint(64); // global size
+		
+		// scenes
+		w & uint(1);
+		w & std::string("scene");
+		writeCode(w, scenePublics, 8);
+		w & uint(64); // global size
+		w & uint(128); // instance size
+		
+		// nodes
+		w & uint(1);
+		w & std::string("node");
+		w & uint(0);
+		
+		// attributes
+		w & uint(numAttributes);
+		for (int i = 0; i < numAttributes; ++i)
+		{
+			w & ("attribute" + toString(i));
+			w & uint(0);
+			w & uint(i * 4);
+			w & std::string(i == 0 ? "semantic" : "");
+		}
+		
+		// texture bindings, one to the failed and one to the loaded texture
+		w & uint(2);
+		w & uint(0) & uint(0) & uint(0);
+		w & uint(1) & uint(0) & uint(16);
+		
+		// attribute sets
+		w & uint(1);
+		w & std::string("attributeSet");
+		w & uint(0) & uint(1) & uint(0) & uint(1);
+		
+		// clips
+		w & uint(1);
+		w & std::string("clip");
+		w & uint(0);
+		w & 2.0f;
+		
+		// objects
+		w & uint(1);
+		w & std::string("object");
+		w & size_t(32);
+		
+		w.close();
+	}
+}
+
+TEST(Engine, MappedMCFile)
+{
+	fs::path path = "engine.dmc";
+	fs::path mappedPath = "engine.mapped.dmc";
+	const int numAttributes = 200000;
+	writeMC(File::create(path), numAttributes);
+	writeMappedMC(File::open(path, File::READ), File::create(mappedPath));
+	
+	MCLoader loader;
+	for (int i = 0; i < 2; ++i)
+	{
+		int t1 = Timer::getMilliSeconds();
+		Pointer<EngineFile> file = loader.load(i == 0 ? path : mappedPath);
+		int t2 = Timer::getMilliSeconds();
+		std::cout << (i == 0 ? "classic: " : "mapped: ") << t2 - t1 << "ms" << std::endl;
+		
+		// failed texture is removed
+		ArrayRef<const TextureInfo> textureInfos = file->getTextureInfos();
+		ASSERT_EQ(textureInfos.size(), 1);
+		EXPECT_STREQ(textureInfos[0].name, "texture");
+		
+		ArrayRef<const SceneInfo> sceneInfos = file->getSceneInfos();
+		ASSERT_EQ(sceneInfos.size(), 1);
+		const SceneInfo& info = sceneInfos[0];
+		EXPECT_STREQ(info.name, "scene");
+		EXPECT_EQ(info.globalSize, 64);
+		EXPECT_EQ(info.instanceSize, 128);
+		
+		ASSERT_EQ(info.nodeInfos.length, 1);
+		EXPECT_STREQ(info.nodeInfos.data[0].name, "node");
+		ASSERT_EQ(info.attributeInfos.length, numAttributes);
+		EXPECT_STREQ(info.attributeInfos.data[0].semantic, "semantic");
+		EXPECT_EQ(info.attributeInfos.data[numAttributes - 1].name, "attribute" + toString(numAttributes - 1));
+		EXPECT_EQ(info.attributeInfos.data[numAttributes - 1].offset, (numAttributes - 1) * 4);
+		
+		// binding to failed texture is removed
+		ASSERT_EQ(info.textureBindings.length, 1);
+		EXPECT_EQ(info.textureBindings.data[0].textureIndex, 0);
+		EXPECT_EQ(info.textureBindings.data[0].offset, 16);
+		
+		ASSERT_EQ(info.attributeSetInfos.length, 1);
+		EXPECT_STREQ(info.attributeSetInfos.data[0].name, "attributeSet");
+		ASSERT_EQ(info.clipInfos.length, 1);
+		EXPECT_STREQ(info.clipInfos.data[0].name, "clip");
+		EXPECT_EQ(info.clipInfos.data[0].length, 2.0f);
+		ASSERT_EQ(info.objectInfos.length, 1);
+		EXPECT_STREQ(info.objectInfos.data[0].name, "object");
+		EXPECT_EQ(info.objectInfos.data[0].offset, 32);
+		
+		EXPECT_TRUE(file->getSceneGlobal(0) != NULL);
+		file->done();
+	}
+	
+	// corrupt file must be rejected
+	{
+		Pointer<File> file = File::open(mappedPath, File::READ_WRITE);
+		file->setSize(sizeof(uint32_t) * 8);
+		file->close();
+		EXPECT_THROW(loader.load(mappedPath), DataException);
+	}
+	
+	fs::remove(path);
+	fs::remove(mappedPath);
+}
+
+#endif
+
+// create cube from -1 to 1
+static void createCube(std::vector<float3>& positions, std::vector<int>& indices)
+{
+	for (int i = 0; i < 8; ++i)
+		positions += vector3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+	int faces[] = {0, 2, 3, 1, 4, 5, 7, 6, 0, 1, 5, 4, 2, 6, 7, 3, 0, 4, 6, 2, 1, 3, 7, 5};
+	for (int i = 0; i < 6; ++i)
+	{
+		int* f = faces + i * 4;
+		indices += f[0], f[1], f[2];
+		indices += f[0], f[2], f[3];
+	}
+}
+
+// project a position into device coordinates
+static float2 project(const float4x4& viewProjection, float3 position)
+{
+	float4 p = viewProjection * vector4(position.x, position.y, position.z, 1.0f);
+	return vector2(p.x / p.w, p.y / p.w);
+}
+
+TEST(Engine, PickBVH)
+{
+	std::vector<float3> positions;
+	std::vector<int> indices;
+	createCube(positions, indices);
+
+	PickBVH bvh;
+	int meshIndex = bvh.addMesh(positions, indices);
+	int left = bvh.addInstance(meshIndex, matrix4x4Translate(vector3(-3.0f, 0.0f, 0.0f)), 5);
+	int right = bvh.addInstance(meshIndex, matrix4x4Translate(vector3(3.0f, 0.0f, 0.0f)), 7);
+	bvh.build();
+
+	// pick along ray
+	float distance;
+	EXPECT_EQ(5, bvh.pick(vector3(-3.0f, 0.0f, 10.0f), vector3(0.0f, 0.0f, -1.0f), distance));
+	EXPECT_FLOAT_EQ(9.0f, distance);
+	EXPECT_EQ(0, bvh.pick(vector3(0.0f, 0.0f, 10.0f), vector3(0.0f, 0.0f, -1.0f), distance));
+
+	// pick at device coordinates
+	float4x4 viewMatrix = matrix4x4LookAt(vector3(0.0f, 2.0f, 10.0f), vector3(0.0f, 0.0f, 0.0f),
+		vector3(0.0f, 1.0f, 0.0f));
+	float4x4 projectionMatrix = matrix4x4PerspectiveY(60.0f, 1.0f, 0.1f, 100.0f);
+	float4x4 viewProjection = projectionMatrix * viewMatrix;
+	EXPECT_EQ(5, bvh.pick(viewMatrix, projectionMatrix, project(viewProjection, vector3(-3.0f, 0.0f, 0.0f))));
+	EXPECT_EQ(7, bvh.pick(viewMatrix, projectionMatrix, project(viewProjection, vector3(3.0f, 0.0f, 0.0f))));
+	EXPECT_EQ(0, bvh.pick(viewMatrix, projectionMatrix, 0.0f, 0.0f));
+
+	// move right cube into the center and refit
+	bvh.setMatrix(right, matrix4x4Translate(vector3(0.0f, 0.0f, 0.0f)));
+	bvh.refit();
+	EXPECT_EQ(7, bvh.pick(viewMatrix, projectionMatrix, 0.0f, 0.0f));
+	EXPECT_EQ(0, bvh.pick(viewMatrix, projectionMatrix, project(viewProjection, vector3(3.0f, 0.0f, 0.0f))));
+
+	// hidden instance can't be picked
+	bvh.setVisible(left, false);
+	EXPECT_EQ(0, bvh.pick(viewMatrix, projectionMatrix, project(viewProjection, vector3(-3.0f, 0.0f, 0.0f))));
+
+	// compare with brute force for a grid of instances and random rays
+	bvh.clear();
+	meshIndex = bvh.addMesh(positions, indices);
+	std::vector<float4x4> matrices;
+	for (int i = 0; i < 1000; ++i)
+	{
+		float3 position = vector3(float(i % 10), float(i / 10 % 10), float(i / 100)) * 3.0f;
+		matrices += matrix4x4Translate(position);
+		bvh.addInstance(meshIndex, matrices.back(), i + 1);
+	}
+	bvh.build();
+	uint32_t seed = 1;
+	for (int r = 0; r < 1000; ++r)
+	{
+		float v[6];
+		for (int i = 0; i < 6; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			v[i] = float(seed >> 8) / float(1 << 24);
+		}
+		float3 origin = vector3(v[0], v[1], v[2]) * 40.0f - splat3(5.0f);
+		float3 direction = vector3(v[3], v[4], v[5]) - splat3(0.5f);
+
+		int expectedId = 0;
+		float expectedDistance = 1e30f;
+		for (int i = 0; i < 1000; ++i)
+		{
+			for (int t = 0; t < 12; ++t)
+			{
+				float3 tuv;
+				if (intersectRayTriangle(origin, direction,
+					transformPosition(matrices[i], positions[indices[t * 3 + 0]]),
+					transformPosition(matrices[i], positions[indices[t * 3 + 1]]),
+					transformPosition(matrices[i], positions[indices[t * 3 + 2]]), tuv)
+					&& tuv.x >= 0.0f && tuv.x < expectedDistance)
+				{
+					expectedDistance = tuv.x;
+					expectedId = i + 1;
+				}
+			}
+		}
+		EXPECT_EQ(expectedId, bvh.pick(origin, direction, distance));
+	}
+
+	// a grid of 200 * 200 quads only tests the triangles near the ray
+	bvh.clear();
+	positions.clear();
+	indices.clear();
+	for (int y = 0; y <= 200; ++y)
+	{
+		for (int x = 0; x <= 200; ++x)
+			positions += vector3(float(x), float(y), float((x * 7 + y * 3) % 5) * 0.1f);
+	}
+	for (int y = 0; y < 200; ++y)
+	{
+		for (int x = 0; x < 200; ++x)
+		{
+			int i = y * 201 + x;
+			indices += i, i + 1, i + 202, i, i + 202, i + 201;
+		}
+	}
+	meshIndex = bvh.addMesh(positions, indices);
+	bvh.addInstance(meshIndex, matrix4x4Translate(vector3(0.0f, 0.0f, 0.0f)), 3);
+	bvh.build();
+	EXPECT_EQ(3, bvh.pick(vector3(50.5f, 50.5f, 10.0f), vector3(0.0f, 0.0f, -1.0f), distance));
+	EXPECT_LT(bvh.getNumTriangleTests(), 100);
+	EXPECT_EQ(0, bvh.pick(vector3(50.5f, 50.5f, 10.0f), vector3(0.0f, 0.0f, 1.0f), distance));
+	EXPECT_EQ(0, bvh.getNumTriangleTests());
+	EXPECT_EQ(0, bvh.pick(vector3(-10.0f, 50.5f, 0.2f), vector3(0.0f, 1.0f, 0.0f), distance));
+	EXPECT_EQ(0, bvh.getNumTriangleTests());
+
+	// the grid can't be picked if it is behind the far plane
+	viewMatrix = matrix4x4LookAt(vector3(100.0f, 100.0f, 150.0f), vector3(100.0f, 100.0f, 0.0f),
+		vector3(0.0f, 1.0f, 0.0f));
+	EXPECT_EQ(0, bvh.pick(viewMatrix, projectionMatrix, 0.0f, 0.0f));
+	EXPECT_EQ(0, bvh.getNumTriangleTests());
+	viewMatrix = matrix4x4LookAt(vector3(100.0f, 100.0f, 50.0f), vector3(100.0f, 100.0f, 0.0f),
+		vector3(0.0f, 1.0f, 0.0f));
+	EXPECT_EQ(3, bvh.pick(viewMatrix, projectionMatrix, 0.0f, 0.0f));
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
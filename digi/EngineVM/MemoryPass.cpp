@@ -5,8 +5,8 @@
 #include <llvm/Support/IRBuilder.h>
 #include <llvm/Target/TargetData.h>
 
+#include <digi/Utility/Arena.h>
 #include <digi/Utility/MapUtility.h>
-#include <digi/Utility/MemoryPool.h>
 #include <digi/Utility/VectorUtility.h>
 #include <digi/Utility/foreach.h>
 #include <digi/System/Log.h>
@@ -36,8 +36,6 @@ void MemoryPass::getAnalysisUsage(llvm::AnalysisUsage& analysisUsage) const
 
 namespace
 {
-	typedef MemoryPool<void*, 1024> Pool;
-
 	int getConstantIndex(llvm::Value* value)
 	{
 		if (llvm::ConstantInt* constantInt = llvm::dyn_cast<llvm::ConstantInt>(value))
@@ -54,16 +52,16 @@ namespace
 	
 
 	// traverse type and allocate pointers for members
-	void* allocType(Pool& pool, llvm::Type* type, NameGenerator& nameGenerator, llvm::IRBuilder<>& builder)
+	void* allocType(Arena& arena, llvm::Type* type, NameGenerator& nameGenerator, llvm::IRBuilder<>& builder)
 	{
 			if (const llvm::StructType* structType = llvm::dyn_cast<llvm::StructType>(type))
 			{
 				// struct type
 				int numElements = structType->getNumElements();
-				void** members = pool.alloc(numElements);
+				void** members = arena.alloc<void*>(numElements);
 				for (int i = 0; i < numElements; ++i)
 				{
-					members[i] = allocType(pool, structType->getElementType(i), nameGenerator, builder);
+					members[i] = allocType(arena, structType->getElementType(i), nameGenerator, builder);
 				}
 				return (void*)members;
 			}
@@ -71,11 +69,11 @@ namespace
 			{
 				// array type
 				int numElements = int(arrayType->getNumElements());
-				void** members = pool.alloc(numElements);
+				void** members = arena.alloc<void*>(numElements);
 				llvm::Type* elementType = arrayType->getElementType();
 				for (int i = 0; i < numElements; ++i)
 				{
-					members[i] = allocType(pool, elementType, nameGenerator, builder);
+					members[i] = allocType(arena, elementType, nameGenerator, builder);
 				}
 				return (void*)members;
 			}
@@ -334,7 +332,7 @@ bool MemoryPass::runOnFunction(llvm::Function& function)
 	// data for alloca simplification
 	std::map<llvm::Value*, void*> pointers;
 	std::vector<llvm::Instruction*> deleteInstructions;
-	Pool pool;
+	Arena arena;
 	
 	// data for memcpy removal
 	llvm::TargetData& targetData = this->getAnalysis<llvm::TargetData>();
@@ -369,7 +367,7 @@ bool MemoryPass::runOnFunction(llvm::Function& function)
 							
 							// create allocas for each basic or vector type contained in the struct or array
 							llvm::IRBuilder<> builder(basicBlock, allocaInst);	
-							void* p = allocType(pool, type, nameGenerator, builder);
+							void* p = allocType(arena, type, nameGenerator, builder);
 							
 							// associate with pointer to allocated memory
 							pointers[allocaInst] = p;
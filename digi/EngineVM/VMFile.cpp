@@ -473,7 +473,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numNodes;
 				r & numNodes;
-				NodeInfo* nodeInfos = this->nodeInfoPool.alloc(numNodes);
+				NodeInfo* nodeInfos = this->arena.alloc<NodeInfo>(numNodes);
 				info.nodeInfos.data = nodeInfos;
 				info.nodeInfos.length = numNodes;
 				for (uint i = 0; i < numNodes; ++i)
@@ -492,7 +492,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numAttributes;
 				r & numAttributes;
-				AttributeInfo* attributeInfos = this->parameterInfoPool.alloc(numAttributes);
+				AttributeInfo* attributeInfos = this->arena.alloc<AttributeInfo>(numAttributes);
 				info.attributeInfos.data = attributeInfos;
 				uint attributeIndex = 0;
 				for (uint i = 0; i < numAttributes; ++i)
@@ -525,7 +525,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numTextureBindings;
 				r & numTextureBindings;
-				TextureBinding* textureBindings = this->textureBindingPool.alloc(numTextureBindings);
+				TextureBinding* textureBindings = this->arena.alloc<TextureBinding>(numTextureBindings);
 				info.textureBindings.data = textureBindings;
 				uint textureBindingIndex = 0;
 				for (uint i = 0; i < numTextureBindings; ++i)
@@ -561,7 +561,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numParameterSets;
 				r & numParameterSets;
-				AttributeSetInfo* attributeSetInfos = this->parameterSetInfoPool.alloc(numParameterSets);
+				AttributeSetInfo* attributeSetInfos = this->arena.alloc<AttributeSetInfo>(numParameterSets);
 				info.attributeSetInfos.data = attributeSetInfos;
 				uint attributeSetIndex = 0;
 				for (uint j = 0; j < numParameterSets; ++j)
@@ -592,7 +592,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numClips;
 				r & numClips;
-				ClipInfo* clipInfos = this->clipInfoPool.alloc(numClips);
+				ClipInfo* clipInfos = this->arena.alloc<ClipInfo>(numClips);
 				info.clipInfos.data = clipInfos;
 				info.clipInfos.length = numClips;
 				for (uint i = 0; i < numClips; ++i)
@@ -610,7 +610,7 @@ VMFile::VMFile(Pointer<IODevice> file, llvm::LLVMContext* context, llvm::Executi
 			{
 				uint numObjects;
 				r & numObjects;
-				ObjectInfo* objectInfos = this->objectInfoPool.alloc(numObjects);
+				ObjectInfo* objectInfos = this->arena.alloc<ObjectInfo>(numObjects);
 				info.objectInfos.data = objectInfos;
 				info.objectInfos.length = numObjects;
 				for (uint i = 0; i < numObjects; ++i)
@@ -825,7 +825,7 @@ void VMFile::done()
 const char* VMFile::readString(ObjectReader& r)
 {
 	size_t length = readVarSize<size_t>(r);
-	char* str = this->stringPool.alloc(length + 1);
+	char* str = this->arena.alloc<char>(length + 1);
 	r.readData(str, length);
 	str[length] = 0;
 	return str;
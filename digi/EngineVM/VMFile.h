@@ -3,7 +3,7 @@
 
 //#include <clang/CodeGen/ModuleBuilder.h>
 
-#include <digi/Utility/MemoryPool.h>
+#include <digi/Utility/Arena.h>
 #include <digi/Scene/ObjectReader.h>
 #include <digi/Engine/Engine.h>
 
@@ -93,13 +93,8 @@ protected:
 	std::vector<Global> textures;
 	std::vector<Global> scenes;
 
-	MemoryPool<char, 1024> stringPool;
-	MemoryPool<NodeInfo, 128> nodeInfoPool;
-	MemoryPool<AttributeInfo, 128> parameterInfoPool;
-	MemoryPool<TextureBinding, 64> textureBindingPool;
-	MemoryPool<AttributeSetInfo, 64> parameterSetInfoPool;
-	MemoryPool<ClipInfo, 64> clipInfoPool;
-	MemoryPool<ObjectInfo, 64> objectInfoPool;
+	// memory for strings and info arrays
+	Arena arena;
 };
 
 /// @}
@@ -7,6 +7,7 @@
 #include "DDS.h"
 #include "Image.h"
 #include "ImageFormat.h"
+#include "ImageRowConsumer.h"
 #include "JPEGWrapper.h"
 #include "PNGWrapper.h"
 #include "TIFFWrapper.h"
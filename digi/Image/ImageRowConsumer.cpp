@@ -0,0 +1,49 @@
+#include <digi/Utility/VectorUtility.h>
+
+#include "ImageRowConsumer.h"
+
+
+namespace digi {
+
+// ImageRowConsumer
+
+ImageRowConsumer::~ImageRowConsumer()
+{
+}
+
+void ImageRowConsumer::end()
+{
+}
+
+
+// ImageRowWriter
+
+ImageRowWriter::~ImageRowWriter()
+{
+}
+
+void ImageRowWriter::begin(ImageFormat format, int width, int height)
+{
+	this->srcRowSize = width * format.getMemorySize();
+	if (this->image == null)
+	{
+		this->image = new Image(Image::IMAGE, format, width, height);
+		this->mipmapIndex = 0;
+		this->imageIndex = 0;
+	}
+}
+
+void ImageRowWriter::rows(int y, int numRows, const uint8_t* data, size_t stride)
+{
+	int width = max(this->image->getWidth() >> this->mipmapIndex, 1);
+	int height = max(this->image->getHeight() >> this->mipmapIndex, 1);
+	size_t rowSize = width * this->image->getFormat().getMemorySize();
+	uint8_t* dstData = this->image->getData<uint8_t>(this->mipmapIndex, this->imageIndex);
+	
+	numRows = min(numRows, height - y);
+	size_t length = min(rowSize, this->srcRowSize);
+	for (int i = 0; i < numRows; ++i)
+		memcpy(dstData + (y + i) * rowSize, data + i * stride, length);
+}
+
+} // namespace digi
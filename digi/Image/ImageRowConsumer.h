@@ -0,0 +1,63 @@
+#ifndef digi_Image_ImageRowConsumer_h
+#define digi_Image_ImageRowConsumer_h
+
+#include "Image.h"
+
+
+namespace digi {
+
+/// @addtogroup Image
+/// @{
+
+/// receives an image strip by strip while it is decoded (e.g. by loadPNG()). the decoders only keep a few rows in
+/// memory, therefore the rows have to be processed or copied before the next strip arrives
+class ImageRowConsumer
+{
+public:
+
+	virtual ~ImageRowConsumer();
+
+	/// called once before the first rows with the format and size of the image
+	virtual void begin(ImageFormat format, int width, int height) = 0;
+
+	/// called with numRows consecutive rows starting at row y. the strips arrive from top to bottom, data points to
+	/// the first row and is only valid during this call. stride is the distance between two rows in bytes
+	virtual void rows(int y, int numRows, const uint8_t* data, size_t stride) = 0;
+
+	/// called after the last row
+	virtual void end();
+};
+
+
+/// copies the rows into an image. if no image is given, a new image is allocated in begin(). a given image must have
+/// the format of the decoded image, rows and columns outside of it are clipped
+class ImageRowWriter : public ImageRowConsumer
+{
+public:
+
+	ImageRowWriter(Pointer<Image> image = null, int mipmapIndex = 0, int imageIndex = 0)
+		: image(image), mipmapIndex(mipmapIndex), imageIndex(imageIndex), srcRowSize(0) {}
+
+	virtual ~ImageRowWriter();
+
+	virtual void begin(ImageFormat format, int width, int height);
+	virtual void rows(int y, int numRows, const uint8_t* data, size_t stride);
+
+	/// get the image
+	Pointer<Image> getImage() {return this->image;}
+
+protected:
+
+	Pointer<Image> image;
+	int mipmapIndex;
+	int imageIndex;
+
+	// size of a decoded row in bytes
+	size_t srcRowSize;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
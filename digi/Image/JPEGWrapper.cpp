@@ -171,6 +171,32 @@ namespace
 		cinfo.dest = this;
 	}
 
+	// number of rows that are delivered to an ImageRowConsumer at once
+	const int STRIP_HEIGHT = 16;
+
+	// determine image format from header
+	ImageFormat getFormat(jpeg_decompress_struct& cinfo, Source& source)
+	{
+		ImageFormat format;
+		if (cinfo.out_color_space == JCS_GRAYSCALE)
+		{
+			format.mapping = ImageFormat::Y;
+			format.layout = ImageFormat::X8;
+		
+		}
+		else if (cinfo.out_color_space == JCS_RGB)
+		{
+			format.mapping = ImageFormat::RGB;
+			format.layout = ImageFormat::XYZ8;		
+		}
+		else
+		{
+			throw DataException(source.ioCatcher.dev, DataException::FORMAT_NOT_SUPPORTED);
+		}
+		format.type = ImageFormat::UNORM;
+		return format;
+	}
+
 } // anonymous namespace
 
 Pointer<Image> loadJPEG(const fs::path& path)
@@ -198,23 +224,7 @@ Pointer<Image> loadJPEG(Pointer<IODevice> dev)
 	source.checkState();
 
 	// determine image format
-	ImageFormat format;
-	if (cinfo.out_color_space == JCS_GRAYSCALE)
-	{
-		format.mapping = ImageFormat::Y;
-		format.layout = ImageFormat::X8;
-	
-	}
-	else if (cinfo.out_color_space == JCS_RGB)
-	{
-		format.mapping = ImageFormat::RGB;
-		format.layout = ImageFormat::XYZ8;		
-	}
-	else
-	{
-		throw DataException(dev, DataException::FORMAT_NOT_SUPPORTED);
-	}
-	format.type = ImageFormat::UNORM;
+	ImageFormat format = getFormat(cinfo, source);
 	int numChannels = format.getNumChannels();
 
 	// read data
@@ -238,6 +248,65 @@ Pointer<Image> loadJPEG(Pointer<IODevice> dev)
 	return image;
 }
 
+void loadJPEG(const fs::path& path, ImageRowConsumer& consumer)
+{
+	Pointer<File> f = File::open(path, File::READ);		
+	loadJPEG(f, consumer);
+	f->close();
+}
+
+void loadJPEG(Pointer<IODevice> dev, ImageRowConsumer& consumer)
+{
+	// jpeg variables
+	jpeg_decompress_struct cinfo;
+	jpeg_error_mgr jerr;
+
+	// init, set io functions and automatic cleanup on exception
+	cinfo.err = jpeg_std_error(&jerr);
+	Source source(cinfo, dev);
+
+	// read header
+	jpeg_read_header(&cinfo, TRUE);
+
+	// check if a read error occured
+	source.checkState();
+
+	// determine image format
+	ImageFormat format = getFormat(cinfo, source);
+	int numChannels = format.getNumChannels();
+
+	// read data
+	jpeg_start_decompress(&cinfo);
+	int width = cinfo.output_width;
+	int height = cinfo.output_height;
+	consumer.begin(format, width, height);
+	int stride = width * numChannels;
+	int stripHeight = min(height, STRIP_HEIGHT);
+	std::vector<JSAMPLE> buffer(stride * stripHeight);
+	JSAMPROW rows[STRIP_HEIGHT];
+	for (int i = 0; i < stripHeight; ++i)
+		rows[i] = &buffer[i * stride];
+	while (cinfo.output_scanline < cinfo.output_height)
+	{
+		// fill strip, the decoder may return less rows than requested
+		int row = cinfo.output_scanline;
+		int numRows = min(height - row, STRIP_HEIGHT);
+		int numRead = 0;
+		while (numRead < numRows)
+		{
+			numRead += jpeg_read_scanlines(&cinfo, rows + numRead, numRows - numRead);
+
+			// check if a read error occured
+			source.checkState();
+		}
+		consumer.rows(row, numRows, &buffer[0], stride);
+	}
+	jpeg_finish_decompress(&cinfo);
+	consumer.end();
+
+	// the source closes the jpeg image, also when an exception is thrown		
+}
+
 void saveJPEG(const fs::path& path, Pointer<Image> image, int quality, int mipmapIndex, int imageIndex)
 {
 	Pointer<File> f = File::create(path);
@@ -4,6 +4,7 @@
 #include <digi/System/FileSystem.h>
 #include <digi/System/IODevice.h>
 #include "Image.h"
+#include "ImageRowConsumer.h"
 
 
 namespace digi {
@@ -15,6 +16,10 @@ namespace digi {
 Pointer<Image> loadJPEG(const fs::path& path);
 Pointer<Image> loadJPEG(Pointer<IODevice> dev);
 
+// load image strip by strip, only a few rows are kept in memory
+void loadJPEG(const fs::path& path, ImageRowConsumer& consumer);
+void loadJPEG(Pointer<IODevice> dev, ImageRowConsumer& consumer);
+
 // save image with given mipmap and image index. quality ranges from 0 (bad) to 100 (good)
 // supports Y, RGB, uint8
 void saveJPEG(const fs::path& path, Pointer<Image> image, int quality, int mipmapIndex = 0, int imageIndex = 0);
@@ -46,7 +46,7 @@ namespace
 		png_infop info_ptr;
 
 		ReadGuard(png_structp png_ptr, png_infop info_ptr)
-			: png_ptr(NULL), info_ptr(NULL)
+			: png_ptr(png_ptr), info_ptr(info_ptr)
 		{
 		}
 
@@ -144,6 +144,97 @@ namespace
 		}
 	}
 */
+
+	// number of rows that are delivered to an ImageRowConsumer at once
+	const int STRIP_HEIGHT = 16;
+
+	// read header, set transforms and determine image format
+	ImageFormat readInfo(png_structp png_ptr, png_infop info_ptr, png_uint_32& width, png_uint_32& height,
+		int& interlaceType)
+	{
+		png_read_info(png_ptr, info_ptr);
+		int numBits;
+		int colorType;
+		int compressionType;
+		int filterMethod;
+		png_get_IHDR(png_ptr,  info_ptr,  &width,  &height, &numBits,  &colorType,
+			&interlaceType, &compressionType,  &filterMethod);
+		bool tRNS = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) != 0;
+
+		// set transforms
+		#ifdef BOOST_LITTLE_ENDIAN
+			if (numBits > 8)
+				png_set_swap(png_ptr);
+		#endif
+		if (numBits < 8)
+			png_set_expand(png_ptr);
+		if (tRNS)
+			png_set_tRNS_to_alpha(png_ptr);
+
+		// determine image format
+		ImageFormat format;
+		switch (colorType)
+		{
+		case PNG_COLOR_TYPE_PALETTE:
+			{
+				// get palette
+				png_color* palette;
+				int numPalette;
+				png_get_PLTE(png_ptr, info_ptr, &palette,
+					&numPalette);
+
+				// check if palette is gray
+				bool gray = true;
+				png_color* end = palette + numPalette;
+				for (png_color* col = palette; col != end; ++col)
+				{
+					gray &= (col->red == col->green) & (col->red == col->blue);
+				}
+
+				// set conversions
+				png_set_palette_to_rgb(png_ptr);
+				if (gray)
+					png_set_rgb_to_gray_fixed(png_ptr, 1, 100000, 0);
+
+				// determine mapping
+				if (gray)
+					format.mapping = tRNS ? ImageFormat::YA : ImageFormat::Y;
+				else
+					format.mapping = tRNS ? ImageFormat::RGBA : ImageFormat::RGB;
+			}
+			break;
+		case PNG_COLOR_TYPE_GRAY:
+			format.mapping = tRNS ? ImageFormat::YA : ImageFormat::Y;
+			break;
+		case PNG_COLOR_TYPE_GRAY_ALPHA:
+			format.mapping = ImageFormat::YA;
+			break;
+		case PNG_COLOR_TYPE_RGB:
+			format.mapping = tRNS ? ImageFormat::RGBA : ImageFormat::RGB;
+			break;
+		case PNG_COLOR_TYPE_RGB_ALPHA:
+			format.mapping = ImageFormat::RGBA;
+			break;
+		}
+
+		switch (format.mapping)
+		{
+		case ImageFormat::Y:
+			format.layout = numBits > 8 ? ImageFormat::X16 : ImageFormat::X8;
+			break;
+		case ImageFormat::YA:
+			format.layout = numBits > 8 ? ImageFormat::XY16 : ImageFormat::XY8;
+			break;
+		case ImageFormat::RGB:
+			format.layout = numBits > 8 ? ImageFormat::XYZ16 : ImageFormat::XYZ8;
+			break;
+		case ImageFormat::RGBA:
+			format.layout = numBits > 8 ? ImageFormat::XYZW16 : ImageFormat::XYZW8;
+			break;
+		}
+		format.type = ImageFormat::UNORM;
+		return format;
+	}
 } // anonymous namespace
 
 
@@ -187,91 +278,12 @@ Pointer<Image> loadPNG(Pointer<IODevice> dev)
 	}
 
 	// read header
-	png_read_info(png_ptr, info_ptr);
 	png_uint_32 width;
 	png_uint_32 height;
-	int numBits;
-	int colorType;
 	int interlaceType;
-	int compressionType;
-	int filterMethod;
-	png_get_IHDR(png_ptr,  info_ptr,  &width,  &height, &numBits,  &colorType,
-		&interlaceType, &compressionType,  &filterMethod);
-	int numBytes = (numBits + 7) >> 3;
-	bool tRNS = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) != 0;
-
-	// set transforms
-	#ifdef BOOST_LITTLE_ENDIAN
-		if (numBits > 8)
-			png_set_swap(png_ptr);
-	#endif
-	if (numBits < 8)
-		png_set_expand(png_ptr);
-	if (tRNS)
-		png_set_tRNS_to_alpha(png_ptr);
-
-	// determine image format
-	switch (colorType)
-	{
-	case PNG_COLOR_TYPE_PALETTE:
-		{
-			// get palette
-			png_color* palette;
-			int numPalette;
-			png_get_PLTE(png_ptr, info_ptr, &palette,
-				&numPalette);
-
-			// check if palette is gray
-			bool gray = true;
-			png_color* end = palette + numPalette;
-			for (png_color* col = palette; col != end; ++col)
-			{
-				gray &= (col->red == col->green) & (col->red == col->blue);
-			}
-
-			// set conversions
-			png_set_palette_to_rgb(png_ptr);
-			if (gray)
-				png_set_rgb_to_gray_fixed(png_ptr, 1, 100000, 0);
-
-			// determine mapping
-			if (gray)
-				format.mapping = tRNS ? ImageFormat::YA : ImageFormat::Y;
-			else
-				format.mapping = tRNS ? ImageFormat::RGBA : ImageFormat::RGB;
-		}
-		break;
-	case PNG_COLOR_TYPE_GRAY:
-		format.mapping = tRNS ? ImageFormat::YA : ImageFormat::Y;
-		break;
-	case PNG_COLOR_TYPE_GRAY_ALPHA:
-		format.mapping = ImageFormat::YA;
-		break;
-	case PNG_COLOR_TYPE_RGB:
-		format.mapping = tRNS ? ImageFormat::RGBA : ImageFormat::RGB;
-		break;
-	case PNG_COLOR_TYPE_RGB_ALPHA:
-		format.mapping = ImageFormat::RGBA;
-		break;
-	}
-
-	switch (format.mapping)
-	{
-	case ImageFormat::Y:
-		format.layout = numBits > 8 ? ImageFormat::X16 : ImageFormat::X8;
-		break;
-	case ImageFormat::YA:
-		format.layout = numBits > 8 ? ImageFormat::XY16 : ImageFormat::XY8;
-		break;
-	case ImageFormat::RGB:
-		format.layout = numBits > 8 ? ImageFormat::XYZ16 : ImageFormat::XYZ8;
-		break;
-	case ImageFormat::RGBA:
-		format.layout = numBits > 8 ? ImageFormat::XYZW16 : ImageFormat::XYZW8;
-		break;
-	}
-	format.type = ImageFormat::UNORM;
+	format = readInfo(png_ptr, info_ptr, width, height, interlaceType);
 	int channelCount = format.getNumChannels();
+	int numBytes = format.getLayoutInfo().componentSize;
 
 	// read data
 	image = new Image(Image::IMAGE, format, width, height);
@@ -287,6 +299,83 @@ Pointer<Image> loadPNG(Pointer<IODevice> dev)
 	return image;
 }
 
+void loadPNG(const fs::path& path, ImageRowConsumer& consumer)
+{
+	Pointer<File> f = File::open(path, File::READ);		
+	loadPNG(f, consumer);
+	f->close();
+}
+
+void loadPNG(Pointer<IODevice> dev, ImageRowConsumer& consumer)
+{
+	// init
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png_ptr)
+		throw std::bad_alloc();		
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr)
+		throw std::bad_alloc();
+
+	// set io functions
+	IOCatcher ioCatcher(dev);
+	png_set_read_fn(png_ptr, &ioCatcher, pngRead);
+
+	// automatic cleanup on exception
+	ReadGuard guard(png_ptr, info_ptr);
+	
+	// declare variables before setjmp so that their constructor gets called in setjmp
+	ImageFormat format;
+	std::vector<uint8_t> buffer;
+
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		// check if a write error occured
+		ioCatcher.checkState();
+
+		// other error, assume data corrupt
+		throw DataException(dev, DataException::DATA_CORRUPT);
+	}
+
+	// read header
+	png_uint_32 width;
+	png_uint_32 height;
+	int interlaceType;
+	format = readInfo(png_ptr, info_ptr, width, height, interlaceType);
+	size_t stride = width * format.getMemorySize();
+	int numPasses = png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
+	consumer.begin(format, width, height);
+
+	if (numPasses > 1)
+	{
+		// interlaced images are complete only after the last pass, therefore the whole image has to be buffered
+		buffer.resize(stride * height);
+		for (int pass = 0; pass < numPasses; ++pass)
+		{
+			for (uint row = 0; row < height; ++row)
+				png_read_row(png_ptr, (png_bytep)&buffer[row * stride], NULL);
+		}
+		for (uint row = 0; row < height; row += STRIP_HEIGHT)
+			consumer.rows(row, min(int(height - row), STRIP_HEIGHT), &buffer[row * stride], stride);
+	}
+	else
+	{
+		// read strips
+		buffer.resize(stride * min(int(height), STRIP_HEIGHT));
+		for (uint row = 0; row < height; row += STRIP_HEIGHT)
+		{
+			int numRows = min(int(height - row), STRIP_HEIGHT);
+			for (int i = 0; i < numRows; ++i)
+				png_read_row(png_ptr, (png_bytep)&buffer[i * stride], NULL);
+			consumer.rows(row, numRows, &buffer[0], stride);
+		}
+	}
+	png_read_end(png_ptr, NULL);
+	consumer.end();
+
+	// the guard closes the png image, also when an exception is thrown
+}
+
 void savePNG(const fs::path& path, Pointer<Image> image, int quality, int mipmapIndex, int imageIndex)
 {
 	Pointer<File> f = File::create(path);
@@ -16,6 +16,37 @@
 
 namespace digi {
 
+namespace
+{
+	// number of bytes that are read from the device at once
+	const size_t READ_SIZE = 65536;
+
+	// guard that deletes the incremental decoder
+	struct DecoderGuard
+	{
+		WebPIDecoder* decoder;
+
+		DecoderGuard(WebPIDecoder* decoder)
+			: decoder(decoder)
+		{
+		}
+
+		~DecoderGuard()
+		{
+			WebPIDelete(this->decoder);
+		}
+	};
+
+	void read(Pointer<IODevice> dev, std::vector<uint8_t>& data, size_t& size)
+	{
+		size_t numRead = dev->read(&data[size], data.size() - size);
+		if (numRead == 0 || numRead == size_t(-1))
+			throw DataException(dev, DataException::UNEXPECTED_END_OF_DATA);
+		size += numRead;
+	}
+} // anonymous namespace
+
+
 Pointer<Image> loadWebP(const fs::path& path)
 {
 	Pointer<File> f = File::open(path, File::READ);		
@@ -26,8 +57,80 @@ Pointer<Image> loadWebP(const fs::path& path)
 
 Pointer<Image> loadWebP(Pointer<IODevice> dev)
 {
+	ImageRowWriter writer;
+	loadWebP(dev, writer);
+	return writer.getImage();
+}
 
-	return null;
+void loadWebP(const fs::path& path, ImageRowConsumer& consumer)
+{
+	Pointer<File> f = File::open(path, File::READ);		
+	loadWebP(f, consumer);
+	f->close();
+}
+
+void loadWebP(Pointer<IODevice> dev, ImageRowConsumer& consumer)
+{
+	// read until the header is complete
+	std::vector<uint8_t> data(READ_SIZE);
+	size_t size = 0;
+	WebPBitstreamFeatures features;
+	VP8StatusCode status;
+	while ((status = WebPGetFeatures(data.data(), size, &features)) == VP8_STATUS_NOT_ENOUGH_DATA)
+	{
+		if (size == data.size())
+			data.resize(size * 2);
+		read(dev, data, size);
+	}
+	if (status != VP8_STATUS_OK)
+		throw DataException(dev, DataException::DATA_CORRUPT);
+
+	// determine image format
+	ImageFormat format;
+	WEBP_CSP_MODE mode;
+	if (features.has_alpha)
+	{
+		format = ImageFormat(ImageFormat::XYZW8, ImageFormat::UNORM, ImageFormat::RGBA);
+		mode = MODE_RGBA;
+	}
+	else
+	{
+		format = ImageFormat(ImageFormat::XYZ8, ImageFormat::UNORM, ImageFormat::RGB);
+		mode = MODE_RGB;
+	}
+
+	// create incremental decoder. it decodes into an internal buffer of the size of the image
+	DecoderGuard guard(WebPINewRGB(mode, NULL, 0, 0));
+	if (guard.decoder == NULL)
+		throw std::bad_alloc();
+	consumer.begin(format, features.width, features.height);
+
+	// append data and deliver the rows as soon as they are decoded
+	int numRows = 0;
+	while (true)
+	{
+		status = WebPIAppend(guard.decoder, data.data(), size);
+		if (status != VP8_STATUS_OK && status != VP8_STATUS_SUSPENDED)
+			throw DataException(dev, DataException::DATA_CORRUPT);
+
+		int lastY;
+		int width;
+		int height;
+		int stride;
+		uint8_t* rgb = WebPIDecGetRGB(guard.decoder, &lastY, &width, &height, &stride);
+		if (rgb != NULL && lastY > numRows)
+		{
+			consumer.rows(numRows, lastY - numRows, rgb + numRows * stride, stride);
+			numRows = lastY;
+		}
+		
+		if (status == VP8_STATUS_OK)
+			break;
+		
+		size = 0;
+		read(dev, data, size);
+	}
+	consumer.end();
 }
 
 void saveWebP(const fs::path& path, Pointer<Image> image, int quality, int mipmapIndex, int imageIndex)
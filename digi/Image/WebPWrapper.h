@@ -4,6 +4,7 @@
 #include <digi/System/FileSystem.h>
 #include <digi/System/IODevice.h>
 #include "Image.h"
+#include "ImageRowConsumer.h"
 
 
 namespace digi {
@@ -15,6 +16,10 @@ namespace digi {
 Pointer<Image> loadWebP(const fs::path& path);
 Pointer<Image> loadWebP(Pointer<IODevice> dev);
 
+// load image incrementally, rows are delivered as soon as they are decoded. the decoder keeps the whole image in memory
+void loadWebP(const fs::path& path, ImageRowConsumer& consumer);
+void loadWebP(Pointer<IODevice> dev, ImageRowConsumer& consumer);
+
 // save image with given mipmap and image index. quality ranges from 0 (bad) to 100 (good)
 // supports Y, YA, RGB, RGBA, uint8
 void saveWebP(const fs::path& path, Pointer<Image> image, int quality, int mipmapIndex = 0, int imageIndex = 0);
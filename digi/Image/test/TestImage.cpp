@@ -148,6 +148,91 @@ TEST(Image, ImageIO)
 	saveWebP("rgba.webp", image, 80.0f);
 }
 
+// checks that the strips arrive in order and copies them into an image
+class StripChecker : public ImageRowWriter
+{
+public:
+
+	StripChecker()
+		: numRows(0), maxNumRows(0), ended(false) {}
+
+	virtual void rows(int y, int numRows, const uint8_t* data, size_t stride)
+	{
+		EXPECT_EQ(y, this->numRows);
+		this->numRows += numRows;
+		this->maxNumRows = max(this->maxNumRows, numRows);
+		ImageRowWriter::rows(y, numRows, data, stride);
+	}
+
+	virtual void end()
+	{
+		this->ended = true;
+	}
+
+	int numRows;
+	int maxNumRows;
+	bool ended;
+};
+
+TEST(Image, LoadStrips)
+{
+	// noise image where the last strip is not complete
+	int width = 300;
+	int height = 100;
+	Pointer<Image> image = new Image(Image::IMAGE, ImageFormat(ImageFormat::XYZ8, ImageFormat::UNORM, ImageFormat::RGB),
+		width, height);
+	uint8_t* data = image->getData<uint8_t>();
+	uint32_t seed = 1;
+	for (size_t i = 0; i < image->getMemorySize(); ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		data[i] = uint8_t(seed >> 24);
+	}
+	savePNG("strips.png", image, 100);
+	saveJPEG("strips.jpg", image, 80);
+	saveWebP("strips.webp", image, 80);
+
+	// png
+	{
+		StripChecker checker;
+		loadPNG("strips.png", checker);
+		EXPECT_EQ(checker.numRows, height);
+		EXPECT_TRUE(checker.ended);
+		EXPECT_LT(checker.maxNumRows, height);
+		EXPECT_EQ(0, memcmp(checker.getImage()->getData<void>(), data, image->getMemorySize()));
+	}
+
+	// jpeg
+	{
+		StripChecker checker;
+		loadJPEG("strips.jpg", checker);
+		EXPECT_EQ(checker.numRows, height);
+		EXPECT_TRUE(checker.ended);
+		EXPECT_LT(checker.maxNumRows, height);
+		Pointer<Image> reference = loadJPEG("strips.jpg");
+		EXPECT_EQ(0, memcmp(checker.getImage()->getData<void>(), reference->getData<void>(),
+			reference->getMemorySize()));
+	}
+
+	// webp
+	{
+		StripChecker checker;
+		loadWebP("strips.webp", checker);
+		EXPECT_EQ(checker.numRows, height);
+		EXPECT_TRUE(checker.ended);
+		EXPECT_EQ(checker.getImage()->getWidth(), width);
+	}
+	
+	// decode into a preallocated image that is smaller than the decoded image
+	{
+		Pointer<Image> small = new Image(Image::IMAGE, image->getFormat(), 10, 10);
+		ImageRowWriter writer(small);
+		loadPNG("strips.png", writer);
+		for (int y = 0; y < 10; ++y)
+			EXPECT_EQ(0, memcmp(small->getData<uint8_t>() + y * 10 * 3, data + y * width * 3, 10 * 3));
+	}
+}
+
 TEST(Image, Noise)
 {
 	Pointer<Image> image = new Image(Image::IMAGE, ImageFormat(ImageFormat::XYZ8, ImageFormat::UNORM, ImageFormat::RGB),
@@ -5,7 +5,9 @@
 #include "DataConverter.h"
 #include "DataConvert.h"
 #include "ImageConverter.h"
+#include "ImageRowConverter.h"
 #include "ImageUtil.h"
+#include "MipmapGenerator.h"
 #include "Version.h"
 
 #endif
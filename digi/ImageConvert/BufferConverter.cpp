@@ -130,11 +130,11 @@ void BufferConverter::convert(
 	BufferFormat dstFormat, void* dstData,
 	size_t numElements)
 {
-	this->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convert(
+	this->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		NULL,
 		dstData, dstFormat.getMemorySize(),
-		numElements);
+		numElements, this->threadPool);
 }
 
 void BufferConverter::convert(
@@ -142,11 +142,11 @@ void BufferConverter::convert(
 	BufferFormat dstFormat, DataConverter::Mode dstMode, void* dstData, size_t dstStride,
 	size_t numElements)
 {
-	this->getElementConverter(srcFormat, dstFormat, dstMode)->convert(
+	this->getElementConverter(srcFormat, dstFormat, dstMode)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		NULL,
 		dstData, dstStride,
-		numElements);
+		numElements, this->threadPool);
 }
 
 void BufferConverter::convert(
@@ -155,11 +155,11 @@ void BufferConverter::convert(
 	BufferFormat dstFormat, DataConverter::Mode dstMode, void* dstData, size_t dstStride,
 	size_t numElements)
 {
-	this->getElementConverter(srcFormat, code, dstFormat, dstMode)->convert(
+	this->getElementConverter(srcFormat, code, dstFormat, dstMode)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		global,
 		dstData, dstStride,
-		numElements);
+		numElements, this->threadPool);
 }
 
 Pointer<Buffer> BufferConverter::convert(Pointer<Buffer> srcBuffer, BufferFormat dstFormat)
@@ -170,12 +170,12 @@ Pointer<Buffer> BufferConverter::convert(Pointer<Buffer> srcBuffer, BufferFormat
 	Pointer<Buffer> dstBuffer = new Buffer(dstFormat, numElements);
 	void* dstData = dstBuffer->getData<void>();
 	
-	this->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convert(
+	this->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		NULL,
 		dstData,
 		dstFormat.getMemorySize(),
-		numElements);
+		numElements, this->threadPool);
 	
 	return dstBuffer;
 }
@@ -17,9 +17,16 @@ class BufferConverter : public Object
 {
 public:
 
-	BufferConverter(Pointer<ConverterContext> context)
-		: context(context) {}
+	/// constructor. if a thread pool is given, large buffers are converted in parallel
+	BufferConverter(Pointer<ConverterContext> context, Pointer<ThreadPool> threadPool = null)
+		: context(context), threadPool(threadPool) {}
 	virtual ~BufferConverter();
+
+	/// set thread pool for parallel conversion, null for conversion on the calling thread
+	void setThreadPool(Pointer<ThreadPool> threadPool) {this->threadPool = threadPool;}
+
+	/// get thread pool
+	Pointer<ThreadPool> getThreadPool() {return this->threadPool;}
 	
 	/// get a converter that converts elements of srcFormat to elements of dstFormat
 	Pointer<DataConverter> getElementConverter(BufferFormat srcFormat,
@@ -44,7 +51,8 @@ public:
 		BufferFormat dstFormat, DataConverter::Mode dstMode, void* dstData, size_t dstStride,
 		size_t numElements);
 
-	/// load from source buffer, do some processing and write to destination buffer
+	/// load from source buffer, do some processing and write to destination buffer. the code must not write to global
+	/// if a thread pool is set
 	void convert(
 		BufferFormat srcFormat, void* srcData,
 		StringRef code, void* global,
@@ -54,7 +62,7 @@ public:
 	/// convert source buffer buffer into new destination buffer
 	Pointer<Buffer> convert(Pointer<Buffer> srcBuffer, BufferFormat dstFormat);
 
-	/// process buffer
+	/// process buffer. always runs on the calling thread as the code may accumulate into global
 	void process(
 		BufferFormat srcFormat, void* srcData,
 		StringRef code, void* global,
@@ -67,6 +75,9 @@ protected:
 
 	// converter cache (crc32 of converter parameters -> converter)
 	std::map<uint32_t, Pointer<DataConverter> > converters;
+
+	// thread pool for parallel conversion
+	Pointer<ThreadPool> threadPool;
 };	
 
 /// @}
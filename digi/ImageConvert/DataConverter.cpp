@@ -11,6 +11,8 @@
 
 #include <llvm/Analysis/Verifier.h>
 
+#include <llvm/Bitcode/ReaderWriter.h>
+
 #include <llvm/ExecutionEngine/JIT.h>
 #include <llvm/ExecutionEngine/GenericValue.h>
 
@@ -20,12 +22,18 @@
 
 #include <llvm/Support/IRBuilder.h>
 #include <llvm/Support/TypeBuilder.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <clang/Frontend/CodeGenOptions.h>
 #include <clang/CodeGen/ModuleBuilder.h>
 
 #include <digi/Utility/StringUtility.h>
 #include <digi/Utility/Convert.h>
+#include <digi/System/File.h>
+#include <digi/System/MappedFile.h>
+#include <digi/System/IOException.h>
+#include <digi/Checksum/CRC32.h>
 #include <digi/CodeGenerator/CodeWriter.h>
 #include <digi/CodeGenerator/CodeWriterFunctions.h>
 #include <digi/EngineVM/Compiler.h>
@@ -141,7 +149,7 @@ float4 getMaxValues(int4 numBits, bool isSigned)
 // ConverterContext
 
 ConverterContext::ConverterContext()
-	: index(0)
+	: index(0), numCacheHits(0), numDiskCacheHits(0), numCacheMisses(0)
 {
 /*
 	this->context = new llvm::LLVMContext();
@@ -902,9 +910,179 @@ namespace
 			return 0;
 		return (intptr_t)executionEngine->getPointerToFunction(function);
 	}
+
+	// cache file layout: length of code (uint32_t), code, bitcode of module
+	
+	// load module from cache file. returns NULL if the file does not exist or was created for different code
+	llvm::Module* loadCachedModule(const fs::path& path, const std::string& code, llvm::LLVMContext& context)
+	{
+		Pointer<MappedFile> file;
+		try
+		{
+			file = MappedFile::open(path);
+		}
+		catch (IOException&)
+		{
+			return NULL;
+		}
+		
+		// check code to detect crc collisions
+		uint32_t codeLength;
+		size_t headerSize = sizeof(uint32_t) + code.length();
+		if (file->size() <= headerSize)
+			return NULL;
+		memcpy(&codeLength, file->data(), sizeof(uint32_t));
+		if (codeLength != code.length() || memcmp(file->data() + sizeof(uint32_t), code.data(), code.length()) != 0)
+			return NULL;
+		
+		// parse bitcode
+		llvm::MemoryBuffer* buffer = llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(
+			(const char*)file->data() + headerSize, file->size() - headerSize), "", false);
+		std::string error;
+		llvm::Module* module = llvm::ParseBitcodeFile(buffer, context, &error);
+		delete buffer;
+		return module;
+	}
+	
+	// save module to cache file. errors are ignored as the cache is optional
+	void saveCachedModule(const fs::path& path, const std::string& code, llvm::Module* module)
+	{
+		std::string bitcode;
+		{
+			llvm::raw_string_ostream s(bitcode);
+			llvm::WriteBitcodeToFile(module, s);
+		}
+		
+		fs::path tempPath;
+		try
+		{
+			// write to temp file and rename so that other processes never see a partially written file.
+			// the temp file name is unique so that processes writing the same cache entry don't clash
+			tempPath = fs::unique_path(path + ".%%%%-%%%%-%%%%-%%%%.tmp");
+			Pointer<File> file = File::create(tempPath);
+			uint32_t codeLength = uint32_t(code.length());
+			file->write(&codeLength, sizeof(uint32_t));
+			file->write(code.data(), code.length());
+			file->write(bitcode.data(), bitcode.length());
+			file->close();
+			fs::rename(tempPath, path);
+		}
+		catch (std::exception&)
+		{
+			// don't leave the temp file behind
+			if (!tempPath.empty())
+			{
+				boost::system::error_code errorCode;
+				fs::remove(tempPath, errorCode);
+			}
+		}
+	}
 }
 
 Pointer<DataConverter> DataConverter::create(Pointer<ConverterContext> context, const std::string& code)
+{
+	// look for already compiled function
+	std::map<std::string, void*>::iterator it = context->functions.find(code);
+	if (it != context->functions.end())
+	{
+		++context->numCacheHits;
+		return new DataConverter(context, (Convert)it->second);
+	}
+
+	// look in on-disk cache
+	fs::path cachePath;
+	llvm::Module* module = NULL;
+	if (!context->cacheDirectory.empty())
+	{
+		cachePath = context->cacheDirectory / (toHexString(calcCRC32(code.data(), code.length())) + ".bc");
+		module = loadCachedModule(cachePath, code, *context->context);
+	}
+	
+	if (module != NULL)
+	{
+		++context->numDiskCacheHits;
+	}
+	else
+	{
+		module = DataConverter::compile(context, code);
+		if (module == NULL)
+			return null;
+		++context->numCacheMisses;
+		
+		if (!cachePath.empty())
+			saveCachedModule(cachePath, code, module);
+	}
+
+	// add module to execution engine (takes ownership)
+	context->executionEngine->addModule(module);
+				
+	// get function pointer
+	Convert convert = (Convert)getPointerToFunction(
+		context->executionEngine, module, "_convert");
+	if (convert == NULL)
+		return null;
+	context->functions[code] = (void*)convert;
+
+	return new DataConverter(context, convert);
+}
+
+DataConverter::~DataConverter()
+{	
+}
+
+namespace
+{
+	// number of elements of a work item
+	const size_t CHUNK_SIZE = 16384;
+
+	class ConvertTask : public ThreadTask
+	{
+	public:
+
+		ConvertTask(DataConverter::Convert convert, uint8_t* srcData, size_t srcStride, void* global,
+			uint8_t* dstData, size_t dstStride, size_t numElements)
+			: convert(convert), srcData(srcData), srcStride(srcStride), global(global),
+			dstData(dstData), dstStride(dstStride), numElements(numElements)
+		{
+		}
+
+		virtual ~ConvertTask() {}
+
+		int getCount() {return int((this->numElements + CHUNK_SIZE - 1) / CHUNK_SIZE);}
+
+		virtual void run(int index)
+		{
+			size_t begin = size_t(index) * CHUNK_SIZE;
+			size_t numElements = std::min(this->numElements - begin, CHUNK_SIZE);
+			this->convert(this->srcData + begin * this->srcStride, this->srcStride, this->global,
+				this->dstData + begin * this->dstStride, this->dstStride, numElements);
+		}
+
+		DataConverter::Convert convert;
+		uint8_t* srcData;
+		size_t srcStride;
+		void* global;
+		uint8_t* dstData;
+		size_t dstStride;
+		size_t numElements;
+	};
+}
+
+void DataConverter::convertParallel(void* srcData, size_t srcStride, void* global,
+	void* dstData, size_t dstStride, size_t numElements, Pointer<ThreadPool> threadPool)
+{
+	if (threadPool == null || numElements < 2 * CHUNK_SIZE)
+	{
+		this->convert(srcData, srcStride, global, dstData, dstStride, numElements);
+		return;
+	}
+	
+	// the strides are in bytes, therefore the ranges start at byte offsets of index * stride
+	ConvertTask task(this->convert, (uint8_t*)srcData, srcStride, global, (uint8_t*)dstData, dstStride, numElements);
+	threadPool->run(task, task.getCount());
+}
+
+llvm::Module* DataConverter::compile(Pointer<ConverterContext> context, const std::string& code)
 {
 	Compiler compiler(Compiler::VM_OPENGL); //! opengl not necessary
 
@@ -924,27 +1102,10 @@ Pointer<DataConverter> DataConverter::create(Pointer<ConverterContext> context,
 
 	Pointer<CompileResult> result = VMFile::compile(compiler, code, astConsumer.get());
 	if (result == null)
-		return null;
+		return NULL;
 	
 	// get module (take ownership)
-	llvm::Module* module = astConsumer->ReleaseModule();
-	if (module == NULL)
-		return null;
-
-	// add module to execution engine
-	context->executionEngine->addModule(module);
-				
-	// get function pointer
-	Convert convert = (Convert)getPointerToFunction(
-		context->executionEngine, module, "_convert");
-	if (convert == NULL)
-		return null;
-
-	return new DataConverter(context, convert);
-}
-
-DataConverter::~DataConverter()
-{	
+	return astConsumer->ReleaseModule();
 }
 
 
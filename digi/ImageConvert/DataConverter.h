@@ -2,8 +2,12 @@
 #define digi_ImageConvert_Converter_h
 
 #include <limits>
+#include <map>
+#include <string>
 
 #include <digi/Utility/Object.h>
+#include <digi/System/FileSystem.h>
+#include <digi/System/ThreadPool.h>
 #include <digi/Image/BufferFormat.h>
 #include <digi/CodeGenerator/CodeWriter.h>
 #include <digi/CodeGenerator/NameGenerator.h>
@@ -48,6 +52,22 @@ public:
 	ConverterContext();
 	virtual ~ConverterContext();
 
+	/// set directory for the on-disk converter cache. compiled converters are stored there as llvm bitcode so that
+	/// later runs skip the compilation of the converter code. an empty path disables the on-disk cache
+	void setCacheDirectory(const fs::path& cacheDirectory) {this->cacheDirectory = cacheDirectory;}
+	
+	/// get directory of the on-disk converter cache
+	const fs::path& getCacheDirectory() {return this->cacheDirectory;}
+
+	/// get number of converters that were already compiled in this context
+	int getNumCacheHits() {return this->numCacheHits;}
+
+	/// get number of converters that were loaded from the on-disk cache
+	int getNumDiskCacheHits() {return this->numDiskCacheHits;}
+
+	/// get number of converters that had to be compiled from code
+	int getNumCacheMisses() {return this->numCacheMisses;}
+
 protected:
 
 	// context
@@ -64,6 +84,17 @@ protected:
 	
 	// index for function name generation
 	int index;
+
+	// compiled convert functions by converter code
+	std::map<std::string, void*> functions;
+
+	// directory of on-disk cache
+	fs::path cacheDirectory;
+	
+	// cache statistics
+	int numCacheHits;
+	int numDiskCacheHits;
+	int numCacheMisses;
 };	
 
 
@@ -88,6 +119,8 @@ public:
 	typedef void (*Convert)(void* srcData, size_t srcStride, void* global,
 		void* dstData, size_t dstStride, size_t numElements);
 
+	/// create a converter from code. the compiled function is cached in the context, therefore creating a converter
+	/// with the same code again is cheap
 	static Pointer<DataConverter> create(Pointer<ConverterContext> context, const std::string& code);
 
 	DataConverter(Pointer<ConverterContext> context, Convert convert)
@@ -95,12 +128,20 @@ public:
 	
 	virtual ~DataConverter();
 
+	/// call convert on ranges of the elements in parallel. runs on the calling thread if no thread pool is given or
+	/// if there are only few elements. the converter must not write to global
+	void convertParallel(void* srcData, size_t srcStride, void* global,
+		void* dstData, size_t dstStride, size_t numElements, Pointer<ThreadPool> threadPool);
+
 
 	// pointer to compiled convert function
 	Convert convert;
 
 protected:
 
+	// compile code to a module. returns NULL on error
+	static llvm::Module* compile(Pointer<ConverterContext> context, const std::string& code);
+
 	// pointer to context to keep it alive
 	Pointer<ConverterContext> context;
 };	
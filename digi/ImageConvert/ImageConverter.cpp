@@ -7,6 +7,7 @@
 #include <digi/ImageIO/ImageIO.h>
 
 #include "ImageUtil.h"
+#include "MipmapGenerator.h"
 #include "ImageConverter.h"
 
 // include last because of global defines (e.g. BOOL)
@@ -22,6 +23,74 @@
 namespace digi {
 
 #ifdef HAVE_S3TC
+	// compresses one row of 4x4 blocks
+	class S3TCCompressTask : public ThreadTask
+	{
+	public:
+
+		S3TCCompressTask(const ubyte4* srcData, int3 size, uint8_t* dstData, size_t blockSize, int flags)
+			: srcData(srcData), size(size), dstData(dstData), blockSize(blockSize), flags(flags)
+		{
+			this->numBlocksX = (size.x + 3) >> 2;
+			this->numBlocksY = (size.y + 3) >> 2;
+		}
+
+		virtual ~S3TCCompressTask() {}
+
+		// get number of block rows of all slices
+		int getNumBlockRows() {return this->numBlocksY * this->size.z;}
+
+		virtual void run(int index)
+		{
+			int z = index / this->numBlocksY;
+			int y = index - z * this->numBlocksY;
+			int3 size = this->size;
+
+			// the last block row and column may be partial
+			int numRows = std::min(size.y - y * 4, 4);
+			int rowMask = ~(~0 << numRows * 4);
+
+			const ubyte4* sourceLine = this->srcData + (size_t(z) * size.y + y * 4) * size.x;
+			uint8_t* blocks = this->dstData + size_t(index) * this->numBlocksX * this->blockSize;
+			for (int x = 0; x < this->numBlocksX; ++x)
+			{
+				int numColumns = std::min(size.x - x * 4, 4);
+				int mask = rowMask & ~(~0 << numColumns) * 0x1111;
+
+				// get block
+				const ubyte4* sourcePixel = sourceLine;
+				ubyte4 pixels[16];
+				ubyte4* p = pixels;
+				for (int j = 0; j < numRows; ++j)
+				{
+					for (int i = 0; i < numColumns; ++i)
+						p[i] = sourcePixel[i];
+
+					// next row
+					sourcePixel += size.x;
+					p += 4;
+				}
+
+				// convert block
+				squish::CompressMasked((const squish::u8*)pixels, mask, blocks, this->flags);
+
+				// next block
+				sourceLine += 4;
+				blocks += this->blockSize;
+			}
+		}
+
+	protected:
+
+		const ubyte4* srcData;
+		int3 size;
+		uint8_t* dstData;
+		size_t blockSize;
+		int flags;
+		int numBlocksX;
+		int numBlocksY;
+	};
+
 	void convertMipmapToS3TC(ImageConverter* imageConverter,
 		Pointer<Image> currentImage, int3 size, int currentMipmapIndex, int currentImageIndex,
 		ImageFormat dstFormat, void* dstData)
@@ -53,67 +122,24 @@ namespace digi {
 		default:
 			flags = squish::kDxt5;
 		}
-
-		int numBlocksX = (size.x + 3) >> 2;
-		int numBlocksY = (size.y + 3) >> 2;
-
-		int partialBlockX = size.x >> 2;
-		int partialBlockY = size.y >> 2;
-
-		ubyte4* sourceRow = currentImage->getData<ubyte4>(currentMipmapIndex, currentImageIndex);
-		uint8_t* blocks = (uint8_t*)dstData;
-		size_t blockSize = dstFormat.getMemorySize();
-	
-		// iterate in z-direction
-		for (int z = 0; z < size.z; ++z)
-		{
-			for (int y = 0; y < numBlocksY; ++y)
-			{
-				int numRows = 4;
-				int mask = 0xffff;
-				if (y == partialBlockY)
-				{
-					numRows = size.y & 3;
-					mask = ~(~0 << numRows * 4);
-				}
 		
-				ubyte4* sourceLine = sourceRow;
-				for (int x = 0; x < numBlocksX; ++x)
-				{
-					int numColumns = 4;
-					if (x == partialBlockX)
-					{
-						numColumns = size.x & 3;
-						mask &= ~(~0 << numColumns) * 0x1111;
-					}
-											
-					// get block
-					ubyte4* sourcePixel = sourceLine;
-					ubyte4 pixels[16];
-					ubyte4* p = pixels;
-					int j = 0;
-					for (; j < numRows; ++j)
-					{
-						int i = 0;
-						for (; i < numColumns; ++i)
-							p[i] = sourcePixel[i];
-					
-						// next row
-						sourcePixel += size.x;
-						p += 4;
-					}
-				
-					// convert block
-					squish::CompressMasked((const squish::u8*)pixels, mask, blocks, flags);
-				
-					// next block
-					sourceLine += 4;
-					blocks += blockSize;
-				}
-
-				// next block row
-				sourceRow += size.x * 4;
-			}
+		// range fit is much faster than the default cluster fit but has lower quality
+		if (imageConverter->getQuality() == ImageConverter::FAST)
+			flags |= squish::kColourRangeFit;
+
+		// compress rows of blocks in parallel
+		S3TCCompressTask task(currentImage->getData<ubyte4>(currentMipmapIndex, currentImageIndex), size,
+			(uint8_t*)dstData, dstFormat.getMemorySize(), flags);
+		int numBlockRows = task.getNumBlockRows();
+		Pointer<ThreadPool> threadPool = imageConverter->getThreadPool();
+		if (threadPool != null && numBlockRows > 1)
+		{
+			threadPool->run(task, numBlockRows);
+		}
+		else
+		{
+			for (int i = 0; i < numBlockRows; ++i)
+				task.run(i);
 		}
 	}
 #endif
@@ -223,11 +249,11 @@ void ImageConverter::convertPixels(
 	ImageFormat dstFormat, void* dstData,
 	size_t numPixels)
 {	
-	this->getPixelConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convert(
+	this->getPixelConverter(srcFormat, dstFormat, DataConverter::NATIVE)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		NULL,
 		dstData, dstFormat.getMemorySize(),
-		numPixels);
+		numPixels, this->threadPool);
 }
 
 void ImageConverter::convertPixels(
@@ -235,11 +261,11 @@ void ImageConverter::convertPixels(
 	ImageFormat dstFormat, DataConverter::Mode dstMode, void* dstData, size_t dstStride,
 	size_t numPixels)
 {
-	this->getPixelConverter(srcFormat, dstFormat, dstMode)->convert(
+	this->getPixelConverter(srcFormat, dstFormat, dstMode)->convertParallel(
 		srcData, srcFormat.getMemorySize(),
 		NULL,
 		dstData, dstStride,
-		numPixels);
+		numPixels, this->threadPool);
 }
 
 /*
@@ -456,45 +482,20 @@ void ImageConverter::convert(
 	}
 	else
 	{
-		// a temporary float4 image is needed
+		// a temporary float4 image that holds all mipmap levels is needed
 		ImageFormat floatFormat = ImageFormat(ImageFormat::XYZW32, ImageFormat::FLOAT, ImageFormat::RGBA);
-		Pointer<Image> floatImage = new Image(srcImage->getType(), floatFormat, srcImage->getSize());
+		Pointer<Image> mipmapImage = new Image(srcImage->getType(), floatFormat, size, numMipmaps);
+		Pointer<Image> tempImage;
+		MipmapGenerator generator(this->mipmapFilter, this->mipmapFlags, this->threadPool);
 		
 		// convert one image at a time since the source image may have mipmaps while the destination image doesn't have mipmaps
 		for (int imageIndex = 0; imageIndex < numImages; ++imageIndex)
 		{
-			// convert source image to float format
-			this->convertImage(srcImage, 1, srcStartImage + imageIndex,
-				floatFormat, DataConverter::NATIVE, floatImage->getData<void>());
-			
-			// check if rescaling of the top-level image is necessary
-			//Pointer<Image> mipmap = rescale ? scaleFiltered(floatImage, size) : floatImage;
-			Pointer<Image> mipmap = floatImage;
-			if (rescale)
-			{
-				// scale down by no more than factor of 2
-				int3 currentSize = srcImage->getSize();
-				do
-				{
-					currentSize = max(size, currentSize >> 1);
-					mipmap = scaleFiltered(floatImage, currentSize);
-				} while (any(currentSize != size));
-			}
+			this->buildMipmaps(srcImage, srcStartImage + imageIndex, mipmapImage, tempImage, generator);
 
-			// convert toplevel float image to destination format
-			this->convertImage(mipmap, 1, 0,
+			// convert all levels to destination format
+			this->convertImage(mipmapImage, numMipmaps, 0,
 				dstFormat, DataConverter::NATIVE, dstImage->getData<void>(dstStartImage + imageIndex));
-
-			// generate mipmaps
-			for (int mipmapIndex = 1; mipmapIndex < numMipmaps; ++mipmapIndex)
-			{
-				size = max(size >> 1, 1);
-				mipmap = scaleFiltered(mipmap, size);
-				
-				// convert scaled mipmap float image to destination format
-				this->convertImage(mipmap, 1, 0,
-					dstFormat, DataConverter::NATIVE, dstImage->getData<void>(mipmapIndex, dstStartImage + imageIndex));
-			}
 		}
 	}
 }
@@ -532,36 +533,60 @@ void ImageConverter::convert(Pointer<Image> srcImage,
 	}
 	else
 	{
-		// a temporary float4 image is needed
+		// a temporary float4 image that holds all mipmap levels is needed
 		ImageFormat floatFormat = ImageFormat(ImageFormat::XYZW32, ImageFormat::FLOAT, ImageFormat::RGBA);
-		Pointer<Image> floatImage = new Image(srcImage->getType(), floatFormat, srcImage->getSize());
+		Pointer<Image> mipmapImage = new Image(srcImage->getType(), floatFormat, size, numMipmaps);
+		Pointer<Image> tempImage;
+		MipmapGenerator generator(this->mipmapFilter, this->mipmapFlags, this->threadPool);
 		
 		// convert one image at a time since the source image may have mipmaps while the destination image doesn't have mipmaps
 		for (int imageIndex = 0; imageIndex < numImages; ++imageIndex)
 		{
-			// convert source image to float format
-			this->convertPixels(srcImage->getFormat(), srcImage->getData<void>(startImage + imageIndex),
-				floatFormat, floatImage->getData<void>(), floatImage->getImageNumPixels());
-			
-			// check if rescaling of the top-level image is necessary
-			Pointer<Image> mipmap = rescale ? scaleFiltered(floatImage, size) : floatImage;
+			this->buildMipmaps(srcImage, startImage + imageIndex, mipmapImage, tempImage, generator);
 
-			// convert toplevel float image to destination format
-			this->convertImage(mipmap, 1, 0, dstFormat, dstMode, dstData);
-			dstData += Image::calcMemorySize(dstFormat, size);
+			// convert all levels to destination format
+			this->convertImage(mipmapImage, numMipmaps, 0, dstFormat, dstMode, dstData);
+			dstData += Image::calcMemorySize(dstFormat, size, numMipmaps);
+		}
+	}
+}
 
-			// generate mipmaps
-			for (int mipmapIndex = 1; mipmapIndex < numMipmaps; ++mipmapIndex)
-			{
-				size = max(size >> 1, 1);
-				mipmap = scaleFiltered(mipmap, size);
-				
-				// convert scaled mipmap float image to destination format
-				this->convertImage(mipmap, 1, 0, dstFormat, dstMode, dstData);
-				dstData += Image::calcMemorySize(dstFormat, size);
-			}
+void ImageConverter::buildMipmaps(Pointer<Image> srcImage, int srcImageIndex, Pointer<Image> mipmapImage,
+	Pointer<Image>& tempImage, MipmapGenerator& generator)
+{
+	ImageFormat floatFormat = mipmapImage->getFormat();
+	int3 srcSize = srcImage->getSize();
+	int3 size = mipmapImage->getSize();
+	
+	if (all(size == srcSize))
+	{
+		// convert source image to float format directly into the top level
+		this->convertImage(srcImage, 1, srcImageIndex,
+			floatFormat, DataConverter::NATIVE, mipmapImage->getData<void>());
+	}
+	else
+	{
+		// convert source image to float format
+		if (tempImage == null)
+			tempImage = new Image(srcImage->getType(), floatFormat, srcSize);
+		this->convertImage(srcImage, 1, srcImageIndex,
+			floatFormat, DataConverter::NATIVE, tempImage->getData<void>());
+	
+		// rescale into the top level
+		if (size.x <= srcSize.x && size.y <= srcSize.y && size.z <= srcSize.z)
+		{
+			generator.scale(tempImage->getData<float4>(), srcSize, mipmapImage->getData<float4>(), size, true);
+		}
+		else
+		{
+			// scale up with interpolation
+			Pointer<Image> scaled = scaleFiltered(tempImage, size);
+			memcpy(mipmapImage->getData<void>(), scaled->getData<void>(), scaled->getMemorySize());
 		}
 	}
+	
+	// calc the other levels from the top level
+	generator.generate(mipmapImage->getData<float4>(), size, mipmapImage->getNumMipmaps());
 }
 
 
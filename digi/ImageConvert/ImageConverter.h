@@ -3,8 +3,10 @@
 
 #include <map>
 
+#include <digi/System/ThreadPool.h>
 #include <digi/Image/Image.h>
 #include "DataConverter.h"
+#include "MipmapGenerator.h"
 
 
 namespace digi {
@@ -29,9 +31,41 @@ class ImageConverter : public Object
 {
 public:
 
-	ImageConverter(Pointer<ConverterContext> context)
-		: context(context) {}
+	/// quality of texture compression
+	enum Quality
+	{
+		/// fast compression with lower quality, e.g. for iteration builds
+		FAST,
+		
+		/// default quality
+		NORMAL
+	};
+
+	/// constructor. if a thread pool is given, pixel conversion, mipmap generation and compression to blocky formats
+	/// (e.g. DXT) run in parallel
+	ImageConverter(Pointer<ConverterContext> context, Pointer<ThreadPool> threadPool = null)
+		: context(context), threadPool(threadPool), quality(NORMAL), mipmapFilter(MipmapGenerator::BOX),
+		mipmapFlags(0) {}
 	virtual ~ImageConverter();
+
+	/// set thread pool for parallel conversion, null for conversion on the calling thread
+	void setThreadPool(Pointer<ThreadPool> threadPool) {this->threadPool = threadPool;}
+
+	/// get thread pool
+	Pointer<ThreadPool> getThreadPool() {return this->threadPool;}
+
+	/// set quality of texture compression
+	void setQuality(Quality quality) {this->quality = quality;}
+
+	/// get quality of texture compression
+	Quality getQuality() {return this->quality;}
+
+	/// set filter for mipmap generation and flags of MipmapGenerator (e.g. MipmapGenerator::SRGB)
+	void setMipmapFilter(MipmapGenerator::Filter filter, int flags = 0)
+	{
+		this->mipmapFilter = filter;
+		this->mipmapFlags = flags;
+	}
 	
 	/// get a converter that converts pixels of srcFormat to a byte buffer
 	Pointer<DataConverter> getPixelConverter(ImageFormat srcFormat, ImageFormat dstFormat, DataConverter::Mode dstMode);
@@ -78,11 +112,25 @@ protected:
 
 	static void buildConversion(ConverterWriter& cw, ImageFormat srcFormat, ImageFormat dstFormat);
 
+	// convert one source image into the top level of a float4 image and generate its mipmaps. the temp image is
+	// created if the source image needs rescaling
+	void buildMipmaps(Pointer<Image> srcImage, int srcImageIndex, Pointer<Image> mipmapImage,
+		Pointer<Image>& tempImage, MipmapGenerator& generator);
+
 	// context (the llvm jit)
 	Pointer<ConverterContext> context;
 
 	// converter cache (crc32 of converter parameters -> converter)
 	std::map<uint32_t, Pointer<DataConverter> > converters;
+
+	// thread pool for parallel conversion
+	Pointer<ThreadPool> threadPool;
+
+	Quality quality;
+
+	// mipmap generation
+	MipmapGenerator::Filter mipmapFilter;
+	int mipmapFlags;
 };	
 
 /// @}
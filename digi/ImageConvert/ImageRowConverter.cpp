@@ -0,0 +1,52 @@
+#include <digi/Utility/VectorUtility.h>
+
+#include "ImageRowConverter.h"
+
+
+namespace digi {
+
+ImageRowConverter::~ImageRowConverter()
+{
+}
+
+void ImageRowConverter::begin(ImageFormat format, int width, int height)
+{
+	this->converter = this->imageConverter->getPixelConverter(format, this->image->getFormat(),
+		DataConverter::NATIVE);
+	this->srcFormat = format;
+	this->srcWidth = width;
+}
+
+void ImageRowConverter::rows(int y, int numRows, const uint8_t* data, size_t stride)
+{
+	int width = max(this->image->getWidth() >> this->mipmapIndex, 1);
+	int height = max(this->image->getHeight() >> this->mipmapIndex, 1);
+	ImageFormat dstFormat = this->image->getFormat();
+	size_t srcPixelSize = this->srcFormat.getMemorySize();
+	size_t dstPixelSize = dstFormat.getMemorySize();
+	uint8_t* dstData = this->image->getData<uint8_t>(this->mipmapIndex, this->imageIndex) + y * width * dstPixelSize;
+
+	numRows = min(numRows, height - y);
+	if (numRows <= 0)
+		return;
+	
+	Pointer<ThreadPool> threadPool = this->imageConverter->getThreadPool();
+	if (width == this->srcWidth && stride == this->srcWidth * srcPixelSize)
+	{
+		// convert whole strip at once
+		this->converter->convertParallel((void*)data, srcPixelSize, NULL,
+			dstData, dstPixelSize, size_t(numRows) * width, threadPool);
+	}
+	else
+	{
+		// convert row by row
+		int length = min(width, this->srcWidth);
+		for (int i = 0; i < numRows; ++i)
+		{
+			this->converter->convertParallel((void*)(data + i * stride), srcPixelSize, NULL,
+				dstData + i * width * dstPixelSize, dstPixelSize, length, threadPool);
+		}
+	}
+}
+
+} // namespace digi
@@ -0,0 +1,56 @@
+#ifndef digi_ImageConvert_ImageRowConverter_h
+#define digi_ImageConvert_ImageRowConverter_h
+
+#include <digi/Image/ImageRowConsumer.h>
+#include "ImageConverter.h"
+
+
+namespace digi {
+
+/// @addtogroup ImageConvert
+/// @{
+
+/**
+	converts the rows of an image that is decoded strip by strip into a preallocated image, therefore the decoded
+	image is never held in memory completely. use like this:
+
+	Pointer<Image> image = new Image(Image::IMAGE, ImageFormat(ImageFormat::XYZW32, ImageFormat::FLOAT,
+		ImageFormat::RGBA), width, height);
+	ImageRowConverter rowConverter(converter, image);
+	loadPNG("image.png", rowConverter);
+
+	the destination format must not be blocky/compressed. rows and columns outside of the destination image are
+	clipped. the strips are converted in parallel if the image converter has a thread pool
+*/
+class ImageRowConverter : public ImageRowConsumer
+{
+public:
+
+	ImageRowConverter(Pointer<ImageConverter> imageConverter, Pointer<Image> image, int mipmapIndex = 0,
+		int imageIndex = 0)
+		: imageConverter(imageConverter), image(image), mipmapIndex(mipmapIndex), imageIndex(imageIndex),
+		srcWidth(0) {}
+
+	virtual ~ImageRowConverter();
+
+	virtual void begin(ImageFormat format, int width, int height);
+	virtual void rows(int y, int numRows, const uint8_t* data, size_t stride);
+
+protected:
+
+	Pointer<ImageConverter> imageConverter;
+	Pointer<Image> image;
+	int mipmapIndex;
+	int imageIndex;
+
+	// converter and format of decoded image
+	Pointer<DataConverter> converter;
+	ImageFormat srcFormat;
+	int srcWidth;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -0,0 +1,580 @@
+#include <math.h>
+
+#include <algorithm>
+
+#include "MipmapGenerator.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define DIGI_MIPMAP_SSE
+#endif
+
+
+namespace digi {
+
+namespace
+{
+	const double pi = 3.1415926535897932384626433832795;
+
+	// number of pixels of a work item when rows are combined
+	const int CHUNK_SIZE = 1024;
+
+	// images with less pixels are processed on the calling thread
+	const size_t MIN_PARALLEL_SIZE = 16384;
+
+	double sinc(double x)
+	{
+		x *= pi;
+		return x == 0.0 ? 1.0 : sin(x) / x;
+	}
+
+	// modified bessel function of the first kind and order 0
+	double bessel0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		double x2 = x * x * 0.25;
+		for (int k = 1; k < 32 && term > sum * 1e-12; ++k)
+		{
+			term *= x2 / (double(k) * double(k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// kaiser windowed sinc with a radius of 3 pixels
+	double kaiser(double x)
+	{
+		const double radius = 3.0;
+		const double alpha = 4.0;
+		if (fabs(x) >= radius)
+			return 0.0;
+		double t = x / radius;
+		return sinc(x) * bessel0(alpha * sqrt(1.0 - t * t)) / bessel0(alpha);
+	}
+
+	// lanczos windowed sinc with a radius of 3 pixels
+	double lanczos(double x)
+	{
+		if (fabs(x) >= 3.0)
+			return 0.0;
+		return sinc(x) * sinc(x / 3.0);
+	}
+
+	// filter weights for one dimension. destination pixel i is the sum of the source pixels starting at first[i]
+	// weighted with weights[offsets[i]] to weights[offsets[i + 1] - 1]
+	struct Weights
+	{
+		std::vector<int> first;
+		std::vector<int> offsets;
+		std::vector<float> weights;
+	};
+
+	void calcWeights(MipmapGenerator::Filter filter, int srcSize, int dstSize, Weights& w)
+	{
+		// the kernel gets stretched when scaling down
+		double scale = double(srcSize) / double(dstSize);
+		double stretch = std::max(scale, 1.0);
+		double radius = (filter == MipmapGenerator::BOX ? 0.5 : 3.0) * stretch;
+
+		w.first.resize(dstSize);
+		w.offsets.resize(dstSize + 1);
+		w.weights.clear();
+		for (int i = 0; i < dstSize; ++i)
+		{
+			// center of destination pixel in source coordinates
+			double center = (double(i) + 0.5) * scale;
+			int begin = std::max(int(floor(center - radius)), 0);
+			int end = std::min(int(ceil(center + radius)), srcSize);
+
+			size_t offset = w.weights.size();
+			double sum = 0.0;
+			for (int j = begin; j < end; ++j)
+			{
+				double weight;
+				if (filter == MipmapGenerator::BOX)
+				{
+					// overlap of source pixel with destination pixel
+					weight = std::max(std::min(double(j + 1), center + radius) - std::max(double(j), center - radius), 0.0);
+				}
+				else
+				{
+					double x = (double(j) + 0.5 - center) / stretch;
+					weight = filter == MipmapGenerator::KAISER ? kaiser(x) : lanczos(x);
+				}
+				w.weights.push_back(float(weight));
+				sum += weight;
+			}
+
+			// normalize so that the weights at the border also sum up to one
+			if (fabs(sum) > 1e-6)
+			{
+				for (size_t k = offset; k < w.weights.size(); ++k)
+					w.weights[k] = float(w.weights[k] / sum);
+			}
+			else
+			{
+				// use nearest pixel
+				w.weights.resize(offset);
+				begin = std::min(int(center), srcSize - 1);
+				w.weights.push_back(1.0f);
+			}
+			w.first[i] = begin;
+			w.offsets[i] = int(offset);
+		}
+		w.offsets[dstSize] = int(w.weights.size());
+	}
+
+
+	// pass in x direction, one work item per row
+	class FilterRowsTask : public ThreadTask
+	{
+	public:
+
+		FilterRowsTask(const float4* srcData, int srcWidth, float4* dstData, int dstWidth, const Weights& w)
+			: srcData(srcData), srcWidth(srcWidth), dstData(dstData), dstWidth(dstWidth), w(w) {}
+
+		virtual ~FilterRowsTask() {}
+
+		virtual void run(int index)
+		{
+			const float4* src = this->srcData + size_t(index) * this->srcWidth;
+			float4* dst = this->dstData + size_t(index) * this->dstWidth;
+			const float* weights = this->w.weights.data();
+			for (int i = 0; i < this->dstWidth; ++i)
+			{
+				const float4* s = src + this->w.first[i];
+				int begin = this->w.offsets[i];
+				int end = this->w.offsets[i + 1];
+			#ifdef DIGI_MIPMAP_SSE
+				__m128 sum = _mm_setzero_ps();
+				for (int k = begin; k < end; ++k, ++s)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps((const float*)s)));
+				_mm_storeu_ps((float*)(dst + i), sum);
+			#else
+				float4 sum = splat4(0.0f);
+				for (int k = begin; k < end; ++k, ++s)
+					sum += weights[k] * *s;
+				dst[i] = sum;
+			#endif
+			}
+		}
+
+	protected:
+
+		const float4* srcData;
+		int srcWidth;
+		float4* dstData;
+		int dstWidth;
+		const Weights& w;
+	};
+
+	// box filter for halving width and height, one work item per destination row
+	class HalveTask : public ThreadTask
+	{
+	public:
+
+		HalveTask(const float4* srcData, int srcWidth, float4* dstData, int dstWidth)
+			: srcData(srcData), srcWidth(srcWidth), dstData(dstData), dstWidth(dstWidth) {}
+
+		virtual ~HalveTask() {}
+
+		virtual void run(int index)
+		{
+			const float4* s1 = this->srcData + size_t(index) * 2 * this->srcWidth;
+			const float4* s2 = s1 + this->srcWidth;
+			float4* dst = this->dstData + size_t(index) * this->dstWidth;
+		#ifdef DIGI_MIPMAP_SSE
+			__m128 quarter = _mm_set1_ps(0.25f);
+			for (int i = 0; i < this->dstWidth; ++i)
+			{
+				__m128 a = _mm_add_ps(_mm_loadu_ps((const float*)(s1 + 2 * i)), _mm_loadu_ps((const float*)(s1 + 2 * i + 1)));
+				__m128 b = _mm_add_ps(_mm_loadu_ps((const float*)(s2 + 2 * i)), _mm_loadu_ps((const float*)(s2 + 2 * i + 1)));
+				_mm_storeu_ps((float*)(dst + i), _mm_mul_ps(_mm_add_ps(a, b), quarter));
+			}
+		#else
+			for (int i = 0; i < this->dstWidth; ++i)
+				dst[i] = (s1[2 * i] + s1[2 * i + 1] + s2[2 * i] + s2[2 * i + 1]) * 0.25f;
+		#endif
+		}
+
+	protected:
+
+		const float4* srcData;
+		int srcWidth;
+		float4* dstData;
+		int dstWidth;
+	};
+
+	// pass in y or z direction. destination rows are weighted sums of source rows. one work item per chunk of a row
+	class CombineRowsTask : public ThreadTask
+	{
+	public:
+
+		CombineRowsTask(const float4* srcData, int srcNumRows, float4* dstData, int dstNumRows, size_t rowLength,
+			const Weights& w)
+			: srcData(srcData), srcNumRows(srcNumRows), dstData(dstData), dstNumRows(dstNumRows), rowLength(rowLength),
+			w(w)
+		{
+			this->numChunks = int((rowLength + CHUNK_SIZE - 1) / CHUNK_SIZE);
+		}
+
+		virtual ~CombineRowsTask() {}
+
+		// get number of work items for given number of slices
+		int getCount(int numSlices) {return numSlices * this->dstNumRows * this->numChunks;}
+
+		virtual void run(int index)
+		{
+			int chunk = index % this->numChunks;
+			int row = index / this->numChunks;
+			int slice = row / this->dstNumRows;
+			int y = row - slice * this->dstNumRows;
+
+			size_t begin = size_t(chunk) * CHUNK_SIZE;
+			int length = int(std::min(this->rowLength - begin, size_t(CHUNK_SIZE)));
+			float4* dst = this->dstData + size_t(row) * this->rowLength + begin;
+			const float4* src = this->srcData + (size_t(slice) * this->srcNumRows + this->w.first[y]) * this->rowLength
+				+ begin;
+			const float* weights = this->w.weights.data();
+
+			for (int k = this->w.offsets[y]; k < this->w.offsets[y + 1]; ++k)
+			{
+				bool first = k == this->w.offsets[y];
+			#ifdef DIGI_MIPMAP_SSE
+				__m128 weight = _mm_set1_ps(weights[k]);
+				if (first)
+				{
+					for (int i = 0; i < length; ++i)
+						_mm_storeu_ps((float*)(dst + i), _mm_mul_ps(weight, _mm_loadu_ps((const float*)(src + i))));
+				}
+				else
+				{
+					for (int i = 0; i < length; ++i)
+					{
+						_mm_storeu_ps((float*)(dst + i), _mm_add_ps(_mm_loadu_ps((const float*)(dst + i)),
+							_mm_mul_ps(weight, _mm_loadu_ps((const float*)(src + i)))));
+					}
+				}
+			#else
+				float weight = weights[k];
+				if (first)
+				{
+					for (int i = 0; i < length; ++i)
+						dst[i] = weight * src[i];
+				}
+				else
+				{
+					for (int i = 0; i < length; ++i)
+						dst[i] += weight * src[i];
+				}
+			#endif
+				src += this->rowLength;
+			}
+		}
+
+	protected:
+
+		const float4* srcData;
+		int srcNumRows;
+		float4* dstData;
+		int dstNumRows;
+		size_t rowLength;
+		const Weights& w;
+		int numChunks;
+	};
+
+	// sRGB conversion, tables with linear interpolation for the range [0, 1]
+	const int SRGB_TABLE_SIZE = 4096;
+
+	double srgbToLinearExact(double c)
+	{
+		return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+	}
+
+	double linearToSrgbExact(double c)
+	{
+		return c <= 0.0031308 ? std::max(c, 0.0) * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+	}
+
+	struct SrgbTables
+	{
+		float toLinear[SRGB_TABLE_SIZE + 1];
+		float toSrgb[SRGB_TABLE_SIZE + 1];
+
+		SrgbTables()
+		{
+			for (int i = 0; i <= SRGB_TABLE_SIZE; ++i)
+			{
+				double c = double(i) / double(SRGB_TABLE_SIZE);
+				this->toLinear[i] = float(srgbToLinearExact(c));
+				this->toSrgb[i] = float(linearToSrgbExact(c));
+			}
+		}
+	};
+	const SrgbTables srgbTables;
+
+	inline float lookup(const float* table, float c)
+	{
+		float f = c * float(SRGB_TABLE_SIZE);
+		int i = int(f);
+		f -= float(i);
+		return table[i] + (table[i + 1] - table[i]) * f;
+	}
+
+	inline float srgbToLinear(float c)
+	{
+		if (c >= 0.0f && c < 1.0f)
+			return lookup(srgbTables.toLinear, c);
+		return float(srgbToLinearExact(c));
+	}
+
+	inline float linearToSrgb(float c)
+	{
+		if (c >= 0.0f && c < 1.0f)
+			return lookup(srgbTables.toSrgb, c);
+		return float(linearToSrgbExact(c));
+	}
+
+	// converts pixels into linear space for filtering or back, one work item per chunk
+	class ColorSpaceTask : public ThreadTask
+	{
+	public:
+
+		ColorSpaceTask(const float4* srcData, float4* dstData, size_t numPixels, int flags, bool toLinear)
+			: srcData(srcData), dstData(dstData), numPixels(numPixels), flags(flags), toLinear(toLinear) {}
+
+		virtual ~ColorSpaceTask() {}
+
+		int getCount() {return int((this->numPixels + CHUNK_SIZE - 1) / CHUNK_SIZE);}
+
+		virtual void run(int index)
+		{
+			size_t begin = size_t(index) * CHUNK_SIZE;
+			size_t end = std::min(begin + CHUNK_SIZE, this->numPixels);
+			bool srgb = (this->flags & MipmapGenerator::SRGB) != 0;
+			bool premultiply = (this->flags & MipmapGenerator::PREMULTIPLY_ALPHA) != 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				float4 p = this->srcData[i];
+				if (this->toLinear)
+				{
+					if (srgb)
+					{
+						p.x = srgbToLinear(p.x);
+						p.y = srgbToLinear(p.y);
+						p.z = srgbToLinear(p.z);
+					}
+					if (premultiply)
+					{
+						p.x *= p.w;
+						p.y *= p.w;
+						p.z *= p.w;
+					}
+				}
+				else
+				{
+					if (premultiply && p.w > 0.0f)
+					{
+						float s = 1.0f / p.w;
+						p.x *= s;
+						p.y *= s;
+						p.z *= s;
+					}
+					if (srgb)
+					{
+						p.x = linearToSrgb(p.x);
+						p.y = linearToSrgb(p.y);
+						p.z = linearToSrgb(p.z);
+					}
+				}
+				this->dstData[i] = p;
+			}
+		}
+
+	protected:
+
+		const float4* srcData;
+		float4* dstData;
+		size_t numPixels;
+		int flags;
+		bool toLinear;
+	};
+} // anonymous namespace
+
+
+// MipmapGenerator
+
+MipmapGenerator::~MipmapGenerator()
+{
+}
+
+void MipmapGenerator::generate(Pointer<Image> image)
+{
+	int3 size = image->getSize();
+	int numMipmaps = image->getNumMipmaps();
+	int numImages = image->getNumImages();
+	for (int imageIndex = 0; imageIndex < numImages; ++imageIndex)
+		this->generate(image->getData<float4>(imageIndex), size, numMipmaps);
+}
+
+void MipmapGenerator::generate(float4* data, int3 size, int numMipmaps)
+{
+	bool convert = this->flags != 0;
+	size_t numPixels = Image::calcNumPixels(size);
+
+	// convert level 0 into linear space if necessary
+	const float4* srcData = data;
+	if (convert && numMipmaps > 1)
+	{
+		this->levels[0].resize(numPixels);
+		ColorSpaceTask task(data, this->levels[0].data(), numPixels, this->flags, true);
+		this->run(task, task.getCount(), numPixels);
+		srcData = this->levels[0].data();
+	}
+
+	float4* dstData = data + numPixels;
+	int3 srcSize = size;
+	for (int mipmapIndex = 1; mipmapIndex < numMipmaps; ++mipmapIndex)
+	{
+		int3 dstSize = max(srcSize >> 1, 1);
+		size_t dstNumPixels = Image::calcNumPixels(dstSize);
+		if (convert)
+		{
+			// filter in linear space and convert back into the mipmap level
+			this->levels[1].resize(dstNumPixels);
+			this->scale(srcData, srcSize, this->levels[1].data(), dstSize);
+			ColorSpaceTask task(this->levels[1].data(), dstData, dstNumPixels, this->flags, false);
+			this->run(task, task.getCount(), dstNumPixels);
+
+			std::swap(this->levels[0], this->levels[1]);
+			srcData = this->levels[0].data();
+		}
+		else
+		{
+			this->scale(srcData, srcSize, dstData, dstSize);
+			srcData = dstData;
+		}
+
+		dstData += dstNumPixels;
+		srcSize = dstSize;
+	}
+}
+
+void MipmapGenerator::scale(const float4* srcData, int3 srcSize, float4* dstData, int3 dstSize, bool applyFlags)
+{
+	if (applyFlags && this->flags != 0)
+	{
+		// convert into linear space, filter and convert back
+		size_t srcNumPixels = Image::calcNumPixels(srcSize);
+		this->levels[0].resize(srcNumPixels);
+		ColorSpaceTask toLinear(srcData, this->levels[0].data(), srcNumPixels, this->flags, true);
+		this->run(toLinear, toLinear.getCount(), srcNumPixels);
+
+		size_t dstNumPixels = Image::calcNumPixels(dstSize);
+		this->levels[1].resize(dstNumPixels);
+		this->scale(this->levels[0].data(), srcSize, this->levels[1].data(), dstSize);
+		
+		ColorSpaceTask fromLinear(this->levels[1].data(), dstData, dstNumPixels, this->flags, false);
+		this->run(fromLinear, fromLinear.getCount(), dstNumPixels);
+		return;
+	}
+
+	bool scaleX = dstSize.x != srcSize.x;
+	bool scaleY = dstSize.y != srcSize.y;
+	bool scaleZ = dstSize.z != srcSize.z;
+	if (!scaleX && !scaleY && !scaleZ)
+	{
+		std::copy(srcData, srcData + Image::calcNumPixels(srcSize), dstData);
+		return;
+	}
+
+	Weights w;
+	const float4* current = srcData;
+	int3 currentSize = srcSize;
+	int tempIndex = 0;
+
+	// fast path for box filter that halves width and height
+	if (this->filter == BOX && srcSize.x == dstSize.x * 2 && srcSize.y == dstSize.y * 2)
+	{
+		currentSize.x = dstSize.x;
+		currentSize.y = dstSize.y;
+		float4* next = dstData;
+		if (scaleZ)
+		{
+			this->temp[tempIndex].resize(Image::calcNumPixels(currentSize));
+			next = this->temp[tempIndex].data();
+			tempIndex ^= 1;
+		}
+
+		HalveTask task(current, srcSize.x, next, dstSize.x);
+		this->run(task, currentSize.y * currentSize.z, Image::calcNumPixels(currentSize));
+		current = next;
+		scaleX = false;
+		scaleY = false;
+	}
+
+	// filter in x direction
+	if (scaleX)
+	{
+		currentSize.x = dstSize.x;
+		float4* next = dstData;
+		if (scaleY || scaleZ)
+		{
+			this->temp[tempIndex].resize(Image::calcNumPixels(currentSize));
+			next = this->temp[tempIndex].data();
+			tempIndex ^= 1;
+		}
+
+		calcWeights(this->filter, srcSize.x, dstSize.x, w);
+		FilterRowsTask task(current, srcSize.x, next, dstSize.x, w);
+		this->run(task, currentSize.y * currentSize.z, Image::calcNumPixels(currentSize));
+		current = next;
+	}
+
+	// filter in y direction
+	if (scaleY)
+	{
+		int srcNumRows = currentSize.y;
+		currentSize.y = dstSize.y;
+		float4* next = dstData;
+		if (scaleZ)
+		{
+			this->temp[tempIndex].resize(Image::calcNumPixels(currentSize));
+			next = this->temp[tempIndex].data();
+			tempIndex ^= 1;
+		}
+
+		calcWeights(this->filter, srcNumRows, dstSize.y, w);
+		CombineRowsTask task(current, srcNumRows, next, dstSize.y, currentSize.x, w);
+		this->run(task, task.getCount(currentSize.z), Image::calcNumPixels(currentSize));
+		current = next;
+	}
+
+	// filter in z direction, the slices are the rows
+	if (scaleZ)
+	{
+		int srcNumSlices = currentSize.z;
+		currentSize.z = dstSize.z;
+
+		calcWeights(this->filter, srcNumSlices, dstSize.z, w);
+		CombineRowsTask task(current, srcNumSlices, dstData, dstSize.z, size_t(currentSize.x) * currentSize.y, w);
+		this->run(task, task.getCount(1), Image::calcNumPixels(currentSize));
+	}
+}
+
+void MipmapGenerator::run(ThreadTask& task, int count, size_t numPixels)
+{
+	if (this->threadPool != null && count > 1 && numPixels >= MIN_PARALLEL_SIZE)
+	{
+		this->threadPool->run(task, count);
+	}
+	else
+	{
+		for (int i = 0; i < count; ++i)
+			task.run(i);
+	}
+}
+
+
+} // namespace digi
@@ -0,0 +1,81 @@
+#ifndef digi_ImageConvert_MipmapGenerator_h
+#define digi_ImageConvert_MipmapGenerator_h
+
+#include <vector>
+
+#include <digi/Math/All.h>
+#include <digi/System/ThreadPool.h>
+#include <digi/Image/Image.h>
+
+
+namespace digi {
+
+/// @addtogroup ImageConvert
+/// @{
+
+/**
+	generates the mipmap chain of float4 images (XYZW32, FLOAT). each level is calculated from the previous level with
+	a separable filter kernel, i.e. one pass per dimension. the passes are split into rows that are processed in
+	parallel if a thread pool is given. the temporary buffers are kept for the next call
+*/
+class MipmapGenerator
+{
+public:
+
+	enum Filter
+	{
+		/// average of the covered pixels
+		BOX,
+
+		/// kaiser windowed sinc, sharper than box
+		KAISER,
+
+		/// lanczos windowed sinc with 3 lobes
+		LANCZOS
+	};
+
+	enum Flags
+	{
+		/// color channels are sRGB encoded and get filtered in linear space
+		SRGB = 1,
+
+		/// color channels are multiplied by alpha before filtering and divided after, so that the color of transparent
+		/// pixels does not bleed into visible pixels
+		PREMULTIPLY_ALPHA = 2
+	};
+
+	MipmapGenerator(Filter filter = BOX, int flags = 0, Pointer<ThreadPool> threadPool = null)
+		: filter(filter), flags(flags), threadPool(threadPool) {}
+
+	~MipmapGenerator();
+
+	/// generate mipmap levels 1 to numMipmaps - 1 of all images from level 0
+	void generate(Pointer<Image> image);
+
+	/// generate mipmap levels 1 to numMipmaps - 1 from level 0. the levels are stored one after another like in Image
+	void generate(float4* data, int3 size, int numMipmaps);
+
+	/// scale float4 data to given size using the filter kernel. if applyFlags is true, the data is converted into
+	/// linear space according to the flags before filtering and back after, like in generate()
+	void scale(const float4* srcData, int3 srcSize, float4* dstData, int3 dstSize, bool applyFlags = false);
+
+protected:
+
+	void run(ThreadTask& task, int count, size_t numPixels);
+
+	Filter filter;
+	int flags;
+	Pointer<ThreadPool> threadPool;
+
+	// linear versions of previous and current level if flags are set
+	std::vector<float4> levels[2];
+
+	// results of the passes of scale()
+	std::vector<float4> temp[2];
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -1,3 +1,5 @@
+#include <iostream>
+
 #include <gtest/gtest.h>
 
 #include <digi/Utility/Convert.h>
@@ -5,12 +7,16 @@
 #include <digi/Math/All.h>
 #include <digi/Math/GTestHelpers.h>
 #include <digi/System/MemoryDevices.h>
+#include <digi/System/Timer.h>
 #include <digi/Image/BufferFormat.h>
 #include <digi/Image/DDS.h>
 #include <digi/Image/JPEGWrapper.h>
 #include <digi/Image/PNGWrapper.h>
 #include <digi/ImageConvert/BufferConverter.h>
 #include <digi/ImageConvert/ImageConverter.h>
+#include <digi/ImageConvert/ImageRowConverter.h>
+#include <digi/ImageConvert/ImageUtil.h>
+#include <digi/ImageConvert/MipmapGenerator.h>
 
 #include "InitLibraries.h"
 
@@ -65,6 +71,50 @@ TEST(ImageConvert, Converter)
 	EXPECT_EQ(dstData[3], 3);
 }
 
+TEST(ImageConvert, ConverterCache)
+{
+	BufferFormat srcFormat(BufferFormat::XYZW16, BufferFormat::FLOAT);
+	BufferFormat dstFormat(BufferFormat::XYZW8, BufferFormat::UNORM);
+	
+	fs::path cacheDirectory = "converterCache";
+	fs::remove_all(cacheDirectory);
+	fs::create_directories(cacheDirectory);
+
+	// converters share the compiled functions of their context and store them in the on-disk cache
+	{
+		Pointer<ConverterContext> context = new ConverterContext();
+		context->setCacheDirectory(cacheDirectory);
+		
+		Pointer<BufferConverter> converter1 = new BufferConverter(context);
+		Pointer<BufferConverter> converter2 = new BufferConverter(context);
+		EXPECT_TRUE(converter1->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE) != null);
+		EXPECT_TRUE(converter2->getElementConverter(srcFormat, dstFormat, DataConverter::NATIVE) != null);
+		
+		EXPECT_EQ(context->getNumCacheHits(), 1);
+		EXPECT_EQ(context->getNumDiskCacheHits(), 0);
+		EXPECT_EQ(context->getNumCacheMisses(), 1);
+	}
+	
+	// a new context loads the converter from the on-disk cache
+	{
+		Pointer<ConverterContext> context = new ConverterContext();
+		context->setCacheDirectory(cacheDirectory);
+
+		Pointer<BufferConverter> converter = new BufferConverter(context);
+		half4 srcData[1];
+		ubyte4 dstData[1];
+		srcData[0] = make_half4(0.0f, 0.1f, 0.5f, 1.0f);
+		converter->convert(srcFormat, srcData, dstFormat, dstData, 1); 
+		EXPECT_VECTOR_EQ(dstData[0], make_ubyte4(0, 25, 128, 255));
+
+		EXPECT_EQ(context->getNumCacheHits(), 0);
+		EXPECT_EQ(context->getNumDiskCacheHits(), 1);
+		EXPECT_EQ(context->getNumCacheMisses(), 0);
+	}
+	
+	fs::remove_all(cacheDirectory);
+}
+
 TEST(ImageConvert, BufferConverter)
 {
 	Pointer<ConverterContext> context = new ConverterContext();
@@ -321,6 +371,205 @@ TEST(ImageConvert, ImageConverter)
 	}
 }
 
+TEST(ImageConvert, ImageRowConverter)
+{
+	Pointer<ConverterContext> context = new ConverterContext();		
+	Pointer<ImageConverter> converter = new ImageConverter(context, ThreadPool::create());
+
+	Pointer<Image> image = loadJPEG("brick.jpg");
+	int width = image->getWidth();
+	int height = image->getHeight();
+	ImageFormat dstFormat(ImageFormat::XYZ32, ImageFormat::FLOAT, ImageFormat::RGB);
+	Pointer<Image> reference = converter->convert(image, dstFormat, vector3(width, height, 1), false);
+
+	// convert strips while decoding into a preallocated image
+	Pointer<Image> converted = new Image(Image::IMAGE, dstFormat, width, height);
+	ImageRowConverter rowConverter(converter, converted);
+	loadJPEG("brick.jpg", rowConverter);
+	EXPECT_EQ(0, memcmp(reference->getData<void>(), converted->getData<void>(), converted->getMemorySize()));
+}
+
+TEST(ImageConvert, ConvertPixelsBenchmark)
+{
+	Pointer<ConverterContext> context = new ConverterContext();
+	Pointer<ThreadPool> threadPool = ThreadPool::create();
+	Pointer<ImageConverter> converter = new ImageConverter(context);
+
+	// noise pixels
+	const size_t numPixels = 4096 * 4096;
+	ImageFormat srcFormat(ImageFormat::XYZW8, ImageFormat::UNORM, ImageFormat::RGBA);
+	ImageFormat dstFormat(ImageFormat::XYZW16, ImageFormat::FLOAT, ImageFormat::RGBA);
+	std::vector<ubyte4> srcData(numPixels);
+	uint32_t seed = 1;
+	for (size_t i = 0; i < numPixels; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		srcData[i] = make_ubyte4(uint8_t(seed >> 24), uint8_t(seed >> 16), uint8_t(seed >> 8), uint8_t(seed));
+	}
+	
+	// compile converter before measuring
+	converter->getPixelConverter(srcFormat, dstFormat, DataConverter::NATIVE);
+
+	std::vector<half4> reference(numPixels);
+	std::vector<half4> dstData(numPixels);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const char* names[] = {"single", "parallel"};
+		converter->setThreadPool(pass == 0 ? null : threadPool);
+
+		int start = Timer::getMilliSeconds();
+		converter->convertPixels(srcFormat, &srcData[0], dstFormat, pass == 0 ? &reference[0] : &dstData[0],
+			numPixels);
+		int duration = std::max(Timer::getMilliSeconds() - start, 1);
+		std::cout << "XYZW8 -> XYZW16F " << names[pass];
+		if (pass == 1)
+			std::cout << " (" << threadPool->getNumThreads() << " threads)";
+		std::cout << ": " << double(numPixels) / 1000.0 / duration << " MP/s" << std::endl;
+	}
+	
+	// parallel conversion must give the same result
+	EXPECT_EQ(0, memcmp(&reference[0], &dstData[0], numPixels * sizeof(half4)));
+}
+
+TEST(ImageConvert, MipmapGenerator)
+{
+	ImageFormat floatFormat(ImageFormat::XYZW32, ImageFormat::FLOAT, ImageFormat::RGBA);
+
+	// box filter averages 2x2 pixels
+	{
+		Pointer<Image> image = new Image(Image::IMAGE, floatFormat, 4, 2, 1, 3);
+		float4* data = image->getData<float4>();
+		for (int i = 0; i < 8; ++i)
+			data[i] = splat4(float(i));
+		MipmapGenerator generator;
+		generator.generate(image);
+		
+		float4* level1 = image->getData<float4>(1, 0);
+		EXPECT_EPSILON_EQ(level1[0].x, 2.5f);
+		EXPECT_EPSILON_EQ(level1[1].x, 4.5f);
+		float4* level2 = image->getData<float4>(2, 0);
+		EXPECT_EPSILON_EQ(level2[0].x, 3.5f);
+	}
+
+	// all filters keep a constant image constant, also for odd sizes and volumes
+	for (int filter = MipmapGenerator::BOX; filter <= MipmapGenerator::LANCZOS; ++filter)
+	{
+		int3 size = vector3(13, 7, 5);
+		int numMipmaps = Image::calcNumMipmaps(size);
+		Pointer<Image> image = new Image(Image::VOLUME, floatFormat, size, numMipmaps);
+		float4* data = image->getData<float4>();
+		for (int i = 0; i < 13 * 7 * 5; ++i)
+			data[i] = make_float4(0.25f, 0.5f, 0.75f, 1.0f);
+		MipmapGenerator generator((MipmapGenerator::Filter)filter);
+		generator.generate(image);
+
+		size_t numPixels = image->getNumPixels();
+		for (size_t i = 0; i < numPixels; ++i)
+			EXPECT_EPSILON_EQ(data[i], make_float4(0.25f, 0.5f, 0.75f, 1.0f));
+	}
+
+	// sRGB: black and white average to middle gray in linear space
+	{
+		Pointer<Image> image = new Image(Image::IMAGE, floatFormat, 2, 1, 1, 2);
+		float4* data = image->getData<float4>();
+		data[0] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		data[1] = make_float4(1.0f, 1.0f, 1.0f, 1.0f);
+		MipmapGenerator generator(MipmapGenerator::BOX, MipmapGenerator::SRGB);
+		generator.generate(image);
+		
+		EXPECT_NEAR(data[2].x, 0.7354f, 0.001f);
+		EXPECT_EPSILON_EQ(data[2].w, 0.5f);
+	}
+
+	// premultiplied alpha: color of transparent pixel does not bleed
+	{
+		Pointer<Image> image = new Image(Image::IMAGE, floatFormat, 2, 1, 1, 2);
+		float4* data = image->getData<float4>();
+		data[0] = make_float4(1.0f, 0.0f, 0.0f, 0.0f);
+		data[1] = make_float4(0.0f, 1.0f, 0.0f, 1.0f);
+		MipmapGenerator generator(MipmapGenerator::BOX, MipmapGenerator::PREMULTIPLY_ALPHA);
+		generator.generate(image);
+		
+		EXPECT_EPSILON_EQ(data[2], make_float4(0.0f, 1.0f, 0.0f, 0.5f));
+	}
+
+	// scaling with applied flags gives the same result as the mipmap level
+	{
+		float4 src[2] = {make_float4(0.0f, 0.0f, 0.0f, 0.0f), make_float4(1.0f, 1.0f, 1.0f, 1.0f)};
+		float4 dst[1];
+		MipmapGenerator generator(MipmapGenerator::BOX, MipmapGenerator::SRGB | MipmapGenerator::PREMULTIPLY_ALPHA);
+		generator.scale(src, vector3(2, 1, 1), dst, vector3(1, 1, 1), true);
+		
+		float4 data[3] = {src[0], src[1]};
+		generator.generate(data, vector3(2, 1, 1), 2);
+		EXPECT_EPSILON_EQ(dst[0], data[2]);
+		EXPECT_NEAR(dst[0].x, 1.0f, 0.001f);
+	}
+
+	// parallel generation gives the same result
+	{
+		int3 size = vector3(300, 200, 1);
+		int numMipmaps = Image::calcNumMipmaps(size);
+		Pointer<Image> image1 = new Image(Image::IMAGE, floatFormat, size, numMipmaps);
+		Pointer<Image> image2 = new Image(Image::IMAGE, floatFormat, size, numMipmaps);
+		float4* data = image1->getData<float4>();
+		uint32_t seed = 1;
+		for (int i = 0; i < 300 * 200; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			data[i] = splat4(float(seed >> 8) / 16777216.0f);
+		}
+		memcpy(image2->getData<void>(), data, 300 * 200 * sizeof(float4));
+		
+		MipmapGenerator(MipmapGenerator::LANCZOS, MipmapGenerator::SRGB).generate(image1);
+		MipmapGenerator(MipmapGenerator::LANCZOS, MipmapGenerator::SRGB, ThreadPool::create(4)).generate(image2);
+		EXPECT_EQ(0, memcmp(image1->getData<void>(), image2->getData<void>(), image1->getMemorySize()));
+	}
+}
+
+TEST(ImageConvert, MipmapGeneratorBenchmark)
+{
+	ImageFormat floatFormat(ImageFormat::XYZW32, ImageFormat::FLOAT, ImageFormat::RGBA);
+	const int size = 2048;
+	int numMipmaps = Image::calcNumMipmaps(vector3(size, size, 1));
+	Pointer<Image> image = new Image(Image::IMAGE, floatFormat, size, size, 1, numMipmaps);
+	float4* data = image->getData<float4>();
+	for (int i = 0; i < size * size; ++i)
+		data[i] = splat4(float(i & 255) / 255.0f);
+	Pointer<ThreadPool> threadPool = ThreadPool::create();
+	
+	// repeated scaleFiltered calls
+	{
+		Pointer<Image> mipmap = new Image(Image::IMAGE, floatFormat, size, size);
+		memcpy(mipmap->getData<void>(), data, size * size * sizeof(float4));
+		int start = Timer::getMilliSeconds();
+		int3 s = vector3(size, size, 1);
+		for (int i = 1; i < numMipmaps; ++i)
+		{
+			s = max(s >> 1, 1);
+			mipmap = scaleFiltered(mipmap, s);
+		}
+		int duration = std::max(Timer::getMilliSeconds() - start, 1);
+		std::cout << "scaleFiltered: " << double(size) * size / 1000.0 / duration << " MP/s" << std::endl;
+	}
+	
+	const char* names[] = {"box", "kaiser", "lanczos"};
+	for (int filter = MipmapGenerator::BOX; filter <= MipmapGenerator::LANCZOS; ++filter)
+	{
+		for (int parallel = 0; parallel < 2; ++parallel)
+		{
+			MipmapGenerator generator(MipmapGenerator::Filter(filter), MipmapGenerator::SRGB,
+				parallel ? threadPool : null);
+			int start = Timer::getMilliSeconds();
+			generator.generate(image);
+			int duration = std::max(Timer::getMilliSeconds() - start, 1);
+			std::cout << "MipmapGenerator " << names[filter] << " sRGB"
+				<< (parallel ? " (" + toString(threadPool->getNumThreads()) + " threads)" : std::string())
+				<< ": " << double(size) * size / 1000.0 / duration << " MP/s" << std::endl;
+		}
+	}
+}
+
 #ifdef HAVE_S3TC
 TEST(ImageConvert, S3TC)
 {
@@ -346,6 +595,48 @@ TEST(ImageConvert, S3TC)
 		saveDDS(arg("brick.dxt1.%0.dds", i), converted, i);
 	}
 }
+
+TEST(ImageConvert, S3TCBenchmark)
+{
+	Pointer<ConverterContext> context = new ConverterContext();
+	Pointer<ThreadPool> threadPool = ThreadPool::create();
+	Pointer<ImageConverter> converter = new ImageConverter(context);
+
+	// noise image
+	const int size = 1024;
+	ImageFormat srcFormat(ImageFormat::XYZW8, ImageFormat::UNORM, ImageFormat::RGBA);
+	Pointer<Image> image = new Image(Image::IMAGE, srcFormat, size, size);
+	ubyte4* pixels = image->getData<ubyte4>();
+	uint32_t seed = 1;
+	for (int i = 0; i < size * size; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pixels[i] = make_ubyte4(uint8_t(seed >> 24), uint8_t(seed >> 16), uint8_t(seed >> 8), 255);
+	}
+
+	ImageFormat dstFormat(ImageFormat::BLOCK8, ImageFormat::UNORM, ImageFormat::DXT1);
+	Pointer<Image> reference;
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		const char* names[] = {"normal", "normal parallel", "fast parallel"};
+		converter->setThreadPool(pass == 0 ? null : threadPool);
+		converter->setQuality(pass == 2 ? ImageConverter::FAST : ImageConverter::NORMAL);
+
+		int start = Timer::getMilliSeconds();
+		Pointer<Image> converted = converter->convert(image, dstFormat, vector3(size, size, 1), false);
+		int duration = std::max(Timer::getMilliSeconds() - start, 1);
+		std::cout << "DXT1 " << names[pass];
+		if (pass != 0)
+			std::cout << " (" << threadPool->getNumThreads() << " threads)";
+		std::cout << ": " << double(size) * size / 1000.0 / duration << " MP/s" << std::endl;
+
+		// parallel compression with same quality must give the same result
+		if (pass == 0)
+			reference = converted;
+		else if (pass == 1)
+			EXPECT_EQ(0, memcmp(reference->getData<void>(), converted->getData<void>(), converted->getMemorySize()));
+	}
+}
 #endif
 
 #ifdef HAVE_PVRTC
@@ -1,2 +1,2 @@
-set(Mesh_DEPENDENCIES Utility Math)
+set(Mesh_DEPENDENCIES System Math)
 set(Mesh_HAS_INIT_DONE YES)
@@ -4,11 +4,13 @@
 #endif
 
 #include <map>
+#include <algorithm>
 
 #include <digi/Utility/VectorUtility.h>
 #include <digi/Utility/ArrayUtility.h>
 #include <digi/Utility/MapUtility.h>
 #include <digi/Utility/foreach.h>
+#include <digi/System/ThreadPool.h>
 
 #include "Mesh.h"
 
@@ -25,60 +27,251 @@ struct Edge
 {
 	int v1;
 	int v2;
-	int triangleIndex;
+	int edgeIndex;
 };
 
-bool operator ==(const Edge& a, const Edge& b)
+// hash of an edge that is independent of the direction. therefore an edge and its reverse edge land in the same
+// shard and in the same probe sequence of the hash table
+static inline uint32_t hashEdge(int v1, int v2)
 {
-	return a.v1 == b.v1 && a.v2 == b.v2;
+	uint64_t a = uint32_t(std::min(v1, v2));
+	uint64_t b = uint32_t(std::max(v1, v2));
+	uint64_t h = (a << 32 | b) * UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	return uint32_t(h >> 32);
 }
 
-bool operator <(const Edge& a, const Edge& b)
+// get shard of an edge from the upper bits of its hash
+static inline int getShard(uint32_t hash, int numShards)
 {
-	return a.v1 < b.v1 || (a.v1 == b.v1 && a.v2 < b.v2);
+	return int((uint64_t(hash) * numShards) >> 32);
 }
 
-void generateNeighbors(int numTriangles, const int* vertexIndices, int* neighbors)
+/*
+	the edges are partitioned into shards by the upper bits of their hash, then each shard gets an own open
+	addressing hash table that is small enough to stay in the cache. the chunks of triangles are partitioned in
+	parallel and the shards are processed in parallel.
+*/
+struct NeighborContext
 {
-	std::vector<Edge> edges(numTriangles * 3);
+	int numTriangles;
+	const int* vertexIndices;
+	int* neighbors;
 
-	// fill array with all vertex pairs
-	for (int i = 0; i < numTriangles; ++i)
+	int numChunks;
+	int numTrianglesPerChunk;
+	int numShards;
+
+	// number of edges per chunk and shard, then start of the edges of a chunk in a shard
+	std::vector<int> counts;
+
+	// start of each shard in shardEdges
+	std::vector<int> shardStarts;
+
+	// edges sorted by shard, in original order inside a shard
+	std::vector<Edge> shardEdges;
+};
+
+// counts the edges per chunk and shard
+class NeighborCountTask : public ThreadTask
+{
+public:
+
+	NeighborCountTask(NeighborContext& c) : c(c) {}
+	virtual ~NeighborCountTask() {}
+
+	virtual void run(int chunkIndex)
 	{
-		// iterate over the three edges of the triangle
-		for (int e = 0; e < 3; ++e)
+		NeighborContext& c = this->c;
+		int begin = chunkIndex * c.numTrianglesPerChunk;
+		int end = std::min(begin + c.numTrianglesPerChunk, c.numTriangles);
+		int* counts = &c.counts[chunkIndex * c.numShards];
+		for (int i = begin; i < end; ++i)
 		{
-			neighbors[i * 3 + e] = -1;
-
-			edges[i * 3 + e].v1 = vertexIndices[i * 3 + e];
-			edges[i * 3 + e].v2 = vertexIndices[i * 3 + (e + 1) % 3];
-			edges[i * 3 + e].triangleIndex = i;
+			const int* v = c.vertexIndices + i * 3;
+			++counts[getShard(hashEdge(v[0], v[1]), c.numShards)];
+			++counts[getShard(hashEdge(v[1], v[2]), c.numShards)];
+			++counts[getShard(hashEdge(v[2], v[0]), c.numShards)];
 		}
 	}
 
-	// sort vertex pairs
-	sort(edges);
+protected:
 
-	// find neighbors
-	for (int i = 0; i < numTriangles; ++i)
+	NeighborContext& c;
+};
+
+// distributes the edges of a chunk into the shards
+class NeighborScatterTask : public ThreadTask
+{
+public:
+
+	NeighborScatterTask(NeighborContext& c) : c(c) {}
+	virtual ~NeighborScatterTask() {}
+
+	virtual void run(int chunkIndex)
 	{
-		Edge edge;
+		NeighborContext& c = this->c;
+		int begin = chunkIndex * c.numTrianglesPerChunk;
+		int end = std::min(begin + c.numTrianglesPerChunk, c.numTriangles);
+		int* positions = &c.counts[chunkIndex * c.numShards];
+		for (int i = begin; i < end; ++i)
+		{
+			const int* v = c.vertexIndices + i * 3;
+			for (int e = 0; e < 3; ++e)
+			{
+				int v1 = v[e];
+				int v2 = v[e == 2 ? 0 : e + 1];
+				Edge& edge = c.shardEdges[positions[getShard(hashEdge(v1, v2), c.numShards)]++];
+				edge.v1 = v1;
+				edge.v2 = v2;
+				edge.edgeIndex = i * 3 + e;
+			}
+		}
+	}
+
+protected:
+
+	NeighborContext& c;
+};
+
+// builds the hash table of one shard and looks up the reverse edge of each edge
+class NeighborShardTask : public ThreadTask
+{
+public:
+
+	NeighborShardTask(NeighborContext& c) : c(c) {}
+	virtual ~NeighborShardTask() {}
 
-		// iterate over the three edges of the triangle
-		for (int e = 0; e < 3; ++e)
+	virtual void run(int shardIndex)
+	{
+		NeighborContext& c = this->c;
+		const Edge* edges = c.shardEdges.data() + c.shardStarts[shardIndex];
+		int numEdges = c.shardStarts[shardIndex + 1] - c.shardStarts[shardIndex];
+
+		// hash table of edge indices in this shard with a load factor of at most 0.5, -1 is empty
+		int size = 16;
+		while (size < numEdges * 2)
+			size *= 2;
+		int mask = size - 1;
+		std::vector<int> table(size, -1);
+
+		// insert edges. if an edge is shared by more than two triangles then the first triangle is kept
+		for (int i = 0; i < numEdges; ++i)
 		{
-			// build edge in reverse order
-			edge.v2 = vertexIndices[i * 3 + e];
-			edge.v1 = vertexIndices[i * 3 + (e + 1) % 3];
+			const Edge& edge = edges[i];
+			int slot = hashEdge(edge.v1, edge.v2) & mask;
+			while (true)
+			{
+				int index = table[slot];
+				if (index == -1)
+				{
+					table[slot] = i;
+					break;
+				}
+				if (edges[index].v1 == edge.v1 && edges[index].v2 == edge.v2)
+					break;
+				slot = (slot + 1) & mask;
+			}
+		}
 
-			// find neighbor (which contains edge in reverse order)
-			std::vector<Edge>::iterator it = find(edges, edge);
-			if (it != edges.end())
+		// find neighbors (which contain the edge in reverse order)
+		for (int i = 0; i < numEdges; ++i)
+		{
+			const Edge& edge = edges[i];
+			int neighbor = -1;
+			int slot = hashEdge(edge.v1, edge.v2) & mask;
+			while (true)
 			{
-				neighbors[i * 3 + e] = it->triangleIndex;
+				int index = table[slot];
+				if (index == -1)
+					break;
+				if (edges[index].v1 == edge.v2 && edges[index].v2 == edge.v1)
+				{
+					neighbor = edges[index].edgeIndex / 3;
+					break;
+				}
+				slot = (slot + 1) & mask;
 			}
+			c.neighbors[edge.edgeIndex] = neighbor;
+		}
+	}
+
+protected:
+
+	NeighborContext& c;
+};
+
+static void runTask(ThreadTask& task, int count, const Pointer<ThreadPool>& threadPool)
+{
+	if (threadPool != null)
+	{
+		threadPool->run(task, count);
+	}
+	else
+	{
+		for (int i = 0; i < count; ++i)
+			task.run(i);
+	}
+}
+
+void generateNeighbors(int numTriangles, const int* vertexIndices, int* neighbors, Pointer<ThreadPool> threadPool)
+{
+	if (numTriangles <= 0)
+		return;
+
+	NeighborContext c;
+	c.vertexIndices = vertexIndices;
+	c.numTriangles = numTriangles;
+	c.neighbors = neighbors;
+
+	// choose number of shards so that the hash table of a shard fits into the cache
+	int numThreads = threadPool != null ? threadPool->getNumThreads() : 1;
+	int shardBits = 0;
+	while (shardBits < 16 && (numTriangles * 3 >> shardBits) > 4096)
+		++shardBits;
+	c.numShards = 1 << shardBits;
+
+	// use multiple chunks only if there are multiple threads
+	c.numChunks = shardBits > 0 ? numThreads * 4 : 1;
+	c.numTrianglesPerChunk = (numTriangles + c.numChunks - 1) / c.numChunks;
+	c.counts.resize(c.numChunks * c.numShards);
+
+	// count edges per chunk and shard
+	if (c.numShards > 1)
+	{
+		NeighborCountTask countTask(c);
+		runTask(countTask, c.numChunks, threadPool);
+	}
+	else
+	{
+		c.counts[0] = numTriangles * 3;
+	}
+
+	// calc start of each chunk in each shard so that the edges stay in original order inside a shard
+	c.shardStarts.resize(c.numShards + 1);
+	int position = 0;
+	for (int shardIndex = 0; shardIndex < c.numShards; ++shardIndex)
+	{
+		c.shardStarts[shardIndex] = position;
+		for (int chunkIndex = 0; chunkIndex < c.numChunks; ++chunkIndex)
+		{
+			int& count = c.counts[chunkIndex * c.numShards + shardIndex];
+			int start = position;
+			position += count;
+			count = start;
 		}
 	}
+	c.shardStarts[c.numShards] = position;
+
+	// distribute edges into shards
+	c.shardEdges.resize(numTriangles * 3);
+	NeighborScatterTask scatterTask(c);
+	runTask(scatterTask, c.numChunks, threadPool);
+
+	// build hash tables and find neighbors
+	NeighborShardTask shardTask(c);
+	runTask(shardTask, c.numShards, threadPool);
 }
 
 enum ProcessedState
@@ -1149,349 +1342,490 @@ bool triangulate(const std::vector<float3>& positions, std::vector<int>& triangl
 float calcAcmr(const std::vector<int>& triangleVertexIndices, int cacheSize)
 {
 	int numTriangles = int(triangleVertexIndices.size() / 3);
+	int numVertexIndices = numTriangles * 3;
+	if (numTriangles == 0)
+		return 0.0f;
+	cacheSize = clamp(cacheSize, 1, 32);
 
-	int cache[32];
-	int cacheIndex = 0;
-	fill(cache, -1);
+	// a vertex is in the fifo cache if less than cacheSize misses happened since it was inserted.
+	// therefore store for each vertex the miss count at insertion instead of simulating the cache
+	int maxVertexIndex = 0;
+	for (int i = 0; i < numVertexIndices; ++i)
+		maxVertexIndex = std::max(maxVertexIndex, triangleVertexIndices[i]);
+	std::vector<int> insertTimes(maxVertexIndex + 1, -cacheSize);
 
-	int numHits = 0;
-	cacheSize = clamp(cacheSize, 1, 32);
-	
-	int numVertexIndices = numTriangles * 3;
+	int numMisses = 0;
 	for (int i = 0; i < numVertexIndices; ++i)
 	{
-		int vertexIndex = triangleVertexIndices[i];
-		
-		// check if we have a cache hit
-		int j;
-		for (j = 0; j < cacheSize; ++j)
+		int& insertTime = insertTimes[triangleVertexIndices[i]];
+		if (numMisses - insertTime >= cacheSize)
 		{
-			if (cache[j] == vertexIndex)
-			{
-				++numHits;
-				break;
-			}
-		}
-		
-		// add to cache if no hit
-		if (j == cacheSize)
-		{
-			cache[cacheIndex] = vertexIndex;
-			cacheIndex = (cacheIndex + 1) % cacheSize;
+			insertTime = numMisses;
+			++numMisses;
 		}
 	}
-	
-	int numMisses = numVertexIndices - numHits;
+
 	return float(numMisses) / float(numTriangles);
 }
 
-struct OptVertex
+/*
+	vertex scores according to Forsyth: the score of a vertex depends on its position in the simulated lru cache and
+	on the number of triangles that still use it. the scores are precalculated and a triangle has the sum of the
+	scores of its vertices. when a triangle is added, only the scores of the vertices in the cache change, therefore
+	only the scores of the triangles that use these vertices get updated.
+*/
+enum
 {
-	int cachePosition;
-	float score;
-	int numTriangles;
-	int triangleIndicesStart;
-};
+	OPT_CACHE_SIZE = 32,
+	OPT_MAX_VALENCE = 64,
 
-struct OptTriangle
-{
-	bool used;
-	int vertexIndex0;
-	int vertexIndex1;
-	int vertexIndex2;
-	int sequenceNumber;
+	// minimum number of triangles per chunk for parallel optimization
+	OPT_MIN_CHUNK_SIZE = 65536
 };
 
-#define CACHE_SIZE 32
-
-static float calcVertexScore(const OptVertex& vertex)
+struct OptScores
 {
-		const int maxSizeVertexCache = CACHE_SIZE;
+	float cacheScores[OPT_CACHE_SIZE];
+	float valenceScores[OPT_MAX_VALENCE];
+
+	OptScores()
+	{
 		const float cacheDecayPower = 1.5f;
 		const float lastTriScore = 0.75f;
 		const float valenceBoostScale = 2.0f;
 		const float valenceBoostPower = 0.5f;
 
-		float score = 0.0f;
-		int cachePosition = vertex.cachePosition;
-		if (cachePosition < 0)
+		for (int i = 0; i < OPT_CACHE_SIZE; ++i)
 		{
-				// Vertex is not in FIFO cache - no score.
+			// vertices of the last triangle have a fixed score, otherwise adding the triangle 1,2,3 or 3,1,2 would
+			// make a difference
+			if (i < 3)
+				this->cacheScores[i] = lastTriScore;
+			else
+				this->cacheScores[i] = powf(1.0f - float(i - 3) / float(OPT_CACHE_SIZE - 3), cacheDecayPower);
 		}
+
+		// bonus points for having a low number of triangles still to use the vertex, so we get rid of lone vertices
+		// quickly. vertices without triangles don't contribute to any triangle
+		this->valenceScores[0] = 0.0f;
+		for (int i = 1; i < OPT_MAX_VALENCE; ++i)
+			this->valenceScores[i] = valenceBoostScale * powf(float(i), -valenceBoostPower);
+	}
+
+	float get(int cachePosition, int valence) const
+	{
+		float score = cachePosition >= 0 ? this->cacheScores[cachePosition] : 0.0f;
+		if (valence < OPT_MAX_VALENCE)
+			score += this->valenceScores[valence];
 		else
+			score += 2.0f * powf(float(valence), -0.5f);
+		return score;
+	}
+};
+
+static const OptScores optScores;
+
+// optimize triangles with vertex indices in the range [0, numVertices)
+static void optimizeVertexCacheChunk(int numVertices, int numTriangles, const int* indices, int* newIndices)
+{
+	// adjacency: triangles of each vertex. the triangles that are not added yet are at the start of the list
+	std::vector<int> valences(numVertices, 0);
+	for (int i = 0; i < numTriangles * 3; ++i)
+		++valences[indices[i]];
+	std::vector<int> adjacencyStarts(numVertices + 1);
+	int start = 0;
+	for (int i = 0; i < numVertices; ++i)
+	{
+		adjacencyStarts[i] = start;
+		start += valences[i];
+		valences[i] = 0;
+	}
+	adjacencyStarts[numVertices] = start;
+	std::vector<int> adjacency(numTriangles * 3);
+	for (int i = 0; i < numTriangles * 3; ++i)
+	{
+		int vertexIndex = indices[i];
+		adjacency[adjacencyStarts[vertexIndex] + valences[vertexIndex]++] = i / 3;
+	}
+
+	// initial scores
+	std::vector<int> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (int i = 0; i < numVertices; ++i)
+		vertexScores[i] = optScores.get(-1, valences[i]);
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool> added(numTriangles, false);
+	int bestIndex = -1;
+	float bestScore = -1.0f;
+	for (int i = 0; i < numTriangles; ++i)
+	{
+		const int* t = indices + i * 3;
+		float score = vertexScores[t[0]] + vertexScores[t[1]] + vertexScores[t[2]];
+		triangleScores[i] = score;
+		if (score > bestScore)
 		{
-				if (cachePosition < 3)
+			bestScore = score;
+			bestIndex = i;
+		}
+	}
+
+	// cache with space for the vertices that get pushed out by a new triangle
+	int cache[OPT_CACHE_SIZE + 3];
+	int newCache[OPT_CACHE_SIZE + 3];
+	int cacheSize = 0;
+
+	// stack of vertices that were added recently, used to continue at a dead end
+	std::vector<int> deadEndStack;
+	deadEndStack.reserve(numTriangles * 3);
+	int nextInputIndex = 0;
+
+	for (int n = 0; n < numTriangles; ++n)
+	{
+		// continue at a dead end: take the best triangle of a recently added vertex or the next triangle in input order
+		while (bestIndex == -1 && !deadEndStack.empty())
+		{
+			int vertexIndex = deadEndStack.back();
+			deadEndStack.pop_back();
+			int begin = adjacencyStarts[vertexIndex];
+			int end = begin + valences[vertexIndex];
+			for (int i = begin; i < end; ++i)
+			{
+				int triangleIndex = adjacency[i];
+				if (triangleScores[triangleIndex] > bestScore)
 				{
-						// This vertex was used in the last triangle,
-						// so it has a fixed score, whichever of the three
-						// it's in. Otherwise, you can get very different
-						// answers depending on whether you add
-						// the triangle 1,2,3 or 3,1,2 - which is silly.
-						score = lastTriScore;
+					bestScore = triangleScores[triangleIndex];
+					bestIndex = triangleIndex;
 				}
-				else
-				{
-						//assert(cachePosition < maxSizeVertexCache);
+			}
+		}
+		if (bestIndex == -1)
+		{
+			while (added[nextInputIndex])
+				++nextInputIndex;
+			bestIndex = nextInputIndex;
+		}
 
-						// Points for being high in the cache.
-						const float scaler = 1.0f / (maxSizeVertexCache - 3);
+		// add triangle
+		const int* t = indices + bestIndex * 3;
+		newIndices[n * 3 + 0] = t[0];
+		newIndices[n * 3 + 1] = t[1];
+		newIndices[n * 3 + 2] = t[2];
+		added[bestIndex] = true;
 
-						score = 1.0f - (cachePosition - 3) * scaler;
-						score = powf(score, cacheDecayPower);
+		// remove triangle from the triangles of its vertices
+		for (int i = 0; i < 3; ++i)
+		{
+			int vertexIndex = t[i];
+			int begin = adjacencyStarts[vertexIndex];
+			int end = begin + --valences[vertexIndex];
+			for (int j = begin; j < end; ++j)
+			{
+				if (adjacency[j] == bestIndex)
+				{
+					std::swap(adjacency[j], adjacency[end]);
+					break;
 				}
+			}
+			deadEndStack.push_back(vertexIndex);
 		}
 
-		// Bonus points for having a low number of tris still to
-		// use the vert, so we get rid of lone verts quickly.
-		float valenceBoost = powf((float)vertex.numTriangles, -valenceBoostPower);
-		score += valenceBoostScale * valenceBoost;
+		// move vertices of triangle to the front of the cache
+		int newCacheSize = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			if (i == 0 || (t[i] != t[0] && (i == 1 || t[i] != t[1])))
+				newCache[newCacheSize++] = t[i];
+		}
+		for (int i = 0; i < cacheSize; ++i)
+		{
+			int vertexIndex = cache[i];
+			if (vertexIndex != t[0] && vertexIndex != t[1] && vertexIndex != t[2])
+				newCache[newCacheSize++] = vertexIndex;
+		}
 
-		return score;
+		// update scores of the vertices in the new cache and of the vertices that fell out of the cache
+		for (int i = 0; i < newCacheSize; ++i)
+		{
+			int vertexIndex = newCache[i];
+			int cachePosition = i < OPT_CACHE_SIZE ? i : -1;
+			cachePositions[vertexIndex] = cachePosition;
+			float score = optScores.get(cachePosition, valences[vertexIndex]);
+			float delta = score - vertexScores[vertexIndex];
+			vertexScores[vertexIndex] = score;
+
+			int begin = adjacencyStarts[vertexIndex];
+			int end = begin + valences[vertexIndex];
+			for (int j = begin; j < end; ++j)
+				triangleScores[adjacency[j]] += delta;
+		}
+		cacheSize = std::min(newCacheSize, int(OPT_CACHE_SIZE));
+		std::copy(newCache, newCache + cacheSize, cache);
+
+		// find best triangle that uses a vertex in the cache
+		bestIndex = -1;
+		bestScore = -1.0f;
+		for (int i = 0; i < cacheSize; ++i)
+		{
+			int vertexIndex = cache[i];
+			int begin = adjacencyStarts[vertexIndex];
+			int end = begin + valences[vertexIndex];
+			for (int j = begin; j < end; ++j)
+			{
+				int triangleIndex = adjacency[j];
+				if (triangleScores[triangleIndex] > bestScore)
+				{
+					bestScore = triangleScores[triangleIndex];
+					bestIndex = triangleIndex;
+				}
+			}
+		}
+	}
 }
 
-struct Optimizer
+// optimizes the triangles of one chunk
+class OptimizeVertexCacheTask : public ThreadTask
 {
-	std::vector<OptTriangle> triangles;
-	std::vector<OptVertex> vertices;
-	std::vector<int> triangleIndices;
-	int cache[CACHE_SIZE];
-	
-	Optimizer(int numTriangles, int numVertices)
-		: triangles(numTriangles + 1), vertices(numVertices + 1), triangleIndices(numTriangles * 3)
-	{
-		fill(cache, numVertices);
-	}
+public:
+
+	OptimizeVertexCacheTask(const std::vector<int>& chunkIndices, const std::vector<int>& chunkStarts,
+		int* newIndices)
+		: chunkIndices(chunkIndices), chunkStarts(chunkStarts), newIndices(newIndices) {}
 
-	void useVertex(int vertexIndex, int triangleIndex)
+	virtual ~OptimizeVertexCacheTask() {}
+
+	virtual void run(int chunkIndex)
 	{
-		// vertex gets used by a triangle
-		OptVertex& vertex = this->vertices[vertexIndex];
-		
-		// decrement number of still-to-be-added triangles
-		--vertex.numTriangles;
-		
-		// remove triangle from list of still-to-be-added triangles
-		int triangleIndicesEnd = vertex.triangleIndicesStart + vertex.numTriangles;
-		for (int i = vertex.triangleIndicesStart; i < triangleIndicesEnd; ++i)
+		int begin = this->chunkStarts[chunkIndex];
+		int numIndices = this->chunkStarts[chunkIndex + 1] - begin;
+		if (numIndices == 0)
+			return;
+		const int* indices = this->chunkIndices.data() + begin;
+
+		// map to local vertex indices by subtracting the minimum vertex index of the chunk
+		int minVertexIndex = indices[0];
+		int maxVertexIndex = indices[0];
+		for (int i = 1; i < numIndices; ++i)
 		{
-			// remove triangle from list of still-to-be-added triangles
-			if (this->triangleIndices[i] == triangleIndex)
-			{
-				this->triangleIndices[i] = this->triangleIndices[triangleIndicesEnd];
-				break;
-			}	
+			minVertexIndex = std::min(minVertexIndex, indices[i]);
+			maxVertexIndex = std::max(maxVertexIndex, indices[i]);
 		}
+		std::vector<int> localIndices(numIndices);
+		for (int i = 0; i < numIndices; ++i)
+			localIndices[i] = indices[i] - minVertexIndex;
+
+		// optimize and map back to global vertex indices
+		int* newIndices = this->newIndices + begin;
+		optimizeVertexCacheChunk(maxVertexIndex - minVertexIndex + 1, numIndices / 3, localIndices.data(),
+			newIndices);
+		for (int i = 0; i < numIndices; ++i)
+			newIndices[i] += minVertexIndex;
+	}
 
-		// add vertex to head of cache
-		{
-			int tempVertexIndex = vertexIndex;
-			int i = 0;
-			do
-			{
-				int temp = this->cache[i];
-				this->cache[i] = tempVertexIndex;
-				tempVertexIndex = temp;
-
-				// check if vertex is already in cche
-				if (tempVertexIndex == vertexIndex)
-					break;
+protected:
 
-				++i;
-			} while (i < CACHE_SIZE);
-			
-			// check if a vertex falls out of the cache
-			if (i == CACHE_SIZE)
-				this->vertices[tempVertexIndex].cachePosition = -1;
-		}			
-	}
+	const std::vector<int>& chunkIndices;
+	const std::vector<int>& chunkStarts;
+	int* newIndices;
 };
 
 void optimizeVertexCache(int numVertices, const std::vector<int>& triangleVertexIndices,
-	std::vector<int>& newTriangleVertexIndices)
+	std::vector<int>& newTriangleVertexIndices, Pointer<ThreadPool> threadPool)
 {
 	int numTriangles = int(triangleVertexIndices.size() / 3);
 
-	std::vector<int> mapNew2OldTriangleIndices(numTriangles);
-	
-	Optimizer optimizer(numTriangles, numVertices);
-	int numProcessedTriangles = 0;
-	
-	// initialize triangle data and determine number of triangles per vertex
-	for (int i = 0; i < numTriangles; ++i)
+	// copy input if it is the same variable as the output
+	std::vector<int> copy;
+	const int* indices = triangleVertexIndices.data();
+	if (&triangleVertexIndices == &newTriangleVertexIndices)
 	{
-		OptTriangle& triangle = optimizer.triangles[i];
-		triangle.used = false;
-		triangle.vertexIndex0 = triangleVertexIndices[i * 3 + 0];
-		triangle.vertexIndex1 = triangleVertexIndices[i * 3 + 1];
-		triangle.vertexIndex2 = triangleVertexIndices[i * 3 + 2];
-		triangle.sequenceNumber = 0;
-		
-		++optimizer.vertices[triangle.vertexIndex0].numTriangles;
-		++optimizer.vertices[triangle.vertexIndex1].numTriangles;
-		++optimizer.vertices[triangle.vertexIndex2].numTriangles;
-	}		
-
-	// initialize vertex data
-	int triangleIndicesStart = 0;
-	for (int i = 0; i < numVertices; ++i)
+		copy.assign(triangleVertexIndices.begin(), triangleVertexIndices.begin() + numTriangles * 3);
+		indices = copy.data();
+	}
+	else
 	{
-		OptVertex& vertex = optimizer.vertices[i];
-		vertex.cachePosition = -1;
+		newTriangleVertexIndices = triangleVertexIndices;
+	}
+	if (numTriangles == 0)
+		return;
 
-		// calculate initial vertex score
-		vertex.score = calcVertexScore(vertex);
-		
-		// allocate triangle indices			
-		vertex.triangleIndicesStart = triangleIndicesStart;
-		triangleIndicesStart += vertex.numTriangles;
-		
-		// reset number of triangles again for next step
-		vertex.numTriangles = 0;
+	int numChunks = threadPool != null ? std::min(numTriangles / OPT_MIN_CHUNK_SIZE, threadPool->getNumThreads() * 4) : 1;
+	if (numChunks <= 1)
+	{
+		optimizeVertexCacheChunk(numVertices, numTriangles, indices, newTriangleVertexIndices.data());
+		return;
 	}
 
-	// iterate over triangles and fill triangle indices of vertices
+	/*
+		optimize chunks in parallel. the triangles are distributed into the chunks by their smallest vertex index,
+		therefore a chunk contains neighboring triangles if the vertex order is coherent (which is usually the case)
+		even if the triangle order is not. this only costs a few cache misses at the chunk boundaries
+	*/
+	std::vector<int> chunks(numTriangles);
+	std::vector<int> chunkStarts(numChunks + 1, 0);
+	int64_t numVerticesPerChunk = (int64_t(numVertices) + numChunks - 1) / numChunks;
 	for (int i = 0; i < numTriangles; ++i)
 	{
-		OptTriangle& triangle = optimizer.triangles[i];
-		
-		{
-			OptVertex& vertex = optimizer.vertices[triangle.vertexIndex0];
-			optimizer.triangleIndices[vertex.triangleIndicesStart + vertex.numTriangles] = i;
-			++vertex.numTriangles;
-		}
-
-		{
-			OptVertex& vertex = optimizer.vertices[triangle.vertexIndex1];
-			optimizer.triangleIndices[vertex.triangleIndicesStart + vertex.numTriangles] = i;
-			++vertex.numTriangles;
-		}
-
-		{
-			OptVertex& vertex = optimizer.vertices[triangle.vertexIndex2];
-			optimizer.triangleIndices[vertex.triangleIndicesStart + vertex.numTriangles] = i;
-			++vertex.numTriangles;
-		}
+		const int* t = indices + i * 3;
+		int chunkIndex = int(std::min(t[0], std::min(t[1], t[2])) / numVerticesPerChunk);
+		chunks[i] = chunkIndex;
+		++chunkStarts[chunkIndex + 1];
 	}
-	
-	while (true)
+	for (int i = 0; i < numChunks; ++i)
+		chunkStarts[i + 1] += chunkStarts[i];
+	std::vector<int> positions(chunkStarts.begin(), chunkStarts.end() - 1);
+	std::vector<int> chunkIndices(numTriangles * 3);
+	for (int i = 0; i < numTriangles; ++i)
 	{
-		// find unused triangle with best score
-		float bestScore = 0.0f;
-		int bestIndex = -1;
-		for (int i = 0; i < numTriangles; ++i)
-		{
-			OptTriangle& triangle = optimizer.triangles[i];
-			if (!triangle.used)
-			{
-				float score = optimizer.vertices[triangle.vertexIndex0].score
-					+ optimizer.vertices[triangle.vertexIndex1].score
-					+ optimizer.vertices[triangle.vertexIndex2].score;
+		int* t = &chunkIndices[positions[chunks[i]]++ * 3];
+		t[0] = indices[i * 3 + 0];
+		t[1] = indices[i * 3 + 1];
+		t[2] = indices[i * 3 + 2];
+	}
+	for (int i = 0; i <= numChunks; ++i)
+		chunkStarts[i] *= 3;
 
-				if (score > bestScore)
-				{
-					bestScore = score;
-					bestIndex = i;
-				}
-			}
-		}
-		
-		// check if a triangle was found
-		if (bestIndex == -1)
-			break;
-			
-		int sequenceNumber = 0;
-		while (bestIndex != -1)
-		{
-			mapNew2OldTriangleIndices[numProcessedTriangles++] = bestIndex;
+	OptimizeVertexCacheTask task(chunkIndices, chunkStarts, newTriangleVertexIndices.data());
+	threadPool->run(task, numChunks);
+}
 
-			OptTriangle& triangle = optimizer.triangles[bestIndex];
-			triangle.used = true;
 
-			// use the three vertices
-			optimizer.useVertex(triangle.vertexIndex0, bestIndex);
-			optimizer.useVertex(triangle.vertexIndex1, bestIndex);
-			optimizer.useVertex(triangle.vertexIndex2, bestIndex);
+// overdraw optimization
 
-			// update cache position and score for all vertices in cache
-			for (int i = 0; i < CACHE_SIZE; ++i)
-			{
-				OptVertex& vertex = optimizer.vertices[optimizer.cache[i]];
-				
-				vertex.cachePosition = i;
-				vertex.score = calcVertexScore(vertex);
-			}
-			
-			// find best triangle that is referenced by the vertices in the cache
-			++sequenceNumber;
-			bestScore = 0.0f;
-			bestIndex = -1;
-			for (int i = 0; i < CACHE_SIZE; ++i)
-			{
-				OptVertex& vertex = optimizer.vertices[optimizer.cache[i]];
+// cluster of triangles for overdraw optimization
+struct OverdrawCluster
+{
+	int begin;
+	int end;
+	float sortKey;
+};
 
-				for (int j = vertex.triangleIndicesStart; j < vertex.triangleIndicesStart + vertex.numTriangles; ++j)
-				{
-					int triangleIndex = optimizer.triangleIndices[j];
-					OptTriangle& triangle = optimizer.triangles[triangleIndex];
+static bool operator <(const OverdrawCluster& a, const OverdrawCluster& b)
+{
+	// clusters that face away from the center of the mesh come first
+	return a.sortKey > b.sortKey;
+}
 
-					if (triangle.sequenceNumber != sequenceNumber)
-					{
-						triangle.sequenceNumber = sequenceNumber;
-						
-						float score = optimizer.vertices[triangle.vertexIndex0].score
-							+ optimizer.vertices[triangle.vertexIndex1].score
-							+ optimizer.vertices[triangle.vertexIndex2].score;
-
-						if (score > bestScore)
-						{
-							bestScore = score;
-							bestIndex = triangleIndex;
-						}
-					}
-				}				
-			}
+// simulates a fifo cache and returns the number of misses of a triangle
+static int simulateFifoCache(const int* t, std::vector<int>& insertTimes, int& numMisses, int cacheSize)
+{
+	int numTriangleMisses = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		int& insertTime = insertTimes[t[i]];
+		if (numMisses - insertTime >= cacheSize)
+		{
+			insertTime = numMisses;
+			++numMisses;
+			++numTriangleMisses;
 		}
 	}
+	return numTriangleMisses;
+}
 
-/*
-	// this is for optimizing also the vertex order
-	for (int i = 0; i < numVertices; ++i)
+void optimizeOverdraw(const std::vector<int>& triangleVertexIndices, const std::vector<float3>& positions,
+	int cacheSize, float threshold, std::vector<int>& newTriangleVertexIndices)
+{
+	int numTriangles = int(triangleVertexIndices.size() / 3);
+	int numVertices = int(positions.size());
+	std::vector<int> indices(triangleVertexIndices.begin(), triangleVertexIndices.begin() + numTriangles * 3);
+	if (&triangleVertexIndices != &newTriangleVertexIndices)
+		newTriangleVertexIndices = triangleVertexIndices;
+	if (numTriangles == 0)
+		return;
+	cacheSize = clamp(cacheSize, 3, 32);
+
+	// hard boundaries: the cache was flushed because all vertices of a triangle miss
+	std::vector<int> hardBoundaries;
+	std::vector<int> insertTimes(numVertices, -cacheSize);
+	int numMisses = 0;
+	for (int i = 0; i < numTriangles; ++i)
 	{
-		mapOld2NewVertexIndices[i] = -1;
+		if (simulateFifoCache(&indices[i * 3], insertTimes, numMisses, cacheSize) == 3)
+			hardBoundaries.push_back(i);
 	}
-	int numProcessedVertices = 0;
-*/
+	hardBoundaries.push_back(numTriangles);
+
+	// soft boundaries: split clusters where the acmr of the part since the last boundary is already close to the acmr
+	// of the whole cluster. the cache is assumed to be empty at the start of each cluster
+	std::vector<OverdrawCluster> clusters;
+	int clusterBegin = 0;
+	int numHardBoundaries = int(hardBoundaries.size());
+	for (int h = 0; h < numHardBoundaries; ++h)
+	{
+		int hardEnd = hardBoundaries[h];
+		if (hardEnd == clusterBegin)
+			continue;
+
+		// acmr of cluster between hard boundaries
+		fill(insertTimes, -cacheSize);
+		numMisses = 0;
+		for (int i = clusterBegin; i < hardEnd; ++i)
+			simulateFifoCache(&indices[i * 3], insertTimes, numMisses, cacheSize);
+		float maxAcmr = float(numMisses) / float(hardEnd - clusterBegin) * threshold;
+
+		fill(insertTimes, -cacheSize);
+		numMisses = 0;
+		for (int i = clusterBegin; i < hardEnd; ++i)
+		{
+			simulateFifoCache(&indices[i * 3], insertTimes, numMisses, cacheSize);
+			int numClusterTriangles = i + 1 - clusterBegin;
+			if (i + 1 == hardEnd || (numClusterTriangles >= 8 && float(numMisses) <= maxAcmr * numClusterTriangles))
+			{
+				OverdrawCluster cluster = {clusterBegin, i + 1, 0.0f};
+				clusters.push_back(cluster);
+				clusterBegin = i + 1;
+				fill(insertTimes, -cacheSize);
+				numMisses = 0;
+			}
+		}
+	}
+
+	// area weighted centroid of the mesh
+	float3 meshCentroid = splat3(0.0f);
+	float meshArea = 0.0f;
 	for (int i = 0; i < numTriangles; ++i)
 	{
-		OptTriangle& triangle = optimizer.triangles[mapNew2OldTriangleIndices[i]];
-/*
-		// this is for optimizing also the vertex order
-		if (mapOld2NewVertexIndices[triangle.vertexIndex0] == -1)		
-			mapOld2NewVertexIndices[triangle.vertexIndex0] = numProcessedVertices++;
-		if (mapOld2NewVertexIndices[triangle.vertexIndex1] == -1)		
-			mapOld2NewVertexIndices[triangle.vertexIndex1] = numProcessedVertices++;
-		if (mapOld2NewVertexIndices[triangle.vertexIndex2] == -1)		
-			mapOld2NewVertexIndices[triangle.vertexIndex2] = numProcessedVertices++;
-		
-		newTriangleVertexIndices[i * 3 + 0] = mapOld2NewVertexIndices[triangle.vertexIndex0];
-		newTriangleVertexIndices[i * 3 + 1] = mapOld2NewVertexIndices[triangle.vertexIndex1];
-		newTriangleVertexIndices[i * 3 + 2] = mapOld2NewVertexIndices[triangle.vertexIndex2];
-*/
-		newTriangleVertexIndices[i * 3 + 0] = triangle.vertexIndex0;
-		newTriangleVertexIndices[i * 3 + 1] = triangle.vertexIndex1;
-		newTriangleVertexIndices[i * 3 + 2] = triangle.vertexIndex2;
+		float3 p0 = positions[indices[i * 3 + 0]];
+		float3 p1 = positions[indices[i * 3 + 1]];
+		float3 p2 = positions[indices[i * 3 + 2]];
+		float area = length(cross(p1 - p0, p2 - p0));
+		meshCentroid += (p0 + p1 + p2) * area;
+		meshArea += area;
 	}
-/*	
-	// handle unused vertices
-	for (int i = 0; i < numVertices; ++i)
+	meshCentroid /= max(meshArea * 3.0f, 1e-30f);
+
+	// sort key of clusters: dot product of the average normal and the vector from the mesh centroid to the
+	// cluster centroid. clusters with high values are on the outside of the mesh and likely occlude other clusters
+	foreach (OverdrawCluster& cluster, clusters)
 	{
-		if (mapOld2NewVertexIndices[i] == -1)
+		float3 centroid = splat3(0.0f);
+		float3 normal = splat3(0.0f);
+		float area = 0.0f;
+		for (int i = cluster.begin; i < cluster.end; ++i)
 		{
-			mapOld2NewVertexIndices[i] = numProcessedVertices;
-			numProcessedVertices++;
+			float3 p0 = positions[indices[i * 3 + 0]];
+			float3 p1 = positions[indices[i * 3 + 1]];
+			float3 p2 = positions[indices[i * 3 + 2]];
+			float3 n = cross(p1 - p0, p2 - p0);
+			float a = length(n);
+			centroid += (p0 + p1 + p2) * a;
+			normal += n;
+			area += a;
 		}
+		centroid /= max(area * 3.0f, 1e-30f);
+		normal /= max(length(normal), 1e-30f);
+		cluster.sortKey = dot(centroid - meshCentroid, normal);
+	}
+	std::stable_sort(clusters.begin(), clusters.end());
+
+	// copy clusters in new order
+	int* newIndices = newTriangleVertexIndices.data();
+	foreach (const OverdrawCluster& cluster, clusters)
+	{
+		int numIndices = (cluster.end - cluster.begin) * 3;
+		std::copy(&indices[cluster.begin * 3], &indices[cluster.begin * 3] + numIndices, newIndices);
+		newIndices += numIndices;
 	}
-*/
 }
 
 
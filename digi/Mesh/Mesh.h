@@ -2,6 +2,7 @@
 #define digi_Mesh_h
 
 #include <digi/Math/All.h>
+#include <digi/System/ThreadPool.h>
 
 
 namespace digi {
@@ -15,7 +16,10 @@ namespace MeshUtility {
 /// generate the neighbor list from the vertex indices.
 /// two triangles are connected if they share two vertex indices.
 /// each triangle has three neighbors, one for each edge. -1 stands for no neighbor.
-void generateNeighbors(int numTriangles, const int* vertexIndices, int* neighbors);
+/// if an edge is shared by more than two triangles then the triangle with the lowest index is the neighbor.
+/// runs in linear time using a hash table of the edges, large meshes are processed in parallel if a thread pool is given
+void generateNeighbors(int numTriangles, const int* vertexIndices, int* neighbors,
+	Pointer<ThreadPool> threadPool = null);
 
 /// generate smoothing groups from edge flags
 bool generateSmoothingGroups(int numTriangles, const int* neighbors, const int* edgeFlags, 
@@ -114,7 +118,7 @@ bool triangulate(const std::vector<int>& numVerticesPerPolygon,
 
 // vertex cache optimization
 
-// calculate average cache miss ratio for fifo vertex cache. cache size is 3 to 32.
+// calculate average cache miss ratio for fifo vertex cache. cache size is clamped to 1 to 32.
 float calcAcmr(const std::vector<int>& triangleVertexIndices, int cacheSize);
 
 /*
@@ -123,9 +127,24 @@ float calcAcmr(const std::vector<int>& triangleVertexIndices, int cacheSize);
 	
 	newTriangleVertexIndices contains the triangle vertex indices for the triangles in optimized order.
 	newTriangleVertexIndices can be the same variable as triangleVertexIndices
+	if a thread pool is given then the triangles of large meshes are grouped into chunks by their smallest vertex index
+	(i.e. each chunk covers a range of vertices) and the chunks are optimized in parallel. the optimized chunks are
+	stored one after another in order of their vertex ranges
 */
 void optimizeVertexCache(int numVertices, const std::vector<int>& triangleVertexIndices,
-	std::vector<int>& newTriangleVertexIndices);
+	std::vector<int>& newTriangleVertexIndices, Pointer<ThreadPool> threadPool = null);
+
+/*
+	overdraw optimization according to "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	(Sander, Nehab, Barczak 2007)
+	
+	triangleVertexIndices should already be optimized for the vertex cache. the triangles are split into clusters
+	where the simulated fifo cache of given size gets flushed or where the acmr of a cluster is at most threshold
+	(e.g. 1.05) times the acmr of the unsplit cluster. the clusters on the outside of the mesh are moved to the front.
+	newTriangleVertexIndices can be the same variable as triangleVertexIndices
+*/
+void optimizeOverdraw(const std::vector<int>& triangleVertexIndices, const std::vector<float3>& positions,
+	int cacheSize, float threshold, std::vector<int>& newTriangleVertexIndices);
 
 
 // bone batching
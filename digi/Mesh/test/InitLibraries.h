@@ -7,12 +7,13 @@
 	
 
 // this saves us from including header files manually
-void digiMeshInit(); void digiUtilityInit(); void digiMathInit(); 
-void digiMeshDone(); void digiUtilityDone(); void digiMathDone(); 
+void digiMeshInit(); void digiSystemInit(); void digiUtilityInit(); void digiMathInit(); 
+void digiMeshDone(); void digiSystemDone(); void digiUtilityDone(); void digiMathDone(); 
 
 static void initLibraries()
 {
 	digiMeshInit();
+	digiSystemInit();
 	digiUtilityInit();
 	digiMathInit();
 	
@@ -21,6 +22,7 @@ static void initLibraries()
 static void doneLibraries()
 {
 	digiMeshDone();
+	digiSystemDone();
 	digiUtilityDone();
 	digiMathDone();
 	
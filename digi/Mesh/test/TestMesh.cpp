@@ -1,7 +1,10 @@
+#include <iostream>
+
 #include <gtest/gtest.h>
 
 #include <digi/Utility/foreach.h>
 #include <digi/Utility/VectorUtility.h>
+#include <digi/System/Timer.h>
 #include <digi/Mesh/Mesh.h>
 #include <digi/Math/GTestHelpers.h>
 
@@ -16,6 +19,237 @@ TEST(Mesh, InitLibraries)
 	std::string versionInfo = VersionInfo::get();
 }
 
+// create grid of quads with two triangles each
+static void createGrid(int width, int height, std::vector<int>& vertexIndices)
+{
+	vertexIndices.resize(width * height * 6);
+	int* it = vertexIndices.data();
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			int v = y * (width + 1) + x;
+			it[0] = v;
+			it[1] = v + 1;
+			it[2] = v + width + 2;
+			it[3] = v;
+			it[4] = v + width + 2;
+			it[5] = v + width + 1;
+			it += 6;
+		}
+	}
+}
+
+TEST(Mesh, GenerateNeighbors)
+{
+	std::vector<int> vertexIndices;
+	createGrid(30, 20, vertexIndices);
+	int numTriangles = int(vertexIndices.size() / 3);
+
+	// non-manifold edge: add a third triangle at edge 0-1
+	vertexIndices += 1;
+	vertexIndices += 0;
+	vertexIndices += 1000;
+	++numTriangles;
+
+	std::vector<int> neighbors(numTriangles * 3);
+	MeshUtility::generateNeighbors(numTriangles, vertexIndices.data(), neighbors.data());
+
+	// compare with brute force search
+	for (int i = 0; i < numTriangles; ++i)
+	{
+		for (int e = 0; e < 3; ++e)
+		{
+			int v1 = vertexIndices[i * 3 + e];
+			int v2 = vertexIndices[i * 3 + (e + 1) % 3];
+			int neighbor = -1;
+			for (int j = 0; j < numTriangles && neighbor == -1; ++j)
+			{
+				for (int f = 0; f < 3; ++f)
+				{
+					if (vertexIndices[j * 3 + f] == v2 && vertexIndices[j * 3 + (f + 1) % 3] == v1)
+						neighbor = j;
+				}
+			}
+			EXPECT_EQ(neighbor, neighbors[i * 3 + e]);
+		}
+	}
+
+	// parallel version must give the same result
+	Pointer<ThreadPool> threadPool = ThreadPool::create(4);
+	createGrid(300, 200, vertexIndices);
+	numTriangles = int(vertexIndices.size() / 3);
+	std::vector<int> neighbors1(numTriangles * 3);
+	std::vector<int> neighbors2(numTriangles * 3);
+	MeshUtility::generateNeighbors(numTriangles, vertexIndices.data(), neighbors1.data());
+	MeshUtility::generateNeighbors(numTriangles, vertexIndices.data(), neighbors2.data(), threadPool);
+	EXPECT_EQ(neighbors1, neighbors2);
+
+	// lower triangle of quad (1, 1) is connected to the quads below and to the right and to the upper triangle
+	int triangleIndex = (300 + 1) * 2;
+	EXPECT_EQ(1 * 2 + 1, neighbors1[triangleIndex * 3 + 0]);
+	EXPECT_EQ((300 + 2) * 2 + 1, neighbors1[triangleIndex * 3 + 1]);
+	EXPECT_EQ(triangleIndex + 1, neighbors1[triangleIndex * 3 + 2]);
+}
+
+TEST(Mesh, GenerateNeighborsBenchmark)
+{
+	Pointer<ThreadPool> threadPool = ThreadPool::create();
+	int sizes[] = {70, 223, 707, 2236};
+	for (int i = 0; i < 4; ++i)
+	{
+		std::vector<int> vertexIndices;
+		createGrid(sizes[i], sizes[i], vertexIndices);
+		int numTriangles = int(vertexIndices.size() / 3);
+		std::vector<int> neighbors(numTriangles * 3);
+
+		int t1 = Timer::getMilliSeconds();
+		MeshUtility::generateNeighbors(numTriangles, vertexIndices.data(), neighbors.data());
+		int t2 = Timer::getMilliSeconds();
+		MeshUtility::generateNeighbors(numTriangles, vertexIndices.data(), neighbors.data(), threadPool);
+		int t3 = Timer::getMilliSeconds();
+
+		std::cout << numTriangles << " triangles: " << t2 - t1 << "ms, " << threadPool->getNumThreads()
+			<< " threads: " << t3 - t2 << "ms" << std::endl;
+	}
+}
+
+// create uv sphere
+static void createSphere(int numSegments, int numRings, std::vector<int>& vertexIndices,
+	std::vector<float3>& positions)
+{
+	positions.clear();
+	vertexIndices.clear();
+	for (int j = 0; j <= numRings; ++j)
+	{
+		float theta = float(j) / float(numRings) * 3.14159265f;
+		for (int i = 0; i <= numSegments; ++i)
+		{
+			float phi = float(i) / float(numSegments) * 2.0f * 3.14159265f;
+			positions += vector3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+		}
+	}
+	for (int j = 0; j < numRings; ++j)
+	{
+		for (int i = 0; i < numSegments; ++i)
+		{
+			int v = j * (numSegments + 1) + i;
+			vertexIndices += v, v + numSegments + 1, v + 1;
+			vertexIndices += v + 1, v + numSegments + 1, v + numSegments + 2;
+		}
+	}
+}
+
+// shuffle order of triangles
+static void shuffleTriangles(std::vector<int>& vertexIndices)
+{
+	int numTriangles = int(vertexIndices.size() / 3);
+	uint32_t seed = 12345;
+	for (int i = numTriangles - 1; i > 0; --i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		int j = int((uint64_t(seed) * uint64_t(i + 1)) >> 32);
+		for (int k = 0; k < 3; ++k)
+			std::swap(vertexIndices[i * 3 + k], vertexIndices[j * 3 + k]);
+	}
+}
+
+// check if two index arrays contain the same triangles
+static bool isTrianglePermutation(const std::vector<int>& a, const std::vector<int>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	size_t numTriangles = a.size() / 3;
+	std::vector<uint64_t> ta(numTriangles);
+	std::vector<uint64_t> tb(numTriangles);
+	for (size_t i = 0; i < numTriangles; ++i)
+	{
+		ta[i] = uint64_t(a[i * 3]) << 42 | uint64_t(a[i * 3 + 1]) << 21 | uint64_t(a[i * 3 + 2]);
+		tb[i] = uint64_t(b[i * 3]) << 42 | uint64_t(b[i * 3 + 1]) << 21 | uint64_t(b[i * 3 + 2]);
+	}
+	sort(ta);
+	sort(tb);
+	return ta == tb;
+}
+
+TEST(Mesh, OptimizeVertexCache)
+{
+	std::vector<int> vertexIndices;
+	std::vector<float3> positions;
+	createSphere(64, 32, vertexIndices, positions);
+	shuffleTriangles(vertexIndices);
+	int numVertices = int(positions.size());
+
+	// acmr of fifo cache: every vertex of the shuffled mesh misses, the cache size is clamped
+	EXPECT_EQ(3.0f, MeshUtility::calcAcmr(std::vector<int>(vertexIndices.begin(), vertexIndices.begin() + 3), 16));
+	EXPECT_GT(MeshUtility::calcAcmr(vertexIndices, 16), 2.0f);
+	EXPECT_EQ(MeshUtility::calcAcmr(vertexIndices, 32), MeshUtility::calcAcmr(vertexIndices, 100));
+
+	// optimize
+	std::vector<int> optimized;
+	MeshUtility::optimizeVertexCache(numVertices, vertexIndices, optimized);
+	EXPECT_TRUE(isTrianglePermutation(vertexIndices, optimized));
+	EXPECT_LT(MeshUtility::calcAcmr(optimized, 16), 0.8f);
+
+	// optimize in place
+	std::vector<int> inPlace = vertexIndices;
+	MeshUtility::optimizeVertexCache(numVertices, inPlace, inPlace);
+	EXPECT_EQ(optimized, inPlace);
+
+	// optimize in parallel chunks
+	createSphere(512, 256, vertexIndices, positions);
+	Pointer<ThreadPool> threadPool = ThreadPool::create(4);
+	MeshUtility::optimizeVertexCache(int(positions.size()), vertexIndices, optimized, threadPool);
+	EXPECT_TRUE(isTrianglePermutation(vertexIndices, optimized));
+	EXPECT_LT(MeshUtility::calcAcmr(optimized, 16), 0.8f);
+
+	// overdraw optimization only reorders clusters
+	std::vector<int> overdraw;
+	MeshUtility::optimizeOverdraw(optimized, positions, 16, 1.05f, overdraw);
+	EXPECT_TRUE(isTrianglePermutation(optimized, overdraw));
+	EXPECT_LT(MeshUtility::calcAcmr(overdraw, 16), MeshUtility::calcAcmr(optimized, 16) * 1.1f);
+}
+
+TEST(Mesh, OptimizeVertexCacheBenchmark)
+{
+	Pointer<ThreadPool> threadPool = ThreadPool::create();
+
+	// corpus of generated meshes
+	const char* names[] = {"grid", "shuffled grid", "sphere", "shuffled sphere", "large shuffled grid"};
+	for (int m = 0; m < 5; ++m)
+	{
+		std::vector<int> vertexIndices;
+		std::vector<float3> positions;
+		if (m == 0 || m == 1 || m == 4)
+		{
+			int size = m == 4 ? 1000 : 300;
+			createGrid(size, size, vertexIndices);
+			positions.resize((size + 1) * (size + 1));
+		}
+		else
+		{
+			createSphere(512, 256, vertexIndices, positions);
+		}
+		if (m == 1 || m == 3 || m == 4)
+			shuffleTriangles(vertexIndices);
+		int numVertices = int(positions.size());
+		int numTriangles = int(vertexIndices.size() / 3);
+
+		std::vector<int> optimized;
+		int t1 = Timer::getMilliSeconds();
+		MeshUtility::optimizeVertexCache(numVertices, vertexIndices, optimized);
+		int t2 = Timer::getMilliSeconds();
+		std::vector<int> optimizedParallel;
+		MeshUtility::optimizeVertexCache(numVertices, vertexIndices, optimizedParallel, threadPool);
+		int t3 = Timer::getMilliSeconds();
+
+		std::cout << names[m] << " (" << numTriangles << " triangles): acmr " << MeshUtility::calcAcmr(vertexIndices, 16)
+			<< " -> " << MeshUtility::calcAcmr(optimized, 16) << ", " << t2 - t1 << "ms ("
+			<< float(numTriangles) / float(std::max(t2 - t1, 1)) * 1e-3f << " MTris/s), " << threadPool->getNumThreads()
+			<< " threads: acmr " << MeshUtility::calcAcmr(optimizedParallel, 16) << ", " << t3 - t2 << "ms" << std::endl;
+	}
+}
+
 TEST(Mesh, GenerateTangentSpace)
 {
 	int positionIndices[6];
@@ -1,6 +1,7 @@
 #ifndef digi_Network_All_h
 #define digi_Network_All_h
 
+#include "EventLoop.h"
 #include "Socket.h"
 
 #endif
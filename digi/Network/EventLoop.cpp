@@ -0,0 +1,327 @@
+#include <algorithm>
+
+#include <digi/Utility/foreach.h>
+#include <digi/System/IOException.h>
+#include <digi/System/Log.h>
+
+#include "EventLoop.h"
+
+
+namespace digi {
+
+
+// SocketHandler
+
+SocketHandler::~SocketHandler()
+{
+}
+
+void SocketHandler::onAccept(EventLoop& loop, Pointer<Socket> socket)
+{
+}
+
+void SocketHandler::onRead(EventLoop& loop, Pointer<Socket> socket)
+{
+}
+
+void SocketHandler::onClose(EventLoop& loop, Pointer<Socket> socket)
+{
+}
+
+
+// EventLoop
+
+EventLoop::~EventLoop()
+{
+}
+
+void EventLoop::addServer(Pointer<Socket> server, Pointer<SocketHandler> handler)
+{
+	Connection& connection = this->connections[server];
+	connection.socket = server;
+	connection.handler = handler;
+	connection.server = true;
+	connection.queueBegin = 0;
+	try
+	{
+		this->addHandle(server, true);
+	}
+	catch (...)
+	{
+		this->connections.erase(server);
+		throw;
+	}
+}
+
+void EventLoop::add(Pointer<Socket> socket, Pointer<SocketHandler> handler)
+{
+	Connection& connection = this->connections[socket];
+	connection.socket = socket;
+	connection.handler = handler;
+	connection.server = false;
+	connection.queueBegin = 0;
+	try
+	{
+		this->addHandle(socket, false);
+	}
+	catch (...)
+	{
+		this->connections.erase(socket);
+		throw;
+	}
+}
+
+void EventLoop::setHandler(Pointer<Socket> socket, Pointer<SocketHandler> handler)
+{
+	this->getConnection(socket).handler = handler;
+}
+
+void EventLoop::remove(Pointer<Socket> socket)
+{
+	ConnectionMap::iterator it = this->connections.find(socket);
+	if (it == this->connections.end())
+		return;
+
+	this->removeHandle(socket);
+	this->connections.erase(it);
+	this->removedSockets.push_back(socket);
+}
+
+void EventLoop::close(Pointer<Socket> socket)
+{
+	ConnectionMap::iterator it = this->connections.find(socket);
+	if (it == this->connections.end())
+		return;
+	this->closeConnection(it, false);
+}
+
+void EventLoop::write(Pointer<Socket> socket, const void* data, size_t length)
+{
+	Connection& connection = this->getConnection(socket);
+	const uint8_t* d = (const uint8_t*)data;
+
+	// write directly if nothing is queued
+	if (connection.queue.empty())
+	{
+		while (length > 0)
+		{
+			size_t numWritten = socket->write(d, length);
+			if (numWritten == 0)
+				break;
+			d += numWritten;
+			length -= numWritten;
+		}
+		if (length == 0)
+			return;
+		this->setWriteInterest(socket, true);
+	}
+
+	// queue the rest
+	connection.queue.insert(connection.queue.end(), d, d + length);
+}
+
+size_t EventLoop::getNumQueuedBytes(Pointer<Socket> socket)
+{
+	Connection& connection = this->getConnection(socket);
+	return connection.queue.size() - connection.queueBegin;
+}
+
+int EventLoop::run(int timeout)
+{
+	// wait for new events unless a handler has thrown an exception before all events of the last call were handled
+	if (this->eventIndex >= this->events.size())
+	{
+		this->events.clear();
+		this->eventIndex = 0;
+		
+		// wake up in time to retry accepting
+		if (!this->acceptRetries.empty())
+			timeout = timeout < 0 ? int(ACCEPT_RETRY_TIME) : std::min(timeout, int(ACCEPT_RETRY_TIME));
+		this->wait(timeout, this->events);
+		
+		foreach (const Pointer<Socket>& server, this->acceptRetries)
+		{
+			Event event = {server, READABLE};
+			this->events.push_back(event);
+		}
+		this->acceptRetries.clear();
+	}
+
+	while (this->eventIndex < this->events.size())
+	{
+		// advance before calling a handler so that the event is not handled again if the handler throws
+		Event event = this->events[this->eventIndex];
+		++this->eventIndex;
+
+		// the socket may have been removed by a handler
+		ConnectionMap::iterator it = this->connections.find(event.socket);
+		if (it == this->connections.end())
+			continue;
+		Connection& connection = it->second;
+
+		if (connection.server)
+		{
+			this->acceptAll(connection);
+			continue;
+		}
+
+		Pointer<Socket> socket = connection.socket;
+		Pointer<SocketHandler> handler = connection.handler;
+
+		// send queued data
+		if ((event.flags & WRITABLE) != 0 && !this->flush(connection))
+		{
+			this->closeConnection(it, true);
+			continue;
+		}
+
+		// read available data, also if the connection was closed because data may be left
+		if ((event.flags & (READABLE | CLOSED)) != 0)
+		{
+			try
+			{
+				handler->onRead(*this, socket);
+			}
+			catch (IOException&)
+			{
+				it = this->connections.find(event.socket);
+				if (it != this->connections.end())
+					this->closeConnection(it, true);
+				continue;
+			}
+		}
+
+		if ((event.flags & CLOSED) != 0)
+		{
+			it = this->connections.find(event.socket);
+			if (it != this->connections.end())
+				this->closeConnection(it, true);
+		}
+	}
+	this->removedSockets.clear();
+
+	return int(this->events.size());
+}
+
+void EventLoop::acceptAll(Connection& connection)
+{
+	Pointer<Socket> server = connection.socket;
+	Pointer<SocketHandler> handler = connection.handler;
+	while (true)
+	{
+		Pointer<Socket> socket;
+		try
+		{
+			socket = this->acceptSocket(server);
+		}
+		catch (IOException& e)
+		{
+			// e.g. too many open files. the connections stay pending, therefore try again later because the server
+			// socket is not reported again until a new connection arrives
+			dWarning("EventLoop: accept failed: " << e.what());
+			this->acceptRetries.push_back(server);
+			return;
+		}
+		if (socket == null)
+			return;
+
+		try
+		{
+			this->add(socket, handler);
+		}
+		catch (IOException& e)
+		{
+			// the loop can't serve more sockets: reject the connection
+			dWarning("EventLoop: can't add accepted socket: " << e.what());
+			try
+			{
+				socket->close();
+			}
+			catch (IOException&)
+			{
+			}
+			continue;
+		}
+
+		try
+		{
+			handler->onAccept(*this, socket);
+		}
+		catch (...)
+		{
+			// accept the remaining connections on the next run()
+			this->acceptRetries.push_back(server);
+			throw;
+		}
+	}
+}
+
+EventLoop::Connection& EventLoop::getConnection(Socket* socket)
+{
+	ConnectionMap::iterator it = this->connections.find(socket);
+	if (it == this->connections.end())
+		throw IOException(socket, IOException::INVALID_HANDLE);
+	return it->second;
+}
+
+bool EventLoop::flush(Connection& connection)
+{
+	std::vector<uint8_t>& queue = connection.queue;
+	try
+	{
+		while (connection.queueBegin < queue.size())
+		{
+			size_t numWritten = connection.socket->write(&queue[connection.queueBegin],
+				queue.size() - connection.queueBegin);
+			if (numWritten == 0)
+				break;
+			connection.queueBegin += numWritten;
+		}
+	}
+	catch (IOException&)
+	{
+		return false;
+	}
+
+	if (connection.queueBegin == queue.size())
+	{
+		// all data was sent
+		queue.clear();
+		connection.queueBegin = 0;
+		this->setWriteInterest(connection.socket, false);
+	}
+	else if (connection.queueBegin >= queue.size() / 2)
+	{
+		// remove the sent data when it is more than half of the queue
+		queue.erase(queue.begin(), queue.begin() + connection.queueBegin);
+		connection.queueBegin = 0;
+	}
+	return true;
+}
+
+void EventLoop::closeConnection(ConnectionMap::iterator it, bool notify)
+{
+	Pointer<Socket> socket = it->second.socket;
+	Pointer<SocketHandler> handler = it->second.handler;
+	this->removeHandle(socket);
+	this->connections.erase(it);
+	this->removedSockets.push_back(socket);
+
+	if (notify)
+		handler->onClose(*this, socket);
+
+	// the handler may have closed the socket already
+	if (socket->isOpen())
+	{
+		try
+		{
+			socket->close();
+		}
+		catch (IOException&)
+		{
+		}
+	}
+}
+
+
+} // namespace digi
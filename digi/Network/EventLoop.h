@@ -0,0 +1,170 @@
+#ifndef digi_Network_EventLoop_h
+#define digi_Network_EventLoop_h
+
+#include <map>
+#include <vector>
+
+#include <digi/Utility/Object.h>
+
+#include "Socket.h"
+
+
+namespace digi {
+
+/// @addtogroup Network
+/// @{
+
+class EventLoop;
+
+
+/// receives the events of the sockets that are served by an EventLoop. all methods are called on the thread that
+/// calls EventLoop::run()
+class SocketHandler : public Object
+{
+public:
+
+	virtual ~SocketHandler();
+
+	/// a new connection was accepted on a server socket. the new socket is non-blocking and is already served by the
+	/// loop with the handler of the server socket, use EventLoop::setHandler() to change it
+	virtual void onAccept(EventLoop& loop, Pointer<Socket> socket);
+
+	/// data is available for reading. events are edge triggered, therefore read until read() returns zero.
+	/// an IOException thrown here closes the connection. other exceptions are passed to the caller of
+	/// EventLoop::run(), the events of the other sockets are then handled by the next call of run()
+	virtual void onRead(EventLoop& loop, Pointer<Socket> socket);
+
+	/// the connection was closed by the remote host or because of an error. the socket is already removed from the
+	/// loop and gets closed after this call
+	virtual void onClose(EventLoop& loop, Pointer<Socket> socket);
+};
+
+
+/**
+	event loop that serves many non-blocking sockets from one thread. readiness is reported edge triggered, i.e. a
+	handler is only called again for a socket after new data has arrived. data that can't be written immediately is
+	queued and sent when the socket becomes writable again.
+	uses epoll on linux, poll on other posix systems and select on windows
+*/
+class EventLoop : public Object
+{
+public:
+
+	/// create an event loop
+	static Pointer<EventLoop> create();
+
+	virtual ~EventLoop();
+
+	/// add a listening server socket. incoming connections are accepted and added to the loop with the given handler
+	void addServer(Pointer<Socket> server, Pointer<SocketHandler> handler);
+
+	/// add a connected socket. the socket is set to non-blocking mode
+	void add(Pointer<Socket> socket, Pointer<SocketHandler> handler);
+
+	/// set the handler of a socket
+	void setHandler(Pointer<Socket> socket, Pointer<SocketHandler> handler);
+
+	/// remove a socket from the loop without closing it. queued data that was not sent yet is discarded
+	void remove(Pointer<Socket> socket);
+
+	/// remove a socket from the loop and close it. onClose() is not called
+	void close(Pointer<Socket> socket);
+
+	/// write data to a socket of the loop. the data that can't be written immediately is queued. throws IOException if
+	/// the connection is broken
+	void write(Pointer<Socket> socket, const void* data, size_t length);
+
+	/// get number of bytes that are queued for writing
+	size_t getNumQueuedBytes(Pointer<Socket> socket);
+
+	/// get number of sockets in the loop including server sockets
+	size_t getNumSockets() {return this->connections.size();}
+
+	/// wait up to timeout milliseconds (-1 for infinite) for events and call the handlers. returns the number of
+	/// sockets that had events. if a handler has thrown an exception, the events that were not handled yet are
+	/// handled first without waiting
+	int run(int timeout);
+
+protected:
+
+	enum Flags
+	{
+		READABLE = 1,
+		WRITABLE = 2,
+		CLOSED = 4
+	};
+
+	struct Event
+	{
+		Socket* socket;
+		int flags;
+	};
+
+	struct Connection
+	{
+		Pointer<Socket> socket;
+		Pointer<SocketHandler> handler;
+		bool server;
+
+		// data that waits for sending
+		std::vector<uint8_t> queue;
+		size_t queueBegin;
+	};
+	typedef std::map<Socket*, Connection> ConnectionMap;
+
+
+	// time in milliseconds after which accepting is tried again when it failed, e.g. because of too many open files
+	enum
+	{
+		ACCEPT_RETRY_TIME = 10
+	};
+
+
+	EventLoop() : eventIndex(0) {}
+
+	// register socket handle with the poller and set it to non-blocking mode
+	virtual void addHandle(Socket* socket, bool server) = 0;
+
+	// unregister socket handle
+	virtual void removeHandle(Socket* socket) = 0;
+
+	// set if the poller has to report writability. needed by level triggered pollers only
+	virtual void setWriteInterest(Socket* socket, bool enable) = 0;
+
+	// wait for events
+	virtual void wait(int timeout, std::vector<Event>& events) = 0;
+
+	// accept a pending connection. returns null if there is none
+	virtual Pointer<Socket> acceptSocket(Socket* server) = 0;
+
+
+	Connection& getConnection(Socket* socket);
+
+	// write queued data. returns false if the connection is broken
+	bool flush(Connection& connection);
+
+	// accept all pending connections of a server socket
+	void acceptAll(Connection& connection);
+
+	// remove connection and close its socket
+	void closeConnection(ConnectionMap::iterator it, bool notify);
+
+
+	ConnectionMap connections;
+
+	// events of the current run() and index of the next event to handle
+	std::vector<Event> events;
+	size_t eventIndex;
+
+	// server sockets where accepting failed and has to be tried again
+	std::vector<Pointer<Socket> > acceptRetries;
+
+	// sockets that were removed while handling events, kept alive until all events are handled
+	std::vector<Pointer<Socket> > removedSockets;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -1,13 +1,20 @@
 #include <digi/System/IOException.h>
 #include "../Socket.h"
+#include "../EventLoop.h"
 
 #include <errno.h>
 #include <netdb.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#ifdef __linux__
+	#include <sys/epoll.h>
+#else
+	#include <poll.h>
+#endif
 
 
 #define CHECK(condition) \
@@ -21,6 +28,11 @@
 	#define MSG_NOSIGNAL 0
 #endif
 
+// peer has shut down sending (linux 2.6.17)
+#if defined(__linux__) && !defined(EPOLLRDHUP)
+	#define EPOLLRDHUP 0x2000
+#endif
+
 namespace digi {
 
 typedef int SOCKET;
@@ -222,6 +234,250 @@ Pointer<Socket> Socket::create(Protocol protocol, int mode)
 	return s;
 }
 
+
+
+// EventLoop
+
+// set socket to non-blocking mode
+static void setNonBlocking(POSIXSocket* socket)
+{
+	u_long nonblocking = 1;
+	if (ioctl(socket->socket, FIONBIO, &nonblocking) == SOCKET_ERROR)
+		Socket::throwException(socket);
+}
+
+// accept a connection on a non-blocking server socket. returns null if no connection is pending
+static Pointer<Socket> acceptNonBlocking(POSIXSocket* server)
+{
+	while (true)
+	{
+		SOCKET socket = ::accept(server->socket, NULL, NULL);
+		if (socket != INVALID_SOCKET)
+		{
+			// prevent SIGPIPE (apple)
+			#ifdef SO_NOSIGPIPE
+				int set = 1;
+				setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(int));
+			#endif
+			return new POSIXSocket(socket);
+		}
+		
+		// no more pending connections
+		if (errno == EWOULDBLOCK || errno == EAGAIN)
+			return null;
+
+		// connection was reset before it was accepted: try next
+		if (errno != ECONNABORTED && errno != EINTR)
+			Socket::throwException(server);
+	}
+}
+
+#ifdef __linux__
+
+// linux implementation of EventLoop using edge triggered epoll
+class EPollEventLoop : public EventLoop
+{
+public:
+
+	EPollEventLoop(int epoll)
+		: epoll(epoll)
+	{
+	}
+
+	virtual ~EPollEventLoop()
+	{
+		::close(this->epoll);
+	}
+
+	virtual void addHandle(Socket* socket, bool server)
+	{
+		POSIXSocket* s = static_cast<POSIXSocket*>(socket);
+		setNonBlocking(s);
+
+		// always register for writability. because of edge triggering it is only reported after the send buffer was full
+		struct epoll_event event;
+		event.events = server ? EPOLLIN | EPOLLET : EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = socket;
+		if (epoll_ctl(this->epoll, EPOLL_CTL_ADD, s->socket, &event) == -1)
+			Socket::throwException(socket);
+	}
+
+	virtual void removeHandle(Socket* socket)
+	{
+		// a closed handle was already removed by the system
+		POSIXSocket* s = static_cast<POSIXSocket*>(socket);
+		if (s->socket != INVALID_SOCKET)
+		{
+			struct epoll_event event;
+			epoll_ctl(this->epoll, EPOLL_CTL_DEL, s->socket, &event);
+		}
+	}
+
+	virtual void setWriteInterest(Socket* socket, bool enable)
+	{
+	}
+
+	virtual void wait(int timeout, std::vector<Event>& events)
+	{
+		struct epoll_event buffer[256];
+		int numEvents = epoll_wait(this->epoll, buffer, 256, timeout);
+		if (numEvents == -1)
+		{
+			if (errno == EINTR)
+				return;
+			throw IOException(null, IOException::IO_ERROR);
+		}
+
+		for (int i = 0; i < numEvents; ++i)
+		{
+			uint32_t e = buffer[i].events;
+			Event event;
+			event.socket = (Socket*)buffer[i].data.ptr;
+			event.flags = ((e & EPOLLIN) != 0 ? READABLE : 0)
+				| ((e & EPOLLOUT) != 0 ? WRITABLE : 0)
+				| ((e & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0 ? CLOSED : 0);
+			events.push_back(event);
+		}
+	}
+
+	virtual Pointer<Socket> acceptSocket(Socket* server)
+	{
+		return acceptNonBlocking(static_cast<POSIXSocket*>(server));
+	}
+
+
+	int epoll;
+};
+
+Pointer<EventLoop> EventLoop::create()
+{
+	int epoll = epoll_create(1024);
+	if (epoll == -1)
+		throw IOException(null, IOException::IO_ERROR);
+	return new EPollEventLoop(epoll);
+}
+
+#else
+
+// posix implementation of EventLoop using poll. poll is level triggered, therefore a handler that does not read all
+// data is called again
+class PollEventLoop : public EventLoop
+{
+public:
+
+	virtual ~PollEventLoop()
+	{
+	}
+
+	virtual void addHandle(Socket* socket, bool server)
+	{
+		POSIXSocket* s = static_cast<POSIXSocket*>(socket);
+		setNonBlocking(s);
+
+		struct pollfd p;
+		p.fd = s->socket;
+		p.events = POLLIN;
+		p.revents = 0;
+		this->indices[socket] = this->fds.size();
+		this->fds.push_back(p);
+		Entry entry = {socket, server};
+		this->entries.push_back(entry);
+	}
+
+	virtual void removeHandle(Socket* socket)
+	{
+		std::map<Socket*, size_t>::iterator it = this->indices.find(socket);
+		if (it == this->indices.end())
+			return;
+
+		// move last entry into the gap
+		size_t index = it->second;
+		this->indices.erase(it);
+		size_t last = this->fds.size() - 1;
+		if (index != last)
+		{
+			this->fds[index] = this->fds[last];
+			this->entries[index] = this->entries[last];
+			this->indices[this->entries[index].socket] = index;
+		}
+		this->fds.pop_back();
+		this->entries.pop_back();
+	}
+
+	virtual void setWriteInterest(Socket* socket, bool enable)
+	{
+		std::map<Socket*, size_t>::iterator it = this->indices.find(socket);
+		if (it != this->indices.end())
+			this->fds[it->second].events = enable ? POLLIN | POLLOUT : POLLIN;
+	}
+
+	virtual void wait(int timeout, std::vector<Event>& events)
+	{
+		int numEvents = ::poll(this->fds.data(), nfds_t(this->fds.size()), timeout);
+		if (numEvents == -1)
+		{
+			if (errno == EINTR)
+				return;
+			throw IOException(null, IOException::IO_ERROR);
+		}
+
+		for (size_t i = 0; i < this->fds.size() && numEvents > 0; ++i)
+		{
+			int e = this->fds[i].revents;
+			if (e == 0)
+				continue;
+			--numEvents;
+
+			Event event;
+			event.socket = this->entries[i].socket;
+			event.flags = ((e & POLLOUT) != 0 ? WRITABLE : 0)
+				| ((e & (POLLHUP | POLLERR)) != 0 ? CLOSED : 0);
+			if ((e & POLLIN) != 0)
+			{
+				if (this->entries[i].server)
+				{
+					event.flags |= READABLE;
+				}
+				else
+				{
+					// readable without data means that the remote host has shut down sending
+					char c;
+					ssize_t numRead = recv(this->fds[i].fd, &c, 1, MSG_PEEK);
+					if (numRead > 0)
+						event.flags |= READABLE;
+					else if (numRead == 0 || (errno != EWOULDBLOCK && errno != EAGAIN))
+						event.flags |= CLOSED;
+				}
+			}
+			events.push_back(event);
+		}
+	}
+
+	virtual Pointer<Socket> acceptSocket(Socket* server)
+	{
+		return acceptNonBlocking(static_cast<POSIXSocket*>(server));
+	}
+
+
+	struct Entry
+	{
+		Socket* socket;
+		bool server;
+	};
+
+	std::vector<struct pollfd> fds;
+	std::vector<Entry> entries;
+	std::map<Socket*, size_t> indices;
+};
+
+Pointer<EventLoop> EventLoop::create()
+{
+	return new PollEventLoop();
+}
+
+#endif
+
+
 void Socket::throwException(Pointer<Socket> socket)
 {
 	int e = errno;
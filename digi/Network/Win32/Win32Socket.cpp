@@ -1,5 +1,9 @@
+// raise the number of sockets that select() can handle, the default is 64. has to be defined before winsock is included
+#define FD_SETSIZE 4096
+
 #include <digi/System/IOException.h>
 #include "../Socket.h"
+#include "../EventLoop.h"
 
 #include <windows.h>
 
@@ -204,6 +208,164 @@ Pointer<Socket> Socket::create(Protocol protocol, int mode)
 	return s;
 }
 
+
+
+// EventLoop
+
+// set socket to non-blocking mode
+static void setNonBlocking(Win32Socket* socket)
+{
+	u_long nonblocking = 1;
+	if (ioctlsocket(socket->socket, FIONBIO, &nonblocking) == SOCKET_ERROR)
+		Socket::throwException(socket);
+}
+
+// windows implementation of EventLoop using select. select is level triggered, therefore a handler that does not
+// read all data is called again. the number of sockets is limited to FD_SETSIZE
+class Win32EventLoop : public EventLoop
+{
+public:
+
+	virtual ~Win32EventLoop()
+	{
+	}
+
+	virtual void addHandle(Socket* socket, bool server)
+	{
+		if (this->entries.size() >= FD_SETSIZE)
+			throw IOException(socket, IOException::IO_ERROR);
+
+		Win32Socket* s = static_cast<Win32Socket*>(socket);
+		setNonBlocking(s);
+
+		Entry entry = {s, server, false};
+		this->indices[socket] = this->entries.size();
+		this->entries.push_back(entry);
+	}
+
+	virtual void removeHandle(Socket* socket)
+	{
+		std::map<Socket*, size_t>::iterator it = this->indices.find(socket);
+		if (it == this->indices.end())
+			return;
+
+		// move last entry into the gap
+		size_t index = it->second;
+		this->indices.erase(it);
+		size_t last = this->entries.size() - 1;
+		if (index != last)
+		{
+			this->entries[index] = this->entries[last];
+			this->indices[this->entries[index].socket] = index;
+		}
+		this->entries.pop_back();
+	}
+
+	virtual void setWriteInterest(Socket* socket, bool enable)
+	{
+		std::map<Socket*, size_t>::iterator it = this->indices.find(socket);
+		if (it != this->indices.end())
+			this->entries[it->second].write = enable;
+	}
+
+	virtual void wait(int timeout, std::vector<Event>& events)
+	{
+		// select fails without sockets
+		if (this->entries.empty())
+		{
+			Sleep(timeout < 0 ? INFINITE : DWORD(timeout));
+			return;
+		}
+
+		fd_set readSet;
+		fd_set writeSet;
+		FD_ZERO(&readSet);
+		FD_ZERO(&writeSet);
+		for (size_t i = 0; i < this->entries.size(); ++i)
+		{
+			const Entry& entry = this->entries[i];
+			FD_SET(entry.socket->socket, &readSet);
+			if (entry.write)
+				FD_SET(entry.socket->socket, &writeSet);
+		}
+
+		timeval t;
+		t.tv_sec = timeout / 1000;
+		t.tv_usec = (timeout % 1000) * 1000;
+		int numEvents = select(0, &readSet, &writeSet, NULL, timeout < 0 ? NULL : &t);
+		if (numEvents == SOCKET_ERROR)
+			throw IOException(null, IOException::IO_ERROR);
+
+		for (size_t i = 0; i < this->entries.size() && numEvents > 0; ++i)
+		{
+			const Entry& entry = this->entries[i];
+			SOCKET socket = entry.socket->socket;
+			Event event;
+			event.socket = entry.socket;
+			event.flags = FD_ISSET(socket, &writeSet) ? WRITABLE : 0;
+			if (FD_ISSET(socket, &readSet))
+			{
+				if (entry.server)
+				{
+					event.flags |= READABLE;
+				}
+				else
+				{
+					// readable without data means that the remote host has shut down sending
+					char c;
+					int numRead = recv(socket, &c, 1, MSG_PEEK);
+					if (numRead > 0)
+						event.flags |= READABLE;
+					else if (numRead == 0 || WSAGetLastError() != WSAEWOULDBLOCK)
+						event.flags |= CLOSED;
+				}
+			}
+			if (event.flags != 0)
+			{
+				--numEvents;
+				events.push_back(event);
+			}
+		}
+	}
+
+	virtual Pointer<Socket> acceptSocket(Socket* server)
+	{
+		Win32Socket* s = static_cast<Win32Socket*>(server);
+		while (true)
+		{
+			SOCKET socket = ::accept(s->socket, NULL, NULL);
+			if (socket != INVALID_SOCKET)
+				return new Win32Socket(socket);
+
+			// no more pending connections
+			int e = WSAGetLastError();
+			if (e == WSAEWOULDBLOCK)
+				return null;
+
+			// connection was reset before it was accepted: try next
+			if (e != WSAECONNRESET && e != WSAEINTR)
+				Socket::throwException(server);
+		}
+	}
+
+
+	struct Entry
+	{
+		Win32Socket* socket;
+		bool server;
+		bool write;
+	};
+
+	std::vector<Entry> entries;
+	std::map<Socket*, size_t> indices;
+};
+
+Pointer<EventLoop> EventLoop::create()
+{
+	return new Win32EventLoop();
+}
+
+
 void Socket::throwException(Pointer<Socket> socket)
 {
 	DWORD e = WSAGetLastError();
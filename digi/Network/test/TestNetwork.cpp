@@ -1,8 +1,13 @@
+#include <iostream>
+#include <stdexcept>
+
 #include <gtest/gtest.h>
 
 #include <digi/Utility/ArrayUtility.h>
 #include <digi/Utility/StringUtility.h>
 #include <digi/System/IOException.h>
+#include <digi/System/Timer.h>
+#include <digi/Network/EventLoop.h>
 #include <digi/Network/Socket.h>
 
 #include "InitLibraries.h"
@@ -148,6 +153,299 @@ TEST(Network, SocketUDPBroadcast)
 	}		
 }
 
+// echoes all received data
+class EchoHandler : public SocketHandler
+{
+public:
+
+	EchoHandler()
+		: numAccepted(), numClosed()
+	{
+	}
+
+	virtual void onAccept(EventLoop& loop, Pointer<Socket> socket)
+	{
+		++this->numAccepted;
+	}
+
+	virtual void onRead(EventLoop& loop, Pointer<Socket> socket)
+	{
+		char buffer[4096];
+		size_t numRead;
+		while ((numRead = socket->read(buffer, sizeof(buffer))) > 0)
+			loop.write(socket, buffer, numRead);
+	}
+
+	virtual void onClose(EventLoop& loop, Pointer<Socket> socket)
+	{
+		++this->numClosed;
+	}
+
+	int numAccepted;
+	int numClosed;
+};
+
+// records all received data
+class RecordHandler : public SocketHandler
+{
+public:
+
+	RecordHandler()
+		: numClosed()
+	{
+	}
+
+	virtual void onRead(EventLoop& loop, Pointer<Socket> socket)
+	{
+		char buffer[4096];
+		size_t numRead;
+		while ((numRead = socket->read(buffer, sizeof(buffer))) > 0)
+			this->data.append(buffer, numRead);
+	}
+
+	virtual void onClose(EventLoop& loop, Pointer<Socket> socket)
+	{
+		++this->numClosed;
+	}
+
+	std::string data;
+	int numClosed;
+};
+
+TEST(Network, EventLoop)
+{
+	try
+	{
+		Pointer<EventLoop> loop = EventLoop::create();
+		Pointer<EchoHandler> echo = new EchoHandler();
+		Pointer<RecordHandler> record = new RecordHandler();
+
+		Pointer<Socket> server = Socket::create(Socket::IP);
+		server->bind(8083);
+		server->listen(5);
+		loop->addServer(server, echo);
+
+		Pointer<Socket> client = Socket::create(Socket::IP);
+		client->connect("127.0.0.1", 8083);
+		loop->add(client, record);
+
+		// small message
+		loop->write(client, "foo", 3);
+		int startTime = Timer::getMilliSeconds();
+		while (record->data.size() < 3 && Timer::getMilliSeconds() - startTime < 5000)
+			loop->run(100);
+		EXPECT_EQ(1, echo->numAccepted);
+		EXPECT_EQ(3, loop->getNumSockets());
+		EXPECT_EQ("foo", record->data);
+
+		// large message that exceeds the socket buffers and therefore gets queued
+		std::string message;
+		for (int i = 0; i < 4 * 1024 * 1024; ++i)
+			message += char('a' + i % 26);
+		record->data.clear();
+		loop->write(client, message.data(), message.size());
+		EXPECT_TRUE(loop->getNumQueuedBytes(client) > 0);
+		startTime = Timer::getMilliSeconds();
+		while (record->data.size() < message.size() && Timer::getMilliSeconds() - startTime < 5000)
+			loop->run(100);
+		EXPECT_EQ(0, loop->getNumQueuedBytes(client));
+		EXPECT_TRUE(record->data == message);
+
+		// shut down client send which must close the connection at the server and then at the client
+		client->shutdown(Socket::SEND);
+		startTime = Timer::getMilliSeconds();
+		while (record->numClosed == 0 && Timer::getMilliSeconds() - startTime < 5000)
+			loop->run(100);
+		EXPECT_EQ(1, echo->numClosed);
+		EXPECT_EQ(1, record->numClosed);
+		EXPECT_EQ(1, loop->getNumSockets());
+		EXPECT_FALSE(client->isOpen());
+
+		loop->close(server);
+		EXPECT_EQ(0, loop->getNumSockets());
+		EXPECT_FALSE(server->isOpen());
+	}
+	catch (IOException& e)
+	{
+		EXPECT_TRUE(false) << e.what();
+	}
+}
+
+// records all received data and throws after each read
+class ThrowHandler : public RecordHandler
+{
+public:
+
+	ThrowHandler()
+		: numAccepted()
+	{
+	}
+
+	virtual void onAccept(EventLoop& loop, Pointer<Socket> socket)
+	{
+		++this->numAccepted;
+	}
+
+	virtual void onRead(EventLoop& loop, Pointer<Socket> socket)
+	{
+		RecordHandler::onRead(loop, socket);
+		throw std::runtime_error("ThrowHandler");
+	}
+
+	int numAccepted;
+};
+
+TEST(Network, EventLoopHandlerException)
+{
+	try
+	{
+		Pointer<EventLoop> loop = EventLoop::create();
+		Pointer<ThrowHandler> handler = new ThrowHandler();
+
+		Pointer<Socket> server = Socket::create(Socket::IP);
+		server->bind(8085);
+		server->listen(5);
+		loop->addServer(server, handler);
+
+		Pointer<Socket> client1 = Socket::create(Socket::IP);
+		client1->connect("127.0.0.1", 8085);
+		Pointer<Socket> client2 = Socket::create(Socket::IP);
+		client2->connect("127.0.0.1", 8085);
+		int startTime = Timer::getMilliSeconds();
+		while (handler->numAccepted < 2 && Timer::getMilliSeconds() - startTime < 5000)
+			loop->run(100);
+		ASSERT_EQ(2, handler->numAccepted);
+
+		// both connections have data in the same run(). the exception of the first read is passed to the caller
+		client1->write("a", 1);
+		client2->write("b", 1);
+		Timer::milliSleep(100);
+		EXPECT_THROW(loop->run(100), std::runtime_error);
+		EXPECT_EQ(1, int(handler->data.size()));
+
+		// the second connection is handled by the next run() without new data
+		EXPECT_THROW(loop->run(0), std::runtime_error);
+		EXPECT_EQ(2, int(handler->data.size()));
+
+		client1->close();
+		client2->close();
+		loop->close(server);
+	}
+	catch (IOException& e)
+	{
+		EXPECT_TRUE(false) << e.what();
+	}
+}
+
+// sends a message and the next one when the echo was received
+class PingHandler : public SocketHandler
+{
+public:
+
+	enum
+	{
+		MESSAGE_SIZE = 64
+	};
+
+	PingHandler(int numMessages, int& numFinished)
+		: numMessages(numMessages), numReceived(), numFinished(numFinished)
+	{
+		for (int i = 0; i < MESSAGE_SIZE; ++i)
+			this->message[i] = char(i);
+	}
+
+	virtual void onRead(EventLoop& loop, Pointer<Socket> socket)
+	{
+		char buffer[4096];
+		size_t numRead;
+		while ((numRead = socket->read(buffer, sizeof(buffer))) > 0)
+		{
+			this->numReceived += numRead;
+			while (this->numReceived >= MESSAGE_SIZE)
+			{
+				this->numReceived -= MESSAGE_SIZE;
+				if (--this->numMessages > 0)
+					this->send(loop, socket);
+				else
+					++this->numFinished;
+			}
+		}
+	}
+
+	void send(EventLoop& loop, Pointer<Socket> socket)
+	{
+		loop.write(socket, this->message, MESSAGE_SIZE);
+	}
+
+	int numMessages;
+	size_t numReceived;
+	int& numFinished;
+	char message[MESSAGE_SIZE];
+};
+
+TEST(Network, EventLoopBenchmark)
+{
+	// loopback load test: many clients send messages to an echo server, client and server run in the same loop
+	const int numClients = 1000;
+	const int numMessages = 100;
+	try
+	{
+		Pointer<EventLoop> loop = EventLoop::create();
+		Pointer<EchoHandler> echo = new EchoHandler();
+
+		Pointer<Socket> server = Socket::create(Socket::IP);
+		server->bind(8084);
+		server->listen(128);
+		loop->addServer(server, echo);
+
+		// connect clients
+		int numFinished = 0;
+		std::vector<Pointer<Socket> > clients;
+		std::vector<Pointer<PingHandler> > handlers;
+		for (int i = 0; i < numClients; ++i)
+		{
+			Pointer<Socket> client = Socket::create(Socket::IP);
+			client->connect("127.0.0.1", 8084);
+			Pointer<PingHandler> handler = new PingHandler(numMessages, numFinished);
+			loop->add(client, handler);
+			clients.push_back(client);
+			handlers.push_back(handler);
+
+			// accept
+			loop->run(0);
+		}
+		int startTime = Timer::getMilliSeconds();
+		while (echo->numAccepted < numClients && Timer::getMilliSeconds() - startTime < 60000)
+			loop->run(100);
+		ASSERT_EQ(numClients, echo->numAccepted);
+		EXPECT_EQ(2 * numClients + 1, loop->getNumSockets());
+
+		// send first message of each client and run until all echos were received
+		startTime = Timer::getMilliSeconds();
+		for (int i = 0; i < numClients; ++i)
+			handlers[i]->send(*loop, clients[i]);
+		while (numFinished < numClients && Timer::getMilliSeconds() - startTime < 60000)
+			loop->run(100);
+		int duration = std::max(Timer::getMilliSeconds() - startTime, 1);
+		EXPECT_EQ(numClients, numFinished);
+
+		int numRoundTrips = numClients * numMessages;
+		std::cout << numClients << " clients, " << numRoundTrips << " round trips in " << duration << "ms ("
+			<< int64_t(numRoundTrips) * 1000 / duration << " messages/s)" << std::endl;
+
+		for (int i = 0; i < numClients; ++i)
+			loop->close(clients[i]);
+		while (echo->numClosed < numClients && Timer::getMilliSeconds() - startTime < 60000)
+			loop->run(100);
+		EXPECT_EQ(1, loop->getNumSockets());
+		loop->close(server);
+	}
+	catch (IOException& e)
+	{
+		EXPECT_TRUE(false) << e.what();
+	}
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -64,14 +64,10 @@ Pointer<EngineFile> MCCache::load(const fs::path& path)
 	fs::path cachePath = path.parent_path() / (path.stem() + s.str());
 	
 	// check if .digi is newer than .dmc cache file or .dmc does not exist
-	bool isCreated = false;
 	boost::system::error_code errorCode;
 	if (last_write_time(path) > last_write_time(cachePath, errorCode))
 	{
-		// recreate cache file
-		isCreated = true;
-		
-		// read scene
+		// recreate cache file: read scene
 		ObjectReader r(path);
 		if (r.read<uint32_t>() != 0x49474944) // "DIGI"
 			throw DataException(r.getDevice(), DataException::FORMAT_ERROR);
@@ -80,10 +76,10 @@ Pointer<EngineFile> MCCache::load(const fs::path& path)
 		r.close();
 		
 		// first write into temp file
-		cachePath += ".tmp";
+		fs::path tempPath = cachePath + ".tmp";
 
 		// create output file
-		ObjectWriter ow(cachePath);
+		ObjectWriter ow(tempPath);
 
 		// scene options
 		SceneOptions sceneOptions;
@@ -117,21 +113,19 @@ Pointer<EngineFile> MCCache::load(const fs::path& path)
 		writeForMC(sceneFile, ow, sceneOptions, mcTarget);
 		
 		ow.close();
+		
+		// convert temp file into memory mapped layout in a second temp file
+		fs::path mappedPath = cachePath + ".mapped.tmp";
+		writeMappedMC(File::open(tempPath, File::READ), File::create(mappedPath));
+		fs::remove(tempPath);
+		
+		// rename so that an interrupted conversion does not leave a truncated cache file
+		fs::rename(mappedPath, cachePath);
 	} 
 	
-	// load cached machine code file (load from .tmp if it has just been created)
-	Pointer<File> file = File::open(cachePath, File::READ);
-	Pointer<EngineFile> engineFile = new MCFile(file);
-	file->close();
-	
-	if (isCreated)
-	{
-		// rename temp file
-		fs::path cachePath2 = cachePath.parent_path() / cachePath.stem();
-		fs::rename(cachePath, cachePath2);
-	}	
-	
-	return engineFile;
+	// load cached machine code file (mapped into memory, cache files of older versions are read using MCFile)
+	MCLoader loader;
+	return loader.load(cachePath);
 }
 
 } // namespace digi
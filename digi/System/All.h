@@ -8,8 +8,11 @@
 #include "IODevice.h"
 #include "IOException.h"
 #include "Log.h"
+#include "MappedFile.h"
 #include "MemoryDevices.h"
 #include "SerialPort.h"
+#include "Thread.h"
+#include "ThreadPool.h"
 #include "Timer.h"
 
 #endif
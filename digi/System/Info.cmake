@@ -7,6 +7,8 @@ if(WIN32)
 elseif(APPLE)
 	find_library(CORESERVICES_LIBRARY CoreServices)
 	set(System_LIBRARIES ${CORESERVICES_LIBRARY})
+else()
+	set(System_LIBRARIES pthread)
 endif()
 
 if(NO_BOOST_FILESYSTEM)
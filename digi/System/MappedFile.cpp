@@ -0,0 +1,10 @@
+#include "MappedFile.h"
+
+
+namespace digi {
+
+MappedFile::~MappedFile()
+{
+}
+
+} // namespace digi
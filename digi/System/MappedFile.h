@@ -0,0 +1,55 @@
+/*
+	read-only file that is mapped into memory using the native operating system api.
+	the mapping is private (copy on write), i.e. the data may be modified in memory without changing the file.
+	pages that are not modified are shared with other processes that map the same file.
+*/
+
+#ifndef digi_System_MappedFile_h
+#define digi_System_MappedFile_h
+
+#include <digi/Utility/Object.h>
+
+#include "FileSystem.h"
+
+
+namespace digi {
+
+/// @addtogroup System
+/// @{
+
+class MappedFile : public Object
+{
+public:
+
+	/// map a file into memory. throws IOException on error
+	static Pointer<MappedFile> open(const fs::path& path);
+
+	virtual ~MappedFile();
+
+	/// get path of mapped file
+	const fs::path& getPath() {return this->path;}
+
+	/// get mapped data (NULL for empty file)
+	uint8_t* data() {return this->d;}
+	
+	/// get size of mapped data
+	size_t size() {return this->s;}
+
+	uint8_t* begin() {return this->d;}
+	uint8_t* end() {return this->d + this->s;}
+
+protected:
+
+	MappedFile(const fs::path& path)
+		: path(path), d(NULL), s(0) {}
+
+	fs::path path;
+	uint8_t* d;
+	size_t s;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
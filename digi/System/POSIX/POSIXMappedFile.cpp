@@ -0,0 +1,67 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../File.h"
+#include "../MappedFile.h"
+
+
+namespace digi {
+
+// posix implementation of MappedFile
+class POSIXMappedFile : public MappedFile
+{
+public:
+
+	POSIXMappedFile(const fs::path& path)
+		: MappedFile(path)
+	{
+	}
+
+	virtual ~POSIXMappedFile()
+	{
+		if (this->d != NULL)
+			munmap(this->d, this->s);
+	}
+	
+	friend class MappedFile;
+};
+
+
+Pointer<MappedFile> MappedFile::open(const fs::path& path)
+{
+	int handle = ::open(path.c_str(), O_RDONLY);
+	if (handle == -1)
+		File::throwException(File::getDummyFile(path));
+
+	Pointer<POSIXMappedFile> file = new POSIXMappedFile(path);
+	struct stat st;
+	if (fstat(handle, &st) == -1)
+	{
+		int e = errno;
+		::close(handle);
+		errno = e;
+		File::throwException(File::getDummyFile(path));
+	}
+	if (st.st_size > 0)
+	{
+		// private mapping with write permission to allow copy on write
+		void* d = mmap(NULL, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, handle, 0);
+		if (d == MAP_FAILED)
+		{
+			int e = errno;
+			::close(handle);
+			errno = e;
+			File::throwException(File::getDummyFile(path));
+		}
+		file->d = (uint8_t*)d;
+		file->s = size_t(st.st_size);
+	}
+
+	// the mapping stays valid after closing the file
+	::close(handle);
+	return file;
+}
+
+} // namespace digi
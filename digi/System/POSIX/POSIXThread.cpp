@@ -0,0 +1,58 @@
+#include <pthread.h>
+#include <string.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "../Thread.h"
+
+
+namespace digi {
+
+// posix implementation of Thread
+class POSIXThread : public Thread
+{
+public:
+
+	POSIXThread(ThreadTask& task)
+		: task(task), joined(false)
+	{
+		int result = pthread_create(&this->thread, NULL, &POSIXThread::threadFunction, this);
+		if (result != 0)
+			throw std::runtime_error(std::string("Thread: create failed: ") + strerror(result));
+	}
+
+	virtual ~POSIXThread()
+	{
+		this->join();
+	}
+
+	virtual void join()
+	{
+		if (!this->joined)
+		{
+			pthread_join(this->thread, NULL);
+			this->joined = true;
+		}
+	}
+
+	static void* threadFunction(void* parameter)
+	{
+		POSIXThread* thread = (POSIXThread*)parameter;
+		thread->task.run(0);
+		return NULL;
+	}
+
+
+	pthread_t thread;
+	ThreadTask& task;
+	bool joined;
+};
+
+
+Pointer<Thread> Thread::create(ThreadTask& task)
+{
+	return new POSIXThread(task);
+}
+
+} // namespace digi
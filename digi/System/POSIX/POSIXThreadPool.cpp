@@ -0,0 +1,165 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <boost/detail/atomic_count.hpp>
+
+#include <digi/Utility/foreach.h>
+
+#include "../ThreadPool.h"
+
+
+namespace digi {
+
+// posix implementation of ThreadPool
+class POSIXThreadPool : public ThreadPool
+{
+public:
+
+	POSIXThreadPool(int numThreads)
+		: task(NULL), count(0), base(0), next(0), numBusy(0), generation(0), quit(false)
+	{
+		pthread_mutex_init(&this->mutex, NULL);
+		pthread_cond_init(&this->startCondition, NULL);
+		pthread_cond_init(&this->doneCondition, NULL);
+
+		// the thread that calls run() is also a worker
+		this->threads.resize(numThreads - 1);
+		foreach (pthread_t& thread, this->threads)
+		{
+			pthread_create(&thread, NULL, &POSIXThreadPool::threadFunction, this);
+		}
+	}
+
+	virtual ~POSIXThreadPool()
+	{
+		// tell the worker threads to quit
+		pthread_mutex_lock(&this->mutex);
+		this->quit = true;
+		pthread_cond_broadcast(&this->startCondition);
+		pthread_mutex_unlock(&this->mutex);
+
+		foreach (pthread_t& thread, this->threads)
+		{
+			pthread_join(thread, NULL);
+		}
+
+		pthread_cond_destroy(&this->doneCondition);
+		pthread_cond_destroy(&this->startCondition);
+		pthread_mutex_destroy(&this->mutex);
+	}
+
+	virtual int getNumThreads()
+	{
+		return int(this->threads.size()) + 1;
+	}
+
+	virtual void run(ThreadTask& task, int count)
+	{
+		// run directly if there is nothing to distribute
+		if (this->threads.empty() || count <= 1)
+		{
+			for (int index = 0; index < count; ++index)
+				task.run(index);
+			return;
+		}
+
+		// start the worker threads
+		pthread_mutex_lock(&this->mutex);
+		this->task = &task;
+		this->count = count;
+		this->base = this->next;
+		this->numBusy = int(this->threads.size());
+		++this->generation;
+		pthread_cond_broadcast(&this->startCondition);
+		pthread_mutex_unlock(&this->mutex);
+
+		// work on the calling thread too
+		this->work();
+
+		// wait until all worker threads are done
+		pthread_mutex_lock(&this->mutex);
+		while (this->numBusy > 0)
+			pthread_cond_wait(&this->doneCondition, &this->mutex);
+		this->task = NULL;
+		pthread_mutex_unlock(&this->mutex);
+	}
+
+	void work()
+	{
+		ThreadTask& task = *this->task;
+		int count = this->count;
+		long base = this->base;
+
+		// fetch items from shared counter until all are taken
+		int index;
+		while ((index = int(++this->next - 1 - base)) < count)
+			task.run(index);
+	}
+
+	static void* threadFunction(void* parameter)
+	{
+		POSIXThreadPool* pool = (POSIXThreadPool*)parameter;
+		int generation = 0;
+
+		pthread_mutex_lock(&pool->mutex);
+		while (true)
+		{
+			// wait for next job
+			while (!pool->quit && pool->generation == generation)
+				pthread_cond_wait(&pool->startCondition, &pool->mutex);
+			if (pool->quit)
+				break;
+			generation = pool->generation;
+			pthread_mutex_unlock(&pool->mutex);
+
+			pool->work();
+
+			// notify run() when the last worker is done
+			pthread_mutex_lock(&pool->mutex);
+			if (--pool->numBusy == 0)
+				pthread_cond_signal(&pool->doneCondition);
+		}
+		pthread_mutex_unlock(&pool->mutex);
+		return NULL;
+	}
+
+
+	std::vector<pthread_t> threads;
+	pthread_mutex_t mutex;
+	pthread_cond_t startCondition;
+	pthread_cond_t doneCondition;
+
+	// current job
+	ThreadTask* task;
+	int count;
+
+	// counter for work items, the index of an item is next - base
+	long base;
+	boost::detail::atomic_count next;
+
+	// number of worker threads that are still working on the current job
+	int numBusy;
+
+	// incremented for each job so that worker threads can detect a new job
+	int generation;
+
+	bool quit;
+};
+
+
+Pointer<ThreadPool> ThreadPool::create(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = getNumProcessors();
+	return new POSIXThreadPool(numThreads);
+}
+
+int ThreadPool::getNumProcessors()
+{
+	long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	return numProcessors > 0 ? int(numProcessors) : 1;
+}
+
+} // namespace digi
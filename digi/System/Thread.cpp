@@ -0,0 +1,12 @@
+#include "Thread.h"
+
+
+namespace digi {
+
+// Thread
+
+Thread::~Thread()
+{
+}
+
+} // namespace digi
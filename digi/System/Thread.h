@@ -0,0 +1,38 @@
+#ifndef digi_System_Thread_h
+#define digi_System_Thread_h
+
+#include <digi/Utility/Object.h>
+
+#include "ThreadPool.h"
+
+
+namespace digi {
+
+/// @addtogroup System
+/// @{
+
+/// thread using the native operating system api. executes task.run(0) once
+class Thread : public Object
+{
+public:
+
+	/// start a thread that calls task.run(0). the task must stay valid until join() returns. throws
+	/// std::runtime_error if the thread can't be created
+	static Pointer<Thread> create(ThreadTask& task);
+
+	/// destructor. waits until the thread has finished
+	virtual ~Thread();
+
+	/// wait until the thread has finished
+	virtual void join() = 0;
+
+protected:
+
+	Thread() {}
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
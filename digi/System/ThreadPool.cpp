@@ -0,0 +1,19 @@
+#include "ThreadPool.h"
+
+
+namespace digi {
+
+// ThreadTask
+
+ThreadTask::~ThreadTask()
+{
+}
+
+
+// ThreadPool
+
+ThreadPool::~ThreadPool()
+{
+}
+
+} // namespace digi
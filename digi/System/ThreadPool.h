@@ -0,0 +1,60 @@
+/*
+	pool of worker threads using the native operating system api.
+	a parallel job is split into a number of work items that are fetched by the threads from a shared
+	counter, therefore threads that finish early take over the remaining items of slower threads.
+*/
+
+#ifndef digi_System_ThreadPool_h
+#define digi_System_ThreadPool_h
+
+#include <digi/Utility/Object.h>
+
+
+namespace digi {
+
+/// @addtogroup System
+/// @{
+
+/// work items of a parallel job. run() gets called once for each index in the range [0, count)
+class ThreadTask
+{
+public:
+
+	virtual ~ThreadTask();
+
+	/// process one work item. may be called concurrently with different indices, must not throw
+	virtual void run(int index) = 0;
+};
+
+
+class ThreadPool : public Object
+{
+public:
+
+	/// create a thread pool with given number of threads including the thread that calls run(),
+	/// i.e. numThreads - 1 worker threads get created. 0 means one thread per processor
+	static Pointer<ThreadPool> create(int numThreads = 0);
+
+	/// get number of processors that are available to this process
+	static int getNumProcessors();
+
+	virtual ~ThreadPool();
+
+	/// get number of threads including the calling thread
+	virtual int getNumThreads() = 0;
+
+	/// call task.run(index) for each index in the range [0, count) distributed over all threads.
+	/// the calling thread also processes items, returns when all items are done.
+	/// only one thread at a time may call run()
+	virtual void run(ThreadTask& task, int count) = 0;
+
+protected:
+
+	ThreadPool() {}
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -28,6 +28,7 @@
 #else
 	// POSIX
 	#include <sys/time.h>
+	#include <time.h>
 #endif
 
 
@@ -52,7 +53,8 @@ namespace Timer
 			// POSIX
 			struct timeval time;
 			gettimeofday(&time, NULL);
-			return time.tv_sec * 1000 + time.tv_usec / 1000.0;
+			// wraps around like timeGetTime() on windows, only differences are meaningful
+			return int(int64_t(time.tv_sec) * 1000 + time.tv_usec / 1000);
 		#endif
 	}
 
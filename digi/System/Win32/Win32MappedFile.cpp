@@ -0,0 +1,77 @@
+#include "../File.h"
+#include "../MappedFile.h"
+
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+
+
+namespace digi {
+
+// win32 implementation of MappedFile
+class Win32MappedFile : public MappedFile
+{
+public:
+
+	Win32MappedFile(const fs::path& path)
+		: MappedFile(path)
+	{
+	}
+
+	virtual ~Win32MappedFile()
+	{
+		if (this->d != NULL)
+			UnmapViewOfFile(this->d);
+	}
+	
+	friend class MappedFile;
+};
+
+
+Pointer<MappedFile> MappedFile::open(const fs::path& path)
+{
+	HANDLE handle = CreateFileW(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		File::throwException(File::getDummyFile(path));
+
+	Pointer<Win32MappedFile> file = new Win32MappedFile(path);
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size))
+	{
+		DWORD e = GetLastError();
+		CloseHandle(handle);
+		SetLastError(e);
+		File::throwException(File::getDummyFile(path));
+	}
+	if (size.QuadPart > 0)
+	{
+		// copy on write mapping
+		HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		void* d = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+		if (d == NULL)
+		{
+			DWORD e = GetLastError();
+			if (mapping != NULL)
+				CloseHandle(mapping);
+			CloseHandle(handle);
+			SetLastError(e);
+			File::throwException(File::getDummyFile(path));
+		}
+		file->d = (uint8_t*)d;
+		file->s = size_t(size.QuadPart);
+		
+		// the view stays valid after closing the mapping and file handles
+		CloseHandle(mapping);
+	}
+
+	CloseHandle(handle);
+	return file;
+}
+
+} // namespace digi
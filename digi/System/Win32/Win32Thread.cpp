@@ -0,0 +1,57 @@
+#include <stdexcept>
+
+#include "../Thread.h"
+
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+
+
+namespace digi {
+
+// win32 implementation of Thread
+class Win32Thread : public Thread
+{
+public:
+
+	Win32Thread(ThreadTask& task)
+		: task(task)
+	{
+		this->thread = CreateThread(NULL, 0, &Win32Thread::threadFunction, this, 0, NULL);
+		if (this->thread == NULL)
+			throw std::runtime_error("Thread: create failed");
+	}
+
+	virtual ~Win32Thread()
+	{
+		this->join();
+	}
+
+	virtual void join()
+	{
+		if (this->thread != NULL)
+		{
+			WaitForSingleObject(this->thread, INFINITE);
+			CloseHandle(this->thread);
+			this->thread = NULL;
+		}
+	}
+
+	static DWORD WINAPI threadFunction(LPVOID parameter)
+	{
+		Win32Thread* thread = (Win32Thread*)parameter;
+		thread->task.run(0);
+		return 0;
+	}
+
+
+	HANDLE thread;
+	ThreadTask& task;
+};
+
+
+Pointer<Thread> Thread::create(ThreadTask& task)
+{
+	return new Win32Thread(task);
+}
+
+} // namespace digi
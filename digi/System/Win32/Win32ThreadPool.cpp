@@ -0,0 +1,166 @@
+#include <vector>
+
+#include <boost/detail/atomic_count.hpp>
+
+#include <digi/Utility/foreach.h>
+
+#include "../ThreadPool.h"
+
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+
+
+namespace digi {
+
+// win32 implementation of ThreadPool (needs Windows Vista for condition variables)
+class Win32ThreadPool : public ThreadPool
+{
+public:
+
+	Win32ThreadPool(int numThreads)
+		: task(NULL), count(0), base(0), next(0), numBusy(0), generation(0), quit(false)
+	{
+		InitializeCriticalSection(&this->mutex);
+		InitializeConditionVariable(&this->startCondition);
+		InitializeConditionVariable(&this->doneCondition);
+
+		// the thread that calls run() is also a worker
+		this->threads.resize(numThreads - 1);
+		foreach (HANDLE& thread, this->threads)
+		{
+			thread = CreateThread(NULL, 0, &Win32ThreadPool::threadFunction, this, 0, NULL);
+		}
+	}
+
+	virtual ~Win32ThreadPool()
+	{
+		// tell the worker threads to quit
+		EnterCriticalSection(&this->mutex);
+		this->quit = true;
+		WakeAllConditionVariable(&this->startCondition);
+		LeaveCriticalSection(&this->mutex);
+
+		foreach (HANDLE thread, this->threads)
+		{
+			WaitForSingleObject(thread, INFINITE);
+			CloseHandle(thread);
+		}
+
+		DeleteCriticalSection(&this->mutex);
+	}
+
+	virtual int getNumThreads()
+	{
+		return int(this->threads.size()) + 1;
+	}
+
+	virtual void run(ThreadTask& task, int count)
+	{
+		// run directly if there is nothing to distribute
+		if (this->threads.empty() || count <= 1)
+		{
+			for (int index = 0; index < count; ++index)
+				task.run(index);
+			return;
+		}
+
+		// start the worker threads
+		EnterCriticalSection(&this->mutex);
+		this->task = &task;
+		this->count = count;
+		this->base = this->next;
+		this->numBusy = int(this->threads.size());
+		++this->generation;
+		WakeAllConditionVariable(&this->startCondition);
+		LeaveCriticalSection(&this->mutex);
+
+		// work on the calling thread too
+		this->work();
+
+		// wait until all worker threads are done
+		EnterCriticalSection(&this->mutex);
+		while (this->numBusy > 0)
+			SleepConditionVariableCS(&this->doneCondition, &this->mutex, INFINITE);
+		this->task = NULL;
+		LeaveCriticalSection(&this->mutex);
+	}
+
+	void work()
+	{
+		ThreadTask& task = *this->task;
+		int count = this->count;
+		long base = this->base;
+
+		// fetch items from shared counter until all are taken
+		int index;
+		while ((index = int(++this->next - 1 - base)) < count)
+			task.run(index);
+	}
+
+	static DWORD WINAPI threadFunction(LPVOID parameter)
+	{
+		Win32ThreadPool* pool = (Win32ThreadPool*)parameter;
+		int generation = 0;
+
+		EnterCriticalSection(&pool->mutex);
+		while (true)
+		{
+			// wait for next job
+			while (!pool->quit && pool->generation == generation)
+				SleepConditionVariableCS(&pool->startCondition, &pool->mutex, INFINITE);
+			if (pool->quit)
+				break;
+			generation = pool->generation;
+			LeaveCriticalSection(&pool->mutex);
+
+			pool->work();
+
+			// notify run() when the last worker is done
+			EnterCriticalSection(&pool->mutex);
+			if (--pool->numBusy == 0)
+				WakeConditionVariable(&pool->doneCondition);
+		}
+		LeaveCriticalSection(&pool->mutex);
+		return 0;
+	}
+
+
+	std::vector<HANDLE> threads;
+	CRITICAL_SECTION mutex;
+	CONDITION_VARIABLE startCondition;
+	CONDITION_VARIABLE doneCondition;
+
+	// current job
+	ThreadTask* task;
+	int count;
+
+	// counter for work items, the index of an item is next - base
+	long base;
+	boost::detail::atomic_count next;
+
+	// number of worker threads that are still working on the current job
+	int numBusy;
+
+	// incremented for each job so that worker threads can detect a new job
+	int generation;
+
+	bool quit;
+};
+
+
+Pointer<ThreadPool> ThreadPool::create(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = getNumProcessors();
+	return new Win32ThreadPool(numThreads);
+}
+
+int ThreadPool::getNumProcessors()
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	int numProcessors = int(systemInfo.dwNumberOfProcessors);
+	return numProcessors > 0 ? numProcessors : 1;
+}
+
+} // namespace digi
@@ -1,12 +1,16 @@
 #include <fstream>
+#include <iostream>
 
 #include <gtest/gtest.h>
 
 #include <digi/Base/VersionInfo.h>
 #include <digi/Utility/Convert.h>
+#include <digi/Utility/LockFreeQueue.h>
 #include <digi/System/File.h>
 #include <digi/System/IOException.h>
+#include <digi/System/MappedFile.h>
 #include <digi/System/SerialPort.h>
+#include <digi/System/Thread.h>
 #include <digi/System/Timer.h>
 
 #include "InitLibraries.h"
@@ -141,6 +145,45 @@ TEST(System, Path)
 	//EXPECT_EQ(to8BitPath(L"\u00E4"), "\xE4");
 }
 
+TEST(System, MappedFile)
+{
+	fs::path path = "mapped.bin";
+	{
+		Pointer<File> file = File::create(path);
+		file->write("hello world!", 12);
+		file->close();
+	}
+	
+	// map file and check contents
+	{
+		Pointer<MappedFile> file = MappedFile::open(path);
+		ASSERT_EQ(file->size(), 12);
+		EXPECT_EQ(std::string((char*)file->begin(), (char*)file->end()), "hello world!");
+		
+		// modify the private copy
+		file->data()[0] = 'H';
+		EXPECT_EQ(file->data()[0], 'H');
+	}
+	
+	// check that the file was not modified
+	{
+		Pointer<MappedFile> file = MappedFile::open(path);
+		EXPECT_EQ(file->data()[0], 'h');
+	}
+	
+	// opening a file that does not exist must fail
+	try
+	{
+		MappedFile::open("doesNotExist.bin");
+		EXPECT_TRUE(false) << "no exception was thrown";
+	}
+	catch (IOException& e)
+	{
+		EXPECT_EQ(e.getReason(), IOException::FILE_NOT_FOUND);
+	}
+	fs::remove(path);
+}
+
 #ifdef TEST_SERIAL_DEVICE
 
 #define STRINGIFY(x) #x
@@ -165,6 +208,69 @@ TEST(System, Timer)
 	EXPECT_TRUE(t > 480 && t < 550);
 }
 
+// producer task that writes increasing numbers into a queue in bulk
+class QueueProducerTask : public ThreadTask
+{
+public:
+
+	QueueProducerTask(LockFreeQueue<int>& queue, int numValues)
+		: queue(queue), numValues(numValues) {}
+
+	virtual ~QueueProducerTask() {}
+
+	virtual void run(int index)
+	{
+		int values[100];
+		int next = 0;
+		while (next < this->numValues)
+		{
+			int count = std::min(100, this->numValues - next);
+			for (int i = 0; i < count; ++i)
+				values[i] = next + i;
+			int numWritten = int(this->queue.write(values, count));
+			
+			// give up time slice if the queue is full
+			if (numWritten == 0)
+				Timer::milliSleep(0);
+			next += numWritten;
+		}
+	}
+
+	LockFreeQueue<int>& queue;
+	int numValues;
+};
+
+TEST(System, ThreadLockFreeQueue)
+{
+	const int numValues = 1000000;
+	LockFreeQueue<int> queue(1024);
+	QueueProducerTask task(queue, numValues);
+
+	// consume on this thread while the producer runs on another thread
+	int t1 = Timer::getMilliSeconds();
+	Pointer<Thread> thread = Thread::create(task);
+	int values[100];
+	int next = 0;
+	bool ok = true;
+	while (next < numValues)
+	{
+		int count = int(queue.read(values, 100));
+		
+		// give up time slice if the queue is empty
+		if (count == 0)
+			Timer::milliSleep(0);
+		for (int i = 0; i < count; ++i)
+			ok &= values[i] == next + i;
+		next += count;
+	}
+	thread->join();
+	int t2 = Timer::getMilliSeconds();
+	
+	EXPECT_TRUE(ok);
+	EXPECT_TRUE(queue.empty());
+	std::cout << "queue: " << numValues / 1000 / std::max(t2 - t1, 1) << " M values/s" << std::endl;
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -1,6 +1,7 @@
 #ifndef digi_Utility_All_h
 #define digi_Utility_All_h
 
+#include "Arena.h"
 #include "ArrayRef.h"
 #include "ArrayUtility.h"
 #include "as.h"
@@ -11,9 +12,9 @@
 #include "IntUtility.h"
 #include "lexicalCast.h"
 #include "ListUtility.h"
+#include "LockFreeQueue.h"
 #include "malloc16.h"
 #include "MapUtility.h"
-#include "MemoryPool.h"
 #include "Object.h"
 #include "Pointer.h"
 #include "ScopedAssign.h"
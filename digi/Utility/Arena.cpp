@@ -0,0 +1,85 @@
+#include "Arena.h"
+#include "malloc16.h"
+
+
+namespace digi {
+
+// Arena
+
+Arena::Arena(size_t blockSize)
+	: blockSize(blockSize), blockIndex(0), offset(0), bytesUsed(0), bytesWasted(0)
+{
+	for (int i = 0; i < NUM_SIZE_CLASSES; ++i)
+		this->numAllocations[i] = 0;
+}
+
+Arena::~Arena()
+{
+	this->clear();
+}
+
+void Arena::reset()
+{
+	this->blockIndex = 0;
+	this->offset = 0;
+	this->bytesUsed = 0;
+	this->bytesWasted = 0;
+	for (int i = 0; i < NUM_SIZE_CLASSES; ++i)
+		this->numAllocations[i] = 0;
+}
+
+void Arena::clear()
+{
+	size_t numBlocks = this->blocks.size();
+	for (size_t i = 0; i < numBlocks; ++i)
+		free16(this->blocks[i].data);
+	this->blocks.clear();
+	this->reset();
+}
+
+Arena::Stats Arena::getStats() const
+{
+	Stats stats;
+	stats.bytesUsed = this->bytesUsed;
+	stats.bytesWasted = this->bytesWasted;
+	stats.bytesReserved = 0;
+	size_t numBlocks = this->blocks.size();
+	for (size_t i = 0; i < numBlocks; ++i)
+		stats.bytesReserved += this->blocks[i].size;
+	stats.numBlocks = numBlocks;
+	for (int i = 0; i < NUM_SIZE_CLASSES; ++i)
+		stats.numAllocations[i] = this->numAllocations[i];
+	return stats;
+}
+
+void* Arena::allocBlock(size_t size, size_t alignment)
+{
+	// the rest of the current block is wasted
+	if (this->blockIndex < this->blocks.size())
+	{
+		this->bytesWasted += this->blocks[this->blockIndex].size - this->offset;
+		++this->blockIndex;
+	}
+
+	// blocks are 16 byte aligned, therefore only larger alignments need extra space
+	size_t extra = alignment > 16 ? alignment - 16 : 0;
+
+	// reuse the next block if it is large enough (after reset() or rewind()), otherwise insert a new block
+	if (this->blockIndex >= this->blocks.size() || this->blocks[this->blockIndex].size < size + extra)
+	{
+		Block block;
+		block.size = size + extra > this->blockSize / 2 ? size + extra : this->blockSize;
+		block.data = (uint8_t*)malloc16(block.size);
+		this->blocks.insert(this->blocks.begin() + this->blockIndex, block);
+	}
+	Block& block = this->blocks[this->blockIndex];
+
+	size_t padding = (0 - size_t(block.data)) & (alignment - 1);
+	this->offset = padding + size;
+	this->bytesUsed += size;
+	this->bytesWasted += padding;
+	++this->numAllocations[getSizeClass(size)];
+	return block.data + padding;
+}
+
+} // namespace digi
@@ -0,0 +1,161 @@
+#ifndef digi_Utility_Arena_h
+#define digi_Utility_Arena_h
+
+#include <vector>
+
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <digi/Base/Platform.h>
+
+
+namespace digi {
+
+/// @addtogroup Utility
+/// @{
+
+/**
+	arena allocator. memory is allocated from large blocks by incrementing an offset and is not freed individually.
+	getMark()/rewind() release everything that was allocated after the mark, reset() releases everything but keeps
+	the blocks for reuse. no constructors or destructors are called for the allocated elements.
+*/
+class Arena
+{
+public:
+
+	/// number of size classes for allocation statistics. size class i counts allocations with
+	/// size in [2^i, 2^(i+1)), the last size class also counts all larger allocations
+	enum
+	{
+		NUM_SIZE_CLASSES = 16
+	};
+
+	/// position in the arena for rewind()
+	struct Mark
+	{
+		size_t blockIndex;
+		size_t offset;
+		size_t bytesUsed;
+		size_t bytesWasted;
+	};
+
+	/// statistics
+	struct Stats
+	{
+		/// number of bytes that are currently allocated
+		size_t bytesUsed;
+
+		/// number of bytes lost for alignment and at the end of blocks
+		size_t bytesWasted;
+
+		/// total size of all blocks
+		size_t bytesReserved;
+
+		/// number of blocks
+		size_t numBlocks;
+
+		/// number of allocations per size class since construction or last reset
+		size_t numAllocations[NUM_SIZE_CLASSES];
+	};
+
+
+	/// constructor. allocations larger than half of the block size get an own block
+	explicit Arena(size_t blockSize = 16384);
+
+	~Arena();
+
+	/// allocate memory with given size and alignment (must be a power of two)
+	void* alloc(size_t size, size_t alignment = 16)
+	{
+		// fast path: fits into current block
+		if (this->blockIndex < this->blocks.size())
+		{
+			Block& block = this->blocks[this->blockIndex];
+			size_t padding = (0 - (size_t(block.data) + this->offset)) & (alignment - 1);
+			if (size + padding <= block.size - this->offset)
+			{
+				uint8_t* p = block.data + this->offset + padding;
+				this->offset += size + padding;
+				this->bytesUsed += size;
+				this->bytesWasted += padding;
+				++this->numAllocations[getSizeClass(size)];
+				return p;
+			}
+		}
+		return this->allocBlock(size, alignment);
+	}
+
+	/// allocate array of uninitialized elements
+	template <typename Type>
+	Type* alloc(size_t numElements)
+	{
+		return (Type*)this->alloc(numElements * sizeof(Type), boost::alignment_of<Type>::value);
+	}
+
+	/// get current position
+	Mark getMark() const
+	{
+		Mark mark = {this->blockIndex, this->offset, this->bytesUsed, this->bytesWasted};
+		return mark;
+	}
+
+	/// release all memory that was allocated after the mark was taken
+	void rewind(const Mark& mark)
+	{
+		this->blockIndex = mark.blockIndex;
+		this->offset = mark.offset;
+		this->bytesUsed = mark.bytesUsed;
+		this->bytesWasted = mark.bytesWasted;
+	}
+
+	/// release all memory but keep the blocks for reuse
+	void reset();
+
+	/// release all memory and free the blocks
+	void clear();
+
+	/// get statistics
+	Stats getStats() const;
+
+	/// get size class of an allocation
+	static int getSizeClass(size_t size)
+	{
+		int sizeClass = 0;
+		while (size > 1 && sizeClass < NUM_SIZE_CLASSES - 1)
+		{
+			size >>= 1;
+			++sizeClass;
+		}
+		return sizeClass;
+	}
+
+protected:
+
+	// not copyable
+	Arena(const Arena&);
+	Arena& operator =(const Arena&);
+
+	void* allocBlock(size_t size, size_t alignment);
+
+	struct Block
+	{
+		uint8_t* data;
+		size_t size;
+	};
+
+	size_t blockSize;
+	std::vector<Block> blocks;
+
+	// current block and offset in current block
+	size_t blockIndex;
+	size_t offset;
+
+	size_t bytesUsed;
+	size_t bytesWasted;
+	size_t numAllocations[NUM_SIZE_CLASSES];
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
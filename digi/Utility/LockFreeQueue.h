@@ -0,0 +1,247 @@
+#ifndef digi_Utility_LockFreeQueue_h
+#define digi_Utility_LockFreeQueue_h
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/detail/atomic_count.hpp>
+
+#include <digi/Base/Platform.h>
+
+
+namespace digi {
+
+/// @addtogroup Utility
+/// @{
+
+/**
+	bounded lock-free queue for one producer thread and one consumer thread. the elements are preallocated and get
+	reused, therefore an element may own memory (e.g. a std::vector) that is allocated only once. the producer fills
+	back() and then calls push(), the consumer reads front() and then calls pop().
+	the read and write counters are on separate cache lines and each side keeps a private copy of the other side's
+	counter that is only refreshed when the queue seems to be full or empty. this avoids that the cache lines bounce
+	between the two threads for every element
+*/
+template <typename Type>
+class LockFreeQueue
+{
+public:
+
+	enum
+	{
+		// assumed size of a cache line in bytes
+		CACHE_LINE_SIZE = 64
+	};
+
+	/// constructor. the capacity gets rounded up to a power of two
+	explicit LockFreeQueue(size_t capacity)
+		: readCount(0), writeCount(0), producerReadCount(0), consumerWriteCount(0)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		this->elements.resize(size);
+		this->mask = size - 1;
+	}
+
+	/// get maximum number of elements
+	size_t capacity() const {return this->mask + 1;}
+
+	/// get number of elements. may already be outdated when called by a thread that is neither producer nor consumer
+	size_t size() const {return size_t((unsigned long)long(this->writeCount) - (unsigned long)long(this->readCount));}
+
+	bool empty() const {return this->size() == 0;}
+
+	bool full() const {return this->size() == this->capacity();}
+
+// producer
+
+	/// get the element that gets added by push() or NULL if the queue is full
+	Type* back()
+	{
+		unsigned long writeCount = (unsigned long)long(this->writeCount);
+		if (this->getFreeSpace(writeCount, 1) == 0)
+			return NULL;
+		return &this->elements[writeCount & this->mask];
+	}
+
+	/// add the element returned by back() to the queue
+	void push()
+	{
+		++this->writeCount;
+	}
+
+	/// copy value into the queue. returns false if the queue is full
+	bool push(const Type& value)
+	{
+		Type* element = this->back();
+		if (element == NULL)
+			return false;
+		*element = value;
+		++this->writeCount;
+		return true;
+	}
+
+	/// copy all values into the queue. returns false and adds nothing if there is not enough space
+	bool push(const Type* values, size_t numValues)
+	{
+		unsigned long writeCount = (unsigned long)long(this->writeCount);
+		if (this->getFreeSpace(writeCount, numValues) < numValues)
+			return false;
+		this->copyIn(writeCount, values, numValues);
+		return true;
+	}
+
+	/// copy as many values into the queue as there is space for. returns the number of values that were added
+	size_t write(const Type* values, size_t numValues)
+	{
+		unsigned long writeCount = (unsigned long)long(this->writeCount);
+		numValues = std::min(numValues, this->getFreeSpace(writeCount, numValues));
+		this->copyIn(writeCount, values, numValues);
+		return numValues;
+	}
+
+// consumer
+
+	/// get the oldest element or NULL if the queue is empty
+	Type* front()
+	{
+		unsigned long readCount = (unsigned long)long(this->readCount);
+		if (this->getNumAvailable(readCount, 1) == 0)
+			return NULL;
+		return &this->elements[readCount & this->mask];
+	}
+
+	/// get element at given index relative to front() or NULL if there are not enough elements
+	Type* get(size_t index)
+	{
+		unsigned long readCount = (unsigned long)long(this->readCount);
+		if (index >= this->getNumAvailable(readCount, index + 1))
+			return NULL;
+		return &this->elements[(readCount + index) & this->mask];
+	}
+
+	/// remove the element returned by front() from the queue
+	void pop()
+	{
+		++this->readCount;
+	}
+
+	/// copy oldest element into value and remove it. returns false if the queue is empty
+	bool pop(Type& value)
+	{
+		Type* element = this->front();
+		if (element == NULL)
+			return false;
+		value = *element;
+		++this->readCount;
+		return true;
+	}
+
+	/// copy up to maxNumValues of the oldest elements into values and remove them. returns the number of values
+	size_t read(Type* values, size_t maxNumValues)
+	{
+		unsigned long readCount = (unsigned long)long(this->readCount);
+		size_t numValues = std::min(maxNumValues, this->getNumAvailable(readCount, maxNumValues));
+		
+		// copy in up to two parts because of wrap-around
+		size_t index = readCount & this->mask;
+		size_t numValues1 = std::min(numValues, this->capacity() - index);
+		std::copy(this->elements.begin() + index, this->elements.begin() + index + numValues1, values);
+		std::copy(this->elements.begin(), this->elements.begin() + (numValues - numValues1), values + numValues1);
+		
+		advance(this->readCount, numValues);
+		return numValues;
+	}
+
+	/// remove all elements. must be called by the consumer or while no other thread uses the queue
+	void clear()
+	{
+		unsigned long readCount = (unsigned long)long(this->readCount);
+		advance(this->readCount, this->getNumAvailable(readCount, this->capacity()));
+	}
+
+protected:
+
+	// not copyable
+	LockFreeQueue(const LockFreeQueue&);
+	LockFreeQueue& operator =(const LockFreeQueue&);
+
+	// get number of free elements for the producer. the copy of the read counter is only refreshed if it indicates
+	// less free space than needed
+	size_t getFreeSpace(unsigned long writeCount, size_t numNeeded)
+	{
+		size_t freeSpace = this->capacity() - size_t(writeCount - this->producerReadCount);
+		if (freeSpace < numNeeded)
+		{
+			this->producerReadCount = (unsigned long)long(this->readCount);
+			freeSpace = this->capacity() - size_t(writeCount - this->producerReadCount);
+		}
+		return freeSpace;
+	}
+
+	// get number of available elements for the consumer. the copy of the write counter is only refreshed if it
+	// indicates less elements than needed
+	size_t getNumAvailable(unsigned long readCount, size_t numNeeded)
+	{
+		size_t numAvailable = size_t(this->consumerWriteCount - readCount);
+		if (numAvailable < numNeeded)
+		{
+			this->consumerWriteCount = (unsigned long)long(this->writeCount);
+			numAvailable = size_t(this->consumerWriteCount - readCount);
+		}
+		return numAvailable;
+	}
+
+	void copyIn(unsigned long writeCount, const Type* values, size_t numValues)
+	{
+		// copy in up to two parts because of wrap-around
+		size_t index = writeCount & this->mask;
+		size_t numValues1 = std::min(numValues, this->capacity() - index);
+		std::copy(values, values + numValues1, this->elements.begin() + index);
+		std::copy(values + numValues1, values + numValues, this->elements.begin());
+		
+		advance(this->writeCount, numValues);
+	}
+
+	// atomic_count only supports increment. the elements are already in place, therefore each increment publishes
+	// a valid element to the other thread
+	static void advance(boost::detail::atomic_count& count, size_t numValues)
+	{
+		for (size_t i = 0; i < numValues; ++i)
+			++count;
+	}
+
+
+	// elements and mask are only read after construction
+	std::vector<Type> elements;
+	size_t mask;
+
+	char padding0[CACHE_LINE_SIZE];
+
+	// number of elements that were removed, only incremented by the consumer
+	boost::detail::atomic_count readCount;
+
+	char padding1[CACHE_LINE_SIZE];
+
+	// number of elements that were added, only incremented by the producer
+	boost::detail::atomic_count writeCount;
+
+	char padding2[CACHE_LINE_SIZE];
+
+	// copy of readCount that is only used by the producer
+	unsigned long producerReadCount;
+
+	char padding3[CACHE_LINE_SIZE];
+
+	// copy of writeCount that is only used by the consumer
+	unsigned long consumerWriteCount;
+
+	char padding4[CACHE_LINE_SIZE];
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -5,12 +5,14 @@
 #include <boost/optional.hpp>
 
 #include <digi/Base/VersionInfo.h>
+#include <digi/Utility/Arena.h>
 #include <digi/Utility/ArrayRef.h>
 #include <digi/Utility/ArrayUtility.h>
 #include <digi/Utility/as.h>
 #include <digi/Utility/Ascii.h>
 #include <digi/Utility/Convert.h>
 #include <digi/Utility/lexicalCast.h>
+#include <digi/Utility/LockFreeQueue.h>
 #include <digi/Utility/malloc16.h>
 #include <digi/Utility/Object.h>
 #include <digi/Utility/SetUtility.h>
@@ -114,6 +116,55 @@ TEST(Utility, boost)
 	}
 }
 
+TEST(Utility, Arena)
+{
+	Arena arena(1024);
+	
+	// aligned allocations
+	for (int i = 0; i < 20; ++i)
+	{
+		size_t alignment = size_t(1) << (i % 7);
+		size_t p = (size_t)arena.alloc(3 + i * 5, alignment);
+		EXPECT_EQ(p & (alignment - 1), 0);
+	}
+	double* d = arena.alloc<double>(10);
+	EXPECT_EQ((size_t)d & (sizeof(double) - 1), 0);
+	
+	// large allocation gets an own block
+	uint8_t* large = arena.alloc<uint8_t>(2000);
+	memset(large, 0, 2000);
+	Arena::Stats stats = arena.getStats();
+	EXPECT_GE(stats.bytesReserved, 2000 + 1024);
+	EXPECT_EQ(stats.numAllocations[Arena::getSizeClass(2000)], 1);
+	EXPECT_EQ(Arena::getSizeClass(1), 0);
+	EXPECT_EQ(Arena::getSizeClass(2000), 10);
+	
+	// rewind to mark reuses memory
+	Arena::Mark mark = arena.getMark();
+	size_t bytesUsed = arena.getStats().bytesUsed;
+	void* p1 = arena.alloc(100);
+	arena.alloc(900);
+	arena.rewind(mark);
+	EXPECT_EQ(arena.getStats().bytesUsed, bytesUsed);
+	EXPECT_EQ(arena.alloc(100), p1);
+	
+	// reset keeps the blocks
+	size_t numBlocks = arena.getStats().numBlocks;
+	arena.reset();
+	stats = arena.getStats();
+	EXPECT_EQ(stats.bytesUsed, 0);
+	EXPECT_EQ(stats.bytesWasted, 0);
+	EXPECT_EQ(stats.numBlocks, numBlocks);
+	for (int i = 0; i < 10; ++i)
+		arena.alloc(100);
+	EXPECT_EQ(arena.getStats().numBlocks, numBlocks);
+	
+	// clear frees the blocks
+	arena.clear();
+	EXPECT_EQ(arena.getStats().numBlocks, 0);
+	EXPECT_EQ(arena.getStats().bytesReserved, 0);
+}
+
 TEST(Utility, ArrayRef)
 {
 	const int i[3] = {1, 2, 3};
@@ -267,6 +318,53 @@ TEST(Utility, lexicalCast)
 	}
 }
 
+TEST(Utility, LockFreeQueue)
+{
+	// capacity gets rounded up to a power of two
+	LockFreeQueue<int> queue(6);
+	EXPECT_EQ(queue.capacity(), 8);
+	EXPECT_TRUE(queue.empty());
+	EXPECT_TRUE(queue.front() == NULL);
+
+	// single elements
+	EXPECT_TRUE(queue.push(1));
+	*queue.back() = 2;
+	queue.push();
+	EXPECT_EQ(queue.size(), 2);
+	EXPECT_EQ(*queue.front(), 1);
+	EXPECT_EQ(*queue.get(1), 2);
+	EXPECT_TRUE(queue.get(2) == NULL);
+	int value;
+	EXPECT_TRUE(queue.pop(value));
+	EXPECT_EQ(value, 1);
+	queue.pop();
+	EXPECT_FALSE(queue.pop(value));
+
+	// bulk push wraps around the end of the buffer
+	int values[10] = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+	EXPECT_TRUE(queue.push(values, 7));
+	EXPECT_FALSE(queue.push(values, 2));
+	EXPECT_EQ(queue.size(), 7);
+	EXPECT_EQ(queue.write(values + 7, 3), 1);
+	EXPECT_TRUE(queue.full());
+	EXPECT_TRUE(queue.back() == NULL);
+	EXPECT_FALSE(queue.push(0));
+
+	// bulk read
+	int result[10];
+	EXPECT_EQ(queue.read(result, 3), 3);
+	EXPECT_EQ(queue.read(result + 3, 10), 5);
+	for (int i = 0; i < 8; ++i)
+		EXPECT_EQ(result[i], 10 + i);
+	EXPECT_EQ(queue.read(result, 10), 0);
+
+	// clear
+	EXPECT_EQ(queue.write(values, 10), 8);
+	queue.clear();
+	EXPECT_TRUE(queue.empty());
+	EXPECT_TRUE(queue.push(values, 8));
+}
+
 TEST(Utility, malloc16)
 {
 	for (int i = 0; i < 20; ++i)
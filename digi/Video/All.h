@@ -1,6 +1,9 @@
 #ifndef digi_Video_All_h
 #define digi_Video_All_h
 
+#include "AsyncMediaDecoder.h"
+#include "AsyncWebMDecoder.h"
+#include "FrameQueue.h"
 #include "MediaDecoder.h"
 #include "MediaEncoder.h"
 #include "VideoFormat.h"
@@ -0,0 +1,95 @@
+#include <digi/System/Timer.h>
+
+#include "AsyncMediaDecoder.h"
+
+
+namespace digi {
+
+AsyncMediaDecoder::AsyncMediaDecoder(Pointer<MediaDecoder> decoder, int numBlocks)
+	: decoder(decoder), blocks(numBlocks), running(0)
+{
+}
+
+AsyncMediaDecoder::~AsyncMediaDecoder()
+{
+	this->stop();
+}
+
+void AsyncMediaDecoder::close()
+{
+	this->stop();
+	this->decoder->close();
+}
+
+void AsyncMediaDecoder::update()
+{
+}
+
+void AsyncMediaDecoder::decode(double time, const uint8_t* data, size_t length)
+{
+	// wait until there is space in the queue
+	Block* block;
+	while ((block = this->blocks.back()) == NULL)
+	{
+		if (long(this->running) == 0)
+			return;
+		Timer::milliSleep(1);
+	}
+
+	// copy block. the buffer of the block gets reused
+	block->time = time;
+	block->data.assign(data, data + length);
+	this->blocks.push();
+}
+
+void AsyncMediaDecoder::clear()
+{
+	this->blocks.clear();
+	this->decoder->clear();
+}
+
+void AsyncMediaDecoder::start()
+{
+	if (this->thread != null)
+		return;
+	++this->running;
+	try
+	{
+		this->thread = Thread::create(*this);
+	}
+	catch (...)
+	{
+		--this->running;
+		throw;
+	}
+}
+
+void AsyncMediaDecoder::stop()
+{
+	if (this->thread == null)
+		return;
+	--this->running;
+	this->thread->join();
+	this->thread = null;
+}
+
+void AsyncMediaDecoder::run(int index)
+{
+	while (long(this->running) != 0)
+	{
+		Block* block = this->blocks.front();
+		if (block != NULL && this->decoder->canDecode())
+		{
+			this->decoder->decode(block->time, block->data.data(), block->data.size());
+			this->blocks.pop();
+		}
+		else
+		{
+			// let the decoder output pending data (e.g. audio samples) and wait
+			this->decoder->update();
+			Timer::milliSleep(1);
+		}
+	}
+}
+
+} // namespace digi
@@ -0,0 +1,78 @@
+#ifndef digi_Video_AsyncMediaDecoder_h
+#define digi_Video_AsyncMediaDecoder_h
+
+#include <vector>
+
+#include <boost/detail/atomic_count.hpp>
+
+#include <digi/Utility/LockFreeQueue.h>
+#include <digi/System/Thread.h>
+
+#include "MediaDecoder.h"
+
+
+namespace digi {
+
+/// @addtogroup Video
+/// @{
+
+/**
+	decodes the blocks of one track on a background thread. decode() copies the block into a bounded lock-free queue
+	and waits while the queue is full, the thread passes the blocks to the actual decoder when its output can take
+	more data (see MediaDecoder::canDecode())
+*/
+class AsyncMediaDecoder : public MediaDecoder, public ThreadTask
+{
+public:
+
+	/// constructor. numBlocks is the capacity of the block queue and gets rounded up to a power of two
+	AsyncMediaDecoder(Pointer<MediaDecoder> decoder, int numBlocks = 64);
+
+	virtual ~AsyncMediaDecoder();
+
+	/// stop the thread and close the decoder
+	virtual void close();
+
+	/// does nothing, the thread updates the decoder while it waits for blocks
+	virtual void update();
+
+	/// copy a block into the queue. the block gets dropped if the queue is full and the thread is not running
+	virtual void decode(double time, const uint8_t* data, size_t length);
+
+	/// discard all blocks and clear the decoder. the thread must be stopped
+	virtual void clear();
+
+	/// start the decode thread
+	void start();
+
+	/// stop the decode thread. blocks that are not decoded yet stay in the queue
+	void stop();
+
+	/// returns true if all blocks are decoded
+	bool isIdle() {return this->blocks.empty();}
+
+	/// thread function
+	virtual void run(int index);
+
+protected:
+
+	struct Block
+	{
+		double time;
+		std::vector<uint8_t> data;
+	};
+
+	Pointer<MediaDecoder> decoder;
+	LockFreeQueue<Block> blocks;
+
+	Pointer<Thread> thread;
+
+	// 1 while the thread is running
+	boost::detail::atomic_count running;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
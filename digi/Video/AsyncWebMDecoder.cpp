@@ -0,0 +1,151 @@
+#include <digi/Utility/foreach.h>
+#include <digi/System/Log.h>
+#include <digi/System/Timer.h>
+
+#include "AsyncWebMDecoder.h"
+
+
+namespace digi {
+
+namespace
+{
+	typedef std::pair<const int, Pointer<AsyncMediaDecoder> > DecoderPair;
+} // anonymous namespace
+
+
+AsyncWebMDecoder::AsyncWebMDecoder(Pointer<WebMDecoder> decoder, double prefetchTime)
+	: decoder(decoder), prefetchTime(prefetchTime), startTime(), times(16), running(0), end(0)
+{
+}
+
+AsyncWebMDecoder::~AsyncWebMDecoder()
+{
+	this->stop();
+}
+
+void AsyncWebMDecoder::setDecoder(int trackIndex, Pointer<MediaDecoder> decoder)
+{
+	Pointer<AsyncMediaDecoder> asyncDecoder = new AsyncMediaDecoder(decoder);
+	this->decoders[trackIndex] = asyncDecoder;
+	this->decoder->setDecoder(trackIndex, asyncDecoder);
+}
+
+void AsyncWebMDecoder::close()
+{
+	this->stop();
+	this->decoder->close();
+}
+
+bool AsyncWebMDecoder::decode(double time)
+{
+	if (this->thread == null)
+	{
+		this->start(time);
+	}
+	else
+	{
+		// pass time to demux thread. if the queue is full the demux thread gets the time on the next call
+		this->times.push(time);
+	}
+	return long(this->end) != 0;
+}
+
+bool AsyncWebMDecoder::isFinished()
+{
+	if (long(this->end) == 0)
+		return false;
+	foreach (const DecoderPair& p, this->decoders)
+	{
+		if (!p.second->isIdle())
+			return false;
+	}
+	return true;
+}
+
+double AsyncWebMDecoder::seek(int trackIndex, double time)
+{
+	// seek while all threads are stopped. the decoders get cleared by WebMDecoder::seek()
+	this->stop();
+	double seekTime = this->decoder->seek(trackIndex, time);
+
+	// prefetch from new position
+	this->start(seekTime);
+	return seekTime;
+}
+
+void AsyncWebMDecoder::run(int index)
+{
+	double time = this->startTime;
+	bool end = false;
+	while (long(this->running) != 0)
+	{
+		// get latest playback time
+		double t;
+		while (this->times.pop(t))
+			time = t;
+
+		// demux until prefetch time. blocks if the queue of a track decoder is full
+		if (!end)
+		{
+			try
+			{
+				end = this->decoder->decode(time + this->prefetchTime);
+			}
+			catch (std::exception& e)
+			{
+				// stop demuxing on read errors
+				dError("error while demuxing: " << e.what());
+				end = true;
+			}
+			if (end)
+				++this->end;
+		}
+		Timer::milliSleep(1);
+	}
+}
+
+void AsyncWebMDecoder::start(double time)
+{
+	this->startTime = time;
+	this->times.clear();
+	while (long(this->end) > 0)
+		--this->end;
+
+	// start decode threads before demux thread
+	foreach (const DecoderPair& p, this->decoders)
+	{
+		p.second->start();
+	}
+	++this->running;
+	try
+	{
+		this->thread = Thread::create(*this);
+	}
+	catch (...)
+	{
+		// stop the decode threads again
+		--this->running;
+		foreach (const DecoderPair& p, this->decoders)
+		{
+			p.second->stop();
+		}
+		throw;
+	}
+}
+
+void AsyncWebMDecoder::stop()
+{
+	if (this->thread == null)
+		return;
+
+	// signal the demux thread to stop. stopping the decode threads releases it if it waits for a full block queue
+	--this->running;
+	foreach (const DecoderPair& p, this->decoders)
+	{
+		p.second->stop();
+	}
+	this->thread->join();
+	this->thread = null;
+}
+
+} // namespace digi
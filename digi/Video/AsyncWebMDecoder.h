@@ -0,0 +1,87 @@
+#ifndef digi_Video_AsyncWebMDecoder_h
+#define digi_Video_AsyncWebMDecoder_h
+
+#include <map>
+
+#include <boost/detail/atomic_count.hpp>
+
+#include <digi/Utility/LockFreeQueue.h>
+#include <digi/System/Thread.h>
+
+#include "AsyncMediaDecoder.h"
+#include "WebMDecoder.h"
+
+
+namespace digi {
+
+/// @addtogroup Video
+/// @{
+
+/**
+	asynchronous webm playback. the webm file is demuxed on a background thread and each track is decoded on an own
+	thread (see AsyncMediaDecoder), therefore decode() does not block the render thread. video frames should go into
+	a FrameQueue so that the render thread only uploads frames that are ready. the demux thread runs ahead of the
+	playback time by the prefetch time, also after seek() so that scrubbing stays smooth
+*/
+class AsyncWebMDecoder : public Object, public ThreadTask
+{
+public:
+
+	AsyncWebMDecoder(Pointer<WebMDecoder> decoder, double prefetchTime = 1.0);
+
+	virtual ~AsyncWebMDecoder();
+
+	/// get duration of video
+	double getDuration() {return this->decoder->getDuration();}
+
+	/// set decoder for a track. the decoder gets called on a background thread. must be called before decode()
+	void setDecoder(int trackIndex, Pointer<MediaDecoder> decoder);
+
+	/// stop the threads and close input device and decoders
+	void close();
+
+	/// set playback time, starts the threads on first call. returns true if the demuxer reached the end of the
+	/// segment, decoded data may still be pending in the decoders and their outputs
+	bool decode(double time);
+
+	/// returns true if the demuxer reached the end of the segment and all blocks are decoded
+	bool isFinished();
+
+	/// stop the threads, seek to given time and start prefetching from there. returns actual seeked time
+	/// (see WebMDecoder::seek()). the outputs of the decoders get cleared, e.g. FrameQueue::clear()
+	double seek(int trackIndex, double time);
+
+	/// thread function of demux thread
+	virtual void run(int index);
+
+protected:
+
+	void start(double time);
+	void stop();
+
+	Pointer<WebMDecoder> decoder;
+	double prefetchTime;
+
+	std::map<int, Pointer<AsyncMediaDecoder> > decoders;
+
+	// demux thread
+	Pointer<Thread> thread;
+
+	// playback time when the demux thread was started
+	double startTime;
+
+	// playback times from the render thread to the demux thread
+	LockFreeQueue<double> times;
+
+	// 1 while the demux thread is running
+	boost::detail::atomic_count running;
+
+	// 1 if the demux thread reached the end of the segment
+	boost::detail::atomic_count end;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
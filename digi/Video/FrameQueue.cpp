@@ -0,0 +1,84 @@
+#include <string.h>
+
+#include "FrameQueue.h"
+
+
+namespace digi {
+
+FrameQueue::FrameQueue(VideoFormat format, int numFrames)
+	: format(format), frames(numFrames)
+{
+}
+
+FrameQueue::~FrameQueue()
+{
+}
+
+VideoFormat FrameQueue::getFormat()
+{
+	return this->format;
+}
+
+void FrameQueue::close()
+{
+}
+
+void FrameQueue::clear()
+{
+	this->frames.clear();
+}
+
+bool FrameQueue::canWrite()
+{
+	return !this->frames.full();
+}
+
+void FrameQueue::write(const Plane* planes)
+{
+	this->write(planes, 0.0);
+}
+
+void FrameQueue::write(const Plane* planes, double time)
+{
+	Frame* frame = this->frames.back();
+	if (frame == NULL)
+		return;
+
+	// copy planes. the buffers of the frame get reused, therefore no memory is allocated after the first frames
+	frame->time = time;
+	for (int i = 0; i < 3; ++i)
+	{
+		const Plane& p = planes[i];
+		size_t size = size_t(p.width) * size_t(p.height);
+		std::vector<uint8_t>& data = frame->data[i];
+		data.resize(size);
+		memcpy(data.data(), p.data, size);
+		frame->planes[i].data = data.data();
+		frame->planes[i].width = p.width;
+		frame->planes[i].height = p.height;
+	}
+	this->frames.push();
+}
+
+bool FrameQueue::present(double time, VideoOut* output)
+{
+	// count frames that are due
+	size_t numFrames = 0;
+	Frame* frame;
+	while ((frame = this->frames.get(numFrames)) != NULL && frame->time <= time)
+		++numFrames;
+	if (numFrames == 0)
+		return false;
+
+	// skip frames that are too late
+	for (size_t i = 1; i < numFrames; ++i)
+		this->frames.pop();
+
+	// write latest frame to the output and release it
+	frame = this->frames.front();
+	output->write(frame->planes, frame->time);
+	this->frames.pop();
+	return true;
+}
+
+} // namespace digi
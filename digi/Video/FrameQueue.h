@@ -0,0 +1,70 @@
+#ifndef digi_Video_FrameQueue_h
+#define digi_Video_FrameQueue_h
+
+#include <vector>
+
+#include <digi/Utility/LockFreeQueue.h>
+
+#include "VideoOut.h"
+
+
+namespace digi {
+
+/// @addtogroup Video
+/// @{
+
+/**
+	video output that buffers decoded frames in a bounded lock-free queue. the decoder writes frames on a background
+	thread and the render thread calls present() which writes the frame that is due to the actual video output
+	(e.g. a VideoTexture), therefore only frames that are ready get uploaded
+*/
+class FrameQueue : public VideoOut
+{
+public:
+
+	/// constructor. numFrames gets rounded up to a power of two
+	FrameQueue(VideoFormat format, int numFrames = 8);
+
+	virtual ~FrameQueue();
+
+	virtual VideoFormat getFormat();
+
+	virtual void close();
+
+	/// discard all frames. the decode thread and the render thread must not use the queue at the same time
+	virtual void clear();
+
+	/// returns false if the queue is full
+	virtual bool canWrite();
+
+	/// write a frame with time 0
+	virtual void write(const Plane* planes);
+
+	/// copy a frame into the queue. the frame gets dropped if the queue is full, therefore check canWrite() first
+	virtual void write(const Plane* planes, double time);
+
+	/// get number of frames in the queue
+	size_t getNumFrames() {return this->frames.size();}
+
+	/// write the latest frame with a time not later than the given time to the output. older frames get skipped.
+	/// returns true if a frame was written
+	bool present(double time, VideoOut* output);
+
+protected:
+
+	struct Frame
+	{
+		double time;
+		std::vector<uint8_t> data[3];
+		Plane planes[3];
+	};
+
+	VideoFormat format;
+	LockFreeQueue<Frame> frames;
+};
+
+/// @}
+
+} // namespace digi
+
+#endif
@@ -11,6 +11,11 @@ void MediaDecoder::update()
 {
 }
 
+bool MediaDecoder::canDecode()
+{
+	return true;
+}
+
 void MediaDecoder::clear()
 {
 }
@@ -22,6 +22,9 @@ public:
 	/// update. may be used to stream out e.g. pending audio data
 	virtual void update();
 	
+	/// returns false if the output can't take more data at the moment, e.g. because a frame queue is full
+	virtual bool canDecode();
+
 	/// decode a block of data
 	virtual void decode(double time, const uint8_t* data, size_t length) = 0;
 	
@@ -17,6 +17,11 @@ VPXDecoder::~VPXDecoder()
 	vpx_codec_destroy(&this->context);
 }
 
+bool VPXDecoder::canDecode()
+{
+	return this->output->canWrite();
+}
+
 void VPXDecoder::decode(double time, const uint8_t* data, size_t length)
 {
 	vpx_codec_decode(&this->context, data, length, NULL, 0);
@@ -38,7 +43,7 @@ void VPXDecoder::decode(double time, const uint8_t* data, size_t length)
 		planes[2].width = image->stride[2];
 		planes[1].height = planes[2].height = (image->d_h + (1 << ys) - 1) >> ys;
 		
-		this->output->write(planes);
+		this->output->write(planes, time);
 	}
 }
 
@@ -47,4 +52,9 @@ void VPXDecoder::close()
 	this->output->close();
 }
 
+void VPXDecoder::clear()
+{
+	this->output->clear();
+}
+
 } // namespace digi
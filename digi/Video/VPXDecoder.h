@@ -27,8 +27,12 @@ public:
 
 	void setOutput(Pointer<VideoOut> output) {this->output = output;}
 
+	virtual bool canDecode();
+
 	virtual void decode(double time, const uint8_t* data, size_t length);
 
+	virtual void clear();
+
 protected:
 	
 	int width;
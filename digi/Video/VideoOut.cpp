@@ -7,4 +7,18 @@ VideoOut::~VideoOut()
 {
 }
 
+void VideoOut::clear()
+{
+}
+
+bool VideoOut::canWrite()
+{
+	return true;
+}
+
+void VideoOut::write(const Plane* planes, double time)
+{
+	this->write(planes);
+}
+
 } // namespace digi
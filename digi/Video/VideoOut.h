@@ -38,10 +38,19 @@ public:
 	/// close video output
 	virtual void close() = 0;
 
+	/// discard frames that are buffered but not displayed yet, e.g. on seek
+	virtual void clear();
+
 // write
 
+	/// returns false if the video output can't take another frame at the moment (e.g. a full queue)
+	virtual bool canWrite();
+
 	/// write a frame to the video output
 	virtual void write(const Plane* planes) = 0;
+
+	/// write a frame with its presentation time in seconds. the default implementation ignores the time
+	virtual void write(const Plane* planes, double time);
 };
 
 /// @}
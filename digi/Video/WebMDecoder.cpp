@@ -4,6 +4,8 @@
 #include <digi/System/Log.h>
 #include <digi/Data/DataException.h>
 #include <digi/Data/EbmlReader.h>
+#include <digi/Data/LittleEndianReader.h>
+#include <digi/Data/LittleEndianWriter.h>
 
 #include "WebMDecoder.h"
 
@@ -39,6 +41,17 @@ namespace
 	}
 
 	typedef std::pair<const int, Pointer<MediaDecoder> > DecoderPair;
+	typedef std::pair<const int, std::vector<WebMDecoder::KeyFrame> > KeyFramesPair;
+
+	// header of key frame index file
+	enum
+	{
+		INDEX_MAGIC = 0x494b4d57, // "WMKI"
+		INDEX_VERSION = 1,
+		
+		// size of one key frame in the index file
+		INDEX_KEY_FRAME_SIZE = 4 * 8
+	};
 } // anonymous namespace
 
 
@@ -65,60 +78,44 @@ bool WebMDecoder::decode(double time)
 
 	while (true)
 	{
-		while (this->blockIt != this->cluster.simpleBlocks.end())
-		{
-			// simple block
-			// http://matroska.org/technical/specs/index.html#simpleblock_structure
-
-			// get track number
-			uint8_t* d = this->blockIt->data();
-			uint8_t* it = d;
-			int trackNumber = getEBMLVarInt(it);
-			
-			// calc timecode (time of cluster + time of block)
-			uint64_t timeCode = this->cluster.timeCode + ((it[0] << 8) | it[1]);
-			it += 2;
-			
-			// convert to seconds
-			double blockTime = double(timeCode) * this->timeCode2Seconds;
-			
-			// return false if not at end of segment (this block is "in the future")
-			if (blockTime > time)
-				return false;
-			
-			// get flags
-			uint8_t flags = *it;
-			++it;
-			
-			// pass block to decoder
-			Pointer<MediaDecoder> decoder = getValue(this->decoders, trackNumber);
-			if (decoder != null)
-				decoder->decode(blockTime, it, this->blockIt->size() - (it - d));
-			
-			++this->blockIt;
-		}
-		
-		this->cluster.simpleBlocks.clear();
-
-		// find next cluster
-		while (true)
+		// get next block, go to next cluster at end of current cluster
+		if (this->block == NULL && !this->readBlock())
 		{
 			// return true if at end of segment
-			if (this->r.getPosition() >= this->segmentEnd)
+			if (!this->readCluster())
 				return true;
-		
-			uint32_t id = this->r.readId();
-			if (id == webm::cluster::id)
-			{
-				// found a cluster
-				webm::cluster::read(this->r, this->cluster);
-				this->blockIt = this->cluster.simpleBlocks.begin();
-				break;
-			}
-
-			// skip unknown chunk
-			this->r.skip(this->r.readSize(1000000));
+			continue;
 		}
+
+		// simple block
+		// http://matroska.org/technical/specs/index.html#simpleblock_structure
+
+		// get track number
+		uint8_t* d = this->block;
+		uint8_t* it = d;
+		int trackNumber = getEBMLVarInt(it);
+		
+		// calc timecode (time of cluster + time of block)
+		uint64_t timeCode = this->clusterTimeCode + ((it[0] << 8) | it[1]);
+		it += 2;
+		
+		// convert to seconds
+		double blockTime = double(timeCode) * this->timeCode2Seconds;
+		
+		// return false if not at end of segment (this block is "in the future")
+		if (blockTime > time)
+			return false;
+		
+		// get flags
+		uint8_t flags = *it;
+		++it;
+		
+		// pass block to decoder
+		Pointer<MediaDecoder> decoder = getValue(this->decoders, trackNumber);
+		if (decoder != null)
+			decoder->decode(blockTime, it, this->blockSize - (it - d));
+		
+		this->block = NULL;
 	}
 }
 
@@ -131,43 +128,268 @@ double WebMDecoder::seek(int trackIndex, double time)
 	}
 
 	// clear current cluster
-	this->cluster.simpleBlocks.clear();
-	this->blockIt = this->cluster.simpleBlocks.begin();
-
-	std::map<double, int64_t>& cues = this->cues[trackIndex];
-	std::map<double, int64_t>::iterator it = cues.upper_bound(time);
-	if (it != cues.begin())
-		--it;
-	if (it != cues.end())
+	this->clusterEnd = 0;
+	this->block = NULL;
+
+	// without cues build the key frame index once
+	if (!this->haveIndex && this->cues.empty())
+		this->buildIndex();
+
+	if (this->haveIndex)
 	{
-		// set position
-		int64_t position = this->segmentStart + it->second;
-		this->r.setPosition(position);
+		// find last key frame that is not later than the given time
+		std::vector<KeyFrame>& keyFrames = this->keyFrames[trackIndex];
+		std::vector<KeyFrame>::iterator it = keyFrames.begin();
+		std::vector<KeyFrame>::iterator end = keyFrames.end();
+		uint64_t timeCode = time > 0.0 ? uint64_t(time / this->timeCode2Seconds + 0.5) : 0;
+		while (it != end)
+		{
+			// binary search
+			std::vector<KeyFrame>::iterator middle = it + (end - it) / 2;
+			if (middle->timeCode <= timeCode)
+				it = middle + 1;
+			else
+				end = middle;
+		}
+		if (it != keyFrames.begin())
+			--it;
+		if (it != keyFrames.end())
+		{
+			// set position to the simple block of the key frame and continue the cluster from there
+			this->r.setPosition(this->segmentStart + it->blockPosition);
+			this->clusterEnd = this->r.getByteCount() + size_t(it->clusterEnd - it->blockPosition);
+			this->clusterTimeCode = it->clusterTimeCode;
+			this->blockArena.reset();
+			this->readBlock();
+			return it->timeCode * this->timeCode2Seconds;
+		}
+	}
+	else
+	{
+		std::map<double, int64_t>& cues = this->cues[trackIndex];
+		std::map<double, int64_t>::iterator it = cues.upper_bound(time);
+		if (it != cues.begin())
+			--it;
+		if (it != cues.end())
+		{
+			// set position
+			int64_t position = this->segmentStart + it->second;
+			this->r.setPosition(position);
+
+			// find next cluster and return its start time
+			if (this->readCluster())
+				return this->clusterTimeCode * this->timeCode2Seconds;
+		}
+	}
+	
+	return this->duration;
+}
 
-		// find next cluster
-		while (true)
+void WebMDecoder::buildIndex()
+{
+	this->keyFrames.clear();
+
+	// save position
+	int64_t position = this->r.getPosition();
+	size_t byteCount = this->r.getByteCount();
+
+	// iterate over top level elements of segment
+	int64_t elementPosition = this->segmentStart;
+	while (elementPosition < this->segmentEnd)
+	{
+		this->r.setPosition(elementPosition);
+		uint32_t id = this->r.readId();
+		int64_t size = int64_t(this->r.readVarInt());
+		int64_t clusterStart = this->r.getPosition();
+		int64_t clusterEnd = clusterStart + size;
+		if (id == webm::cluster::id)
 		{
-			// check if at end of segment
-			if (this->r.getPosition() >= this->segmentEnd)
-				break;
-		
-			uint32_t id = this->r.readId();
-			if (id == webm::cluster::id)
+			// iterate over elements of cluster
+			uint64_t clusterTimeCode = 0;
+			int64_t blockPosition = clusterStart;
+			while (blockPosition < clusterEnd)
+			{
+				uint32_t id = this->r.readId();
+				if (id == 0xE7)
+				{
+					// time code
+					clusterTimeCode = this->r.read<uint64_t>();
+					blockPosition = this->r.getPosition();
+					continue;
+				}
+				size_t size = this->r.readSize(100000000u);
+				int64_t dataStart = this->r.getPosition();
+				if (id == 0xA3)
+				{
+					// simple block: only read track number, time code and flags
+					int trackNumber = int(this->r.readVarInt());
+					uint8_t header[3];
+					this->r.readData(header, 3);
+					if ((header[2] & 0x80) != 0)
+					{
+						KeyFrame keyFrame;
+						keyFrame.timeCode = clusterTimeCode + ((header[0] << 8) | header[1]);
+						keyFrame.clusterTimeCode = clusterTimeCode;
+						keyFrame.blockPosition = blockPosition - this->segmentStart;
+						keyFrame.clusterEnd = clusterEnd - this->segmentStart;
+						this->keyFrames[trackNumber].push_back(keyFrame);
+					}
+				}
+
+				// go to next element. skip small elements without seeking to keep the read buffer
+				blockPosition = dataStart + int64_t(size);
+				int64_t toSkip = blockPosition - this->r.getPosition();
+				if (toSkip < 4096)
+					this->r.skip(size_t(toSkip));
+				else
+					this->r.setPosition(blockPosition);
+			}
+		}
+		elementPosition = clusterEnd;
+	}
+	this->haveIndex = true;
+
+	// restore position. the end of the current cluster is relative to the byte count
+	this->r.setPosition(position);
+	this->clusterEnd += this->r.getByteCount() - byteCount;
+}
+
+bool WebMDecoder::loadIndex(const fs::path& path)
+{
+	if (!fs::exists(path))
+		return false;
+
+	try
+	{
+		int64_t fileSize = int64_t(fs::file_size(path));
+		LittleEndianReader r(path);
+
+		// check header and size of segment
+		if (r.read<uint32_t>() != INDEX_MAGIC || r.read<uint32_t>() != INDEX_VERSION
+			|| r.read<int64_t>() != this->segmentEnd - this->segmentStart)
+		{
+			return false;
+		}
+
+		// read key frames of all tracks
+		std::map<int, std::vector<KeyFrame> > keyFrames;
+		uint32_t numTracks = r.read<uint32_t>();
+		for (uint32_t i = 0; i < numTracks; ++i)
+		{
+			int trackNumber = r.read<int32_t>();
+			uint32_t numKeyFrames = r.read<uint32_t>();
+			
+			// check number of key frames against remaining file size before allocating them
+			if (int64_t(numKeyFrames) * INDEX_KEY_FRAME_SIZE > fileSize - r.getPosition())
+				return false;
+			std::vector<KeyFrame>& trackKeyFrames = keyFrames[trackNumber];
+			trackKeyFrames.resize(numKeyFrames);
+			foreach (KeyFrame& keyFrame, trackKeyFrames)
 			{
-				// found a cluster
-				webm::cluster::read(this->r, this->cluster);
-				this->blockIt = this->cluster.simpleBlocks.begin();
-				
-				// return start time of cluster
-				return this->cluster.timeCode * this->timeCode2Seconds;
+				keyFrame.timeCode = r.read<uint64_t>();
+				keyFrame.clusterTimeCode = r.read<uint64_t>();
+				keyFrame.blockPosition = r.read<int64_t>();
+				keyFrame.clusterEnd = r.read<int64_t>();
 			}
+		}
+		r.close();
 
-			// skip unknown chunk
-			this->r.skip(this->r.readSize(1000000));
+		std::swap(this->keyFrames, keyFrames);
+		this->haveIndex = true;
+		return true;
+	}
+	catch (DataException&)
+	{
+		// index file is truncated
+		return false;
+	}
+}
+
+void WebMDecoder::saveIndex(const fs::path& path)
+{
+	LittleEndianWriter w(path);
+	w.write<uint32_t>(INDEX_MAGIC);
+	w.write<uint32_t>(INDEX_VERSION);
+	w.write<int64_t>(this->segmentEnd - this->segmentStart);
+	w.write<uint32_t>(uint32_t(this->keyFrames.size()));
+	foreach (const KeyFramesPair& p, this->keyFrames)
+	{
+		w.write<int32_t>(p.first);
+		w.write<uint32_t>(uint32_t(p.second.size()));
+		foreach (const KeyFrame& keyFrame, p.second)
+		{
+			w.write<uint64_t>(keyFrame.timeCode);
+			w.write<uint64_t>(keyFrame.clusterTimeCode);
+			w.write<int64_t>(keyFrame.blockPosition);
+			w.write<int64_t>(keyFrame.clusterEnd);
 		}
 	}
+	w.close();
+}
+
+bool WebMDecoder::readCluster()
+{
+	// find next cluster
+	while (true)
+	{
+		// check if at end of segment
+		if (this->r.getPosition() >= this->segmentEnd)
+			return false;
 	
-	return this->duration;
+		uint32_t id = this->r.readId();
+		if (id == webm::cluster::id)
+		{
+			// found a cluster
+			this->startCluster();
+			return true;
+		}
+
+		// skip unknown chunk
+		this->r.skip(this->r.readSize(1000000));
+	}
+}
+
+void WebMDecoder::startCluster()
+{
+	size_t size = this->r.readSize(100000000u);
+	this->clusterEnd = this->r.getByteCount() + size;
+	this->clusterTimeCode = 0;
+
+	// the blocks of the last cluster are not needed any more
+	this->blockArena.reset();
+	this->block = NULL;
+
+	// read until first block so that the time code of the cluster is known
+	this->readBlock();
+}
+
+bool WebMDecoder::readBlock()
+{
+	while (this->r.getByteCount() < this->clusterEnd)
+	{
+		uint32_t id = this->r.readId();
+		switch (id)
+		{
+		case 0xE7:
+			// time code
+			this->clusterTimeCode = this->r.read<uint64_t>();
+			break;
+		case 0xA3:
+			{
+				// simple block: track number (at least 1 byte), time code (2 bytes) and flags (1 byte)
+				size_t size = this->r.readSize(10000000u);
+				if (size < 4)
+					throw DataException(this->r.getDevice(), DataException::DATA_CORRUPT);
+				this->block = this->blockArena.alloc<uint8_t>(size);
+				this->blockSize = size;
+				this->r.readData(this->block, size);
+			}
+			return true;
+		default:
+			this->r.skip(this->r.readSize(100000000u));
+		}
+	}
+	return false;
 }
 
 void WebMDecoder::readHeader(webm::Info& info, webm::Tracks& tracks)
@@ -232,9 +454,8 @@ void WebMDecoder::readHeader(webm::Info& info, webm::Tracks& tracks)
 		}
 		else if (id == webm::cluster::id)
 		{
-			// read first cluster
-			webm::cluster::read(this->r, this->cluster);
-			this->blockIt = this->cluster.simpleBlocks.begin();
+			// start first cluster
+			this->startCluster();
 			
 			// stop
 			break;
@@ -251,6 +472,7 @@ void WebMDecoder::readHeader(webm::Info& info, webm::Tracks& tracks)
 	{
 		// save position
 		int64_t position = this->r.getPosition();
+		size_t byteCount = this->r.getByteCount();
 
 		// iterate over seek infos
 		foreach (webm::Seek& seek, seekHead.seeks)
@@ -300,8 +522,9 @@ void WebMDecoder::readHeader(webm::Info& info, webm::Tracks& tracks)
 			}
 		}
 		
-		// restore position
+		// restore position. the end of the current cluster is relative to the byte count
 		this->r.setPosition(position);
+		this->clusterEnd += this->r.getByteCount() - byteCount;
 	}
 	
 	if (!haveInfo || !haveTracks)
@@ -2,9 +2,11 @@
 #define digi_Video_WebMDecoder_h
 
 #include <map>
+#include <vector>
 
 #include <boost/optional.hpp>
 
+#include <digi/Utility/Arena.h>
 #include <digi/Data/EbmlReader.h>
 #include "MediaDecoder.h"
 
@@ -16,20 +18,44 @@ namespace digi {
 
 #include "webm.struct.h"
 
+/**
+	webm demuxer. clusters are parsed lazily while decoding, i.e. a simple block is read when it is needed. the blocks
+	of a cluster are read into an arena that is reset at the start of the next cluster, therefore no memory gets
+	allocated after the first few clusters. the decoders get pointers into the arena that stay valid until the end
+	of the cluster.
+	for exact seeking a key frame index can be built by scanning only the headers of the clusters and blocks. the
+	index can be saved to a file (e.g. next to the webm file) so that the scan is needed only once
+*/
 class WebMDecoder : public Object
 {
 public:
+
+	/// entry of the key frame index
+	struct KeyFrame
+	{
+		// time code of key frame
+		uint64_t timeCode;
+
+		// time code of cluster that contains the key frame
+		uint64_t clusterTimeCode;
+
+		// position of the simple block element and end of the cluster relative to the segment start
+		int64_t blockPosition;
+		int64_t clusterEnd;
+	};
 	
 	/// decode webm from given device (must be seekable)
 	WebMDecoder(Pointer<IODevice> dev, webm::Info& info, webm::Tracks& tracks)
-		: r(dev), segmentStart(), segmentEnd(), timeCode2Seconds()
+		: r(dev), segmentStart(), segmentEnd(), timeCode2Seconds(), haveIndex(false), clusterEnd(), clusterTimeCode(),
+		blockArena(1 << 20), block(), blockSize()
 	{
 		this->readHeader(info, tracks);
 	}
 
 	/// decode webm from given file path
 	WebMDecoder(const fs::path& path, webm::Info& info, webm::Tracks& tracks)
-		: r(path), segmentStart(), segmentEnd(), timeCode2Seconds()
+		: r(path), segmentStart(), segmentEnd(), timeCode2Seconds(), haveIndex(false), clusterEnd(), clusterTimeCode(),
+		blockArena(1 << 20), block(), blockSize()
 	{
 		this->readHeader(info, tracks);
 	}
@@ -48,13 +74,36 @@ public:
 	/// decode until given time
 	bool decode(double time);
 
-	/// seek to given time and return actual seeked time (start of next cluster). uses cues of track given by trackIndex
+	/// seek to the last key frame of the track given by trackIndex that is not later than the given time and
+	/// return the time of the key frame. uses the key frame index if available, otherwise the cues in which case
+	/// the seek lands at the start of the cluster. the index is built on first seek if the file has no cues
 	double seek(int trackIndex, double time);
 
+	/// build key frame index by scanning the headers of all clusters and blocks. the data of the blocks is skipped
+	void buildIndex();
+
+	/// returns true if a key frame index was built or loaded
+	bool hasIndex() {return this->haveIndex;}
+
+	/// load key frame index from given file. returns false if the file does not exist or does not match the webm file
+	bool loadIndex(const fs::path& path);
+
+	/// save key frame index to given file
+	void saveIndex(const fs::path& path);
+
 protected:
 
 	void readHeader(webm::Info& info, webm::Tracks& tracks);
 
+	// find next cluster and read until its first block. returns false at end of segment
+	bool readCluster();
+
+	// start a cluster after its id was read
+	void startCluster();
+
+	// read next simple block of current cluster into the arena. returns false at end of cluster
+	bool readBlock();
+
 	// device where webm file is read from
 	EbmlReader r;
 
@@ -71,9 +120,20 @@ protected:
 	// cues: track id -> (time -> cluster position from segment start)
 	std::map<int, std::map<double, int64_t> > cues;
 
-	// current cluster
-	webm::Cluster cluster;
-	std::list<std::vector<uint8_t> >::iterator blockIt;
+	// key frame index: track id -> key frames sorted by time code
+	bool haveIndex;
+	std::map<int, std::vector<KeyFrame> > keyFrames;
+
+	// current cluster: end position (byte count of reader) and time code
+	size_t clusterEnd;
+	uint64_t clusterTimeCode;
+
+	// memory for the blocks of the current cluster
+	Arena blockArena;
+
+	// block that was read but not decoded yet, NULL if none
+	uint8_t* block;
+	size_t blockSize;
 	
 	// decoders for the tracks
 	std::map<int, Pointer<MediaDecoder> > decoders;
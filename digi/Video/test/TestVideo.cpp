@@ -5,11 +5,14 @@
 
 #include <digi/Utility/ListUtility.h>
 #include <digi/Utility/foreach.h>
+#include <digi/System/File.h>
 #include <digi/System/Log.h>
 #include <digi/System/ConsoleLogChannel.h>
 #include <digi/System/Timer.h>
 #include <digi/Audio/AudioIn.h>
 #include <digi/Audio/LineOut.h>
+#include <digi/Video/AsyncWebMDecoder.h>
+#include <digi/Video/FrameQueue.h>
 #include <digi/Video/VideoIn.h>
 #include <digi/Video/VideoTexture.h>
 #ifdef HAVE_OGG
@@ -154,8 +157,9 @@ class TestTextIn : public MediaEncoder
 {
 public:
 
-	TestTextIn()
-		: index()
+	// every keyInterval subtitle is a key frame if keyInterval is not zero
+	TestTextIn(int keyInterval = 0)
+		: index(), keyInterval(keyInterval)
 	{
 	
 	}
@@ -169,7 +173,7 @@ public:
 		this->subtitle = str(boost::format("Index%1%") % this->index);
 		
 		packet.time = double(this->index);
-		packet.type = Packet::NORMAL;
+		packet.type = this->keyInterval != 0 && this->index % this->keyInterval == 0 ? Packet::KEY : Packet::NORMAL;
 		
 		if ((this->index & 1) == 0)
 		{
@@ -187,6 +191,7 @@ public:
 	
 	
 	int index;
+	int keyInterval;
 	std::string subtitle;
 };
 
@@ -258,6 +263,327 @@ TEST(Video, WebMEncoder)
 		p.second->close();	
 }
 
+// test text output that records the subtitles
+class TestTextOut : public MediaDecoder
+{
+public:
+
+	virtual void close()
+	{
+	}
+
+	virtual void decode(double time, const uint8_t* data, size_t length)
+	{
+		this->times.push_back(time);
+		this->texts.push_back(std::string((const char*)data, length));
+	}
+
+	std::vector<double> times;
+	std::vector<std::string> texts;
+};
+
+TEST(Video, WebMDemux)
+{
+	// encode 100 subtitles with a time distance of one second. a cluster can hold about 32 seconds
+	{
+		webm::Info info;
+		info.timeCodeScale = 1000000;
+		webm::Tracks tracks;
+		webm::TrackEntry& subtitleTrack = add(tracks.trackEntries);
+		subtitleTrack.trackNumber = 1;
+		subtitleTrack.trackType = 0x11; // subtitle
+		subtitleTrack.codecID = "S_TEXT/UTF8";
+		std::map<int, Pointer<MediaEncoder> > encoders;
+		encoders[1] = new TestTextIn();
+
+		Pointer<WebMEncoder> encoder = new WebMEncoder("demux.webm", info, tracks);
+		encoder->encode(encoders, 100.0);
+		encoder->finishSegment(info, tracks);
+		encoder->close();
+		encoders[1]->close();
+	}
+
+	// decode
+	webm::Info info;
+	webm::Tracks tracks;
+	Pointer<WebMDecoder> decoder = new WebMDecoder("demux.webm", info, tracks);
+	Pointer<TestTextOut> textOut = new TestTextOut();
+	decoder->setDecoder(1, textOut);
+
+	// decode until 10.5 seconds
+	EXPECT_FALSE(decoder->decode(10.5));
+	EXPECT_EQ(11, int(textOut->times.size()));
+
+	// decode across clusters until end
+	EXPECT_FALSE(decoder->decode(50.0));
+	EXPECT_EQ(51, int(textOut->times.size()));
+	EXPECT_TRUE(decoder->decode(1000.0));
+	ASSERT_EQ(100, int(textOut->times.size()));
+	for (int i = 0; i < 100; ++i)
+	{
+		EXPECT_EQ(double(i), textOut->times[i]);
+		EXPECT_EQ((i & 1) == 0 ? str(boost::format("Index%1%") % i) : std::string(" "), textOut->texts[i]);
+	}
+	decoder->close();
+}
+
+// test video output that records the frames
+class TestFrameOut : public VideoOut
+{
+public:
+
+	virtual VideoFormat getFormat()
+	{
+		return VideoFormat(VideoFormat::YV12, 4, 4, 10.0f);
+	}
+
+	virtual void close()
+	{
+	}
+
+	virtual void write(const Plane* planes)
+	{
+	}
+
+	virtual void write(const Plane* planes, double time)
+	{
+		this->times.push_back(time);
+		this->values.push_back(*(const uint8_t*)planes[0].data);
+	}
+
+	std::vector<double> times;
+	std::vector<int> values;
+};
+
+TEST(Video, FrameQueue)
+{
+	Pointer<FrameQueue> queue = new FrameQueue(VideoFormat(VideoFormat::YV12, 4, 4, 10.0f), 4);
+	Pointer<TestFrameOut> frameOut = new TestFrameOut();
+
+	// write frames until the queue is full
+	uint8_t y[16];
+	uint8_t uv[4] = {};
+	VideoOut::Plane planes[3] = {{y, 4, 4}, {uv, 2, 2}, {uv, 2, 2}};
+	int numFrames = 0;
+	while (queue->canWrite())
+	{
+		y[0] = uint8_t(numFrames);
+		queue->write(planes, numFrames * 0.1);
+		++numFrames;
+	}
+	EXPECT_EQ(4, numFrames);
+
+	// no frame is due yet
+	EXPECT_FALSE(queue->present(-0.05, frameOut));
+
+	// the first frame is due
+	EXPECT_TRUE(queue->present(0.05, frameOut));
+	
+	// the second frame is skipped
+	EXPECT_TRUE(queue->present(0.25, frameOut));
+	EXPECT_EQ(1, int(queue->getNumFrames()));
+	ASSERT_EQ(2, int(frameOut->values.size()));
+	EXPECT_EQ(0, frameOut->values[0]);
+	EXPECT_EQ(2, frameOut->values[1]);
+	EXPECT_DOUBLE_EQ(0.2, frameOut->times[1]);
+
+	queue->clear();
+	EXPECT_EQ(0, int(queue->getNumFrames()));
+	EXPECT_FALSE(queue->present(1.0, frameOut));
+}
+
+TEST(Video, AsyncWebMDecoder)
+{
+	// encode 100 subtitles with a time distance of one second
+	{
+		webm::Info info;
+		info.timeCodeScale = 1000000;
+		webm::Tracks tracks;
+		webm::TrackEntry& subtitleTrack = add(tracks.trackEntries);
+		subtitleTrack.trackNumber = 1;
+		subtitleTrack.trackType = 0x11; // subtitle
+		subtitleTrack.codecID = "S_TEXT/UTF8";
+		std::map<int, Pointer<MediaEncoder> > encoders;
+		encoders[1] = new TestTextIn();
+
+		Pointer<WebMEncoder> encoder = new WebMEncoder("async.webm", info, tracks);
+		encoder->encode(encoders, 100.0);
+		encoder->finishSegment(info, tracks);
+		encoder->close();
+		encoders[1]->close();
+	}
+
+	// decode on background threads with 5 seconds prefetch
+	webm::Info info;
+	webm::Tracks tracks;
+	Pointer<AsyncWebMDecoder> decoder = new AsyncWebMDecoder(new WebMDecoder("async.webm", info, tracks), 5.0);
+	Pointer<TestTextOut> textOut = new TestTextOut();
+	decoder->setDecoder(1, textOut);
+
+	// start at 10 seconds and wait until the demuxer has reached the end
+	decoder->decode(10.0);
+	int startTime = Timer::getMilliSeconds();
+	while (!decoder->decode(1000.0) && Timer::getMilliSeconds() - startTime < 5000)
+		Timer::milliSleep(1);
+	while (!decoder->isFinished() && Timer::getMilliSeconds() - startTime < 5000)
+		Timer::milliSleep(1);
+	decoder->close();
+
+	ASSERT_EQ(100, int(textOut->times.size()));
+	for (int i = 0; i < 100; ++i)
+	{
+		EXPECT_EQ(double(i), textOut->times[i]);
+		EXPECT_EQ((i & 1) == 0 ? str(boost::format("Index%1%") % i) : std::string(" "), textOut->texts[i]);
+	}
+}
+
+// test text output that only takes data after it was opened
+class TestGateTextOut : public TestTextOut
+{
+public:
+
+	TestGateTextOut()
+		: open(0), numRequests(0) {}
+
+	virtual bool canDecode()
+	{
+		// gets called by AsyncMediaDecoder when a block is queued
+		++this->numRequests;
+		return long(this->open) != 0;
+	}
+
+	boost::detail::atomic_count open;
+	boost::detail::atomic_count numRequests;
+};
+
+TEST(Video, AsyncWebMDecoderSeek)
+{
+	// encode 100 subtitles with a key frame every 10 seconds
+	{
+		webm::Info info;
+		info.timeCodeScale = 1000000;
+		webm::Tracks tracks;
+		webm::TrackEntry& subtitleTrack = add(tracks.trackEntries);
+		subtitleTrack.trackNumber = 1;
+		subtitleTrack.trackType = 0x11; // subtitle
+		subtitleTrack.codecID = "S_TEXT/UTF8";
+		std::map<int, Pointer<MediaEncoder> > encoders;
+		encoders[1] = new TestTextIn(10);
+
+		Pointer<WebMEncoder> encoder = new WebMEncoder("asyncseek.webm", info, tracks);
+		encoder->encode(encoders, 100.0);
+		encoder->finishSegment(info, tracks);
+		encoder->close();
+		encoders[1]->close();
+	}
+
+	webm::Info info;
+	webm::Tracks tracks;
+	Pointer<AsyncWebMDecoder> decoder = new AsyncWebMDecoder(new WebMDecoder("asyncseek.webm", info, tracks), 5.0);
+	Pointer<TestGateTextOut> textOut = new TestGateTextOut();
+	decoder->setDecoder(1, textOut);
+
+	// start at 0 seconds and wait until blocks are queued in front of the closed output
+	decoder->decode(0.0);
+	int startTime = Timer::getMilliSeconds();
+	while (long(textOut->numRequests) == 0 && Timer::getMilliSeconds() - startTime < 5000)
+		Timer::milliSleep(1);
+	EXPECT_NE(0, long(textOut->numRequests));
+	EXPECT_TRUE(textOut->times.empty());
+
+	// seek while blocks are queued. the queued blocks get discarded and prefetching restarts at the key frame
+	EXPECT_EQ(50.0, decoder->seek(1, 55.0));
+	++textOut->open;
+	while (!decoder->decode(1000.0) && Timer::getMilliSeconds() - startTime < 5000)
+		Timer::milliSleep(1);
+	while (!decoder->isFinished() && Timer::getMilliSeconds() - startTime < 5000)
+		Timer::milliSleep(1);
+	decoder->close();
+
+	// the first block after the seek is the key frame
+	ASSERT_EQ(50, int(textOut->times.size()));
+	EXPECT_EQ(50.0, textOut->times.front());
+	EXPECT_EQ("Index50", textOut->texts.front());
+	EXPECT_EQ(99.0, textOut->times.back());
+}
+
+TEST(Video, WebMSeek)
+{
+	// encode 100 subtitles with a key frame every 10 seconds
+	{
+		webm::Info info;
+		info.timeCodeScale = 1000000;
+		webm::Tracks tracks;
+		webm::TrackEntry& subtitleTrack = add(tracks.trackEntries);
+		subtitleTrack.trackNumber = 1;
+		subtitleTrack.trackType = 0x11; // subtitle
+		subtitleTrack.codecID = "S_TEXT/UTF8";
+		std::map<int, Pointer<MediaEncoder> > encoders;
+		encoders[1] = new TestTextIn(10);
+
+		Pointer<WebMEncoder> encoder = new WebMEncoder("seek.webm", info, tracks);
+		encoder->encode(encoders, 100.0);
+		encoder->finishSegment(info, tracks);
+		encoder->close();
+		encoders[1]->close();
+	}
+
+	// seek using cues
+	webm::Info info;
+	webm::Tracks tracks;
+	Pointer<WebMDecoder> decoder = new WebMDecoder("seek.webm", info, tracks);
+	Pointer<TestTextOut> textOut = new TestTextOut();
+	decoder->setDecoder(1, textOut);
+	EXPECT_FALSE(decoder->hasIndex());
+	EXPECT_EQ(20.0, decoder->seek(1, 25.5));
+	EXPECT_FALSE(decoder->decode(25.5));
+	ASSERT_EQ(6, int(textOut->times.size()));
+	EXPECT_EQ(20.0, textOut->times.front());
+
+	// build key frame index while decoding, the current position must not change
+	decoder->buildIndex();
+	EXPECT_TRUE(decoder->hasIndex());
+	EXPECT_FALSE(decoder->decode(30.5));
+	ASSERT_EQ(11, int(textOut->times.size()));
+	EXPECT_EQ(30.0, textOut->times.back());
+
+	// seek using key frame index
+	EXPECT_EQ(0.0, decoder->seek(1, 5.0));
+	EXPECT_EQ(50.0, decoder->seek(1, 50.0));
+	EXPECT_EQ(90.0, decoder->seek(1, 1000.0));
+	EXPECT_EQ(20.0, decoder->seek(1, 29.9));
+	textOut->times.clear();
+	textOut->texts.clear();
+	EXPECT_FALSE(decoder->decode(21.5));
+	ASSERT_EQ(2, int(textOut->times.size()));
+	EXPECT_EQ("Index20", textOut->texts[0]);
+	decoder->saveIndex("seek.webm.index");
+	decoder->close();
+
+	// load key frame index
+	decoder = new WebMDecoder("seek.webm", info, tracks);
+	EXPECT_FALSE(decoder->loadIndex("missing.webm.index"));
+	EXPECT_TRUE(decoder->loadIndex("seek.webm.index"));
+	EXPECT_TRUE(decoder->hasIndex());
+	EXPECT_EQ(70.0, decoder->seek(1, 75.0));
+	decoder->close();
+
+	// index with a number of key frames that exceeds the file size is rejected
+	{
+		fs::remove("corrupt.webm.index");
+		fs::copy_file("seek.webm.index", "corrupt.webm.index");
+		Pointer<File> file = File::open("corrupt.webm.index", File::WRITE);
+		file->setPosition(4 + 4 + 8 + 4 + 4);
+		uint32_t numKeyFrames = 0xffffffff;
+		file->write(&numKeyFrames, 4);
+		file->close();
+	}
+	decoder = new WebMDecoder("seek.webm", info, tracks);
+	EXPECT_FALSE(decoder->loadIndex("corrupt.webm.index"));
+	EXPECT_FALSE(decoder->hasIndex());
+	decoder->close();
+}
+
 // video player
 Pointer<Display> display;
 Pointer<VideoTexture> videoOut;